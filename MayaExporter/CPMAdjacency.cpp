@@ -0,0 +1,270 @@
+#include <cstring>
+
+#include "CPMAdjacency.h"
+#include "CPMMeshWriter.h"
+#include "CPMParallel.h"
+#include "CPMProfiler.h"
+
+//
+//	Hachage
+//	les positions et les artes sont rparties en partitions d'aprs leur hachage: chaque thread construit sans verrou
+//	la table  adressage ouvert d'une partition, les deux sens d'une arte sont toujours dans la mme partition
+//
+static inline unsigned long long Mix(unsigned long long h)
+{
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline unsigned long long DoubleBits(double value)
+// Rsum: -0 et +0 sont la mme position
+{
+	if(value == 0.0) value = 0.0;
+	unsigned long long bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static inline unsigned long long HashPosition(const VECTOR3_ARRAY<double> &points, unsigned int v)
+{
+	return Mix(DoubleBits(points.x[v]) ^ Mix(DoubleBits(points.y[v]) ^ Mix(DoubleBits(points.z[v]))));
+}
+
+static inline unsigned int Partition(unsigned long long hash, unsigned int numPartitions)
+// Rsum: bits de poids fort, les bits de poids faible choisissent la case dans la table de la partition
+{
+	return (unsigned int) (((hash >> 32) * numPartitions) >> 32);
+}
+
+static inline size_t TableSize(size_t count)
+// Rsum: puissance de 2, tables remplies  moiti au plus
+{
+	size_t size = 16;
+	while(size < 2 * count) size <<= 1;
+	return size;
+}
+
+template<typename PARTITION>
+static void SortByPartition(size_t count, unsigned int numPartitions, const PARTITION &partition, std::vector<unsigned int> &order, std::vector<size_t> &offsets)
+// Rsum: tri par dnombrement stable des lments [0, count), ceux de la partition p sont order[offsets[p], offsets[p + 1])
+{
+	const unsigned int numChunks = GetWorkerCount();
+	const size_t chunkSize = (count + numChunks - 1) / numChunks;
+
+	std::vector<size_t> chunkCounts((size_t) numChunks * numPartitions, 0);
+	ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t c = begin; c < end; c++)
+		{
+			size_t *counts = &chunkCounts[c * numPartitions];
+			const size_t iEnd = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+			for(size_t i = c * chunkSize; i < iEnd; i++) counts[partition(i)]++;
+		}
+	});
+
+	offsets.assign(numPartitions + 1, 0);
+	size_t offset = 0;
+	for(unsigned int p = 0; p < numPartitions; p++)
+	{
+		offsets[p] = offset;
+		for(unsigned int c = 0; c < numChunks; c++)
+		{
+			const size_t n = chunkCounts[(size_t) c * numPartitions + p];
+			chunkCounts[(size_t) c * numPartitions + p] = offset;
+			offset += n;
+		}
+	}
+	offsets[numPartitions] = offset;
+
+	order.resize(count);
+	ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t c = begin; c < end; c++)
+		{
+			size_t *positions = &chunkCounts[c * numPartitions];
+			const size_t iEnd = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+			for(size_t i = c * chunkSize; i < iEnd; i++) order[positions[partition(i)]++] = (unsigned int) i;
+		}
+	});
+}
+
+
+//
+//	Fusion des positions: chaque vertex reoit l'indice du premier vertex de mme position
+//
+static void WeldPositions(const VECTOR3_ARRAY<double> &points, unsigned int numPartitions, std::vector<unsigned int> &positionIds)
+{
+	const unsigned int numVertices = (unsigned int) points.size();
+	positionIds.resize(numVertices);
+
+	std::vector<unsigned int> order;
+	std::vector<size_t> offsets;
+	SortByPartition(numVertices, numPartitions, [&](size_t v) { return Partition(HashPosition(points, (unsigned int) v), numPartitions); }, order, offsets);
+
+	ParallelFor(numPartitions, 1, [&](size_t begin, size_t end)
+	{
+		std::vector<unsigned int> table; // vertex + 1, 0 = case libre
+		for(size_t p = begin; p < end; p++)
+		{
+			const size_t mask = TableSize(offsets[p + 1] - offsets[p]) - 1;
+			table.assign(mask + 1, 0);
+
+			// les vertices d'une partition sont dans l'ordre croissant: le premier insr est le plus petit indice
+			for(size_t i = offsets[p]; i < offsets[p + 1]; i++)
+			{
+				const unsigned int v = order[i];
+				for(size_t slot = (size_t) HashPosition(points, v) & mask; ; slot = (slot + 1) & mask)
+				{
+					const unsigned int w = table[slot];
+					if(!w)
+					{
+						table[slot] = v + 1;
+						positionIds[v] = v;
+						break;
+					}
+					if(points.x[w - 1] == points.x[v] && points.y[w - 1] == points.y[v] && points.z[w - 1] == points.z[v])
+					{
+						positionIds[v] = w - 1;
+						break;
+					}
+				}
+			}
+		}
+	});
+}
+
+
+//
+//	Appariement des artes
+//
+struct EDGE_SLOT
+{
+	unsigned long long	key;	// (dbut << 32) | fin en indices de positions, 0 = case libre: une arte dgnre n'est jamais insre
+	unsigned int		first;	// plus petite demi-arte (3 * triangle + ct) de ce sens
+	unsigned int		count;
+};
+
+static inline unsigned long long EdgeKey(unsigned int a, unsigned int b)
+{
+	return ((unsigned long long) a << 32) | b;
+}
+
+static inline unsigned int NextHalfEdge(unsigned int h)
+{
+	return h % 3 == 2 ? h - 2 : h + 1;
+}
+
+static inline unsigned int OppositeHalfEdge(unsigned int h)
+// Rsum: le sommet oppos  l'arte h est le dbut de la demi-arte qui prcde h
+{
+	return h % 3 == 0 ? h + 2 : h - 1;
+}
+
+static const EDGE_SLOT *FindEdge(const std::vector<EDGE_SLOT> &table, unsigned long long key)
+{
+	const size_t mask = table.size() - 1;
+	for(size_t slot = (size_t) Mix(key) & mask; ; slot = (slot + 1) & mask)
+	{
+		if(table[slot].key == key) return &table[slot];
+		if(!table[slot].key) return NULL;
+	}
+}
+
+CPM_ADJACENCY_STATS BuildAdjacency(const std::vector<unsigned int> &triangles, const VECTOR3_ARRAY<double> &points, std::vector<unsigned int> &adjacency)
+{
+	CPM_PROFILE_SCOPE("BuildAdjacency");
+
+	const size_t numTriangles = triangles.size() / 3;
+	const size_t numHalfEdges = 3 * numTriangles;
+	const unsigned int numPartitions = numTriangles >= CPM_ADJACENCY_PARALLEL_MIN_TRIANGLES ? GetWorkerCount() : 1;
+
+	CPM_ADJACENCY_STATS stats;
+	stats.triangles = (unsigned int) numTriangles;
+	adjacency.resize(6 * numTriangles);
+	if(!numTriangles) return stats;
+
+	std::vector<unsigned int> positionIds;
+	WeldPositions(points, numPartitions, positionIds);
+
+	// les deux sens d'une arte ont la mme partition: celle de l'arte non oriente
+	std::vector<unsigned int> order;
+	std::vector<size_t> offsets;
+	SortByPartition(numHalfEdges, numPartitions, [&](size_t h)
+	{
+		const unsigned int a = positionIds[triangles[h]], b = positionIds[triangles[NextHalfEdge((unsigned int) h)]];
+		return Partition(Mix(a < b ? EdgeKey(a, b) : EdgeKey(b, a)), numPartitions);
+	}, order, offsets);
+
+	std::vector<CPM_ADJACENCY_STATS> partitionStats(numPartitions);
+	ParallelFor(numPartitions, 1, [&](size_t begin, size_t end)
+	{
+		std::vector<EDGE_SLOT> table;
+		for(size_t p = begin; p < end; p++)
+		{
+			const size_t mask = TableSize(offsets[p + 1] - offsets[p]) - 1;
+			EDGE_SLOT empty = { 0, 0, 0 };
+			table.assign(mask + 1, empty);
+
+			// demi-artes de la partition dans l'ordre croissant: la premire insre de chaque sens est la plus petite
+			for(size_t i = offsets[p]; i < offsets[p + 1]; i++)
+			{
+				const unsigned int h = order[i];
+				const unsigned int a = positionIds[triangles[h]], b = positionIds[triangles[NextHalfEdge(h)]];
+				if(a == b) continue;
+
+				const unsigned long long key = EdgeKey(a, b);
+				size_t slot = (size_t) Mix(key) & mask;
+				while(table[slot].key && table[slot].key != key) slot = (slot + 1) & mask;
+				if(!table[slot].key)
+				{
+					table[slot].key = key;
+					table[slot].first = h;
+				}
+				table[slot].count++;
+			}
+
+			CPM_ADJACENCY_STATS &partition = partitionStats[p];
+			for(size_t i = offsets[p]; i < offsets[p + 1]; i++)
+			{
+				const unsigned int h = order[i];
+				const unsigned int a = positionIds[triangles[h]], b = positionIds[triangles[NextHalfEdge(h)]];
+
+				// sans voisin, le sommet oppos est celui du triangle de l'arte
+				unsigned int neighbor = h;
+				if(a == b) partition.degenerateEdges++;
+				else
+				{
+					const EDGE_SLOT *own = FindEdge(table, EdgeKey(a, b));
+					const EDGE_SLOT *reverse = FindEdge(table, EdgeKey(b, a));
+					if(!reverse) partition.boundaryEdges++;
+					else if(own->first == h) neighbor = reverse->first;
+					else partition.nonManifoldEdges++;
+				}
+
+				adjacency[2 * (size_t) h + 1] = triangles[OppositeHalfEdge(neighbor)];
+			}
+		}
+	});
+
+	ParallelFor(numHalfEdges, CPM_ADJACENCY_PARALLEL_MIN_TRIANGLES, [&](size_t begin, size_t end)
+	{
+		for(size_t h = begin; h < end; h++) adjacency[2 * h] = triangles[h];
+	});
+
+	for(unsigned int p = 0; p < numPartitions; p++)
+	{
+		stats.boundaryEdges += partitionStats[p].boundaryEdges;
+		stats.nonManifoldEdges += partitionStats[p].nonManifoldEdges;
+		stats.degenerateEdges += partitionStats[p].degenerateEdges;
+	}
+	return stats;
+}
+
+CPM_ADJACENCY_STATS BuildMeshAdjacency(CPM_MESH_DATA &mesh)
+{
+	return BuildAdjacency(mesh.triangles, mesh.points, mesh.adjacency);
+}
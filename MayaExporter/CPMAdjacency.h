@@ -0,0 +1,37 @@
+#ifndef CPM_ADJACENCY_H_INCLUDED
+#define CPM_ADJACENCY_H_INCLUDED
+
+#include <vector>
+
+#include "CPMMeshBuffers.h"
+
+struct CPM_MESH_DATA;
+
+//
+//	Adjacence des triangles (option CPM_EXPORT_ADJACENCY) pour les passes de silhouettes et de volumes d'ombre
+//	six indices par triangle, dans l'ordre des primitives "triangles with adjacency" de Direct3D et OpenGL:
+//	v0, a01, v1, a12, v2, a20 o aXY est le sommet oppos  l'arte XY dans le triangle voisin
+//	les artes sont compares par position et non par indice de vertex: l'adjacence traverse les coutures de normales et d'UVs
+//
+//	artes sans voisin: le sommet oppos est celui du triangle lui-mme, le triangle voisin est donc le triangle retourn
+//	et l'arte est toujours une silhouette, ce qu'attendent les volumes d'ombre pour les bords ouverts
+//	arte non-manifold (plus d'un triangle dans un mme sens): seules la premire arte de chaque sens (plus petit indice de triangle)
+//	sont apparies, les autres sont traites comme des bords; une arte dont les deux extrmits sont  la mme position n'a pas de voisin
+//
+#define CPM_ADJACENCY_PARALLEL_MIN_TRIANGLES	(1 << 15)	// en dessous, la construction reste sur le thread appelant
+
+struct CPM_ADJACENCY_STATS
+{
+	CPM_ADJACENCY_STATS() : triangles(0), boundaryEdges(0), nonManifoldEdges(0), degenerateEdges(0) {}
+
+	unsigned int	triangles;
+	unsigned int	boundaryEdges;		// artes sans triangle voisin en sens oppos
+	unsigned int	nonManifoldEdges;	// artes laisses sans voisin parce que d'autres triangles partagent la mme arte
+	unsigned int	degenerateEdges;	// extrmits  la mme position
+};
+
+// adjacency reoit 6 indices par triangle, les rsultats ne dpendent pas du nombre de threads
+CPM_ADJACENCY_STATS BuildAdjacency(const std::vector<unsigned int> &triangles, const VECTOR3_ARRAY<double> &points, std::vector<unsigned int> &adjacency);
+CPM_ADJACENCY_STATS BuildMeshAdjacency(CPM_MESH_DATA &mesh); // remplit mesh.adjacency, aprs la conversion des axes et le dcoupage du mesh
+
+#endif // CPM_ADJACENCY_H_INCLUDED
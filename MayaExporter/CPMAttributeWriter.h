@@ -0,0 +1,163 @@
+#ifndef CPM_ATTRIBUTE_WRITER_H_INCLUDED
+#define CPM_ATTRIBUTE_WRITER_H_INCLUDED
+
+#include <ostream>
+#include <vector>
+
+#include "CPMScalar.h"
+#include "CPMFormat.h"
+#include "CPMExportOptions.h"
+
+//
+//	CPMAttributeWriter: crit un tableau d'attributs dans la prcision T
+//	le type T est choisi une fois par section: aucune conversion de type n'est dcide lment par lment
+//	au format binaire, les lments d'une grande section sont aligns dans le fichier selon GetSectionAlignment
+//
+template<typename T>
+class CPMAttributeWriter
+{
+	public:
+	CPMAttributeWriter(std::ostream &os, unsigned int exportOptions) : m_os(os), m_exportOptions(exportOptions), m_binary((exportOptions & CPM_EXPORT_BINARY) != 0),
+		m_firstComponent(true), m_oldPrecision(0), m_components(0) {}
+
+	void begin(const char *name, const char *tag, unsigned int count, unsigned int components, unsigned short flags = 0)
+	// Rsum: crit l'en-tte de la section
+	// Args: name - nom de la section au format texte
+	//		 tag - identifiant de la section au format binaire
+	//		 count - nombre d'lments
+	//		 components - nombre de composantes par lment
+	//		 flags - CPM_SECTION_* de la section binaire
+	{
+		m_components = components;
+
+		if(m_binary)
+		{
+			const unsigned long long size = (unsigned long long) count * components * sizeof(T);
+			WriteAlignedSectionHeader(m_os, GetSectionAlignment(m_exportOptions, size), tag, count, SCALAR_TRAITS<T>::type, components, size, flags);
+			m_buffer.reserve(BUFFER_SIZE);
+		}
+		else
+		{
+			m_os << name << ": " << count << std::endl;
+			m_oldPrecision = m_os.precision(SCALAR_TRAITS<T>::textDigits);
+		}
+	}
+
+	template<typename S>
+	void write(S value)
+	// Rsum: crit une composante de l'lment actuel
+	{
+		const T converted = SCALAR_TRAITS<T>::convert(value);
+
+		if(m_binary)
+		{
+			m_buffer.push_back(converted);
+			if(m_buffer.size() == BUFFER_SIZE) flush();
+		}
+		else
+		{
+			if(!m_firstComponent) m_os << " ";
+			m_os << (typename SCALAR_TRAITS<T>::TextType) converted;
+			m_firstComponent = false;
+		}
+	}
+
+	template<typename S>
+	void writeArrays(const S *const *arrays, size_t count)
+	// Rsum: crit 'count' lments dont chaque composante est range dans un tableau spar (arrays[composante][lment])
+	{
+		if(m_binary)
+		{
+			flush();
+
+			const size_t block = BUFFER_SIZE / m_components;
+			for(size_t first = 0; first < count; first += block)
+			{
+				const size_t n = count - first < block ? count - first : block;
+				m_buffer.resize(n * m_components);
+
+				T *dst = &m_buffer[0];
+				for(unsigned int c = 0; c < m_components; c++)
+				{
+					const S *src = arrays[c] + first;
+					for(size_t i = 0; i < n; i++) dst[i*m_components + c] = SCALAR_TRAITS<T>::convert(src[i]);
+				}
+				flush();
+			}
+		}
+		else
+		{
+			for(size_t i = 0; i < count; i++)
+			{
+				for(unsigned int c = 0; c < m_components; c++) write(arrays[c][i]);
+				endElement();
+			}
+		}
+	}
+
+	template<typename S>
+	void writeInterleaved(const S *values, size_t count)
+	// Rsum: crit 'count' lments dont les composantes se suivent dans le tableau values
+	{
+		if(m_binary)
+		{
+			flush();
+
+			const size_t total = count * m_components;
+			for(size_t first = 0; first < total; first += BUFFER_SIZE)
+			{
+				const size_t n = total - first < BUFFER_SIZE ? total - first : BUFFER_SIZE;
+				m_buffer.resize(n);
+				for(size_t i = 0; i < n; i++) m_buffer[i] = SCALAR_TRAITS<T>::convert(values[first + i]);
+				flush();
+			}
+		}
+		else
+		{
+			for(size_t i = 0; i < count; i++)
+			{
+				for(unsigned int c = 0; c < m_components; c++) write(values[i*m_components + c]);
+				endElement();
+			}
+		}
+	}
+
+	void endElement()
+	{
+		if(!m_binary) m_os << std::endl;
+		m_firstComponent = true;
+	}
+
+	void end()
+	{
+		if(m_binary)
+		{
+			flush();
+		}
+		else
+		{
+			m_os << "\n\n";
+			m_os.precision(m_oldPrecision);
+		}
+	}
+
+	protected:
+	void flush()
+	{
+		if(!m_buffer.empty()) m_os.write((const char*) &m_buffer[0], m_buffer.size() * sizeof(T));
+		m_buffer.clear();
+	}
+
+	protected:
+	static const size_t		BUFFER_SIZE = 16384;
+
+	std::ostream			&m_os;
+	unsigned int			m_exportOptions;
+	bool					m_binary;
+	bool					m_firstComponent;
+	std::streamsize			m_oldPrecision;
+	unsigned int			m_components;
+	std::vector<T>			m_buffer;
+};
+
+#endif // CPM_ATTRIBUTE_WRITER_H_INCLUDED
@@ -0,0 +1,335 @@
+#include <cstring>
+
+#include "CPMChecksum.h"
+#include "CPMSimd.h"
+
+#if defined(_MSC_VER) && (defined(CPM_X86) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
+#if !defined(CPM_X86) && (defined(__ARM_FEATURE_CRC32) || defined(_M_ARM64))
+#define CPM_ARM_CRC32
+#if !defined(_MSC_VER)
+#include <arm_acle.h>
+#endif
+#endif
+
+#define CRC32C_POLYNOMIAL		0x82F63B78	// polynme de Castagnoli, bits inverss
+#define CRC_LANE_SIZE			8192		// octets de chacun des trois flux calculs simultanment
+#define CHECKSUM_BUFFER_SIZE	(64 * 1024)
+
+
+//
+//	Tables
+//	les fonctions de calcul travaillent sur l'tat du registre (somme inverse): l'tat aprs les octets A puis B est
+//	shift(tat aprs A, taille de B) ^ tat aprs B depuis 0, ce qui permet de calculer trois flux sparment puis de les combiner
+//
+struct CRC_TABLES
+{
+	CRC_TABLES();
+
+	unsigned int	slice[8][256];		// table logicielle, 8 octets par itration
+	unsigned int	shift1[4][256];		// dcalage de l'tat de CRC_LANE_SIZE octets nuls, par octet de l'tat
+	unsigned int	shift2[4][256];		// dcalage de 2 * CRC_LANE_SIZE octets nuls
+};
+
+static const CRC_TABLES &Tables()
+{
+	static const CRC_TABLES tables;
+	return tables;
+}
+
+static unsigned int SoftwareCrc(const CRC_TABLES &t, unsigned int crc, const unsigned char *p, size_t n)
+{
+	for(; n >= 8; p += 8, n -= 8)
+	{
+		unsigned int low, high;
+		memcpy(&low, p, 4);
+		memcpy(&high, p + 4, 4);
+		low ^= crc;
+		crc = t.slice[7][low & 0xff] ^ t.slice[6][(low >> 8) & 0xff] ^ t.slice[5][(low >> 16) & 0xff] ^ t.slice[4][low >> 24] ^
+			t.slice[3][high & 0xff] ^ t.slice[2][(high >> 8) & 0xff] ^ t.slice[1][(high >> 16) & 0xff] ^ t.slice[0][high >> 24];
+	}
+	for(; n; p++, n--) crc = t.slice[0][(crc ^ *p) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+static void BuildShiftTable(const CRC_TABLES &t, unsigned int size, unsigned int table[4][256])
+// Rsum: l'tat est linaire: la table de chaque octet combine le dcalage des 8 bits de cet octet
+{
+	static const unsigned char zeros[CRC_LANE_SIZE] = { 0 };
+
+	unsigned int bits[32];
+	for(unsigned int b = 0; b < 32; b++)
+	{
+		bits[b] = 1u << b;
+		for(unsigned int left = size; left; left -= CRC_LANE_SIZE) bits[b] = SoftwareCrc(t, bits[b], zeros, CRC_LANE_SIZE);
+	}
+
+	for(unsigned int k = 0; k < 4; k++)
+	{
+		for(unsigned int v = 0; v < 256; v++)
+		{
+			unsigned int shifted = 0;
+			for(unsigned int b = 0; b < 8; b++) if(v & (1u << b)) shifted ^= bits[8 * k + b];
+			table[k][v] = shifted;
+		}
+	}
+}
+
+CRC_TABLES::CRC_TABLES()
+{
+	for(unsigned int v = 0; v < 256; v++)
+	{
+		unsigned int crc = v;
+		for(unsigned int b = 0; b < 8; b++) crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLYNOMIAL : 0);
+		slice[0][v] = crc;
+	}
+	for(unsigned int v = 0; v < 256; v++)
+	{
+		for(unsigned int s = 1; s < 8; s++) slice[s][v] = slice[0][slice[s - 1][v] & 0xff] ^ (slice[s - 1][v] >> 8);
+	}
+
+	BuildShiftTable(*this, CRC_LANE_SIZE, shift1);
+	BuildShiftTable(*this, 2 * CRC_LANE_SIZE, shift2);
+}
+
+static inline unsigned int Shift(const unsigned int table[4][256], unsigned int crc)
+{
+	return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^ table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+}
+
+static unsigned int SoftwareCrc(unsigned int crc, const unsigned char *p, size_t n)
+{
+	return SoftwareCrc(Tables(), crc, p, n);
+}
+
+
+//
+//	Instructions crc32
+//
+#if defined(CPM_X86)
+#if defined(_M_X64) || defined(__x86_64__)
+CPM_TARGET_SSE42 static inline unsigned int Crc64(unsigned int crc, const unsigned char *p)
+{
+	unsigned long long value;
+	memcpy(&value, p, 8);
+	return (unsigned int) _mm_crc32_u64(crc, value);
+}
+#else
+CPM_TARGET_SSE42 static inline unsigned int Crc64(unsigned int crc, const unsigned char *p)
+{
+	unsigned int low, high;
+	memcpy(&low, p, 4);
+	memcpy(&high, p + 4, 4);
+	return _mm_crc32_u32(_mm_crc32_u32(crc, low), high);
+}
+#endif
+
+CPM_TARGET_SSE42 static unsigned int HardwareCrc(unsigned int crc, const unsigned char *p, size_t n)
+// Rsum: l'instruction a une latence de 3 cycles pour un dbit d'une par cycle: trois flux indpendants l'occupent entirement
+{
+	if(n >= 3 * CRC_LANE_SIZE)
+	{
+		const CRC_TABLES &t = Tables();
+		do
+		{
+			unsigned int c0 = crc, c1 = 0, c2 = 0;
+			for(const unsigned char *end = p + CRC_LANE_SIZE; p < end; p += 8)
+			{
+				c0 = Crc64(c0, p);
+				c1 = Crc64(c1, p + CRC_LANE_SIZE);
+				c2 = Crc64(c2, p + 2 * CRC_LANE_SIZE);
+			}
+			crc = Shift(t.shift2, c0) ^ Shift(t.shift1, c1) ^ c2;
+			p += 2 * CRC_LANE_SIZE;
+			n -= 3 * CRC_LANE_SIZE;
+		}
+		while(n >= 3 * CRC_LANE_SIZE);
+	}
+
+	for(; n >= 8; p += 8, n -= 8) crc = Crc64(crc, p);
+	for(; n; p++, n--) crc = _mm_crc32_u8(crc, *p);
+	return crc;
+}
+
+static bool HasHardwareCrc()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 20)) != 0;
+#elif defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.2") != 0;
+#else
+	return false;
+#endif
+}
+#elif defined(CPM_ARM_CRC32)
+static unsigned int HardwareCrc(unsigned int crc, const unsigned char *p, size_t n)
+// Rsum: un seul flux, la latence de crc32cx est faible sur les processeurs ARMv8
+{
+	for(; n >= 8; p += 8, n -= 8)
+	{
+		unsigned long long value;
+		memcpy(&value, p, 8);
+		crc = __crc32cd(crc, value);
+	}
+	for(; n; p++, n--) crc = __crc32cb(crc, *p);
+	return crc;
+}
+
+static bool HasHardwareCrc()
+{
+	return true;
+}
+#endif
+
+
+//
+//	Choix de l'implmentation
+//
+typedef unsigned int (*CRC_FUNCTION)(unsigned int crc, const unsigned char *p, size_t n);
+
+struct CRC_IMPLEMENTATION
+{
+	CRC_IMPLEMENTATION() : function(SoftwareCrc), name("software")
+	{
+#if defined(CPM_X86)
+		if(HasHardwareCrc()) { function = HardwareCrc; name = "sse4.2"; }
+#elif defined(CPM_ARM_CRC32)
+		if(HasHardwareCrc()) { function = HardwareCrc; name = "armv8"; }
+#endif
+		Tables();
+	}
+
+	CRC_FUNCTION	function;
+	const char		*name;
+};
+
+static const CRC_IMPLEMENTATION &Implementation()
+{
+	static const CRC_IMPLEMENTATION implementation;
+	return implementation;
+}
+
+unsigned int Crc32c(unsigned int crc, const void *data, size_t size)
+{
+	return ~Implementation().function(~crc, (const unsigned char*) data, size);
+}
+
+const char *Crc32cImplementation()
+{
+	return Implementation().name;
+}
+
+
+//
+//	CPMChecksumStreamBuf
+//
+CPMChecksumStreamBuf::CPMChecksumStreamBuf(std::ostream &os, unsigned int blockSize) :
+	m_os(os), m_blockSize(blockSize ? blockSize : CPM_CHECKSUM_BLOCK_SIZE), m_buffer(CHECKSUM_BUFFER_SIZE), m_crc(0), m_blockUsed(0), m_written(0)
+{
+	setp(&m_buffer[0], &m_buffer[0] + m_buffer.size());
+}
+
+CPMChecksumStreamBuf::~CPMChecksumStreamBuf()
+{
+	flushBuffer();
+}
+
+void CPMChecksumStreamBuf::getChecksums(std::vector<unsigned int> &checksums)
+{
+	flushBuffer();
+
+	checksums = m_checksums;
+	if(m_blockUsed) checksums.push_back(m_crc);
+}
+
+CPMChecksumStreamBuf::int_type CPMChecksumStreamBuf::overflow(int_type c)
+{
+	flushBuffer();
+
+	if(!traits_type::eq_int_type(c, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+
+	return traits_type::not_eof(c);
+}
+
+std::streamsize CPMChecksumStreamBuf::xsputn(const char *s, std::streamsize n)
+// Rsum: les grands tableaux ne passent pas par le tampon
+{
+	if(n <= epptr() - pptr())
+	{
+		memcpy(pptr(), s, (size_t) n);
+		pbump((int) n);
+		return n;
+	}
+
+	flushBuffer();
+	if(n >= (std::streamsize) m_buffer.size()) consume(s, (size_t) n);
+	else
+	{
+		memcpy(pptr(), s, (size_t) n);
+		pbump((int) n);
+	}
+	return n;
+}
+
+int CPMChecksumStreamBuf::sync()
+{
+	flushBuffer();
+	m_os.flush();
+	return m_os ? 0 : -1;
+}
+
+CPMChecksumStreamBuf::pos_type CPMChecksumStreamBuf::seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which)
+// Rsum: seule la position courante peut tre lue (tellp)
+{
+	if(off != 0 || way != std::ios_base::cur || !(which & std::ios_base::out)) return pos_type(off_type(-1));
+
+	return pos_type((off_type) (m_written + (pptr() - pbase())));
+}
+
+void CPMChecksumStreamBuf::consume(const char *data, size_t size)
+{
+	m_os.write(data, size);
+	m_written += size;
+
+	while(size)
+	{
+		const size_t n = size < m_blockSize - m_blockUsed ? size : m_blockSize - m_blockUsed;
+		m_crc = Crc32c(m_crc, data, n);
+		m_blockUsed += (unsigned int) n;
+		data += n;
+		size -= n;
+
+		if(m_blockUsed == m_blockSize)
+		{
+			m_checksums.push_back(m_crc);
+			m_crc = 0;
+			m_blockUsed = 0;
+		}
+	}
+}
+
+void CPMChecksumStreamBuf::flushBuffer()
+{
+	const size_t used = pptr() - pbase();
+	if(used) consume(pbase(), used);
+	setp(&m_buffer[0], &m_buffer[0] + m_buffer.size());
+}
+
+
+//
+//	CPMChecksumOStream
+//
+CPMChecksumOStream::CPMChecksumOStream(std::ostream &os, unsigned int blockSize) :
+	std::ostream(NULL), m_buffer(os, blockSize)
+{
+	rdbuf(&m_buffer);
+}
@@ -0,0 +1,66 @@
+#ifndef CPM_CHECKSUM_H_INCLUDED
+#define CPM_CHECKSUM_H_INCLUDED
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include "CPMFormat.h"
+
+//
+//	Sommes de contrle CRC32C (polynme de Castagnoli), pour dtecter les fichiers corrompus avant de les analyser
+//	instruction crc32 de SSE4.2 (dtecte  l'excution) ou des processeurs ARMv8, table logicielle par tranches de 8 octets sinon
+//	conteneur compress: une somme par bloc dans l'index (CPM_CHUNK_ENTRY::checksum), calcule sur le bloc dcompress
+//	fichier binaire non compress: section CPM_TAG_CHECKSUMS, une somme par bloc de CPM_CHECKSUM_BLOCK_SIZE octets
+//
+unsigned int Crc32c(unsigned int crc, const void *data, size_t size); // crc: 0, puis la somme des octets prcdents pour continuer
+const char *Crc32cImplementation(); // "sse4.2", "armv8" ou "software"
+
+class CPMChecksumStreamBuf : public std::streambuf
+// Transmet le flux  os en calculant au passage la somme de chaque bloc de blockSize octets
+// os doit tre au dbut du fichier: tellp() donne la position dans le fichier, comme pour CPMChunkedStreamBuf
+{
+	public:
+	CPMChecksumStreamBuf(std::ostream &os, unsigned int blockSize = CPM_CHECKSUM_BLOCK_SIZE);
+	virtual ~CPMChecksumStreamBuf();
+
+	unsigned int getBlockSize() const { return m_blockSize; }
+
+	// sommes des octets reus jusqu'ici: les blocs complets puis, s'il n'est pas vide, le bloc en cours
+	// les octets crits ensuite continuent d'tre compts, sans modifier les sommes dj retournes
+	void getChecksums(std::vector<unsigned int> &checksums);
+
+	protected:
+	virtual int_type overflow(int_type c);
+	virtual std::streamsize xsputn(const char *s, std::streamsize n);
+	virtual int sync();
+	virtual pos_type seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which);
+
+	void consume(const char *data, size_t size); // somme puis criture dans m_os
+	void flushBuffer();
+
+	protected:
+	std::ostream				&m_os;
+	unsigned int				m_blockSize;
+	std::vector<char>			m_buffer;
+
+	std::vector<unsigned int>	m_checksums;	// blocs complets
+	unsigned int				m_crc;			// bloc en cours
+	unsigned int				m_blockUsed;
+	unsigned long long			m_written;		// octets transmis  m_os
+};
+
+class CPMChecksumOStream : public std::ostream
+{
+	public:
+	CPMChecksumOStream(std::ostream &os, unsigned int blockSize = CPM_CHECKSUM_BLOCK_SIZE);
+
+	unsigned int getBlockSize() const { return m_buffer.getBlockSize(); }
+	void getChecksums(std::vector<unsigned int> &checksums) { m_buffer.getChecksums(checksums); }
+
+	protected:
+	CPMChecksumStreamBuf	m_buffer;
+};
+
+#endif // CPM_CHECKSUM_H_INCLUDED
@@ -0,0 +1,373 @@
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+#include "CPMChunkedStream.h"
+#include "CPMChecksum.h"
+
+
+//
+//	CPMChunkedStreamBuf
+//
+CPMChunkedStreamBuf::CPMChunkedStreamBuf(std::ostream &os, CPM_CODEC codec, unsigned int chunkSize) :
+	m_os(os), m_codec(codec), m_chunkSize(chunkSize), m_closed(false), m_offset(0), m_start(std::chrono::steady_clock::now())
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	CPM_CONTAINER_HEADER header;
+	memcpy(header.magic, CPM_CONTAINER_MAGIC, 4);
+	header.version = CPM_CONTAINER_VERSION;
+	header.codec = codec;
+	header.chunkSize = chunkSize;
+
+	WriteBinary(m_os, header);
+	m_offset = sizeof(header);
+
+	resetBuffer();
+}
+
+CPMChunkedStreamBuf::~CPMChunkedStreamBuf()
+{
+	close();
+}
+
+const CPM_CONTAINER_STATS &CPMChunkedStreamBuf::getStats() const
+{
+	return m_stats;
+}
+
+CPMChunkedStreamBuf::COMPRESSED_CHUNK CPMChunkedStreamBuf::CompressChunk(CPM_CODEC codec, const std::shared_ptr<std::string> &raw)
+// Rsum: calcule la somme de contrle et compresse un bloc sur un thread du pool, le bloc est stock tel quel s'il ne se compresse pas
+{
+	COMPRESSED_CHUNK chunk;
+	chunk.rawSize = (unsigned int) raw->size();
+	chunk.codec = codec;
+	chunk.checksum = Crc32c(0, raw->data(), raw->size());
+
+	if(codec == CPM_CODEC_STORE || !CompressBlock(codec, raw->data(), raw->size(), chunk.data))
+	{
+		chunk.codec = CPM_CODEC_STORE;
+		chunk.data.swap(*raw);
+	}
+
+	return chunk;
+}
+
+CPMChunkedStreamBuf::int_type CPMChunkedStreamBuf::overflow(int_type c)
+// Rsum: appele quand le bloc courant est plein
+{
+	if(m_closed) return traits_type::eof();
+
+	submitChunk();
+
+	if(!traits_type::eq_int_type(c, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+
+	return traits_type::not_eof(c);
+}
+
+CPMChunkedStreamBuf::pos_type CPMChunkedStreamBuf::seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which)
+// Rsum: seule la position courante peut tre lue (tellp), en octets non compresss
+{
+	if(off != 0 || way != std::ios_base::cur || !(which & std::ios_base::out)) return pos_type(off_type(-1));
+
+	return pos_type((off_type) (m_stats.rawSize + (pptr() - pbase())));
+}
+
+void CPMChunkedStreamBuf::resetBuffer()
+{
+	m_buffer.resize(m_chunkSize);
+	setp(&m_buffer[0], &m_buffer[0] + m_chunkSize);
+}
+
+void CPMChunkedStreamBuf::submitChunk()
+// Rsum: confie le bloc courant au pool de threads et crit les blocs dj compresss
+{
+	const size_t used = pptr() - pbase();
+	if(used == 0) return;
+
+	std::shared_ptr<std::string> raw(new std::string);
+	raw->swap(m_buffer);
+	raw->resize(used);
+
+	const CPM_CODEC codec = m_codec;
+	m_pending.push_back(m_pool.submit([codec, raw]() { return CompressChunk(codec, raw); }));
+	m_stats.rawSize += used;
+
+	resetBuffer();
+
+	// au-del de deux blocs en attente par thread, l'appelant attend la compression
+	writeCompletedChunks(2 * m_pool.size());
+}
+
+void CPMChunkedStreamBuf::writeCompletedChunks(size_t maxPending)
+// Rsum: crit dans l'ordre les blocs compresss disponibles
+// Args: maxPending - nombre de blocs pouvant rester en attente, en attendant leur compression si ncessaire
+{
+	while(!m_pending.empty())
+	{
+		if(m_pending.size() <= maxPending && m_pending.front().wait_for(std::chrono::seconds(0)) != std::future_status::ready) break;
+
+		COMPRESSED_CHUNK chunk = m_pending.front().get();
+		m_pending.pop_front();
+
+		CPM_CHUNK_ENTRY entry;
+		entry.offset = m_offset;
+		entry.size = (unsigned int) chunk.data.size();
+		entry.rawSize = chunk.rawSize;
+		entry.codec = chunk.codec;
+		entry.checksum = chunk.checksum;
+		m_index.push_back(entry);
+
+		m_os.write(chunk.data.data(), chunk.data.size());
+		m_offset += chunk.data.size();
+	}
+}
+
+bool CPMChunkedStreamBuf::close()
+{
+	if(m_closed) return m_os.good();
+
+	submitChunk();
+	writeCompletedChunks(0);
+
+	CPM_CONTAINER_TRAILER trailer;
+	trailer.indexOffset = m_offset;
+	trailer.rawSize = m_stats.rawSize;
+	trailer.chunkCount = (unsigned int) m_index.size();
+	memcpy(trailer.magic, CPM_CONTAINER_MAGIC, 4);
+
+	if(!m_index.empty()) m_os.write((const char*) &m_index[0], m_index.size() * sizeof(CPM_CHUNK_ENTRY));
+	WriteBinary(m_os, trailer);
+	m_os.flush();
+
+	m_stats.compressedSize = m_offset + m_index.size() * sizeof(CPM_CHUNK_ENTRY) + sizeof(trailer);
+	m_stats.chunkCount = trailer.chunkCount;
+	m_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+
+	m_closed = true;
+	setp(NULL, NULL);
+
+	return m_os.good();
+}
+
+
+//
+//	CPMChunkedOStream
+//
+CPMChunkedOStream::CPMChunkedOStream(std::ostream &os, CPM_CODEC codec, unsigned int chunkSize) :
+	std::ostream(NULL), m_buffer(os, codec, chunkSize)
+{
+	rdbuf(&m_buffer);
+}
+
+bool CPMChunkedOStream::close()
+{
+	return m_buffer.close();
+}
+
+const CPM_CONTAINER_STATS &CPMChunkedOStream::getStats() const
+{
+	return m_buffer.getStats();
+}
+
+
+//
+//	CPMChunkedReader
+//
+CPMChunkedReader::CPMChunkedReader() : m_is(NULL)
+{
+	memset(&m_header, 0, sizeof(m_header));
+	memset(&m_trailer, 0, sizeof(m_trailer));
+}
+
+bool CPMChunkedReader::open(std::istream &is)
+{
+	m_is = &is;
+	m_index.clear();
+
+	is.seekg(0, std::ios::end);
+	const unsigned long long fileSize = (unsigned long long) is.tellg();
+	if(fileSize < sizeof(CPM_CONTAINER_HEADER) + sizeof(CPM_CONTAINER_TRAILER)) return false;
+
+	is.seekg(0, std::ios::beg);
+	is.read((char*) &m_header, sizeof(m_header));
+	is.seekg(fileSize - sizeof(m_trailer), std::ios::beg);
+	is.read((char*) &m_trailer, sizeof(m_trailer));
+	if(!is) return false;
+
+	if(memcmp(m_header.magic, CPM_CONTAINER_MAGIC, 4) != 0 || memcmp(m_trailer.magic, CPM_CONTAINER_MAGIC, 4) != 0) return false;
+	if(m_header.version < 1 || m_header.version > CPM_CONTAINER_VERSION) return false;
+	if(m_trailer.indexOffset + (unsigned long long) m_trailer.chunkCount * sizeof(CPM_CHUNK_ENTRY) + sizeof(m_trailer) != fileSize) return false;
+
+	m_index.resize(m_trailer.chunkCount);
+	is.seekg(m_trailer.indexOffset, std::ios::beg);
+	if(!m_index.empty()) is.read((char*) &m_index[0], m_index.size() * sizeof(CPM_CHUNK_ENTRY));
+	if(!is) return false;
+
+	// les blocs doivent se suivre entre l'en-tte et l'index
+	unsigned long long offset = sizeof(m_header), rawSize = 0;
+	for(size_t i = 0; i < m_index.size(); i++)
+	{
+		if(m_index[i].offset != offset || m_index[i].rawSize > m_header.chunkSize) return false;
+
+		offset += m_index[i].size;
+		rawSize += m_index[i].rawSize;
+	}
+
+	return offset == m_trailer.indexOffset && rawSize == m_trailer.rawSize;
+}
+
+CPM_CODEC CPMChunkedReader::getCodec() const
+{
+	return (CPM_CODEC) m_header.codec;
+}
+
+unsigned int CPMChunkedReader::getChunkCount() const
+{
+	return (unsigned int) m_index.size();
+}
+
+const CPM_CHUNK_ENTRY &CPMChunkedReader::getChunk(unsigned int i) const
+{
+	return m_index[i];
+}
+
+unsigned long long CPMChunkedReader::getRawSize() const
+{
+	return m_trailer.rawSize;
+}
+
+unsigned int CPMChunkedReader::getChunkSize() const
+{
+	return m_header.chunkSize;
+}
+
+bool CPMChunkedReader::hasChecksums() const
+{
+	return m_header.version >= 2;
+}
+
+bool CPMChunkedReader::decompressChunk(unsigned int i, const char *compressed, char *data) const
+{
+	const CPM_CHUNK_ENTRY &entry = m_index[i];
+	if(entry.rawSize && !DecompressBlock((CPM_CODEC) entry.codec, compressed, entry.size, data, entry.rawSize)) return false;
+
+	return !hasChecksums() || Crc32c(0, data, entry.rawSize) == entry.checksum;
+}
+
+bool CPMChunkedReader::readChunk(unsigned int i, std::string &data)
+// Rsum: lit et dcompresse le bloc i uniquement
+{
+	if(i >= m_index.size()) return false;
+	const CPM_CHUNK_ENTRY &entry = m_index[i];
+
+	std::string compressed(entry.size, '\0');
+	m_is->seekg(entry.offset, std::ios::beg);
+	if(entry.size) m_is->read(&compressed[0], entry.size);
+	if(!*m_is) return false;
+
+	data.resize(entry.rawSize);
+	return decompressChunk(i, compressed.data(), entry.rawSize ? &data[0] : NULL);
+}
+
+bool CPMChunkedReader::readAll(std::string &data)
+// Rsum: lit tous les blocs en une fois puis les dcompresse en parallle, chacun  sa position dans data
+{
+	if(m_index.empty())
+	{
+		data.clear();
+		return true;
+	}
+
+	const unsigned long long begin = m_index[0].offset;
+	std::string compressed((size_t) (m_trailer.indexOffset - begin), '\0');
+	m_is->seekg(begin, std::ios::beg);
+	if(!compressed.empty()) m_is->read(&compressed[0], compressed.size());
+	if(!*m_is) return false;
+
+	std::vector<size_t> rawOffsets(m_index.size());
+	size_t rawOffset = 0;
+	for(size_t i = 0; i < m_index.size(); i++)
+	{
+		rawOffsets[i] = rawOffset;
+		rawOffset += m_index[i].rawSize;
+	}
+	data.resize(rawOffset);
+
+	std::atomic<bool> ok(true);
+	const std::vector<CPM_CHUNK_ENTRY> &index = m_index;
+	ParallelFor(m_index.size(), 1, [&](size_t first, size_t last)
+	{
+		for(size_t i = first; i < last; i++)
+		{
+			if(index[i].rawSize == 0) continue;
+
+			if(!decompressChunk((unsigned int) i, &compressed[(size_t) (index[i].offset - begin)], &data[rawOffsets[i]])) ok = false;
+		}
+	});
+
+	return ok;
+}
+
+bool CPMChunkedReader::validate(std::vector<unsigned int> &corrupted)
+// Rsum: lit les blocs par lots et les vrifie en parallle, la mmoire utilise est borne par la taille d'un lot
+{
+	corrupted.clear();
+	if(m_index.empty()) return true;
+
+	const size_t batchSize = 4 * (size_t) GetWorkerCount();
+	std::vector<char> valid(m_index.size());
+	std::string compressed;
+	for(size_t batch = 0; batch < m_index.size(); batch += batchSize)
+	{
+		const size_t end = std::min(batch + batchSize, m_index.size());
+		const unsigned long long begin = m_index[batch].offset;
+
+		compressed.resize((size_t) (m_index[end - 1].offset + m_index[end - 1].size - begin));
+		m_is->clear();
+		m_is->seekg(begin, std::ios::beg);
+		if(!compressed.empty()) m_is->read(&compressed[0], compressed.size());
+		if(!*m_is) return false;
+
+		const std::vector<CPM_CHUNK_ENTRY> &index = m_index;
+		ParallelFor(end - batch, 1, [&](size_t first, size_t last)
+		{
+			std::string data;
+			for(size_t i = batch + first; i < batch + last; i++)
+			{
+				data.resize(index[i].rawSize);
+				valid[i] = decompressChunk((unsigned int) i, &compressed[(size_t) (index[i].offset - begin)], index[i].rawSize ? &data[0] : NULL);
+			}
+		});
+	}
+
+	for(size_t i = 0; i < valid.size(); i++) if(!valid[i]) corrupted.push_back((unsigned int) i);
+	return true;
+}
+
+bool CPMChunkedReader::readRange(unsigned long long offset, size_t size, std::string &data)
+// Rsum: tous les blocs sauf le dernier ont la taille m_header.chunkSize, le premier bloc concern est trouv sans parcourir l'index
+{
+	data.clear();
+	if(offset + size > m_trailer.rawSize || (size && !m_header.chunkSize)) return false;
+	data.reserve(size);
+
+	std::string chunk;
+	for(unsigned long long position = offset; position < offset + size; )
+	{
+		const unsigned int i = (unsigned int) (position / m_header.chunkSize);
+		if(!readChunk(i, chunk)) return false;
+
+		const size_t first = (size_t) (position - (unsigned long long) i * m_header.chunkSize);
+		if(first >= chunk.size()) return false;
+		const size_t n = std::min<size_t>(chunk.size() - first, (size_t) (offset + size - position));
+
+		data.append(chunk, first, n);
+		position += n;
+	}
+	return true;
+}
@@ -0,0 +1,118 @@
+#ifndef CPM_CHUNKED_STREAM_H_INCLUDED
+#define CPM_CHUNKED_STREAM_H_INCLUDED
+
+#include <ostream>
+#include <istream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <future>
+#include <memory>
+#include <chrono>
+
+#include "CPMFormat.h"
+#include "CPMCompression.h"
+#include "CPMParallel.h"
+
+//
+//	Ecriture et lecture du conteneur compress par blocs (voir CPMFormat.h)
+//
+struct CPM_CONTAINER_STATS
+{
+	unsigned long long	rawSize;			// octets reus
+	unsigned long long	compressedSize;		// octets crits, en-tte et index compris
+	unsigned int		chunkCount;
+	double				seconds;			// dure entre l'ouverture et la fermeture du conteneur
+};
+
+class CPMChunkedStreamBuf : public std::streambuf
+// Dcoupe le flux en blocs de taille fixe, compresss sur un pool de threads pendant que l'appelant continue d'crire
+// les blocs sont crits dans leur ordre d'arrive, le nombre de blocs en attente est limit pour borner la mmoire
+{
+	public:
+	CPMChunkedStreamBuf(std::ostream &os, CPM_CODEC codec, unsigned int chunkSize = CPM_CONTAINER_CHUNK_SIZE);
+	virtual ~CPMChunkedStreamBuf();
+
+	bool close(); // crit le dernier bloc, l'index et le trailer: retourne false en cas d'erreur d'criture
+
+	const CPM_CONTAINER_STATS &getStats() const;
+
+	protected:
+	struct COMPRESSED_CHUNK
+	{
+		std::string		data;
+		unsigned int	rawSize;
+		CPM_CODEC		codec;
+		unsigned int	checksum;
+	};
+
+	static COMPRESSED_CHUNK CompressChunk(CPM_CODEC codec, const std::shared_ptr<std::string> &raw);
+
+	virtual int_type overflow(int_type c);
+	virtual pos_type seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which);
+
+	void submitChunk();
+	void writeCompletedChunks(size_t maxPending);
+	void resetBuffer();
+
+	protected:
+	std::ostream				&m_os;
+	CPM_CODEC					m_codec;
+	unsigned int				m_chunkSize;
+	bool						m_closed;
+
+	std::string					m_buffer;
+	std::deque< std::future<COMPRESSED_CHUNK> >	m_pending;
+	std::vector<CPM_CHUNK_ENTRY>	m_index;
+	unsigned long long			m_offset;
+
+	CPM_CONTAINER_STATS			m_stats;
+	std::chrono::steady_clock::time_point	m_start;
+
+	CPMThreadPool				m_pool; // en dernier: ses threads sont arrts avant la destruction des autres membres
+};
+
+class CPMChunkedOStream : public std::ostream
+{
+	public:
+	CPMChunkedOStream(std::ostream &os, CPM_CODEC codec, unsigned int chunkSize = CPM_CONTAINER_CHUNK_SIZE);
+
+	bool close();
+	const CPM_CONTAINER_STATS &getStats() const;
+
+	protected:
+	CPMChunkedStreamBuf		m_buffer;
+};
+
+class CPMChunkedReader
+// Lecture d'un conteneur: bloc par bloc (accs direct grce  l'index) ou en entier avec une dcompression parallle
+// la somme de contrle de chaque bloc dcompress est vrifie: un bloc corrompu fait chouer la lecture au lieu d'tre transmis
+{
+	public:
+	CPMChunkedReader();
+
+	bool open(std::istream &is); // lit et vrifie l'en-tte, le trailer et l'index
+
+	CPM_CODEC				getCodec() const;
+	unsigned int			getChunkCount() const;
+	const CPM_CHUNK_ENTRY	&getChunk(unsigned int i) const;
+	unsigned long long		getRawSize() const;
+	unsigned int			getChunkSize() const; // taille des blocs dcompresss, sauf le dernier
+	bool					hasChecksums() const; // false pour les conteneurs de version 1
+
+	bool readChunk(unsigned int i, std::string &data);
+	bool readAll(std::string &data);
+	bool readRange(unsigned long long offset, size_t size, std::string &data); // octets [offset, offset + size) du fichier CPM, seuls les blocs concerns sont lus
+	bool validate(std::vector<unsigned int> &corrupted); // vrifie tous les blocs sur tous les coeurs: corrupted reoit les blocs invalides, false si la lecture choue
+
+	protected:
+	bool decompressChunk(unsigned int i, const char *compressed, char *data) const; // dcompresse puis vrifie la somme
+
+	protected:
+	std::istream					*m_is;
+	CPM_CONTAINER_HEADER			m_header;
+	CPM_CONTAINER_TRAILER			m_trailer;
+	std::vector<CPM_CHUNK_ENTRY>	m_index;
+};
+
+#endif // CPM_CHUNKED_STREAM_H_INCLUDED
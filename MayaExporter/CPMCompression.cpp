@@ -0,0 +1,96 @@
+#include <cstring>
+
+#include "CPMCompression.h"
+
+#ifdef CPM_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef CPM_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+const char *CodecName(CPM_CODEC codec)
+{
+	switch(codec)
+	{
+		case CPM_CODEC_LZ4:		return "lz4";
+		case CPM_CODEC_ZSTD:	return "zstd";
+		default:				return "store";
+	}
+}
+
+bool IsCodecAvailable(CPM_CODEC codec)
+{
+	switch(codec)
+	{
+		case CPM_CODEC_STORE:	return true;
+#ifdef CPM_HAVE_LZ4
+		case CPM_CODEC_LZ4:		return true;
+#endif
+#ifdef CPM_HAVE_ZSTD
+		case CPM_CODEC_ZSTD:	return true;
+#endif
+		default:				return false;
+	}
+}
+
+bool CompressBlock(CPM_CODEC codec, const char *src, size_t size, std::string &dst)
+{
+#if !defined(CPM_HAVE_LZ4) && !defined(CPM_HAVE_ZSTD)
+	(void) src; (void) size; (void) dst;
+#endif
+	switch(codec)
+	{
+#ifdef CPM_HAVE_LZ4
+		case CPM_CODEC_LZ4:
+		{
+			dst.resize(LZ4_compressBound((int) size));
+			const int written = LZ4_compress_default(src, &dst[0], (int) size, (int) dst.size());
+			if(written <= 0 || (size_t) written >= size) return false;
+
+			dst.resize(written);
+			return true;
+		}
+#endif
+
+#ifdef CPM_HAVE_ZSTD
+		case CPM_CODEC_ZSTD:
+		{
+			dst.resize(ZSTD_compressBound(size));
+			const size_t written = ZSTD_compress(&dst[0], dst.size(), src, size, CPM_ZSTD_ARCHIVE_LEVEL);
+			if(ZSTD_isError(written) || written >= size) return false;
+
+			dst.resize(written);
+			return true;
+		}
+#endif
+
+		default:
+			return false;
+	}
+}
+
+bool DecompressBlock(CPM_CODEC codec, const char *src, size_t size, char *dst, size_t rawSize)
+{
+	switch(codec)
+	{
+		case CPM_CODEC_STORE:
+			if(size != rawSize) return false;
+			memcpy(dst, src, size);
+			return true;
+
+#ifdef CPM_HAVE_LZ4
+		case CPM_CODEC_LZ4:
+			return LZ4_decompress_safe(src, dst, (int) size, (int) rawSize) == (int) rawSize;
+#endif
+
+#ifdef CPM_HAVE_ZSTD
+		case CPM_CODEC_ZSTD:
+			return ZSTD_decompress(dst, rawSize, src, size) == rawSize;
+#endif
+
+		default:
+			return false;
+	}
+}
@@ -0,0 +1,30 @@
+#ifndef CPM_COMPRESSION_H_INCLUDED
+#define CPM_COMPRESSION_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+
+//
+//	Compression de blocs indpendants
+//	les bibliothques sont optionnelles: CPM_HAVE_LZ4 et CPM_HAVE_ZSTD sont dfinis par le projet quand elles sont disponibles
+//	(toujours pour le plugin, qui lie lz4.lib et zstd.lib; par Tools/CMakeLists.txt s'il les trouve)
+//
+enum CPM_CODEC
+{
+	CPM_CODEC_STORE		= 0,	// bloc stock sans compression
+	CPM_CODEC_LZ4		= 1,	// prrglage chargement rapide
+	CPM_CODEC_ZSTD		= 2,	// prrglage archivage
+};
+
+#define CPM_ZSTD_ARCHIVE_LEVEL		9	// au-del, le gain en taille est ngligeable sur les fichiers CPM pour une compression bien plus lente
+
+const char *CodecName(CPM_CODEC codec);
+bool IsCodecAvailable(CPM_CODEC codec);
+
+// Compresse size octets dans dst, retourne false si le codec n'est pas disponible ou si le bloc ne se compresse pas
+bool CompressBlock(CPM_CODEC codec, const char *src, size_t size, std::string &dst);
+
+// Dcompresse exactement rawSize octets dans dst
+bool DecompressBlock(CPM_CODEC codec, const char *src, size_t size, char *dst, size_t rawSize);
+
+#endif // CPM_COMPRESSION_H_INCLUDED
@@ -0,0 +1,89 @@
+#ifndef CPM_DAG_VISIBILITY_H_INCLUDED
+#define CPM_DAG_VISIBILITY_H_INCLUDED
+
+#include <vector>
+#include <unordered_map>
+
+//
+//	Visibilit effective des meshes d'une scne
+//	un mesh est export si aucun noeud de son chemin n'est cach: attribut visibility, objet intermdiaire, ou override
+//	d'affichage dsactiv (c'est par drawOverride qu'un calque d'affichage cach masque ses membres)
+//
+//	le parcours descend depuis la racine et n'entre jamais dans le sous-arbre d'un noeud cach; l'tat propre de chaque noeud
+//	est lu une seule fois et mmoris, mme si le noeud est instanci sous plusieurs parents: la collecte est linaire
+//	en nombre de chemins parcourus au lieu de remonter les anctres de chaque mesh
+//
+enum CPM_NODE_VISIBILITY
+{
+	CPM_NODE_HIDDEN				= 0x1,	// visibility dsactiv
+	CPM_NODE_INTERMEDIATE		= 0x2,	// objet intermdiaire (forme d'origine d'une dformation...)
+	CPM_NODE_OVERRIDE_HIDDEN	= 0x4,	// overrideEnabled et overrideVisibility dsactiv, en particulier par un calque cach
+};
+
+struct CPM_VISIBILITY_STATS
+{
+	CPM_VISIBILITY_STATS() : visitedNodes(0), evaluatedNodes(0), prunedSubtrees(0), visibleShapes(0), hiddenShapes(0) {}
+
+	unsigned int	visitedNodes;	// chemins parcourus
+	unsigned int	evaluatedNodes;	// noeuds dont l'tat a t lu, les autres visites sont servies par le cache
+	unsigned int	prunedSubtrees;
+	unsigned int	visibleShapes;
+	unsigned int	hiddenShapes;	// formes caches elles-mmes; celles des sous-arbres lagus ne sont pas visites
+};
+
+template<typename KEY, typename HASH>
+class CPMVisibilityCache
+// Etat propre de chaque noeud (combinaison de CPM_NODE_VISIBILITY), lu  la premire visite du noeud
+{
+	public:
+	template<typename EVALUATE>
+	unsigned int get(const KEY &node, EVALUATE evaluate, CPM_VISIBILITY_STATS &stats)
+	{
+		typename std::unordered_map<KEY, unsigned int, HASH>::const_iterator it = m_states.find(node);
+		if(it != m_states.end()) return it->second;
+
+		stats.evaluatedNodes++;
+		const unsigned int state = evaluate();
+		m_states.insert(std::make_pair(node, state));
+		return state;
+	}
+
+	void clear() { m_states.clear(); }
+
+	protected:
+	std::unordered_map<KEY, unsigned int, HASH>	m_states;
+};
+
+//
+//	Parcours en profondeur avec lagage
+//	DAG_ITERATOR: isDone(), next(), prune() (les descendants du noeud courant ne sont pas visits), isShape(),
+//	node() (cl du cache), state() (lecture de l'tat propre du noeud courant) et path() (chemin du noeud courant)
+//
+template<typename DAG_ITERATOR, typename CACHE, typename PATH>
+CPM_VISIBILITY_STATS CollectVisibleShapes(DAG_ITERATOR &it, CACHE &cache, std::vector<PATH> &shapes)
+{
+	CPM_VISIBILITY_STATS stats;
+	for(; !it.isDone(); it.next())
+	{
+		stats.visitedNodes++;
+		const unsigned int state = cache.get(it.node(), [&]() { return it.state(); }, stats);
+
+		if(it.isShape())
+		{
+			if(state) stats.hiddenShapes++;
+			else
+			{
+				stats.visibleShapes++;
+				shapes.push_back(it.path());
+			}
+		}
+		else if(state)
+		{
+			stats.prunedSubtrees++;
+			it.prune();
+		}
+	}
+	return stats;
+}
+
+#endif // CPM_DAG_VISIBILITY_H_INCLUDED
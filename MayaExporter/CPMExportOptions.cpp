@@ -0,0 +1,153 @@
+#include <cstring>
+
+#include "CPMExportOptions.h"
+
+CPM_PRECISION GetExportPrecision(unsigned int exportOptions)
+// Rsum: dtermine la prcision de chaque attribut  partir des options d'exportation
+{
+	CPM_PRECISION precision;
+
+	precision.positions = (exportOptions & CPM_EXPORT_DOUBLE) != 0 ? CPM_SCALAR_DOUBLE : CPM_SCALAR_FLOAT;
+
+	const CPM_SCALAR_TYPE vectors = (exportOptions & CPM_EXPORT_HALF_VECTORS) != 0 ? CPM_SCALAR_HALF : CPM_SCALAR_FLOAT;
+	precision.normals = vectors;
+	precision.tangents = vectors;
+	precision.binormals = vectors;
+
+	precision.uvs = CPM_SCALAR_FLOAT;
+	precision.colors = CPM_SCALAR_FLOAT;
+
+	return precision;
+}
+
+AXIS_CONVERSION GetExportAxisConversion(unsigned int exportOptions)
+// Rsum: traduit les options d'inversion des axes et du sens des faces en une conversion applique aux tableaux entiers
+{
+	AXIS_CONVERSION conversion;
+
+	conversion.invert[0] = (exportOptions & CPM_EXPORT_INVERTX) != 0;
+	conversion.invert[1] = (exportOptions & CPM_EXPORT_INVERTY) != 0;
+	conversion.invert[2] = (exportOptions & CPM_EXPORT_INVERTZ) != 0;
+	conversion.invertV = (exportOptions & CPM_EXPORT_INVERTV) != 0;
+	conversion.swapWinding = (exportOptions & CPM_EXPORT_COUNTERCLOCKWISE) == 0;
+
+	return conversion;
+}
+
+bool IsExportCompressed(unsigned int exportOptions)
+{
+	return (exportOptions & (CPM_EXPORT_COMPRESS_FAST | CPM_EXPORT_COMPRESS_ARCHIVE)) != 0;
+}
+
+CPM_CODEC GetExportCodec(unsigned int exportOptions)
+{
+	if(exportOptions & CPM_EXPORT_COMPRESS_FAST) return CPM_CODEC_LZ4;
+	if(exportOptions & CPM_EXPORT_COMPRESS_ARCHIVE) return CPM_CODEC_ZSTD;
+	return CPM_CODEC_STORE;
+}
+
+
+//
+//	Alignement des sections
+//
+static unsigned int s_pageAlignment = CPM_DEFAULT_PAGE_ALIGNMENT;
+
+unsigned int GetPageAlignment()
+{
+	return s_pageAlignment;
+}
+
+void SetPageAlignment(unsigned int alignment)
+{
+	unsigned int power = CPM_MIN_SECTION_ALIGNMENT;
+	while(power < alignment && power < (1u << 30)) power <<= 1;
+	s_pageAlignment = power;
+}
+
+unsigned int GetSectionAlignment(unsigned int exportOptions)
+{
+	return (exportOptions & CPM_EXPORT_PAGE_ALIGNED) ? s_pageAlignment : CPM_MIN_SECTION_ALIGNMENT;
+}
+
+unsigned int GetSectionAlignment(unsigned int exportOptions, unsigned long long size)
+// Rsum: une petite section n'est pas aligne, son remplissage coterait plus que la copie qu'il vite
+{
+	const unsigned int alignment = GetSectionAlignment(exportOptions);
+	return size >= alignment ? alignment : 1;
+}
+
+
+//
+//	Noms des options
+//
+struct EXPORT_OPTION_NAME
+{
+	CPM_POLYEXPORT_OPTION	option;
+	const char				*name;
+};
+
+static const EXPORT_OPTION_NAME g_optionNames[] =
+{
+	{ CPM_EXPORT_NORMALS,				"normals" },
+	{ CPM_EXPORT_UVS,					"uvs" },
+	{ CPM_EXPORT_TGT_BINORMALS,			"tangents" },
+	{ CPM_EXPORT_COLORS,				"colors" },
+	{ CPM_EXPORT_INVERTX,				"invertX" },
+	{ CPM_EXPORT_INVERTY,				"invertY" },
+	{ CPM_EXPORT_INVERTZ,				"invertZ" },
+	{ CPM_EXPORT_JOINMESHES,			"joinMeshes" },
+	{ CPM_EXPORT_DOUBLE,				"double" },
+	{ CPM_EXPORT_COUNTERCLOCKWISE,		"counterClockwise" },
+	{ CPM_EXPORT_MATERIALSETS,			"materials" },
+	{ CPM_EXPORT_TEXTURENAMES,			"textureNames" },
+	{ CPM_EXPORT_TRUNCATE_TEXTURENAMES,	"truncateTextureNames" },
+	{ CPM_EXPORT_INVERTU,				"invertU" },
+	{ CPM_EXPORT_INVERTV,				"invertV" },
+	{ CPM_EXPORT_OBJECT_RELATIVE,		"objectRelative" },
+	{ CPM_EXPORT_BINARY,				"binary" },
+	{ CPM_EXPORT_HALF_VECTORS,			"halfVectors" },
+	{ CPM_EXPORT_COMPRESS_FAST,			"compressFast" },
+	{ CPM_EXPORT_COMPRESS_ARCHIVE,		"compressArchive" },
+	{ CPM_EXPORT_WELD_BY_VALUE,			"weldByValue" },
+	{ CPM_EXPORT_STREAMING,				"streaming" },
+	{ CPM_EXPORT_SUBMESHES,				"submeshes" },
+	{ CPM_EXPORT_SPLIT_16BIT,			"split16" },
+	{ CPM_EXPORT_INDEX_CODEC,			"indexCodec" },
+	{ CPM_EXPORT_INTERLEAVED,			"interleaved" },
+	{ CPM_EXPORT_PAGE_ALIGNED,			"pageAligned" },
+	{ CPM_EXPORT_ADJACENCY,				"adjacency" },
+	{ CPM_EXPORT_CLEAN_TRIANGLES,		"cleanTriangles" },
+	{ CPM_EXPORT_MIKKTSPACE,			"mikkTSpace" },
+};
+
+unsigned int GetExportOptionCount()
+{
+	return sizeof(g_optionNames) / sizeof(g_optionNames[0]);
+}
+
+CPM_POLYEXPORT_OPTION GetExportOption(unsigned int i)
+{
+	return g_optionNames[i].option;
+}
+
+const char *ExportOptionName(CPM_POLYEXPORT_OPTION option)
+{
+	for(unsigned int i = 0; i < GetExportOptionCount(); i++)
+	{
+		if(g_optionNames[i].option == option) return g_optionNames[i].name;
+	}
+	return "";
+}
+
+bool ParseExportOption(const char *name, CPM_POLYEXPORT_OPTION &option)
+{
+	for(unsigned int i = 0; i < GetExportOptionCount(); i++)
+	{
+		if(strcmp(g_optionNames[i].name, name) == 0)
+		{
+			option = g_optionNames[i].option;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,70 @@
+#ifndef CPM_EXPORT_OPTIONS_H_INCLUDED
+#define CPM_EXPORT_OPTIONS_H_INCLUDED
+
+#include "CPMScalar.h"
+#include "CPMVertexKernels.h"
+#include "CPMCompression.h"
+
+//
+//	Options d'exportation, communes au plugin et aux outils en ligne de commande
+//	elles sont enregistres telles quelles dans l'en-tte des fichiers binaires
+//
+enum CPM_POLYEXPORT_OPTION
+{
+	CPM_EXPORT_NORMALS					= 0x1,
+	CPM_EXPORT_UVS						= 0x2,
+	CPM_EXPORT_TGT_BINORMALS			= 0x4,
+	CPM_EXPORT_COLORS					= 0x8,
+	CPM_EXPORT_INVERTX					= 0x10,
+	CPM_EXPORT_INVERTY					= 0x20,
+	CPM_EXPORT_INVERTZ					= 0x40,
+	CPM_EXPORT_JOINMESHES				= 0x80,
+	CPM_EXPORT_DOUBLE					= 0x100,
+	CPM_EXPORT_COUNTERCLOCKWISE			= 0x200,
+	CPM_EXPORT_MATERIALSETS				= 0x400,
+	CPM_EXPORT_TEXTURENAMES				= 0x800,
+	CPM_EXPORT_TRUNCATE_TEXTURENAMES	= 0x1000,
+	CPM_EXPORT_INVERTU					= 0x2000,
+	CPM_EXPORT_INVERTV					= 0x4000,
+	CPM_EXPORT_OBJECT_RELATIVE			= 0x8000,
+	CPM_EXPORT_BINARY					= 0x10000,
+	CPM_EXPORT_HALF_VECTORS				= 0x20000,
+	CPM_EXPORT_COMPRESS_FAST			= 0x40000,	// conteneur compress par blocs, LZ4
+	CPM_EXPORT_COMPRESS_ARCHIVE			= 0x80000,	// conteneur compress par blocs, Zstd
+	CPM_EXPORT_WELD_BY_VALUE			= 0x100000,	// fusion des vertices de mme valeur, voir CPMValueWelder
+	CPM_EXPORT_STREAMING				= 0x200000,	// exportation hors mmoire, voir CPMStreamingExport
+	CPM_EXPORT_SUBMESHES				= 0x400000,	// triangles regroups par matriau, un intervalle par matriau au lieu des faceIds, voir CPMSubmeshBuilder
+	CPM_EXPORT_SPLIT_16BIT				= 0x800000,	// meshes de plus de 65536 vertices dcoups en plusieurs objets, voir CPMMeshSplitter
+	CPM_EXPORT_INDEX_CODEC				= 0x1000000,	// indices des triangles compresss au format binaire, voir CPMIndexCodec
+	CPM_EXPORT_INTERLEAVED				= 0x2000000,	// attributs des vertices entrelacs au format binaire, voir CPMVertexLayout
+	CPM_EXPORT_PAGE_ALIGNED				= 0x4000000,	// grandes sections binaires alignes sur GetPageAlignment() au lieu de 16 octets
+	CPM_EXPORT_ADJACENCY				= 0x8000000,	// 6 indices par triangle avec les sommets des triangles voisins, voir CPMAdjacency
+	CPM_EXPORT_CLEAN_TRIANGLES			= 0x10000000,	// suppression des triangles dgnrs et des doublons, voir CPMTriangleCleaner
+	CPM_EXPORT_MIKKTSPACE				= 0x20000000,	// tangentes calcules par l'exporteur (MikkTSpace) au lieu de celles de Maya, voir CPMTangentSpace
+};
+
+// options proposes par dfaut, dans la fentre du plugin comme en ligne de commande
+#define CPM_EXPORT_DEFAULT_OPTIONS	(CPM_EXPORT_NORMALS | CPM_EXPORT_UVS | CPM_EXPORT_MATERIALSETS | CPM_EXPORT_TEXTURENAMES | CPM_EXPORT_INVERTZ | CPM_EXPORT_INVERTV | CPM_EXPORT_OBJECT_RELATIVE)
+
+CPM_PRECISION GetExportPrecision(unsigned int exportOptions);
+AXIS_CONVERSION GetExportAxisConversion(unsigned int exportOptions);
+bool IsExportCompressed(unsigned int exportOptions);
+CPM_CODEC GetExportCodec(unsigned int exportOptions);
+
+// alignement des donnes des grandes sections dans les fichiers binaires (tableaux d'indices et d'attributs, vertices entrelacs):
+// 16 octets pour les chargements SIMD, ou une page avec CPM_EXPORT_PAGE_ALIGNED pour envoyer les donnes au GPU depuis le fichier projet en mmoire
+#define CPM_MIN_SECTION_ALIGNMENT	16
+#define CPM_DEFAULT_PAGE_ALIGNMENT	4096
+
+unsigned int GetPageAlignment();
+void SetPageAlignment(unsigned int alignment); // arrondi  la puissance de 2 suprieure, 4096 ou 65536 en gnral
+unsigned int GetSectionAlignment(unsigned int exportOptions);
+unsigned int GetSectionAlignment(unsigned int exportOptions, unsigned long long size); // 1 pour les sections plus petites que l'alignement
+
+// noms des options en ligne de commande (-normals, -binary...)
+const char *ExportOptionName(CPM_POLYEXPORT_OPTION option);
+bool ParseExportOption(const char *name, CPM_POLYEXPORT_OPTION &option); // retourne false si le nom est inconnu
+unsigned int GetExportOptionCount();
+CPM_POLYEXPORT_OPTION GetExportOption(unsigned int i);
+
+#endif // CPM_EXPORT_OPTIONS_H_INCLUDED
@@ -0,0 +1,123 @@
+#include <algorithm>
+
+#include "CPMExportScheduler.h"
+#include "CPMExportOptions.h"
+#include "CPMStreamingExport.h"
+
+static unsigned long long s_exportMemoryBudget = CPM_DEFAULT_EXPORT_BUDGET;
+
+unsigned long long GetExportMemoryBudget()
+{
+	return s_exportMemoryBudget;
+}
+
+void SetExportMemoryBudget(unsigned long long bytes)
+{
+	s_exportMemoryBudget = bytes;
+}
+
+unsigned long long EstimateMeshMemory(unsigned long long polygons, unsigned long long faceVertices, unsigned int exportOptions)
+{
+	// les triangles et les vertices sont dans les fichiers temporaires, la mmoire de travail est celle de leur budget
+	if(exportOptions & CPM_EXPORT_STREAMING) return GetStreamingSettings().memoryBudget;
+
+	const bool normals = (exportOptions & CPM_EXPORT_NORMALS) != 0;
+	const bool UVs = (exportOptions & CPM_EXPORT_UVS) != 0;
+	const bool tangents = (exportOptions & CPM_EXPORT_TGT_BINORMALS) != 0;
+	const bool colors = (exportOptions & CPM_EXPORT_COLORS) != 0;
+
+	// extraction: un indice par attribut et par face-vertex, et la table de hachage de l'assemblage
+	const unsigned long long faceVertexBytes = 4 * (1 + normals + UVs + tangents + colors) + 16;
+
+	// au plus un vertex par face-vertex, positions en double
+	const unsigned long long vertexBytes = 24 + (normals ? 12 : 0) + (UVs ? 8 : 0) + (tangents ? 24 : 0) + (colors ? 16 : 0);
+	const unsigned long long triangles = faceVertices > 2 * polygons ? faceVertices - 2 * polygons : 0;
+	const unsigned long long triangleBytes = 12 + ((exportOptions & CPM_EXPORT_ADJACENCY) ? 24 : 0);
+
+	// la fusion, les tangentes et le dcoupage recopient le mesh: deux copies au plus  la fois
+	return faceVertices * faceVertexBytes + 2 * (faceVertices * vertexBytes + triangles * triangleBytes);
+}
+
+
+//
+//	CPMExportScheduler
+//
+CPMExportScheduler::CPMExportScheduler(unsigned long long memoryBudget) : m_budget(memoryBudget), m_started(0), m_nextToWrite(0), m_inFlight(0)
+{
+}
+
+void CPMExportScheduler::add(unsigned long long memory)
+{
+	m_memory.push_back(memory);
+	m_stats.meshes++;
+}
+
+size_t CPMExportScheduler::findPending(size_t rank)
+{
+	size_t pending = rank;
+	while(m_pending[pending] != pending) pending = m_pending[pending];
+
+	// les rangs parcourus dsignent directement le rsultat
+	while(m_pending[rank] != pending)
+	{
+		const size_t next = m_pending[rank];
+		m_pending[rank] = pending;
+		rank = next;
+	}
+	return pending;
+}
+
+void CPMExportScheduler::start(size_t rank)
+{
+	m_pending[rank] = rank + 1;
+	m_started++;
+
+	m_inFlight += m_memory[m_order[rank]];
+	if(m_inFlight > m_stats.peakMemory) m_stats.peakMemory = m_inFlight;
+}
+
+bool CPMExportScheduler::admit(size_t &mesh)
+{
+	const size_t count = m_memory.size();
+	if(m_started == count) return false;
+
+	if(m_order.empty())
+	{
+		m_order.resize(count);
+		for(size_t i = 0; i < count; i++) m_order[i] = i;
+		std::stable_sort(m_order.begin(), m_order.end(), [this](size_t a, size_t b) { return m_memory[a] > m_memory[b]; });
+
+		m_rank.resize(count);
+		for(size_t r = 0; r < count; r++) m_rank[m_order[r]] = r;
+
+		m_pending.resize(count + 1);
+		for(size_t r = 0; r <= count; r++) m_pending[r] = r;
+	}
+
+	// plus gros mesh non lanc qui tient dans le reste du budget: les rangs trop gros pour le reste forment le dbut de m_order
+	const unsigned long long remaining = !m_budget ? ~0ULL : m_inFlight < m_budget ? m_budget - m_inFlight : 0;
+	const size_t fits = std::partition_point(m_order.begin(), m_order.end(), [this, remaining](size_t i) { return m_memory[i] > remaining; }) - m_order.begin();
+
+	size_t rank = findPending(fits);
+	if(rank == count)
+	{
+		// le prochain mesh  crire ne peut pas attendre qu'un autre libre sa mmoire
+		rank = m_rank[m_nextToWrite];
+		if(m_pending[rank] != rank)
+		{
+			m_stats.deferred++;
+			return false;
+		}
+		m_stats.forced++;
+	}
+
+	start(rank);
+	mesh = m_order[rank];
+	return true;
+}
+
+void CPMExportScheduler::written()
+{
+	m_inFlight -= m_memory[m_nextToWrite];
+	m_nextToWrite++;
+}
@@ -0,0 +1,106 @@
+#ifndef CPM_EXPORT_SCHEDULER_H_INCLUDED
+#define CPM_EXPORT_SCHEDULER_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+#include <future>
+
+#include "CPMParallel.h"
+
+//
+//	Ordonnancement des meshes d'un fichier
+//	chaque mesh passe par trois tapes: extraction sur le thread appelant (API Maya, tables partages du lecteur OBJ),
+//	traitement sur un thread du pool (fusion, nettoyage, tangentes, dcoupage, adjacence), criture sur le thread appelant
+//	- les meshes sont lancs du plus gros au plus petit: un gros mesh en fin de liste ne prolonge pas seul l'exportation
+//	- un mesh n'est lanc que si sa mmoire estime tient dans le budget avec celle des meshes lancs et pas encore crits
+//	- les meshes sont crits dans leur ordre d'origine: le fichier ne dpend ni du nombre de threads ni du budget
+//	le prochain mesh  crire est lanc mme s'il dpasse le budget quand plus rien d'autre n'y tient, sans quoi l'criture
+//	attendrait indfiniment: la mmoire estime dpasse alors le budget d'au plus ce mesh
+//
+#define CPM_DEFAULT_EXPORT_BUDGET	((unsigned long long) 2048 << 20)
+
+// budget de l'exportation en octets, 0 = illimit
+unsigned long long GetExportMemoryBudget();
+void SetExportMemoryBudget(unsigned long long bytes);
+
+// majorant de la mmoire de travail d'un mesh d'aprs ses polygones et ses face-vertices, connus avant l'extraction
+unsigned long long EstimateMeshMemory(unsigned long long polygons, unsigned long long faceVertices, unsigned int exportOptions);
+
+struct CPM_SCHEDULER_STATS
+{
+	CPM_SCHEDULER_STATS() : meshes(0), deferred(0), forced(0), peakMemory(0) {}
+
+	unsigned int		meshes;
+	unsigned int		deferred;	// lancements retards par le budget
+	unsigned int		forced;		// meshes lancs hors budget parce que l'criture les attendait
+	unsigned long long	peakMemory;	// mmoire estime des meshes lancs et pas encore crits, au plus haut
+};
+
+class CPMExportScheduler
+// Ordre de lancement et contrle d'admission; pas de protection contre les accs concurrents: appel par le seul thread appelant
+{
+	public:
+	explicit CPMExportScheduler(unsigned long long memoryBudget); // 0 = illimit
+
+	void add(unsigned long long memory); // meshes dans l'ordre du fichier, avant le premier appel  admit
+	size_t size() const { return m_memory.size(); }
+
+	bool admit(size_t &mesh); // mesh  lancer maintenant, false si aucun ne peut l'tre
+	size_t nextToWrite() const { return m_nextToWrite; }
+	void written(); // le prochain mesh est crit, sa mmoire est libre
+	bool done() const { return m_nextToWrite == m_memory.size(); }
+
+	const CPM_SCHEDULER_STATS &getStats() const { return m_stats; }
+
+	protected:
+	size_t findPending(size_t rank); // premier rang non lanc  partir de rank, size() s'il n'y en a pas
+	void start(size_t rank);
+
+	protected:
+	unsigned long long				m_budget;
+	std::vector<unsigned long long>	m_memory;
+	std::vector<size_t>				m_order;	// meshes par mmoire dcroissante, dans l'ordre du fichier  galit
+	std::vector<size_t>				m_rank;		// rang de chaque mesh dans m_order
+	std::vector<size_t>				m_pending;	// rang suivant  examiner (raccourcis compresss au-del des rangs lancs)
+	size_t							m_started;
+	size_t							m_nextToWrite;
+	unsigned long long				m_inFlight;
+	CPM_SCHEDULER_STATS				m_stats;
+};
+
+template<typename EXTRACT, typename PROCESS, typename WRITE>
+bool RunScheduledExport(CPMExportScheduler &scheduler, EXTRACT extract, PROCESS process, WRITE write, size_t &failedMesh)
+// Rsum: exporte les meshes du scheduler
+// Args: extract(mesh), write(mesh) - appels sur le thread appelant, write dans l'ordre du fichier
+//		 process(mesh) - appel sur un thread du pool entre les deux, ses ParallelFor se partagent les coeurs avec les autres meshes en cours
+//		 failedMesh - mesh dont une tape a retourn false (sortie)
+// Sortie: false si une tape a chou, les meshes dj lancs sont termins avant le retour
+{
+	CPMThreadPool pool;
+	std::vector< std::future<bool> > processed(scheduler.size());
+
+	while(!scheduler.done())
+	{
+		size_t mesh;
+		while(scheduler.admit(mesh))
+		{
+			if(!extract(mesh))
+			{
+				failedMesh = mesh;
+				return false;
+			}
+			processed[mesh] = pool.submit([&process, mesh]() { return process(mesh); });
+		}
+
+		const size_t next = scheduler.nextToWrite();
+		if(!processed[next].get() || !write(next))
+		{
+			failedMesh = next;
+			return false;
+		}
+		scheduler.written();
+	}
+	return true;
+}
+
+#endif // CPM_EXPORT_SCHEDULER_H_INCLUDED
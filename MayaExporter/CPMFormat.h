@@ -0,0 +1,260 @@
+#ifndef CPM_FORMAT_H_INCLUDED
+#define CPM_FORMAT_H_INCLUDED
+
+#include <ostream>
+#include <string>
+
+#include "CPMScalar.h"
+
+//
+//	Format binaire des fichiers CPM (little-endian)
+//
+//	CPM_BINARY_HEADER
+//	pour chaque objet: une suite de sections (CPM_SECTION_HEADER suivi de 'size' octets de donnes, dont 'padding' octets de remplissage)
+//	table des chanes CPM_TAG_STRINGS, absente si aucune texture n'est exporte: chanes termines par un zro,
+//	dsignes dans les matriaux par leur offset depuis le dbut des donnes de la section
+//	table des objets CPM_TAG_OBJECT_TABLE, absente si le fichier n'a pas d'objet
+//	sommes de contrle CPM_TAG_CHECKSUMS de tout ce qui prcde, absentes si le fichier est crit sans CPMChecksumOStream
+//	section de fin CPM_TAG_END
+//	CPM_FILE_TRAILER: en fin de fichier, pour trouver la table des objets et les sommes de contrle sans lire les objets
+//
+#define CPM_BINARY_MAGIC		"CPMB"
+#define CPM_BINARY_VERSION		11		// 2: noms des textures dans CPM_TAG_STRINGS au lieu de chanes dans chaque matriau
+										// 3: triangles en uint16 ou uint32 selon l'objet, indices relatifs aux sous-meshes (CPM_SECTION_BASE_VERTEX)
+										// 4: triangles compresss (CPM_SECTION_INDEX_CODEC)
+										// 5: sommets entrelacs (CPM_TAG_VERTEX_FORMAT, CPM_TAG_VERTEX_BUFFER), remplissage au dbut des sections
+										// 6: grandes sections alignes (CPM_BINARY_HEADER::sectionAlignment)
+										// 7: table des objets (CPM_TAG_OBJECT_TABLE) et CPM_FILE_TRAILER
+										// 8: colonnes des objets dans la table des objets
+										// 9: sommes de contrle CRC32C (CPM_TAG_CHECKSUMS), dsignes par CPM_FILE_TRAILER
+										// 10: adjacence des triangles (CPM_TAG_ADJACENCY)
+										// 11: couleurs des vertices (CPM_TAG_COLORS)
+
+#define CPM_TAG_OBJECT			"OBJT"
+#define CPM_TAG_TRIANGLES		"TRIS"
+#define CPM_TAG_ADJACENCY		"ADJC"
+#define CPM_TAG_VERTICES		"VERT"
+#define CPM_TAG_NORMALS			"NORM"
+#define CPM_TAG_TANGENTS		"TANG"
+#define CPM_TAG_BINORMALS		"BINO"
+#define CPM_TAG_UVS				"TXCO"
+#define CPM_TAG_COLORS			"COLR"
+#define CPM_TAG_VERTEX_FORMAT	"VFMT"
+#define CPM_TAG_VERTEX_BUFFER	"VBUF"
+#define CPM_TAG_MATERIALS		"MTLS"
+#define CPM_TAG_STRINGS			"STRS"
+#define CPM_TAG_OBJECT_TABLE	"OTOC"
+#define CPM_TAG_CHECKSUMS		"CRCS"
+#define CPM_TAG_END				"CEND"
+
+struct CPM_BINARY_HEADER
+{
+	char				magic[4];
+	unsigned int		version;
+	unsigned int		exportOptions;
+
+	// prcision des attributs (CPM_SCALAR_TYPE)
+	unsigned char		positions;
+	unsigned char		normals;
+	unsigned char		tangents;
+	unsigned char		binormals;
+	unsigned char		uvs;
+
+	unsigned char		sectionAlignment;	// log2 de l'alignement des donnes des grandes sections dans le fichier, voir CPM_SECTION_HEADER::padding
+	unsigned char		reserved[2];
+};
+
+// CPM_TAG_TRIANGLES: indices relatifs au firstVertex du sous-mesh qui contient le triangle (CPM_EXPORT_SUBMESHES),
+// les triangles qui suivent le dernier sous-mesh sont relatifs  la fin de sa fentre de vertices
+#define CPM_SECTION_BASE_VERTEX		0x1
+// CPM_TAG_TRIANGLES: indices compresss, voir CPMIndexCodec.h; scalarType (CPM_SCALAR_UINT32) est le type des indices dcods
+// et size la taille des donnes compresses
+#define CPM_SECTION_INDEX_CODEC		0x2
+
+// CPM_TAG_ADJACENCY: 6 indices absolus par triangle (v0, a01, v1, a12, v2, a20), mme en prsence de CPM_SECTION_BASE_VERTEX
+// dans les triangles, voir CPMAdjacency.h; count est le nombre de triangles
+
+struct CPM_SECTION_HEADER
+{
+	char				tag[4];
+	unsigned char		scalarType;		// CPM_SCALAR_TYPE des lments, CPM_SCALAR_NONE si la section n'est pas un tableau
+	unsigned char		components;		// nombre de composantes par lment
+	unsigned short		flags;			// CPM_SECTION_*
+	unsigned int		count;			// nombre d'lments
+	unsigned int		padding;		// octets nuls avant les lments, pour aligner leur position dans le fichier (CPM_BINARY_HEADER::sectionAlignment)
+	unsigned long long	size;			// taille des donnes qui suivent, en octets, remplissage compris
+};
+
+// CPM_TAG_VERTEX_FORMAT: CPM_VERTEX_FORMAT suivi de 'count' CPM_VERTEX_ATTRIBUTE
+// CPM_TAG_VERTEX_BUFFER: 'count' vertices de 'stride' octets, placs  un multiple de 'alignment' octets depuis le dbut du fichier, mme s'ils sont peu nombreux
+// les deux sections remplacent les sections des attributs (CPM_EXPORT_INTERLEAVED), les octets inutiliss d'un vertex sont nuls
+struct CPM_VERTEX_FORMAT
+{
+	unsigned int		stride;			// taille d'un vertex
+	unsigned int		alignment;		// alignement des donnes de CPM_TAG_VERTEX_BUFFER dans le fichier
+};
+
+struct CPM_VERTEX_ATTRIBUTE
+{
+	char				tag[4];			// tag de la section que l'attribut remplace: CPM_TAG_VERTICES, CPM_TAG_NORMALS...
+	unsigned char		scalarType;
+	unsigned char		components;
+	unsigned short		offset;			// position de l'attribut dans le vertex
+};
+
+// CPM_TAG_OBJECT_TABLE: 'count' CPM_OBJECT_ENTRY dans l'ordre des objets, les CPM_COLUMN_ENTRY de tous les objets,
+// puis les noms des objets termins par un zro
+struct CPM_OBJECT_ENTRY
+{
+	unsigned long long	offset;			// position de la section CPM_TAG_OBJECT de l'objet depuis le dbut du fichier
+	unsigned long long	size;			// taille de toutes les sections de l'objet
+	float				boundsMin[3];	// bote englobante des vertices crits (axes convertis), vide (min > max) sans vertex
+	float				boundsMax[3];
+	unsigned int		name;			// offset du nom depuis la fin des colonnes
+	unsigned int		firstColumn;	// colonnes [firstColumn, firstColumn + columnCount) de la table
+	unsigned int		columnCount;
+	unsigned int		reserved;
+};
+
+// colonne: sections d'un mme attribut de l'objet, lisibles sans lire les autres (par exemple positions et triangles seulement)
+// tag: CPM_TAG_OBJECT (proprits), CPM_TAG_TRIANGLES, CPM_TAG_VERTICES... CPM_TAG_VERTEX_BUFFER
+// pour les vertices entrelacs (CPM_TAG_VERTEX_FORMAT compris), CPM_TAG_MATERIALS
+struct CPM_COLUMN_ENTRY
+{
+	char				tag[4];
+	unsigned int		reserved;
+	unsigned long long	offset;			// position du premier en-tte de section de la colonne
+	unsigned long long	size;			// en-ttes, remplissage et donnes compris
+};
+
+// CPM_TAG_CHECKSUMS: CPM_CHECKSUM_TABLE suivi de 'count' CRC32C, un par bloc de blockSize octets des 'size' premiers octets du fichier
+// (tout ce qui prcde la section), le dernier bloc peut tre plus court
+#define CPM_CHECKSUM_BLOCK_SIZE	(1 << 20)
+
+struct CPM_CHECKSUM_TABLE
+{
+	unsigned int		blockSize;
+	unsigned int		reserved;
+	unsigned long long	size;
+};
+
+#define CPM_FILE_TRAILER_MAGIC	"CPMT"
+
+struct CPM_FILE_TRAILER
+{
+	unsigned long long	objectTable;	// position de la section CPM_TAG_OBJECT_TABLE, 0 si elle est absente
+	unsigned long long	checksums;		// position de la section CPM_TAG_CHECKSUMS, 0 si elle est absente
+	unsigned int		objectCount;
+	char				magic[4];
+};
+
+// format texte: la table des objets prcde CPM_FILE_END, une ligne par objet (offset, taille, bote englobante puis nom) suivie
+// d'une ligne "columns:" (nombre de colonnes, puis tag, offset et taille de chaque colonne), et le fichier se termine par CPM_TEXT_TRAILER suivi de la position de la table sur 20 chiffres
+#define CPM_TEXT_TRAILER		"\nCPM_OBJECT_TABLE "
+#define CPM_TEXT_TRAILER_SIZE	(sizeof(CPM_TEXT_TRAILER) - 1 + 20)
+
+
+//
+//	Conteneur compress par blocs (little-endian)
+//
+//	CPM_CONTAINER_HEADER
+//	blocs compresss indpendamment, chacun contenant chunkSize octets du fichier CPM (texte ou binaire), sauf le dernier
+//	index: un CPM_CHUNK_ENTRY par bloc
+//	CPM_CONTAINER_TRAILER: en fin de fichier, pour trouver l'index sans lire les blocs
+//
+#define CPM_CONTAINER_MAGIC			"CPMZ"
+#define CPM_CONTAINER_VERSION		2	// 2: CRC32C des blocs dcompresss dans l'index
+#define CPM_CONTAINER_CHUNK_SIZE	(1 << 20)
+
+struct CPM_CONTAINER_HEADER
+{
+	char				magic[4];
+	unsigned int		version;
+	unsigned int		codec;			// CPM_CODEC demand  l'exportation
+	unsigned int		chunkSize;		// taille des blocs dcompresss
+};
+
+struct CPM_CHUNK_ENTRY
+{
+	unsigned long long	offset;			// position du bloc depuis le dbut du fichier
+	unsigned int		size;			// taille du bloc compress
+	unsigned int		rawSize;		// taille du bloc dcompress
+	unsigned int		codec;			// CPM_CODEC du bloc: CPM_CODEC_STORE si le bloc ne se compresse pas
+	unsigned int		checksum;		// CRC32C du bloc dcompress, 0 dans les conteneurs de version 1
+};
+
+struct CPM_CONTAINER_TRAILER
+{
+	unsigned long long	indexOffset;
+	unsigned long long	rawSize;		// taille totale du fichier CPM dcompress
+	unsigned int		chunkCount;
+	char				magic[4];
+};
+
+
+template<typename T>
+inline void WriteBinary(std::ostream &os, const T &value)
+{
+	os.write((const char*) &value, sizeof(T));
+}
+
+inline void WriteBinaryString(std::ostream &os, const char *str)
+// Rsum: crit la longueur de la chane (32 bits) suivie de ses caractres, sans le zro final
+{
+	const unsigned int length = (unsigned int) strlen(str);
+	WriteBinary(os, length);
+	os.write(str, length);
+}
+
+inline void WriteSectionHeader(std::ostream &os, const char *tag, unsigned int count, CPM_SCALAR_TYPE scalarType, unsigned int components, unsigned long long size,
+	unsigned short flags = 0, unsigned int padding = 0)
+// Rsum: size comprend les 'padding' octets de remplissage, crits par l'appelant aprs l'en-tte
+{
+	CPM_SECTION_HEADER header;
+	memcpy(header.tag, tag, 4);
+	header.scalarType = (unsigned char) scalarType;
+	header.components = (unsigned char) components;
+	header.flags = flags;
+	header.count = count;
+	header.padding = padding;
+	header.size = size;
+
+	WriteBinary(os, header);
+}
+
+inline unsigned int SectionPadding(std::ostream &os, unsigned int alignment)
+// Rsum: remplissage qui place sur un multiple de alignment les donnes d'une section dont l'en-tte est crit  la position actuelle
+// tellp() d'un conteneur compress compte les octets non compresss, c'est--dire la position dans le fichier CPM: 0 si elle est inconnue
+{
+	const std::streamoff position = os.tellp();
+	if(position < 0 || alignment <= 1) return 0;
+
+	const unsigned long long data = (unsigned long long) position + sizeof(CPM_SECTION_HEADER);
+	return (unsigned int) ((alignment - data % alignment) % alignment);
+}
+
+inline void WriteAlignedSectionHeader(std::ostream &os, unsigned int alignment, const char *tag, unsigned int count, CPM_SCALAR_TYPE scalarType, unsigned int components,
+	unsigned long long size, unsigned short flags = 0)
+// Rsum: crit l'en-tte puis le remplissage, size est la taille des lments seuls
+// le remplissage est fait d'octets nuls: il ne cote presque rien une fois le fichier compress
+{
+	const unsigned int padding = SectionPadding(os, alignment);
+	WriteSectionHeader(os, tag, count, scalarType, components, padding + size, flags, padding);
+
+	static const char zeros[256] = { 0 };
+	for(unsigned int left = padding; left; )
+	{
+		const unsigned int n = left < sizeof(zeros) ? left : (unsigned int) sizeof(zeros);
+		os.write(zeros, n);
+		left -= n;
+	}
+}
+
+inline void WriteSection(std::ostream &os, const char *tag, unsigned int count, const std::string &data)
+// Rsum: crit une section dont le contenu a t prpar en mmoire
+{
+	WriteSectionHeader(os, tag, count, CPM_SCALAR_NONE, 0, data.size());
+	os.write(data.data(), data.size());
+}
+
+#endif // CPM_FORMAT_H_INCLUDED
@@ -0,0 +1,196 @@
+#include "CPMIndexCodec.h"
+
+static inline unsigned int ZigzagEncode(unsigned int delta)
+{
+	return (delta << 1) ^ (unsigned int) ((int) delta >> 31);
+}
+
+static inline unsigned int ZigzagDecode(unsigned int value)
+{
+	return (value >> 1) ^ (0u - (value & 1));
+}
+
+static inline unsigned int ValueCode(unsigned int value)
+// Rsum: nombre d'octets de la valeur - 1
+{
+	return value < (1u << 8) ? 0 : (value < (1u << 16) ? 1 : (value < (1u << 24) ? 2 : 3));
+}
+
+
+//
+//	Encodage
+//
+CPMIndexEncoder::CPMIndexEncoder(std::ostream *os) : m_os(os), m_previous(0), m_size(0)
+{
+	m_values.reserve(CPM_INDEX_CODEC_BLOCK);
+	if(m_os) m_bytes.resize(CPM_INDEX_CODEC_BLOCK / 4 + CPM_INDEX_CODEC_BLOCK * 4);
+}
+
+void CPMIndexEncoder::encode(const unsigned int *indices, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		m_values.push_back(ZigzagEncode(indices[i] - m_previous));
+		m_previous = indices[i];
+		if(m_values.size() == CPM_INDEX_CODEC_BLOCK) flushBlock();
+	}
+}
+
+void CPMIndexEncoder::finish()
+{
+	if(!m_values.empty()) flushBlock();
+}
+
+void CPMIndexEncoder::flushBlock()
+{
+	const size_t count = m_values.size();
+	const size_t numControls = (count + 3) / 4;
+
+	if(!m_os)
+	{
+		m_size += numControls;
+		for(size_t i = 0; i < count; i++) m_size += ValueCode(m_values[i]) + 1;
+		m_values.clear();
+		return;
+	}
+
+	unsigned char *control = &m_bytes[0];
+	unsigned char *data = control + numControls;
+	for(size_t i = 0; i < numControls; i++) control[i] = 0;
+
+	for(size_t i = 0; i < count; i++)
+	{
+		const unsigned int value = m_values[i];
+		const unsigned int code = ValueCode(value);
+		control[i / 4] |= (unsigned char) (code << (2 * (i % 4)));
+		for(unsigned int b = 0; b <= code; b++) *data++ = (unsigned char) (value >> (8 * b));
+	}
+
+	const size_t size = data - control;
+	m_os->write((const char*) control, size);
+	m_size += size;
+	m_values.clear();
+}
+
+unsigned long long EncodedIndexSize(const unsigned int *indices, size_t count)
+{
+	CPMIndexEncoder encoder(NULL);
+	encoder.encode(indices, count);
+	encoder.finish();
+	return encoder.size();
+}
+
+
+//
+//	Dcodage
+//	les fonctions de dcodage d'un bloc retournent le nombre de groupes de 4 indices dcods et avancent data et previous
+//
+static size_t DecodeGroupsScalar(const unsigned char *control, size_t numGroups, const unsigned char *&data, const unsigned char *end,
+	unsigned int &previous, unsigned int *indices, size_t count)
+// Rsum: dcode count indices (4 par groupe, moins pour le dernier groupe)  partir du groupe 0 de control
+{
+	size_t i = 0;
+	for(size_t g = 0; g < numGroups; g++)
+	{
+		const unsigned int codes = control[g];
+		for(unsigned int k = 0; k < 4 && i < count; k++, i++)
+		{
+			const unsigned int length = ((codes >> (2 * k)) & 3) + 1;
+			if(data + length > end) return g;
+
+			unsigned int value = 0;
+			for(unsigned int b = 0; b < length; b++) value |= (unsigned int) data[b] << (8 * b);
+			data += length;
+
+			previous += ZigzagDecode(value);
+			indices[i] = previous;
+		}
+	}
+	return numGroups;
+}
+
+#ifdef CPM_TARGET_AVX2
+struct GROUP_SHUFFLES
+// Pour chaque octet de contrle: masque pshufb qui place les octets des 4 valeurs dans 4 entiers 32 bits, et nombre d'octets du groupe
+{
+	GROUP_SHUFFLES()
+	{
+		for(unsigned int c = 0; c < 256; c++)
+		{
+			unsigned int byte = 0;
+			for(unsigned int k = 0; k < 4; k++)
+			{
+				const unsigned int length = ((c >> (2 * k)) & 3) + 1;
+				for(unsigned int b = 0; b < 4; b++) masks[c][4*k + b] = (signed char) (b < length ? byte + b : -1);
+				byte += length;
+			}
+			lengths[c] = (unsigned char) byte;
+		}
+	}
+
+	signed char		masks[256][16];
+	unsigned char	lengths[256];
+};
+
+static const GROUP_SHUFFLES g_groupShuffles;
+
+CPM_TARGET_AVX2 static size_t DecodeGroupsSSSE3(const unsigned char *control, size_t numGroups, const unsigned char *&data, const unsigned char *end,
+	unsigned int &previous, unsigned int *indices)
+// Rsum: dcode les groupes complets tant que 16 octets peuvent tre lus sans dpasser la fin des donnes
+{
+	const __m128i one = _mm_set1_epi32(1);
+	__m128i last = _mm_set1_epi32((int) previous);
+
+	const unsigned char *bytes = data;
+	size_t g = 0;
+	for(; g < numGroups && bytes + 16 <= end; g++)
+	{
+		const unsigned int c = control[g];
+		__m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) bytes), _mm_loadu_si128((const __m128i*) g_groupShuffles.masks[c]));
+		bytes += g_groupShuffles.lengths[c];
+
+		// zigzag, puis somme prfixe des 4 diffrences
+		v = _mm_xor_si128(_mm_srli_epi32(v, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(v, one)));
+		v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+		v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+		v = _mm_add_epi32(v, last);
+
+		_mm_storeu_si128((__m128i*) (indices + 4*g), v);
+		last = _mm_shuffle_epi32(v, 0xFF);
+	}
+
+	data = bytes;
+	previous = (unsigned int) _mm_cvtsi128_si32(last);
+	return g;
+}
+#endif
+
+bool DecodeIndices(const unsigned char *data, size_t size, unsigned int *indices, size_t count, CPM_SIMD_LEVEL level)
+{
+	const unsigned char *end = data + size;
+	unsigned int previous = 0;
+
+	for(size_t first = 0; first < count; first += CPM_INDEX_CODEC_BLOCK)
+	{
+		const size_t n = count - first < CPM_INDEX_CODEC_BLOCK ? count - first : CPM_INDEX_CODEC_BLOCK;
+		const size_t numGroups = (n + 3) / 4;
+		if((size_t) (end - data) < numGroups) return false;
+
+		const unsigned char *control = data;
+		data += numGroups;
+		unsigned int *block = indices + first;
+
+		// le dernier groupe d'une section peut tre incomplet: il est toujours dcod par le chemin scalaire
+		size_t done = 0;
+#ifdef CPM_TARGET_AVX2
+		if(level >= CPM_SIMD_AVX2) done = DecodeGroupsSSSE3(control, n / 4, data, end, previous, block);
+#else
+		(void) level;
+#endif
+
+		const size_t remaining = numGroups - done;
+		if(DecodeGroupsScalar(control + done, remaining, data, end, previous, block + 4*done, n - 4*done) != remaining) return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,54 @@
+#ifndef CPM_INDEX_CODEC_H_INCLUDED
+#define CPM_INDEX_CODEC_H_INCLUDED
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "CPMSimd.h"
+
+//
+//	Compression des indices des triangles (option CPM_EXPORT_INDEX_CODEC, section CPM_TAG_TRIANGLES avec CPM_SECTION_INDEX_CODEC)
+//	chaque indice est cod par sa diffrence avec l'indice prcdent (le premier avec 0), en zigzag (0, -1, 1, -2... -> 0, 1, 2, 3...),
+//	puis sur 1  4 octets little-endian: les indices d'un mesh dont les vertices sont numrots dans l'ordre de leur premire utilisation
+//	tiennent presque tous sur un octet
+//
+//	les indices sont regroups par blocs de CPM_INDEX_CODEC_BLOCK (le dernier bloc peut tre plus court):
+//	un bloc contient d'abord un octet de contrle par groupe de 4 indices (2 bits par indice: nombre d'octets - 1, indice de poids faible
+//	dans les bits de poids faible), puis les octets des indices; les indices absents du dernier groupe ont un code 0 et aucun octet
+//	la diffrence continue d'un bloc au suivant
+//
+//	la longueur des octets d'un groupe se dduit de son octet de contrle: le dcodeur SIMD lit 16 octets et les replace
+//	avec une seule instruction pshufb (SSSE3, utilise au niveau CPM_SIMD_AVX2), puis annule le zigzag et cumule les diffrences
+//
+#define CPM_INDEX_CODEC_BLOCK		4096	// multiple de 4: seul le dernier bloc d'une section a un groupe incomplet
+
+class CPMIndexEncoder
+// Encodage par morceaux successifs, les blocs complets sont crits au fur et  mesure
+{
+	public:
+	CPMIndexEncoder(std::ostream *os); // os = NULL: les octets sont seulement compts, pour connatre la taille de la section
+
+	void encode(const unsigned int *indices, size_t count);
+	void finish(); // crit le dernier bloc
+
+	unsigned long long size() const { return m_size; } // octets produits, dernier bloc compris aprs finish()
+
+	protected:
+	void flushBlock();
+
+	protected:
+	std::ostream				*m_os;
+	unsigned int				m_previous;
+	std::vector<unsigned int>	m_values;	// valeurs en zigzag du bloc en cours
+	std::vector<unsigned char>	m_bytes;
+	unsigned long long			m_size;
+};
+
+// taille des indices encods, sans les crire
+unsigned long long EncodedIndexSize(const unsigned int *indices, size_t count);
+
+// dcode exactement count indices, retourne false si les donnes sont tronques
+bool DecodeIndices(const unsigned char *data, size_t size, unsigned int *indices, size_t count, CPM_SIMD_LEVEL level = GetSimdLevel());
+
+#endif // CPM_INDEX_CODEC_H_INCLUDED
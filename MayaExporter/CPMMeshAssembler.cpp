@@ -0,0 +1,503 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "CPMMeshAssembler.h"
+#include "CPMParallel.h"
+#include "CPMProfiler.h"
+#include "CPMRadixSort.h"
+
+//
+//	Mode d'assemblage par dfaut
+//
+static CPM_WELD_MODE InitialWeldMode()
+{
+	CPM_WELD_MODE mode = CPM_WELD_AUTO;
+	const char *name = getenv("CPM_WELD_MODE");
+	if(name) ParseWeldMode(name, mode);
+	return mode;
+}
+
+static CPM_WELD_MODE s_weldMode = InitialWeldMode();
+
+CPM_WELD_MODE GetWeldMode()
+{
+	return s_weldMode;
+}
+
+void SetWeldMode(CPM_WELD_MODE mode)
+{
+	s_weldMode = mode;
+}
+
+const char *WeldModeName(CPM_WELD_MODE mode)
+{
+	switch(mode)
+	{
+		case CPM_WELD_SERIAL:		return "serial";
+		case CPM_WELD_PARALLEL:		return "parallel";
+		case CPM_WELD_RADIX_SORT:	return "radix";
+		default:					return "auto";
+	}
+}
+
+bool ParseWeldMode(const char *name, CPM_WELD_MODE &mode)
+{
+	const CPM_WELD_MODE modes[] = { CPM_WELD_AUTO, CPM_WELD_SERIAL, CPM_WELD_PARALLEL, CPM_WELD_RADIX_SORT };
+	for(unsigned int i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+	{
+		if(strcmp(name, WeldModeName(modes[i])) == 0)
+		{
+			mode = modes[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+static unsigned int CountFirstOccurrences(const std::vector<unsigned char> &firstOccurrence, unsigned int numChunks, size_t chunkSize, std::vector<unsigned int> &chunkFirsts)
+// Rsum: somme prfixe par intervalle des premires occurrences, chunkFirsts[c] reoit le rang de la premire occurrence de l'intervalle c
+// Retour: nombre total de premires occurrences
+{
+	const size_t count = firstOccurrence.size();
+	chunkFirsts.assign(numChunks + 1, 0);
+	ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t c = begin; c < end; c++)
+		{
+			const size_t fEnd = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+			unsigned int n = 0;
+			for(size_t f = c * chunkSize; f < fEnd; f++) n += firstOccurrence[f];
+			chunkFirsts[c + 1] = n;
+		}
+	});
+	for(unsigned int c = 0; c < numChunks; c++) chunkFirsts[c + 1] += chunkFirsts[c];
+	return chunkFirsts[numChunks];
+}
+
+//
+//	CPMVertexWelder
+//
+CPMVertexWelder::CPMVertexWelder(unsigned int numPoints) : m_dVertices(numPoints), m_numVertices(0)
+{
+
+}
+
+void CPMVertexWelder::reset(unsigned int numPoints)
+{
+	m_dVertices.clear();
+	m_dVertices.resize(numPoints);
+	m_sortedPoints.clear();
+	m_sortedComponents.clear();
+	m_numVertices = 0;
+}
+
+unsigned int CPMVertexWelder::getNumVertices() const
+{
+	return m_numVertices;
+}
+
+const DVerticeComponent *CPMVertexWelder::findVertex(const ADD_POINT_INFO &point) const
+{
+	for(std::list<DVerticeComponent>::const_iterator it = m_dVertices[point.pointId].begin(); it != m_dVertices[point.pointId].end(); it++)
+	{
+		CPM_PROFILE_COUNT("weldProbes", 1);
+
+		if(point.normalId)			{ if(it->normalId != *point.normalId) continue; }
+		if(point.uvId)				{ if(it->uvId != *point.uvId) continue; }
+		if(point.tgtBinormalId)		{ if(it->tgtBinormalId != *point.tgtBinormalId) continue; }
+		if(point.colorId)			{ if(it->colorId != *point.colorId) continue; }
+
+		return &*it;
+	}
+	return NULL;
+}
+
+void CPMVertexWelder::insertVertex(const ADD_POINT_INFO &point, unsigned int fVertexId)
+{
+	DVerticeComponent nVertice;
+	if(point.normalId)			nVertice.normalId = *(point.normalId);
+	if(point.uvId)				nVertice.uvId = *(point.uvId);
+	if(point.tgtBinormalId)		nVertice.tgtBinormalId = *(point.tgtBinormalId);
+	if(point.colorId)			nVertice.colorId = *(point.colorId);
+	nVertice.fVertexId = fVertexId;
+	m_dVertices[point.pointId].push_back(nVertice);
+}
+
+unsigned int CPMVertexWelder::addPoint(const ADD_POINT_INFO &point)
+{
+	CPM_PROFILE_ACCUMULATE("CPMVertexWelder::addPoint");
+
+	const DVerticeComponent *vertex = findVertex(point);
+	if(vertex) return vertex->fVertexId;
+
+	insertVertex(point, m_numVertices);
+	m_numVertices++;
+
+	return m_numVertices - 1;
+}
+
+void CPMVertexWelder::weld(const FACE_VERTEX_IDS &ids, unsigned int *vertexIds, CPM_WELD_MODE mode)
+{
+	CPM_PROFILE_SCOPE("CPMVertexWelder::weld");
+
+	// les modes parallle et par tri numrotent les vertices depuis zro: ils demandent un welder vide
+	if(mode == CPM_WELD_AUTO) mode = GetWeldMode();
+	if(mode == CPM_WELD_AUTO) mode = ids.count >= CPM_WELD_PARALLEL_MIN_FACE_VERTICES && GetWorkerCount() > 1 ? CPM_WELD_PARALLEL : CPM_WELD_SERIAL;
+	if(m_numVertices != 0 || m_dVertices.size() < 2) mode = CPM_WELD_SERIAL;
+
+	if(mode == CPM_WELD_PARALLEL)
+	{
+		weldParallel(ids, vertexIds);
+		return;
+	}
+
+	if(mode == CPM_WELD_RADIX_SORT && weldRadixSort(ids, vertexIds)) return;
+
+	for(size_t f = 0; f < ids.count; f++) vertexIds[f] = addPoint(ids.get(f));
+}
+
+void CPMVertexWelder::weldParallel(const FACE_VERTEX_IDS &ids, unsigned int *vertexIds)
+// Rsum: les listes m_dVertices tant indexes par point, chaque thread assemble sans verrou les face-vertices d'un intervalle de points
+//		   les indices locaux aux threads sont ensuite traduits en indices globaux par une somme prfixe sur les premires occurrences
+{
+	const size_t count = ids.count;
+	const unsigned int numPoints = (unsigned int) m_dVertices.size();
+	const unsigned int numChunks = GetWorkerCount(); // lu une fois: sur un thread du pool, il varie avec le nombre de tches en cours
+	const unsigned int numRanges = numChunks < numPoints ? numChunks : numPoints;
+	const unsigned int rangeSize = (numPoints + numRanges - 1) / numRanges;
+
+	const size_t chunkSize = (count + numChunks - 1) / numChunks;
+
+	// 1. tri par dnombrement des face-vertices par intervalle de points, l'ordre des face-vertices est conserv dans chaque intervalle
+	std::vector<size_t> chunkRangeCounts((size_t) numChunks * numRanges, 0);
+	ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t c = begin; c < end; c++)
+		{
+			size_t *counts = &chunkRangeCounts[c * numRanges];
+			const size_t fEnd = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+			for(size_t f = c * chunkSize; f < fEnd; f++) counts[ids.points[f] / rangeSize]++;
+		}
+	});
+
+	std::vector<size_t> rangeOffsets(numRanges + 1, 0);
+	size_t offset = 0;
+	for(unsigned int r = 0; r < numRanges; r++)
+	{
+		rangeOffsets[r] = offset;
+		for(unsigned int c = 0; c < numChunks; c++)
+		{
+			const size_t n = chunkRangeCounts[(size_t) c * numRanges + r];
+			chunkRangeCounts[(size_t) c * numRanges + r] = offset;
+			offset += n;
+		}
+	}
+	rangeOffsets[numRanges] = offset;
+
+	std::vector<unsigned int> order(count);
+	ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t c = begin; c < end; c++)
+		{
+			size_t *positions = &chunkRangeCounts[c * numRanges];
+			const size_t fEnd = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+			for(size_t f = c * chunkSize; f < fEnd; f++) order[positions[ids.points[f] / rangeSize]++] = (unsigned int) f;
+		}
+	});
+
+	// 2. assemblage par intervalle de points: les vertices reoivent un indice local  l'intervalle
+	std::vector<unsigned char> firstOccurrence(count, 0);
+	std::vector< std::vector<unsigned int> > localToGlobal(numRanges);
+	ParallelFor(numRanges, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t r = begin; r < end; r++)
+		{
+			unsigned int numLocal = 0;
+			for(size_t i = rangeOffsets[r]; i < rangeOffsets[r + 1]; i++)
+			{
+				const unsigned int f = order[i];
+				const ADD_POINT_INFO point = ids.get(f);
+
+				const DVerticeComponent *vertex = findVertex(point);
+				if(vertex)
+				{
+					vertexIds[f] = vertex->fVertexId;
+				}
+				else
+				{
+					insertVertex(point, numLocal);
+					vertexIds[f] = numLocal++;
+					firstOccurrence[f] = 1;
+				}
+			}
+			localToGlobal[r].resize(numLocal);
+		}
+	});
+
+	// 3. somme prfixe des premires occurrences: un vertex reoit le rang de sa premire occurrence, comme avec addPoint
+	std::vector<unsigned int> chunkFirsts;
+	m_numVertices = CountFirstOccurrences(firstOccurrence, numChunks, chunkSize, chunkFirsts);
+
+	ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t c = begin; c < end; c++)
+		{
+			const size_t fEnd = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+			unsigned int globalId = chunkFirsts[c];
+			for(size_t f = c * chunkSize; f < fEnd; f++)
+			{
+				if(firstOccurrence[f]) localToGlobal[ids.points[f] / rangeSize][vertexIds[f]] = globalId++;
+			}
+		}
+	});
+
+	// 4. traduction des indices locaux
+	ParallelFor(count, CPM_WELD_PARALLEL_MIN_FACE_VERTICES / 4, [&](size_t begin, size_t end)
+	{
+		for(size_t f = begin; f < end; f++) vertexIds[f] = localToGlobal[ids.points[f] / rangeSize][vertexIds[f]];
+	});
+
+	ParallelFor(numRanges, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t r = begin; r < end; r++)
+		{
+			const unsigned int pointEnd = (unsigned int) (r + 1) * rangeSize < numPoints ? (unsigned int) (r + 1) * rangeSize : numPoints;
+			for(unsigned int p = (unsigned int) r * rangeSize; p < pointEnd; p++)
+			{
+				for(std::list<DVerticeComponent>::iterator it = m_dVertices[p].begin(); it != m_dVertices[p].end(); it++) it->fVertexId = localToGlobal[r][it->fVertexId];
+			}
+		}
+	});
+}
+
+struct WELD_KEY_FIELD
+// Indices d'un attribut dans la cl de tri: (id + bias) sur 'bits' bits  partir du bit 'shift'
+{
+	const unsigned int	*ids;
+	unsigned int		bias;
+	unsigned int	bits;
+	unsigned int	shift;
+};
+
+template<typename KEY>
+struct WELD_RECORD
+{
+	KEY				key;
+	unsigned int	faceVertex;
+};
+
+template<typename KEY>
+static void SortFaceVertices(const FACE_VERTEX_IDS &ids, const WELD_KEY_FIELD *fields, unsigned int numFields, unsigned int keyBits,
+							 unsigned int *representatives, std::vector<unsigned char> &firstOccurrence)
+// Rsum: trie les face-vertices par cl puis parcourt les groupes de cls identiques
+//		   le tri tant stable, le premier face-vertex d'un groupe est sa premire occurrence: il devient le reprsentant du groupe
+// Args: representatives - reoit le reprsentant de chaque face-vertex
+//		 firstOccurrence - mis  1 pour les reprsentants
+{
+	const size_t count = ids.count;
+
+	std::vector< WELD_RECORD<KEY> > records(count), buffer;
+	ParallelFor(count, CPM_WELD_PARALLEL_MIN_FACE_VERTICES / 4, [&](size_t begin, size_t end)
+	{
+		for(size_t f = begin; f < end; f++)
+		{
+			KEY key = KEY();
+			for(unsigned int k = 0; k < numFields; k++) SetKeyBits(key, fields[k].shift, (unsigned long long) (fields[k].ids[f] + fields[k].bias));
+			records[f].key = key;
+			records[f].faceVertex = (unsigned int) f;
+		}
+	});
+
+	RadixSort(records, keyBits, buffer);
+	buffer.clear();
+	buffer.shrink_to_fit();
+
+	ParallelFor(count, CPM_WELD_PARALLEL_MIN_FACE_VERTICES / 4, [&](size_t begin, size_t end)
+	{
+		// un groupe peut commencer dans l'intervalle prcdent
+		size_t groupStart = begin;
+		while(groupStart > 0 && records[groupStart - 1].key == records[begin].key) groupStart--;
+		unsigned int representative = records[groupStart].faceVertex;
+
+		for(size_t i = begin; i < end; i++)
+		{
+			if(i > groupStart && records[i].key != records[i - 1].key)
+			{
+				representative = records[i].faceVertex;
+			}
+			if(representative == records[i].faceVertex) firstOccurrence[representative] = 1;
+			representatives[records[i].faceVertex] = representative;
+		}
+	});
+}
+
+bool CPMVertexWelder::weldRadixSort(const FACE_VERTEX_IDS &ids, unsigned int *vertexIds)
+// Rsum: les indices de chaque face-vertex sont concatns en une cl de 64 ou 128 bits, juste assez large pour les valeurs rencontres
+//		   les cls sont tries par base puis les vertices numrots par une somme prfixe sur les premires occurrences
+{
+	const size_t count = ids.count;
+	const unsigned int numChunks = GetWorkerCount();
+	const size_t chunkSize = (count + numChunks - 1) / numChunks;
+
+	// 1. largeur de chaque champ de la cl; les attributs non assigns valent -1, d'o le dcalage de 1
+	WELD_KEY_FIELD fields[5];
+	unsigned int numFields = 0;
+	const unsigned int *attributes[4] = { ids.normals, ids.uvs, ids.tgtBinormals, ids.colors };
+
+	fields[numFields].ids = ids.points;
+	fields[numFields].bias = 0;
+	fields[numFields].bits = BitsFor(m_dVertices.size() - 1);
+	numFields++;
+
+	for(unsigned int a = 0; a < 4; a++)
+	{
+		if(!attributes[a]) continue;
+
+		std::vector<unsigned int> chunkMax(numChunks, 0);
+		ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+		{
+			for(size_t c = begin; c < end; c++)
+			{
+				const size_t fEnd = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+				unsigned int value = 0;
+				for(size_t f = c * chunkSize; f < fEnd; f++) if(attributes[a][f] + 1 > value) value = attributes[a][f] + 1;
+				chunkMax[c] = value;
+			}
+		});
+
+		unsigned int maxValue = 0;
+		for(unsigned int c = 0; c < numChunks; c++) if(chunkMax[c] > maxValue) maxValue = chunkMax[c];
+
+		fields[numFields].ids = attributes[a];
+		fields[numFields].bias = 1;
+		fields[numFields].bits = BitsFor(maxValue);
+		numFields++;
+	}
+
+	unsigned int keyBits = 0;
+	for(unsigned int k = 0; k < numFields; k++)
+	{
+		fields[k].shift = keyBits;
+		keyBits += fields[k].bits;
+	}
+	if(keyBits > 128) return false;
+
+	// 2. tri et reprsentant de chaque groupe de face-vertices identiques
+	std::vector<unsigned char> firstOccurrence(count, 0);
+	if(keyBits <= 64)	SortFaceVertices<unsigned long long>(ids, fields, numFields, keyBits, vertexIds, firstOccurrence);
+	else				SortFaceVertices<CPM_KEY128>(ids, fields, numFields, keyBits, vertexIds, firstOccurrence);
+
+	// 3. les reprsentants reoivent le rang de leur premire occurrence, comme avec addPoint
+	std::vector<unsigned int> chunkFirsts;
+	m_numVertices = CountFirstOccurrences(firstOccurrence, numChunks, chunkSize, chunkFirsts);
+	m_sortedPoints.resize(m_numVertices);
+	m_sortedComponents.resize(m_numVertices);
+
+	ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t c = begin; c < end; c++)
+		{
+			const size_t fEnd = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+			unsigned int globalId = chunkFirsts[c];
+			for(size_t f = c * chunkSize; f < fEnd; f++)
+			{
+				if(!firstOccurrence[f]) continue;
+
+				const ADD_POINT_INFO point = ids.get(f);
+				DVerticeComponent &vertex = m_sortedComponents[globalId];
+				if(point.normalId)			vertex.normalId = *point.normalId;
+				if(point.uvId)				vertex.uvId = *point.uvId;
+				if(point.tgtBinormalId)		vertex.tgtBinormalId = *point.tgtBinormalId;
+				if(point.colorId)			vertex.colorId = *point.colorId;
+				vertex.fVertexId = globalId;
+				m_sortedPoints[globalId] = point.pointId;
+
+				vertexIds[f] = globalId++;
+			}
+		}
+	});
+
+	// 4. les autres face-vertices prennent l'indice de leur reprsentant, dj traduit
+	ParallelFor(count, CPM_WELD_PARALLEL_MIN_FACE_VERTICES / 4, [&](size_t begin, size_t end)
+	{
+		for(size_t f = begin; f < end; f++) if(!firstOccurrence[f]) vertexIds[f] = vertexIds[vertexIds[f]];
+	});
+
+	return true;
+}
+
+static inline void CopyVertex(const ASSEMBLY_SOURCE &source, ASSEMBLY_OUTPUT &output, unsigned int i, const DVerticeComponent &vertex)
+// Rsum: recopie les attributs du vertex assembl  partir du point i
+{
+	const unsigned int v = vertex.fVertexId;
+
+	output.points->x[v] = source.points[4*i];
+	output.points->y[v] = source.points[4*i + 1];
+	output.points->z[v] = source.points[4*i + 2];
+	if(output.normals) {
+		output.normals->x[v] = source.normals[3*vertex.normalId];
+		output.normals->y[v] = source.normals[3*vertex.normalId + 1];
+		output.normals->z[v] = source.normals[3*vertex.normalId + 2];
+	}
+	if(output.UVs) {
+		output.UVs->u[v] = source.u[vertex.uvId];
+		output.UVs->v[v] = source.v[vertex.uvId];
+	}
+	if(output.tangents) {
+		output.tangents->x[v] = source.tangents[3*vertex.tgtBinormalId];
+		output.tangents->y[v] = source.tangents[3*vertex.tgtBinormalId + 1];
+		output.tangents->z[v] = source.tangents[3*vertex.tgtBinormalId + 2];
+		output.binormals->x[v] = source.binormals[3*vertex.tgtBinormalId];
+		output.binormals->y[v] = source.binormals[3*vertex.tgtBinormalId + 1];
+		output.binormals->z[v] = source.binormals[3*vertex.tgtBinormalId + 2];
+	}
+	if(output.colors) {
+		output.colors->r[v] = source.colors[4*vertex.colorId];
+		output.colors->g[v] = source.colors[4*vertex.colorId + 1];
+		output.colors->b[v] = source.colors[4*vertex.colorId + 2];
+		output.colors->a[v] = source.colors[4*vertex.colorId + 3];
+	}
+}
+
+void CPMVertexWelder::assemble(const ASSEMBLY_SOURCE &source, ASSEMBLY_OUTPUT &output) const
+// Rsum: redimensionne les tableaux de sortie et y recopie les attributs de chaque vertex assembl
+{
+	CPM_PROFILE_SCOPE("CPMVertexWelder::assemble");
+
+	output.points->resize(m_numVertices);
+	if(output.normals)			output.normals->resize(m_numVertices);
+	if(output.UVs)				output.UVs->resize(m_numVertices);
+	if(output.tangents) {
+		output.tangents->resize(m_numVertices);
+		output.binormals->resize(m_numVertices);
+	}
+	if(output.colors)			output.colors->resize(m_numVertices);
+
+	if(!m_sortedPoints.empty())
+	{
+		for(unsigned int v = 0; v < m_sortedPoints.size(); v++) CopyVertex(source, output, m_sortedPoints[v], m_sortedComponents[v]);
+		return;
+	}
+
+	for(unsigned int i = 0; i < m_dVertices.size(); i++)
+	{
+		for(std::list<DVerticeComponent>::const_iterator it = m_dVertices[i].begin(); it != m_dVertices[i].end(); it++) CopyVertex(source, output, i, *it);
+	}
+}
+
+
+void BuildMaterialTriangleIds(const std::vector<unsigned int> &triangleOffsets, const std::vector<unsigned int> &faceIds, std::vector<unsigned int> &triangleIds)
+// Rsum: liste les triangles issus des polygones faceIds
+// Args: triangleOffsets - premier triangle de chaque polygone, voir BuildTriangleOffsets
+{
+	size_t numTris = 0;
+	for(size_t k = 0; k < faceIds.size(); k++) numTris += triangleOffsets[faceIds[k] + 1] - triangleOffsets[faceIds[k]];
+
+	triangleIds.resize(numTris);
+
+	size_t triId = 0;
+	for(size_t k = 0; k < faceIds.size(); k++)
+	{
+		for(unsigned int t = triangleOffsets[faceIds[k]]; t < triangleOffsets[faceIds[k] + 1]; t++) triangleIds[triId++] = t;
+	}
+}
@@ -0,0 +1,172 @@
+#ifndef CPM_MESH_ASSEMBLER_H_INCLUDED
+#define CPM_MESH_ASSEMBLER_H_INCLUDED
+
+#include <list>
+#include <vector>
+
+#include "CPMMeshBuffers.h"
+
+//
+//	Assemblage des vertices, indpendant de l'API Maya
+//	les face-vertices (un point et les indices de ses attributs pour une face) sont fusionns en vertices uniques,
+//	puis les attributs des vertices sont recopis depuis les tableaux du mesh source
+//
+struct DVerticeComponent
+{
+	DVerticeComponent(	unsigned int normalId = 0,
+						unsigned int tgtBinormalId = 0,
+						unsigned int uvId = 0,
+						unsigned int colorId = 0,
+						unsigned int fVertexId = 0)
+	: normalId(normalId), tgtBinormalId(tgtBinormalId), uvId(uvId), colorId(colorId), fVertexId(fVertexId) {}
+
+	unsigned int	normalId;
+	unsigned int	tgtBinormalId;
+	unsigned int	uvId;
+	unsigned int	colorId;
+
+	unsigned int	fVertexId;
+};
+
+struct ADD_POINT_INFO
+{
+	ADD_POINT_INFO() : pointId(0), normalId(NULL), uvId(NULL), tgtBinormalId(NULL), colorId(NULL) {}
+	ADD_POINT_INFO(unsigned int pointId) : pointId(pointId), normalId(NULL), uvId(NULL), tgtBinormalId(NULL), colorId(NULL) {}
+
+	unsigned int pointId;
+	const unsigned int *normalId;
+	const unsigned int *uvId;
+	const unsigned int *tgtBinormalId;
+	const unsigned int *colorId;
+};
+
+struct FACE_VERTEX_IDS
+// Indices des attributs de tous les face-vertices du mesh, dans l'ordre des polygones (NULL si l'attribut n'est pas export)
+// un attribut non assign (-1 dans Maya) vaut ~0u
+{
+	FACE_VERTEX_IDS() : count(0), points(NULL), normals(NULL), uvs(NULL), tgtBinormals(NULL), colors(NULL) {}
+
+	ADD_POINT_INFO get(size_t f) const
+	{
+		ADD_POINT_INFO point(points[f]);
+		if(normals)			point.normalId = &normals[f];
+		if(uvs)				point.uvId = &uvs[f];
+		if(tgtBinormals)	point.tgtBinormalId = &tgtBinormals[f];
+		if(colors)			point.colorId = &colors[f];
+		return point;
+	}
+
+	size_t				count;
+	const unsigned int	*points;
+	const unsigned int	*normals;
+	const unsigned int	*uvs;
+	const unsigned int	*tgtBinormals;
+	const unsigned int	*colors;
+};
+
+enum CPM_WELD_MODE
+{
+	CPM_WELD_AUTO,			// parallle pour les gros meshes quand plusieurs threads sont disponibles
+	CPM_WELD_SERIAL,		// addPoint sur chaque face-vertex
+	CPM_WELD_PARALLEL,		// un intervalle de points par thread, mme numrotation que CPM_WELD_SERIAL
+	CPM_WELD_RADIX_SORT,	// tri par base des face-vertices sur une cl compacte, mmoire proportionnelle au nombre de face-vertices
+};
+
+#define CPM_WELD_PARALLEL_MIN_FACE_VERTICES		(1 << 16)
+
+// mode utilis quand weld reoit CPM_WELD_AUTO, initialis depuis la variable d'environnement CPM_WELD_MODE (auto par dfaut)
+CPM_WELD_MODE GetWeldMode();
+void SetWeldMode(CPM_WELD_MODE mode);
+
+const char *WeldModeName(CPM_WELD_MODE mode);
+bool ParseWeldMode(const char *name, CPM_WELD_MODE &mode); // auto, serial, parallel ou radix
+
+struct ASSEMBLY_SOURCE
+// Attributs du mesh source, tableaux contigus indexs par les ids des DVerticeComponent (NULL si l'attribut n'est pas export)
+{
+	ASSEMBLY_SOURCE() : points(NULL), normals(NULL), u(NULL), v(NULL), tangents(NULL), binormals(NULL), colors(NULL) {}
+
+	const double	*points;		// x, y, z, w par point, comme MPointArray::get
+	const float		*normals;		// x, y, z
+	const float		*u;
+	const float		*v;
+	const float		*tangents;		// x, y, z
+	const float		*binormals;		// x, y, z
+	const float		*colors;		// r, g, b, a
+};
+
+struct ASSEMBLY_OUTPUT
+{
+	ASSEMBLY_OUTPUT() : points(NULL), normals(NULL), tangents(NULL), binormals(NULL), UVs(NULL), colors(NULL) {}
+
+	VECTOR3_ARRAY<double>	*points;
+	VECTOR3_ARRAY<float>	*normals;
+	VECTOR3_ARRAY<float>	*tangents;
+	VECTOR3_ARRAY<float>	*binormals;
+	UV_ARRAY				*UVs;
+	COLOR_ARRAY				*colors;
+};
+
+class CPMVertexWelder
+{
+	public:
+	CPMVertexWelder(unsigned int numPoints = 0);
+
+	void reset(unsigned int numPoints);
+
+	unsigned int addPoint(const ADD_POINT_INFO &point); // retourne l'indice du vertex final
+	unsigned int getNumVertices() const;
+
+	// assemble tous les face-vertices d'un mesh, vertexIds reoit l'indice du vertex final de chacun
+	// les vertices sont numrots dans l'ordre de leur premire occurrence quel que soit le mode
+	// aprs CPM_WELD_RADIX_SORT, addPoint n'est plus utilisable avant le prochain reset
+	void weld(const FACE_VERTEX_IDS &ids, unsigned int *vertexIds, CPM_WELD_MODE mode = CPM_WELD_AUTO);
+
+	void assemble(const ASSEMBLY_SOURCE &source, ASSEMBLY_OUTPUT &output) const;
+
+	protected:
+	const DVerticeComponent *findVertex(const ADD_POINT_INFO &point) const; // NULL si aucun vertex du point ne correspond
+	void insertVertex(const ADD_POINT_INFO &point, unsigned int fVertexId);
+	void weldParallel(const FACE_VERTEX_IDS &ids, unsigned int *vertexIds);
+	bool weldRadixSort(const FACE_VERTEX_IDS &ids, unsigned int *vertexIds); // false si les indices ne tiennent pas dans une cl de 128 bits
+
+	protected:
+	std::vector< std::list<DVerticeComponent> >	m_dVertices; // vertices dsassembls, par point
+	std::vector<unsigned int>					m_sortedPoints; // CPM_WELD_RADIX_SORT: point et attributs de chaque vertex, par indice de vertex
+	std::vector<DVerticeComponent>				m_sortedComponents;
+	unsigned int								m_numVertices;
+};
+
+
+template<typename POLYGON_POINTS, typename TRIANGLE_POINTS>
+inline void RemapPolygonTriangles(const POLYGON_POINTS &polygonPoints, const unsigned int *polygonVertices, unsigned int polygonSize,
+								  const TRIANGLE_POINTS &trianglePoints, unsigned int begin, unsigned int end, unsigned int *triangles)
+// Rsum: traduit les triangles d'un polygone, dcrits par les indices de ses points, en indices de vertices finaux
+// Args: polygonPoints, polygonVertices - point et vertex final de chaque sommet du polygone
+//		 trianglePoints - points des triangles du mesh, seul l'intervalle [begin, end) concerne le polygone
+{
+	for(unsigned int j = begin; j < end; j++)
+	{
+		for(unsigned int k = 0; k < polygonSize; k++)
+		{
+			if((unsigned int) trianglePoints[j] == (unsigned int) polygonPoints[k])
+			{
+				triangles[j] = polygonVertices[k];
+				break;
+			}
+		}
+	}
+}
+
+template<typename TRIANGLE_COUNTS>
+inline void BuildTriangleOffsets(const TRIANGLE_COUNTS &triangleCounts, unsigned int numPolygons, std::vector<unsigned int> &offsets)
+// Rsum: indice du premier triangle de chaque polygone (somme prfixe du nombre de triangles)
+{
+	offsets.resize(numPolygons + 1);
+	offsets[0] = 0;
+	for(unsigned int i = 0; i < numPolygons; i++) offsets[i + 1] = offsets[i] + triangleCounts[i];
+}
+
+void BuildMaterialTriangleIds(const std::vector<unsigned int> &triangleOffsets, const std::vector<unsigned int> &faceIds, std::vector<unsigned int> &triangleIds);
+
+#endif // CPM_MESH_ASSEMBLER_H_INCLUDED
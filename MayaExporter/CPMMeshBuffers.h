@@ -0,0 +1,66 @@
+#ifndef CPM_MESH_BUFFERS_H_INCLUDED
+#define CPM_MESH_BUFFERS_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+template<typename T>
+inline void GatherValues(std::vector<T> &gathered, const std::vector<T> &values, const std::vector<unsigned int> &ids)
+// Rsum: gathered[i] = values[ids[i]], ids peut rpter un lment
+{
+	gathered.resize(ids.size());
+	for(size_t i = 0; i < ids.size(); i++) gathered[i] = values[ids[i]];
+}
+
+//
+//	Tableaux d'attributs des vertices, rangs composante par composante (x[], y[], z[])
+//	afin que les traitements puissent parcourir des tableaux contigus
+//	gather(source, ids): lment i = lment ids[i] de source
+//
+template<typename T>
+struct VECTOR3_ARRAY
+{
+	void resize(size_t count) { x.resize(count); y.resize(count); z.resize(count); }
+	void gather(const VECTOR3_ARRAY &source, const std::vector<unsigned int> &ids) { GatherValues(x, source.x, ids); GatherValues(y, source.y, ids); GatherValues(z, source.z, ids); }
+	void clear() { x.clear(); y.clear(); z.clear(); }
+	void swap(VECTOR3_ARRAY &other) { x.swap(other.x); y.swap(other.y); z.swap(other.z); }
+	size_t size() const { return x.size(); }
+
+	std::vector<T>	x;
+	std::vector<T>	y;
+	std::vector<T>	z;
+};
+
+struct UV_ARRAY
+{
+	void resize(size_t count) { u.resize(count); v.resize(count); }
+	void clear() { u.clear(); v.clear(); }
+	void swap(UV_ARRAY &other) { u.swap(other.u); v.swap(other.v); }
+	void gather(const UV_ARRAY &source, const std::vector<unsigned int> &ids) { GatherValues(u, source.u, ids); GatherValues(v, source.v, ids); }
+	size_t size() const { return u.size(); }
+
+	std::vector<float>	u;
+	std::vector<float>	v;
+};
+
+struct COLOR_ARRAY
+{
+	void resize(size_t count) { r.resize(count); g.resize(count); b.resize(count); a.resize(count); }
+	void clear() { r.clear(); g.clear(); b.clear(); a.clear(); }
+	void swap(COLOR_ARRAY &other) { r.swap(other.r); g.swap(other.g); b.swap(other.b); a.swap(other.a); }
+	void gather(const COLOR_ARRAY &source, const std::vector<unsigned int> &ids)
+	{
+		GatherValues(r, source.r, ids);
+		GatherValues(g, source.g, ids);
+		GatherValues(b, source.b, ids);
+		GatherValues(a, source.a, ids);
+	}
+	size_t size() const { return r.size(); }
+
+	std::vector<float>	r;
+	std::vector<float>	g;
+	std::vector<float>	b;
+	std::vector<float>	a;
+};
+
+#endif // CPM_MESH_BUFFERS_H_INCLUDED
@@ -8,10 +8,298 @@
 #include <maya/MFnLambertShader.h>
 #include <maya/MFnPhongShader.h>
 #include <maya/MFnBlinnShader.h>
+#include <algorithm>
 
 #include "CPMMeshExtractor.h"
+#include "CPMStreamingExport.h"
+#include "CPMProfiler.h"
 
-CPMMeshExtractor::CPMMeshExtractor(const MDagPath &dagPath, bool objectSpace, MStatus &status) : m_dagPath(dagPath), m_mesh(dagPath, &status)
+//
+//	CPMMayaPolygonStream
+//
+#define CPM_POLYGON_MATERIAL_BLOCK		(64 << 10)	// polygones du fichier des matriaux lus ou crits ensemble
+
+class CPMMayaPolygonStream : public CPMPolygonStream
+// Polygones lus un  un dans le mesh Maya: seul le lot en cours est en mmoire, la triangulation est celle de Maya comme pour MFnMesh::getTriangles
+// polygonMaterials, s'il est fourni, contient le matriau de chaque polygone (voir CPMMeshExtractor::extractMaterials)
+{
+	public:
+	CPMMayaPolygonStream(const MDagPath &dagPath, const MESH_EXTRACTOR_INFO &mesh, CPMTempFile *polygonMaterials, MStatus &status) : m_polygons(dagPath, MObject::kNullObj, &status),
+		m_info(mesh), m_polygonMaterials(polygonMaterials), m_firstMaterial(0) {}
+
+	virtual bool read(size_t maxFaceVertices, POLYGON_BATCH &batch);
+
+	protected:
+	bool readMaterial(unsigned int polygon, int &material);
+
+	protected:
+	MItMeshPolygon				m_polygons;
+	const MESH_EXTRACTOR_INFO	&m_info;
+
+	CPMTempFile					*m_polygonMaterials;
+	std::vector<int>			m_materials; // matriaux des polygones [m_firstMaterial, m_firstMaterial + m_materials.size())
+	unsigned int				m_firstMaterial;
+
+	MIntArray					m_vertexList; // points du polygone actuel
+	MIntArray					m_trianglePoints; // points des triangles du polygone actuel
+	MIntArray					m_triangleVertices; // points d'un triangle
+	MPointArray					m_trianglePositions;
+	std::vector<unsigned int>	m_faceVertices;
+	std::vector<unsigned int>	m_triangles;
+};
+
+bool CPMMayaPolygonStream::readMaterial(unsigned int polygon, int &material)
+// Rsum: les polygones sont parcourus dans l'ordre, le fichier est lu par blocs
+{
+	if(polygon < m_firstMaterial || polygon >= m_firstMaterial + m_materials.size())
+	{
+		const unsigned long long numPolygons = m_polygonMaterials->size() / sizeof(int);
+		if(polygon >= numPolygons) return false;
+
+		m_firstMaterial = polygon;
+		m_materials.resize((size_t) std::min<unsigned long long>(CPM_POLYGON_MATERIAL_BLOCK, numPolygons - polygon));
+		if(!m_polygonMaterials->read(polygon * sizeof(int), &m_materials[0], m_materials.size() * sizeof(int))) return false;
+	}
+
+	material = m_materials[polygon - m_firstMaterial];
+	return true;
+}
+
+bool CPMMayaPolygonStream::read(size_t maxFaceVertices, POLYGON_BATCH &batch)
+{
+	MStatus status;
+	batch.clear();
+
+	for(; !m_polygons.isDone(); m_polygons.next())
+	{
+		if(!m_polygons.getVertices(m_vertexList)) {
+			MGlobal::displayError("MItMeshPolygon::getVertices");
+			return false;
+		}
+
+		const unsigned int size = m_vertexList.length();
+		const unsigned int first = (unsigned int) batch.points.size();
+		if(first && first + size > maxFaceVertices) break;
+
+		// indices des attributs de chaque face-vertex, comme CPMMeshExtractor::extractGeometry
+		m_faceVertices.resize(size);
+		for(unsigned int j = 0; j < size; j++)
+		{
+			m_faceVertices[j] = first + j;
+			batch.points.push_back(m_vertexList[j]);
+
+			if(m_info.normals) batch.normals.push_back(m_polygons.normalIndex(j));
+			if(m_info.UVs) {
+				int uvId = 0;
+				if(!m_polygons.getUVIndex(j, uvId, &m_info.uvSetName)) {
+					MGlobal::displayError("MItMeshPolygon::getUVIndex");
+					return false;
+				}
+				batch.uvs.push_back(uvId);
+			}
+			if(m_info.tangents) {
+				batch.tgtBinormals.push_back(m_polygons.tangentIndex(j, &status));
+				if(!status) {
+					MGlobal::displayError("MItMeshPolygon::tangentIndex");
+					return false;
+				}
+			}
+			if(m_info.colors) {
+				int colorId = 0;
+				if(!m_polygons.getColorIndex(j, colorId, &m_info.colorSetName)) {
+					MGlobal::displayError("MItMeshPolygon::getColorIndex");
+					return false;
+				}
+				batch.colors.push_back(colorId);
+			}
+		}
+
+		// triangles du polygone, traduits en face-vertices du lot
+		int numTriangles = 0;
+		m_polygons.numTriangles(numTriangles);
+		m_trianglePoints.setLength(3 * numTriangles);
+		for(int t = 0; t < numTriangles; t++)
+		{
+			if(!m_polygons.getTriangle(t, m_trianglePositions, m_triangleVertices, MSpace::kObject)) {
+				MGlobal::displayError("MItMeshPolygon::getTriangle");
+				return false;
+			}
+			for(unsigned int k = 0; k < 3; k++) m_trianglePoints[3*t + k] = m_triangleVertices[k];
+		}
+
+		m_triangles.resize(3 * numTriangles);
+		if(numTriangles) RemapPolygonTriangles(m_vertexList, &m_faceVertices[0], size, m_trianglePoints, 0, 3 * numTriangles, &m_triangles[0]);
+		batch.triangles.insert(batch.triangles.end(), m_triangles.begin(), m_triangles.end());
+
+		if(m_polygonMaterials)
+		{
+			int material = -1;
+			if(!readMaterial(m_polygons.index(), material)) {
+				MGlobal::displayError("CPMMayaPolygonStream : fichier temporaire des matriaux illisible");
+				return false;
+			}
+			batch.triangleMaterials.insert(batch.triangleMaterials.end(), numTriangles, material);
+		}
+	}
+
+	return true;
+}
+
+
+//
+//	CPMMayaVertexSource
+//
+class CPMMayaVertexSource : public CPMVertexSource
+// Attributs lus dans le mesh Maya pour chaque bloc de vertices, dans l'espace objet: les points et les normales sont lus dans les tableaux
+// internes de Maya, sans copie, les uvs et les couleurs un  un; Maya n'a pas d'accs aux tangentes par indice, leurs tableaux sont lus une fois
+{
+	public:
+	CPMMayaVertexSource(MFnMesh &mesh, const MESH_EXTRACTOR_INFO &info) : m_mesh(mesh), m_info(info), m_points(NULL), m_normals(NULL) {}
+
+	MStatus init();
+	virtual bool read(const int *ids, size_t count, STREAMING_VERTICES &vertices);
+
+	unsigned int numTangents() const { return m_tangents.length(); }
+
+	protected:
+	MFnMesh						&m_mesh;
+	const MESH_EXTRACTOR_INFO	&m_info;
+
+	const float					*m_points;
+	const float					*m_normals;
+	MFloatVectorArray			m_tangents;
+	MFloatVectorArray			m_binormals;
+};
+
+MStatus CPMMayaVertexSource::init()
+{
+	MStatus status;
+
+	m_points = m_mesh.getRawPoints(&status);
+	if(!status) {
+		MGlobal::displayError("MFnMesh::getRawPoints");
+		return MS::kFailure;
+	}
+	if(m_info.normals) {
+		m_normals = m_mesh.getRawNormals(&status);
+		if(!status) {
+			MGlobal::displayError("MFnMesh::getRawNormals");
+			return MS::kFailure;
+		}
+	}
+	if(m_info.tangents) {
+		if(m_mesh.getTangents(m_tangents, MSpace::kObject, &m_info.uvSetName) == MS::kFailure) {
+			MGlobal::displayError("MFnMesh::getTangents");
+			return MS::kFailure;
+		}
+		if(m_mesh.getBinormals(m_binormals, MSpace::kObject, &m_info.uvSetName) == MS::kFailure) {
+			MGlobal::displayError("MFnMesh::getBinormals");
+			return MS::kFailure;
+		}
+	}
+
+	return MS::kSuccess;
+}
+
+bool CPMMayaVertexSource::read(const int *ids, size_t count, STREAMING_VERTICES &vertices)
+{
+	for(size_t v = 0; v < count; v++, ids += 5)
+	{
+		vertices.points->x[v] = m_points[3*ids[0]];
+		vertices.points->y[v] = m_points[3*ids[0] + 1];
+		vertices.points->z[v] = m_points[3*ids[0] + 2];
+		if(vertices.normals) {
+			vertices.normals->x[v] = m_normals[3*ids[1]];
+			vertices.normals->y[v] = m_normals[3*ids[1] + 1];
+			vertices.normals->z[v] = m_normals[3*ids[1] + 2];
+		}
+		if(vertices.UVs) {
+			// un face-vertex sans uv (-1) reoit (0, 0)
+			float u = 0.0f, v2 = 0.0f;
+			if(ids[2] >= 0 && !m_mesh.getUV(ids[2], u, v2, &m_info.uvSetName)) {
+				MGlobal::displayError("MFnMesh::getUV");
+				return false;
+			}
+			vertices.UVs->u[v] = u;
+			vertices.UVs->v[v] = v2;
+		}
+		if(vertices.tangents) {
+			const MFloatVector &tangent = m_tangents[ids[3]], &binormal = m_binormals[ids[3]];
+			vertices.tangents->x[v] = tangent.x;
+			vertices.tangents->y[v] = tangent.y;
+			vertices.tangents->z[v] = tangent.z;
+			vertices.binormals->x[v] = binormal.x;
+			vertices.binormals->y[v] = binormal.y;
+			vertices.binormals->z[v] = binormal.z;
+		}
+		if(vertices.colors) {
+			// un face-vertex sans couleur (-1) reoit (0, 0, 0, 1)
+			MColor color(0.0f, 0.0f, 0.0f, 1.0f);
+			if(ids[4] >= 0 && !m_mesh.getColor(ids[4], color, &m_info.colorSetName)) {
+				MGlobal::displayError("MFnMesh::getColor");
+				return false;
+			}
+			vertices.colors->r[v] = color.r;
+			vertices.colors->g[v] = color.g;
+			vertices.colors->b[v] = color.b;
+			vertices.colors->a[v] = color.a;
+		}
+	}
+	return true;
+}
+
+static bool WritePolygonMaterials(MItMeshPolygon &polygons, int material, CPMTempFile &file)
+// Rsum: inscrit material pour les polygones du set; les indices sont tris par lots, les polygones conscutifs sont crits ensemble
+{
+	std::vector<unsigned int> indices;
+	std::vector<int> values;
+	indices.reserve(CPM_POLYGON_MATERIAL_BLOCK);
+
+	auto flush = [&]() -> bool
+	{
+		std::sort(indices.begin(), indices.end());
+		for(size_t i = 0; i < indices.size();)
+		{
+			size_t j = i + 1;
+			while(j < indices.size() && indices[j] == indices[j - 1] + 1) j++;
+
+			values.assign(j - i, material);
+			if(!file.writeAt(indices[i] * sizeof(int), &values[0], values.size() * sizeof(int))) return false;
+			i = j;
+		}
+		indices.clear();
+		return true;
+	};
+
+	for(polygons.reset(); !polygons.isDone(); polygons.next())
+	{
+		indices.push_back(polygons.index());
+		if(indices.size() == CPM_POLYGON_MATERIAL_BLOCK && !flush()) return false;
+	}
+	return flush();
+}
+
+
+
+//
+//	CPMMeshExtractor
+//
+static unsigned int InternTextureName(const MPlug &fileNamePlug, CPMStringPool *strings)
+// Rsum: offset du chemin de la texture dans le pool de la session, 0 si le plug est vide ou si les noms des textures ne sont pas exports
+{
+	if(!strings) return 0;
+
+	MString fileName;
+	fileNamePlug.getValue(fileName);
+	return strings->intern(fileName.asChar(), fileName.length());
+}
+
+static void SetMaterialColor(float *c, const MColor &color)
+{
+	CPM_MATERIAL::SetColor(c, color.r, color.g, color.b, color.a);
+}
+
+CPMMeshExtractor::CPMMeshExtractor(const MDagPath &dagPath, bool objectSpace, MStatus &status) : m_dagPath(dagPath), m_mesh(dagPath, &status), m_polygonMaterials(NULL)
 {
 	m_space = MSpace::kWorld;
 	if(objectSpace) m_space = MSpace::kObject;
@@ -43,7 +331,75 @@ MStatus CPMMeshExtractor::extractMesh(MESH_EXTRACTOR_INFO &mesh)
 	return MS::kSuccess;
 }
 
-MStatus CPMMeshExtractor::extractGeometry(MESH_EXTRACTOR_INFO &mesh, unsigned int &numVertices)
+MStatus CPMMeshExtractor::extractStreamingMesh(MESH_EXTRACTOR_INFO &mesh, CPMStreamingMesh &streamingMesh)
+// Rsum: ni les triangles, ni les faceIds des matriaux, ni les tableaux des attributs ne sont copis en entier
+{
+	CPM_PROFILE_SCOPE("CPMMeshExtractor::extractStreamingMesh");
+	MStatus status;
+
+	if(!extractSetNames(mesh)) return MS::kFailure;
+
+	// matriau de chaque polygone dans un fichier temporaire, lu avec les polygones: les triangles des matriaux sont rpartis par streamingMesh
+	CPMTempFile polygonMaterials;
+	if(mesh.materials)
+	{
+		const unsigned int numPolygons = m_mesh.numPolygons();
+		std::vector<int> unassigned(std::min<unsigned int>(CPM_POLYGON_MATERIAL_BLOCK, numPolygons), -1);
+		bool written = polygonMaterials.open(streamingMesh.getSettings().tempDirectory);
+		for(unsigned int first = 0; written && first < numPolygons; first += (unsigned int) unassigned.size())
+		{
+			written = polygonMaterials.write(&unassigned[0], std::min<unsigned int>((unsigned int) unassigned.size(), numPolygons - first) * sizeof(int));
+		}
+		if(!written) {
+			MGlobal::displayError("CPMMeshExtractor : impossible d'crire le fichier temporaire des matriaux");
+			return MS::kFailure;
+		}
+		m_polygonMaterials = &polygonMaterials;
+	}
+
+	status = extractMaterials(mesh);
+	m_polygonMaterials = NULL;
+	if(!status) {
+		MGlobal::displayError("CPMMeshExtractor::extractMaterials");
+		return MS::kFailure;
+	}
+
+	// attributs lus par blocs pendant la fusion des vertices
+	CPMMayaVertexSource vertices(m_mesh, mesh);
+	if(!vertices.init()) return MS::kFailure;
+
+	STREAMING_SOURCE source;
+	source.vertices = &vertices;
+	source.numPoints = m_mesh.numVertices();
+	if(mesh.normals)	source.numNormals = m_mesh.numNormals();
+	if(mesh.UVs)		source.numUVs = m_mesh.numUVs(mesh.uvSetName);
+	if(mesh.tangents)	source.numTgtBinormals = vertices.numTangents();
+	if(mesh.colors)		source.numColors = m_mesh.numColors(mesh.colorSetName);
+	if(mesh.materials)	source.numMaterials = (unsigned int) mesh.materials->size();
+
+	MESH_TRANSFORM transform;
+	if(m_space == MSpace::kWorld)
+	{
+		if(!getWorldTransform(transform)) return MS::kFailure;
+		source.transform = &transform;
+	}
+
+	CPMMayaPolygonStream polygons(m_dagPath, mesh, mesh.materials ? &polygonMaterials : NULL, status);
+	if(!status) {
+		MGlobal::displayError("MItMeshPolygon::MItMeshPolygon");
+		return MS::kFailure;
+	}
+
+	if(!streamingMesh.build(polygons, source)) {
+		MGlobal::displayError(streamingMesh.getError().c_str());
+		return MS::kFailure;
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus CPMMeshExtractor::extractSetNames(MESH_EXTRACTOR_INFO &mesh)
+// Rsum: sets d'uvs et de couleurs courants, si mesh n'en prcise pas
 {
 	MStatus status;
 
@@ -74,15 +430,22 @@ MStatus CPMMeshExtractor::extractGeometry(MESH_EXTRACTOR_INFO &mesh, unsigned in
 		}
 	}
 
+	return MS::kSuccess;
+}
+
+MStatus CPMMeshExtractor::extractGeometry(MESH_EXTRACTOR_INFO &mesh, unsigned int &numVertices)
+{
+	CPM_PROFILE_SCOPE("CPMMeshExtractor::extractGeometry");
+	MStatus status;
+
+	if(!extractSetNames(mesh)) return MS::kFailure;
+
 	//
 	//	Composition de la liste de vertices dsassembls
 	//
 
 	// Nombre de points (chaque point dans l'espace peut tre associ  plusieurs normales et coordonnes uv, donnant lieu  plusieurs vertices)
-	m_dVertices.resize(m_mesh.numVertices());
-
-	// Nombre actuel de vertices compts, dont la valeur finale donnera le nombre de vertices du mesh  exporter
-	unsigned int actualNumVertices = 0;
+	m_welder.reset(m_mesh.numVertices());
 
 	// On rcupre les triangles et on redimensionne le vector triangles (sortie)
 	MIntArray triangleCounts, triangleVertices;
@@ -93,19 +456,25 @@ MStatus CPMMeshExtractor::extractGeometry(MESH_EXTRACTOR_INFO &mesh, unsigned in
 	}
 
 	///////////////////////////////////////////
-	mesh.triangles.setLength(triangleVertices.length());
+	mesh.triangles.resize(triangleVertices.length());
 	///////////////////////////////////////////
 
 
 	// Nombre de polygones
 	const unsigned int numPolygons = m_mesh.numPolygons();
-	unsigned int numTris = 0;
+	const unsigned int numFaceVertices = m_mesh.numFaceVertices();
+
+	// Pour chaque polygone, on rcupre les indices de vertices, de normales et de coordonnes UV dans des tableaux couvrant tout le mesh,
+	// l'assemblage par m_welder se fait ensuite en une fois (et en parallle pour les gros meshes)
+	MIntArray vertexList, normalList; // indices de vertice et de normale du polygone actuel
+	std::vector<unsigned int> pointIds(numFaceVertices), normalIds, uvIds, tgtBinormalIds, colorIds;
+	std::vector<unsigned int> polygonOffsets(numPolygons + 1, 0); // premier face-vertex de chaque polygone
+	if(mesh.normals)	normalIds.resize(numFaceVertices);
+	if(mesh.UVs)		uvIds.resize(numFaceVertices);
+	if(mesh.tangents)	tgtBinormalIds.resize(numFaceVertices);
+	if(mesh.colors)		colorIds.resize(numFaceVertices);
+	const unsigned int numColors = mesh.colors ? (unsigned int) m_mesh.numColors(mesh.colorSetName) : 0;
 
-	// Pour chaque polygone, on rcupre les indices de vertices, de normales et de coordonnes UV et on les enregistre dans m_dVertices
-	// en vue d'assembler les vertices du mesh  exporter
-	MIntArray vertexList, normalList, uvList, tgtBinormalList, colorList; // indices de vertice, normale, coordonnes UV, et couleur du polygone actuel
-	MIntArray nFaceVertexList; // indices des vertices finaux du polygone actuel
-	unsigned int actualTriangleVertId = 0; // dbut des indices de vertices du polygone actuel dans le tableau triangleVertices
 	for(unsigned int i = 0; i < numPolygons; i++)
 	{
 		// On rcupre les indices de vertices, de normales, de coordonnes uv, de tangente et de couleur
@@ -117,91 +486,103 @@ MStatus CPMMeshExtractor::extractGeometry(MESH_EXTRACTOR_INFO &mesh, unsigned in
 			MGlobal::displayError("MFnMesh::getFaceNormalIds");
 			return MS::kFailure;
 		}
+
+		const unsigned int first = polygonOffsets[i];
+		polygonOffsets[i + 1] = first + vertexList.length();
+
+		for(unsigned int j = 0; j < vertexList.length(); j++) {
+			pointIds[first + j] = vertexList[j];
+			if(mesh.normals) normalIds[first + j] = normalList[j];
+		}
 		if(mesh.UVs) {
-			uvList.setLength(vertexList.length());
-			for(unsigned int j = 0; j < uvList.length(); j++) {
-					if(!m_mesh.getPolygonUVid(i, j, uvList[j], &mesh.uvSetName)) {
+			for(unsigned int j = 0; j < vertexList.length(); j++) {
+				int uvId;
+				if(!m_mesh.getPolygonUVid(i, j, uvId, &mesh.uvSetName)) {
 					MGlobal::displayError("MFnMesh::getPolygonUVid");
 					return MS::kFailure;
 				}
+				uvIds[first + j] = uvId;
 			}
 		}
-		if(mesh.tgtBinormals) {
-			tgtBinormalList.setLength(vertexList.length());
-			for(unsigned int j = 0; j < tgtBinormalList.length(); j++) {
-					tgtBinormalList[j] = m_mesh.getTangentId(i, vertexList[j], &status);
-					if(!status) {
+		if(mesh.tangents) {
+			for(unsigned int j = 0; j < vertexList.length(); j++) {
+				tgtBinormalIds[first + j] = m_mesh.getTangentId(i, vertexList[j], &status);
+				if(!status) {
 					MGlobal::displayError("MFnMesh::getTangentId");
 					return MS::kFailure;
 				}
 			}
 		}
 		if(mesh.colors) {
-			colorList.setLength(vertexList.length());
-			for(unsigned int j = 0; j < colorList.length(); j++) {
-					if(!m_mesh.getColorIndex(i, j, colorList[j], &mesh.colorSetName)) {
-					MGlobal::displayError("MFnMesh::getPolygonUVid");
+			for(unsigned int j = 0; j < vertexList.length(); j++) {
+				int colorId;
+				if(!m_mesh.getColorIndex(i, j, colorId, &mesh.colorSetName)) {
+					MGlobal::displayError("MFnMesh::getColorIndex");
 					return MS::kFailure;
 				}
+				// un face-vertex sans couleur (-1) reoit la couleur par dfaut, ajoute aprs les couleurs du mesh par extractSource
+				colorIds[first + j] = colorId >= 0 ? (unsigned int) colorId : numColors;
 			}
 		}
-		
-		// On rcupre le nouvel indice de vertice (assembl plus tard)
-		nFaceVertexList.setLength(vertexList.length());
-		for(unsigned int j = 0; j < nFaceVertexList.length(); j++)
-		{
-			ADD_POINT_INFO nPoint(vertexList[j]);
-			if(mesh.normals)		nPoint.normalId = &normalList[j];
-			if(mesh.tgtBinormals)	nPoint.tgtBinormalId = &tgtBinormalList[j];
-			if(mesh.UVs)			nPoint.uvId = &uvList[j];
-			if(mesh.colors)			nPoint.colorId = &colorList[j];
+	}
 
-			nFaceVertexList[j] = addPoint(nPoint, actualNumVertices);
-		}
+	// On rcupre le nouvel indice de vertice de chaque face-vertex (les attributs sont assembls plus tard)
+	FACE_VERTEX_IDS ids;
+	ids.count = polygonOffsets[numPolygons];
+	if(ids.count) {
+		ids.points = &pointIds[0];
+		if(mesh.normals)	ids.normals = &normalIds[0];
+		if(mesh.UVs)		ids.uvs = &uvIds[0];
+		if(mesh.tangents)	ids.tgtBinormals = &tgtBinormalIds[0];
+		if(mesh.colors)		ids.colors = &colorIds[0];
+	}
+
+	std::vector<unsigned int> faceVertexIds(ids.count);
+	if(ids.count) m_welder.weld(ids, &faceVertexIds[0]);
 
-		// On entre les valeurs d'indices dans le vector triangles en faisant le lien entre la description de la face (vertexList) et la
-		// description des triangles composant la face (triangleVertices)
-		for(unsigned int j = actualTriangleVertId; j < actualTriangleVertId + triangleCounts[i]*3; j++)
+	// On entre les valeurs d'indices dans le vector triangles en faisant le lien entre la description de la face (pointIds) et la
+	// description des triangles composant la face (triangleVertices)
+	unsigned int actualTriangleVertId = 0; // dbut des indices de vertices du polygone actuel dans le tableau triangleVertices
+	for(unsigned int i = 0; i < numPolygons; i++)
+	{
+		const unsigned int first = polygonOffsets[i];
+		if(polygonOffsets[i + 1] > first)
 		{
-			for(unsigned int k = 0; k < vertexList.length(); k++)
-			{
-				if(triangleVertices[j] == vertexList[k])
-				{
-					mesh.triangles[j] = nFaceVertexList[k];
-					break;
-				}
-			}
+			RemapPolygonTriangles(&pointIds[first], &faceVertexIds[first], polygonOffsets[i + 1] - first, triangleVertices, actualTriangleVertId,
+								  actualTriangleVertId + triangleCounts[i]*3, &mesh.triangles[0]);
 		}
 
 		actualTriangleVertId += triangleCounts[i]*3;
 	}
 
-	numVertices = actualNumVertices;
+	numVertices = m_welder.getNumVertices();
+
+	CPM_PROFILE_COUNT("polygons", numPolygons);
+	CPM_PROFILE_COUNT("faceVertices", numFaceVertices);
+	CPM_PROFILE_COUNT("uniqueVertices", numVertices);
 	
 	return MS::kSuccess;
 }
 
 MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 {
+	CPM_PROFILE_SCOPE("CPMMeshExtractor::extractMaterials");
 	MStatus status;
 
 	if(!mesh.materials) return MS::kSuccess;
 
 	//
-	//	On rcupre les faces du mesh
+	//	On rcupre les faces du mesh, sauf en streaming: le matriau de chaque polygone est alors crit dans m_polygonMaterials
 	//
-	MIntArray triangleCounts, triangleVertices;
-	if(!m_mesh.getTriangles(triangleCounts, triangleVertices)) {
-		MGlobal::displayError("MFnMesh::getTriangles");
-		return MS::kFailure;
-	}
-
-	MIntArray triIndices;
-	triIndices.setLength(triangleCounts.length() + 1);
-	triIndices[0] = 0;
-	for(unsigned int i = 0; i < triangleCounts.length(); i++)
+	std::vector<unsigned int> triIndices;
+	if(!m_polygonMaterials)
 	{
-		triIndices[i + 1] = triIndices[0] + triangleCounts[i];
+		MIntArray triangleCounts, triangleVertices;
+		if(!m_mesh.getTriangles(triangleCounts, triangleVertices)) {
+			MGlobal::displayError("MFnMesh::getTriangles");
+			return MS::kFailure;
+		}
+		BuildTriangleOffsets(triangleCounts, triangleCounts.length(), triIndices);
 	}
 
 	//
@@ -232,7 +613,7 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 
 	for(unsigned int i = 0; i < setCount; i++)
 	{
-		MATERIAL_INFO material; // est cr en dbut de boucle pour tre rinitialis  chaque fois
+		CPM_MATERIAL material; // est cr en dbut de boucle pour tre rinitialis  chaque fois
 
 		MObject set = m_polygonSets[i];
 		MObject comp = m_polygonComponents[i];
@@ -251,28 +632,6 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 			MGlobal::displayError("MItMeshPolygon::MItMeshPolygon");
 			continue;
 		}
-		
-		std::vector<unsigned int> faceIds;
-		unsigned int numTris = 0;
-		unsigned int j = 0;
-		faceIds.resize(itMeshPolygon.count());
-		for(itMeshPolygon.reset(); !itMeshPolygon.isDone(); itMeshPolygon.next())
-		{
-			faceIds[j] = itMeshPolygon.index();
-			numTris += triangleCounts[ faceIds[j] ];
-			j++;
-		}
-		
-		unsigned int triId = 0;
-		material.faceIds.resize(numTris);
-		for(unsigned int k = 0; k < itMeshPolygon.count(); k++)
-		{
-			for(unsigned l = 0; l < (unsigned int) triangleCounts[ faceIds[k] ]; l++)
-			{
-				material.faceIds[triId + l] = triIndices[ faceIds[k] ] + l;
-			}
-			triId += triangleCounts[ faceIds[k] ];
-		}
 
 		// On rcupre le shader
 		MObject shaderNode = findShader(set);
@@ -312,7 +671,7 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 			{
 				MObject textureNode = itDg.thisNode();
 				MPlug fileNamePlug = MFnDependencyNode(textureNode).findPlug("fileTextureName");
-				fileNamePlug.getValue(material.colorTexName);
+				material.colorTexName = InternTextureName(fileNamePlug, mesh.strings);
 			}
 		}
 
@@ -337,7 +696,7 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 			{
 				MObject textureNode = itDg.thisNode();
 				MPlug fileNamePlug = MFnDependencyNode(textureNode).findPlug("fileTextureName");
-				fileNamePlug.getValue(material.transparencyTexName);
+				material.transparencyTexName = InternTextureName(fileNamePlug, mesh.strings);
 			}
 		}
 
@@ -362,7 +721,7 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 			{
 				MObject textureNode = itDg.thisNode();
 				MPlug fileNamePlug = MFnDependencyNode(textureNode).findPlug("fileTextureName");
-				fileNamePlug.getValue(material.ambientTexName);
+				material.ambientTexName = InternTextureName(fileNamePlug, mesh.strings);
 			}
 		}
 
@@ -387,8 +746,7 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 			{
 				MObject textureNode = itDg.thisNode();
 				MPlug fileNamePlug = MFnDependencyNode(textureNode).findPlug("fileTextureName");
-				MString bumpFile;
-				fileNamePlug.getValue(material.normalTexName);
+				material.normalTexName = InternTextureName(fileNamePlug, mesh.strings);
 			}
 		}
 
@@ -399,9 +757,9 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 		MFnLambertShader lambertShader(shaderNode, &status);
 		if(status)
 		{
-			if(material.colorTexName == "") material.color = lambertShader.color()*lambertShader.diffuseCoeff();
-			if(material.transparencyTexName == "") material.transparency = lambertShader.transparency();
-			if(material.ambientTexName == "") material.ambient = lambertShader.ambientColor();
+			if(!material.colorTexName) SetMaterialColor(material.color, lambertShader.color()*lambertShader.diffuseCoeff());
+			if(!material.transparencyTexName) SetMaterialColor(material.transparency, lambertShader.transparency());
+			if(!material.ambientTexName) SetMaterialColor(material.ambient, lambertShader.ambientColor());
 
 			MFnPhongShader phongShader(shaderNode, &status);
 			if(status)
@@ -428,7 +786,7 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 					{
 						MObject textureNode = itDg.thisNode();
 						MPlug fileNamePlug = MFnDependencyNode(textureNode).findPlug("fileTextureName");
-						fileNamePlug.getValue(material.specularColorTexName);
+						material.specularColorTexName = InternTextureName(fileNamePlug, mesh.strings);
 					}
 				}
 
@@ -452,12 +810,12 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 					{
 						MObject textureNode = itDg.thisNode();
 						MPlug fileNamePlug = MFnDependencyNode(textureNode).findPlug("fileTextureName");
-						fileNamePlug.getValue(material.specularPowerTexName);
+						material.specularPowerTexName = InternTextureName(fileNamePlug, mesh.strings);
 					}
 				}
 
-				if(material.specularColorTexName == "") material.specularColor = phongShader.specularColor();
-				if(material.specularPowerTexName == "") material.specularPower = phongShader.cosPower();
+				if(!material.specularColorTexName) SetMaterialColor(material.specularColor, phongShader.specularColor());
+				if(!material.specularPowerTexName) material.specularPower = phongShader.cosPower();
 			}
 			else
 			{
@@ -469,6 +827,28 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 			}
 		}
 
+		// Faces du set: matriau de chaque polygone en streaming, triangles du matriau sinon
+		if(m_polygonMaterials)
+		{
+			if(!WritePolygonMaterials(itMeshPolygon, (int) mesh.materials->size(), *m_polygonMaterials)) {
+				MGlobal::displayError("CPMMeshExtractor : impossible d'crire le fichier temporaire des matriaux");
+				return MS::kFailure;
+			}
+		}
+		else
+		{
+			std::vector<unsigned int> faceIds;
+			unsigned int j = 0;
+			faceIds.resize(itMeshPolygon.count());
+			for(itMeshPolygon.reset(); !itMeshPolygon.isDone(); itMeshPolygon.next())
+			{
+				faceIds[j] = itMeshPolygon.index();
+				j++;
+			}
+
+			BuildMaterialTriangleIds(triIndices, faceIds, material.faceIds);
+		}
+
 		mesh.materials->push_back(material);
 	}
 
@@ -477,11 +857,42 @@ MStatus CPMMeshExtractor::extractMaterials(MESH_EXTRACTOR_INFO &mesh)
 
 MStatus CPMMeshExtractor::assembleMesh(MESH_EXTRACTOR_INFO &mesh, const unsigned int &numVertices)
 {
+	CPM_PROFILE_SCOPE("CPMMeshExtractor::assembleMesh");
+
 	if(numVertices == 0) {
 		MGlobal::displayError("CPMMeshExtractor : le mesh n'a aucun vertice");
 		return MS::kFailure;
 	}
 	
+	ASSEMBLY_SOURCE source;
+	if(!extractSource(mesh, source)) return MS::kFailure;
+
+	ASSEMBLY_OUTPUT output;
+	output.points = &mesh.points;
+	output.normals = mesh.normals;
+	output.tangents = mesh.tangents;
+	output.binormals = mesh.binormals;
+	output.UVs = mesh.UVs;
+	output.colors = mesh.colors;
+
+	m_welder.assemble(source, output);
+
+	// Les donnes sont rcupres dans l'espace objet, puis transformes en une seule passe si l'exportation se fait dans l'espace monde
+	if(m_space == MSpace::kWorld)
+	{
+		MESH_TRANSFORM transform;
+		if(!getWorldTransform(transform)) return MS::kFailure;
+
+		CPM_PROFILE_SCOPE("TransformMesh");
+		TransformMesh(transform, &mesh.points, mesh.normals, mesh.tangents, mesh.binormals);
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus CPMMeshExtractor::extractSource(const MESH_EXTRACTOR_INFO &mesh, ASSEMBLY_SOURCE &source)
+// Rsum: attributs du mesh dans l'espace objet, indexs par les ids des face-vertices
+{
 	MPointArray				vertexArray;
 	MFloatVectorArray		normalsArray;
 	MFloatArray				uArray;
@@ -506,7 +917,7 @@ MStatus CPMMeshExtractor::assembleMesh(MESH_EXTRACTOR_INFO &mesh, const unsigned
 			return MS::kFailure;
 		}
 	}
-	if(mesh.tgtBinormals) {
+	if(mesh.tangents) {
 		if(m_mesh.getTangents(tangentsArray, MSpace::kObject, &mesh.uvSetName) == MS::kFailure) {
 		MGlobal::displayError("MFnMesh::getTangents");
 		return MS::kFailure;
@@ -523,55 +934,58 @@ MStatus CPMMeshExtractor::assembleMesh(MESH_EXTRACTOR_INFO &mesh, const unsigned
 		}
 	}
 
-	// On redimensionne les vectors contenant les informations de position, normale...
-	mesh.points.setLength(numVertices);
-	if(mesh.normals)			mesh.normals->setLength(numVertices);
-	if(mesh.UVs)				mesh.UVs->resize(numVertices);
-	if(mesh.tgtBinormals)		mesh.tgtBinormals->resize(numVertices);
-	if(mesh.colors)				mesh.colors->setLength(numVertices);
-
-	for(unsigned int i = 0; i < m_dVertices.size(); i++)
+	// On recopie les attributs dans des tableaux contigus, les attributs de chaque vertex assembl y sont lus
+	m_sourcePoints.resize(4 * vertexArray.length());
+	m_sourceNormals.resize(3 * normalsArray.length());
+	m_sourceU.resize(uArray.length());
+	m_sourceV.resize(vArray.length());
+	m_sourceTangents.resize(3 * tangentsArray.length());
+	m_sourceBinormals.resize(3 * binormalsArray.length());
+	m_sourceColors.resize(mesh.colors ? 4 * (colorsArray.length() + 1) : 0);
+	if(!m_sourcePoints.empty())		vertexArray.get((double (*)[4]) &m_sourcePoints[0]);
+	if(!m_sourceNormals.empty())	normalsArray.get((float (*)[3]) &m_sourceNormals[0]);
+	if(!m_sourceU.empty())			uArray.get(&m_sourceU[0]);
+	if(!m_sourceV.empty())			vArray.get(&m_sourceV[0]);
+	if(!m_sourceTangents.empty())	tangentsArray.get((float (*)[3]) &m_sourceTangents[0]);
+	if(!m_sourceBinormals.empty())	binormalsArray.get((float (*)[3]) &m_sourceBinormals[0]);
+	for(unsigned int i = 0; i < colorsArray.length(); i++)
 	{
-		for(std::list<DVerticeComponent>::iterator it = m_dVertices[i].begin(); it != m_dVertices[i].end(); it++)
-		{			
-			mesh.points[it->fVertexId] = vertexArray[i];
-			if(mesh.normals) (*mesh.normals)[it->fVertexId] = normalsArray[it->normalId];
-			if(mesh.UVs) {
-				(*mesh.UVs)[it->fVertexId].u = uArray[it->uvId];
-				(*mesh.UVs)[it->fVertexId].v = uArray[it->uvId];
-			}
-			if(mesh.tgtBinormals) {
-				(*mesh.tgtBinormals)[it->fVertexId].tangent = tangentsArray[it->tgtBinormalId];
-				(*mesh.tgtBinormals)[it->fVertexId].binormal = binormalsArray[it->tgtBinormalId];
-			}
-			if(mesh.colors) (*mesh.colors)[it->fVertexId] = colorsArray[it->colorId];
-		}
+		m_sourceColors[4*i] = colorsArray[i].r;
+		m_sourceColors[4*i + 1] = colorsArray[i].g;
+		m_sourceColors[4*i + 2] = colorsArray[i].b;
+		m_sourceColors[4*i + 3] = colorsArray[i].a;
+	}
+	if(mesh.colors) // couleur par dfaut des face-vertices sans couleur: (0, 0, 0, 1)
+	{
+		m_sourceColors[4*colorsArray.length() + 3] = 1.0f;
 	}
 
+	source = ASSEMBLY_SOURCE();
+	source.points = m_sourcePoints.empty() ? NULL : &m_sourcePoints[0];
+	source.normals = m_sourceNormals.empty() ? NULL : &m_sourceNormals[0];
+	source.u = m_sourceU.empty() ? NULL : &m_sourceU[0];
+	source.v = m_sourceV.empty() ? NULL : &m_sourceV[0];
+	source.tangents = m_sourceTangents.empty() ? NULL : &m_sourceTangents[0];
+	source.binormals = m_sourceBinormals.empty() ? NULL : &m_sourceBinormals[0];
+	source.colors = m_sourceColors.empty() ? NULL : &m_sourceColors[0];
+
 	return MS::kSuccess;
 }
 
-unsigned int CPMMeshExtractor::addPoint(const ADD_POINT_INFO &point, unsigned int &actualNumVertices)
+MStatus CPMMeshExtractor::getWorldTransform(MESH_TRANSFORM &transform)
 {
-	for(std::list<DVerticeComponent>::iterator it = m_dVertices[point.pointId].begin(); it != m_dVertices[point.pointId].end(); it++)
-	{
-		if(point.normalId)			{ if(it->normalId != *point.normalId) continue; }
-		if(point.uvId)				{ if(it->uvId != *point.uvId) continue; }
-		if(point.tgtBinormalId)		{ if(it->tgtBinormalId != *point.tgtBinormalId) continue; }
-		if(point.colorId)			{ if(it->colorId != *point.colorId) continue; }
-
-		return it->fVertexId;
-	}
-	DVerticeComponent nVertice;
-	if(point.normalId)			nVertice.normalId = *(point.normalId);
-	if(point.uvId)				nVertice.uvId = *(point.uvId);
-	if(point.tgtBinormalId)		nVertice.tgtBinormalId = *(point.tgtBinormalId);
-	if(point.colorId)			nVertice.colorId = *(point.colorId);
-	nVertice.fVertexId = actualNumVertices;
-	m_dVertices[point.pointId].push_back(nVertice);
-	actualNumVertices++;
-
-	return actualNumVertices - 1;
+	MStatus status;
+	MMatrix matrix = m_dagPath.inclusiveMatrix(&status);
+	if(!status) {
+		MGlobal::displayError("MDagPath::inclusiveMatrix");
+		return MS::kFailure;
+	}
+
+	double m[4][4];
+	matrix.get(m);
+	BuildMeshTransform(m, transform);
+
+	return MS::kSuccess;
 }
 
 MObject CPMMeshExtractor::findShader(const MObject &setNode)
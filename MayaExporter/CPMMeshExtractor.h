@@ -1,7 +1,6 @@
 #ifndef CPM_MESH_EXTRACTOR_H_INCLUDED
 #define CPM_MESH_EXTRACTOR_H_INCLUDED
 
-#include <list>
 #include <vector>
 #include <maya/MIntArray.h>
 #include <maya/MPointArray.h>
@@ -10,90 +9,33 @@
 #include <maya/MColorArray.h>
 #include <maya/MDagPath.h>
 #include <maya/MFnMesh.h>
+#include <maya/MMatrix.h>
 
+#include "CPMMeshBuffers.h"
+#include "CPMMeshAssembler.h"
+#include "CPMMeshWriter.h"
+#include "CPMTransformKernels.h"
 
-struct DVerticeComponent
-{
-	DVerticeComponent(	unsigned int normalId = 0,
-						unsigned int tgtBinormalId = 0,
-						unsigned int uvId = 0,
-						unsigned int colorId = 0,
-						unsigned int fVertexId = 0)
-	: normalId(normalId), tgtBinormalId(tgtBinormalId), uvId(uvId), colorId(colorId), fVertexId(fVertexId) {}
-
-	unsigned int	normalId;
-	unsigned int	tgtBinormalId;
-	unsigned int	uvId;
-	unsigned int	colorId;
-
-	unsigned int	fVertexId;
-};
-
-struct MATERIAL_INFO
-{
-	MATERIAL_INFO() :	color(1.0f, 1.0f, 1.0f, 1.0f), colorTexName(""), ambient(0.0f, 0.0f, 0.0f, 1.0f), ambientTexName(""), specularColor(0.0f, 0.0f, 0.0f, 0.0f), specularColorTexName(""),
-						specularPower(255.0f), specularPowerTexName(""), transparency(0.0f, 0.0f, 0.0f, 0.0f), transparencyTexName(""), normalTexName(""), bumpTexName("") {}
-	
-	MColor			color;
-	MString			colorTexName;
-
-	MColor			specularColor;
-	MString			specularColorTexName;
-
-	float			specularPower;
-	MString			specularPowerTexName;
-
-	MColor			ambient;
-	MString			ambientTexName;
-
-	MColor			transparency;
-	MString			transparencyTexName;
-
-	MString			normalTexName;
-	MString			bumpTexName;
-
-	std::vector<unsigned int>		faceIds; // faces concernes par le matriau, si faceIds.length() = 0, le mesh entier est concern
-};
-
-struct UV
-{
-	float u;
-	float v;
-};
-
-struct TGT_BINORMAL
-{
-	MFloatVector	tangent;
-	MFloatVector	binormal;
-};
+class CPMStreamingMesh;
+class CPMTempFile;
 
 struct MESH_EXTRACTOR_INFO
 {
-	MESH_EXTRACTOR_INFO() : normals(NULL), tgtBinormals(NULL), UVs(NULL), colors(NULL), materials(NULL) {}
+	MESH_EXTRACTOR_INFO() : normals(NULL), tangents(NULL), binormals(NULL), UVs(NULL), colors(NULL), materials(NULL), strings(NULL) {}
 
-	MIntArray							triangles;
+	std::vector<unsigned int>			triangles;
 
-	MPointArray							points;
-	MFloatVectorArray					*normals;
-	std::vector<TGT_BINORMAL>			*tgtBinormals;
-	std::vector<UV>						*UVs;
+	VECTOR3_ARRAY<double>				points;
+	VECTOR3_ARRAY<float>				*normals;
+	VECTOR3_ARRAY<float>				*tangents; // tangents et binormals sont extraites ensemble
+	VECTOR3_ARRAY<float>				*binormals;
+	UV_ARRAY							*UVs;
 	MString								uvSetName;
-	MColorArray							*colors;
+	COLOR_ARRAY							*colors;
 	MString								colorSetName;
 
-	std::list<MATERIAL_INFO>			*materials;
-};
-
-struct ADD_POINT_INFO
-{
-	ADD_POINT_INFO() : pointId(0), normalId(NULL), uvId(NULL), tgtBinormalId(NULL), colorId(NULL) {}
-	ADD_POINT_INFO(int pointId) : pointId(pointId), normalId(NULL), uvId(NULL), tgtBinormalId(NULL), colorId(NULL) {}
-
-	int pointId;
-	int *normalId;
-	int *uvId;
-	int *tgtBinormalId;
-	int *colorId;
+	std::vector<CPM_MATERIAL>			*materials; // un faceIds vide concerne le mesh entier
+	CPMStringPool						*strings; // reoit les noms des textures, NULL sans CPM_EXPORT_TEXTURENAMES: les matriaux gardent leurs couleurs
 };
 
 class CPMMeshExtractor
@@ -107,12 +49,18 @@ class CPMMeshExtractor
 
 	virtual MStatus extractMesh(MESH_EXTRACTOR_INFO &mesh);
 
+	// CPM_EXPORT_STREAMING: seuls les matriaux sont extraits dans mesh, les triangles et les vertices sont assembls par streamingMesh
+	virtual MStatus extractStreamingMesh(MESH_EXTRACTOR_INFO &mesh, CPMStreamingMesh &streamingMesh);
+
 	protected:
+	virtual MStatus extractSetNames(MESH_EXTRACTOR_INFO &mesh);
 	virtual MStatus extractGeometry(MESH_EXTRACTOR_INFO &mesh, unsigned int &numVertices);
 	virtual MStatus extractMaterials(MESH_EXTRACTOR_INFO &mesh);
+	virtual MStatus extractSource(const MESH_EXTRACTOR_INFO &mesh, ASSEMBLY_SOURCE &source);
 	virtual MStatus assembleMesh(MESH_EXTRACTOR_INFO &mesh, const unsigned int &numVertices);
 
-	virtual unsigned int addPoint(const ADD_POINT_INFO &point, unsigned int &actualNumVertices);
+	MStatus getWorldTransform(MESH_TRANSFORM &transform);
+
 	MObject findShader(const MObject &setNode);
 
 	protected:
@@ -121,11 +69,21 @@ class CPMMeshExtractor
 	MSpace::Space		m_space;
 
 	// Vertices
-	std::vector< std::list<DVerticeComponent> >	m_dVertices; // vertices dsassembls
+	CPMVertexWelder						m_welder; // assemble les vertices dsassembls
+
+	// Attributs du mesh source, tableaux contigus indexs par les ids des face-vertices (voir ASSEMBLY_SOURCE)
+	std::vector<double>					m_sourcePoints;
+	std::vector<float>					m_sourceNormals;
+	std::vector<float>					m_sourceU;
+	std::vector<float>					m_sourceV;
+	std::vector<float>					m_sourceTangents;
+	std::vector<float>					m_sourceBinormals;
+	std::vector<float>					m_sourceColors;
 
 	// Sets
 	MObjectArray						m_polygonSets;
 	MObjectArray						m_polygonComponents;
+	CPMTempFile							*m_polygonMaterials; // CPM_EXPORT_STREAMING: reoit le matriau de chaque polygone au lieu des faceIds
 };
 
 #endif // CPM_MESH_EXTRACTOR_H_INCLUDED
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "CPMMeshSplitter.h"
+#include "CPMMeshWriter.h"
+#include "CPMProfiler.h"
+
+template<typename ARRAY>
+static void GatherPart(ARRAY &values, const ARRAY &source, const std::vector<unsigned int> &sources, size_t numVertices)
+// Rsum: attributs des vertices d'un morceau, les attributs non exports (tableaux vides) restent vides
+{
+	if(source.size() == numVertices) values.gather(source, sources);
+}
+
+CPM_SPLIT_STATS SplitMesh(const CPM_MESH_DATA &mesh, unsigned int maxVertices, bool submeshes, std::vector<CPM_MESH_DATA> &parts)
+{
+	CPM_PROFILE_SCOPE("SplitMesh");
+	CPM_SPLIT_STATS stats;
+
+	const unsigned int numTriangles = (unsigned int) mesh.triangles.size() / 3;
+	const unsigned int numVertices = (unsigned int) mesh.points.size();
+	const unsigned int numMaterials = (unsigned int) mesh.materials.size();
+	stats.inputVertices = stats.outputVertices = numVertices;
+
+	// avec les sous-meshes, un mesh assez petit peut encore dpasser maxVertices une fois ses vertices dupliqus par BuildSubmeshes
+	parts.clear();
+	if((numVertices <= maxVertices && !submeshes) || maxVertices < 3) return stats;
+
+	// ordre des triangles: celui du mesh, ou celui de BuildSubmeshes (premier matriau qui rclame le triangle, puis les triangles sans matriau)
+	std::vector<unsigned int> order, groups(numTriangles, 0);
+	order.reserve(numTriangles);
+	if(submeshes && numMaterials > 1)
+	{
+		groups.assign(numTriangles, numMaterials);
+		for(unsigned int m = 0; m < numMaterials; m++)
+		{
+			const std::vector<unsigned int> &faceIds = mesh.materials[m].faceIds;
+			for(size_t i = 0; i < faceIds.size(); i++)
+			{
+				const unsigned int t = faceIds[i];
+				if(t < numTriangles && groups[t] == numMaterials)
+				{
+					groups[t] = m;
+					order.push_back(t);
+				}
+			}
+		}
+		for(unsigned int t = 0; t < numTriangles; t++) if(groups[t] == numMaterials) order.push_back(t);
+	}
+	else
+	{
+		for(unsigned int t = 0; t < numTriangles; t++) order.push_back(t);
+	}
+
+	// rpartition: un vertex est ajout au morceau la premire fois qu'un de ses triangles y entre,
+	// avec les sous-meshes il l'est une fois par groupe de triangles, comme BuildSubmeshes le fera
+	const unsigned int numGroups = submeshes ? numMaterials + 1 : 1;
+	std::vector<unsigned int> stamp(numVertices, ~0u), localIds(numVertices);
+	std::vector<unsigned int> partOf(numTriangles), localTriangles(numTriangles);
+	std::vector< std::vector<unsigned int> > sources(1), triangles(1);
+
+	unsigned int part = 0;
+	for(unsigned int i = 0; i < numTriangles; i++)
+	{
+		const unsigned int t = order[i];
+		const unsigned int *triangle = &mesh.triangles[3 * t];
+		const unsigned int group = submeshes ? groups[t] : 0;
+		unsigned int key = part * numGroups + group;
+
+		unsigned int added = 0;
+		for(unsigned int k = 0; k < 3; k++)
+		{
+			const unsigned int v = triangle[k];
+			if(stamp[v] != key && (k == 0 || v != triangle[0]) && (k < 2 || v != triangle[1])) added++;
+		}
+
+		if(sources[part].size() + added > maxVertices)
+		{
+			part++;
+			sources.push_back(std::vector<unsigned int>());
+			triangles.push_back(std::vector<unsigned int>());
+			key = part * numGroups + group;
+		}
+
+		for(unsigned int k = 0; k < 3; k++)
+		{
+			const unsigned int v = triangle[k];
+			if(stamp[v] != key)
+			{
+				stamp[v] = key;
+				localIds[v] = (unsigned int) sources[part].size();
+				sources[part].push_back(v);
+			}
+			triangles[part].push_back(localIds[v]);
+		}
+
+		partOf[t] = part;
+		localTriangles[t] = (unsigned int) triangles[part].size() / 3 - 1;
+	}
+
+	// construction des morceaux
+	const unsigned int numParts = part + 1;
+	if(numParts == 1) return stats;
+
+	parts.resize(numParts);
+	stats.outputVertices = 0;
+	for(unsigned int p = 0; p < numParts; p++)
+	{
+		CPM_MESH_DATA &data = parts[p];
+
+		char suffix[32];
+		sprintf(suffix, "_part%u", p);
+		data.name = mesh.name + suffix;
+		memcpy(data.transform, mesh.transform, sizeof(mesh.transform));
+		data.uvSetName = mesh.uvSetName;
+		data.colorSetName = mesh.colorSetName;
+		data.strings = mesh.strings;
+
+		data.triangles.swap(triangles[p]);
+		GatherPart(data.points, mesh.points, sources[p], numVertices);
+		GatherPart(data.normals, mesh.normals, sources[p], numVertices);
+		GatherPart(data.tangents, mesh.tangents, sources[p], numVertices);
+		GatherPart(data.binormals, mesh.binormals, sources[p], numVertices);
+		GatherPart(data.UVs, mesh.UVs, sources[p], numVertices);
+		GatherPart(data.colors, mesh.colors, sources[p], numVertices);
+
+		data.materials.resize(numMaterials);
+		for(unsigned int m = 0; m < numMaterials; m++) static_cast<CPM_MATERIAL_RECORD&>(data.materials[m]) = mesh.materials[m];
+
+		stats.outputVertices += (unsigned int) sources[p].size();
+	}
+
+	// listes de triangles des matriaux, dans leur ordre d'origine
+	std::vector<unsigned char> assigned(numTriangles, 0);
+	std::vector<unsigned int> assignedTriangles(numParts, 0);
+	for(unsigned int m = 0; m < numMaterials; m++)
+	{
+		const std::vector<unsigned int> &faceIds = mesh.materials[m].faceIds;
+		for(size_t i = 0; i < faceIds.size(); i++)
+		{
+			const unsigned int t = faceIds[i];
+			if(t >= numTriangles) continue;
+
+			parts[partOf[t]].materials[m].faceIds.push_back(localTriangles[t]);
+			if(!assigned[t])
+			{
+				assigned[t] = 1;
+				assignedTriangles[partOf[t]]++;
+			}
+		}
+	}
+
+	// un morceau ne garde que les matriaux dont il a des triangles, mais un matriau seul couvre tout le morceau (ses faceIds sont ignors):
+	// si le morceau a aussi des triangles sans matriau, un matriau vide est gard pour que les listes de triangles restent crites
+	if(numMaterials > 1)
+	{
+		std::vector<unsigned char> keep(numMaterials);
+		for(unsigned int p = 0; p < numParts; p++)
+		{
+			std::vector<CPM_MATERIAL> &materials = parts[p].materials;
+
+			unsigned int numKept = 0, firstEmpty = numMaterials;
+			for(unsigned int m = 0; m < numMaterials; m++)
+			{
+				keep[m] = !materials[m].faceIds.empty();
+				if(keep[m]) numKept++;
+				else if(firstEmpty == numMaterials) firstEmpty = m;
+			}
+			if(numKept == 1 && assignedTriangles[p] < parts[p].triangles.size() / 3) keep[firstEmpty] = 1;
+
+			size_t kept = 0;
+			for(unsigned int m = 0; m < numMaterials; m++)
+			{
+				if(!keep[m]) continue;
+				if(kept != m) std::swap(materials[kept], materials[m]);
+				kept++;
+			}
+			materials.resize(kept);
+		}
+	}
+
+	stats.parts = numParts;
+	return stats;
+}
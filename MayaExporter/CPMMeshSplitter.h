@@ -0,0 +1,29 @@
+#ifndef CPM_MESH_SPLITTER_H_INCLUDED
+#define CPM_MESH_SPLITTER_H_INCLUDED
+
+#include <vector>
+
+struct CPM_MESH_DATA;
+
+//
+//	Dcoupage des gros meshes (option CPM_EXPORT_SPLIT_16BIT)
+//	les triangles sont rpartis dans l'ordre en morceaux d'au plus maxVertices vertices, pour que chaque morceau
+//	utilise des indices 16 bits: seuls les vertices partags par deux morceaux sont dupliqus
+//	avec CPM_EXPORT_SUBMESHES, les triangles sont d'abord regroups par matriau et le compte tient compte des vertices
+//	que BuildSubmeshes dupliquera entre deux sous-meshes d'un mme morceau
+//
+struct CPM_SPLIT_STATS
+{
+	CPM_SPLIT_STATS() : inputVertices(0), outputVertices(0), parts(0) {}
+
+	unsigned int	inputVertices;
+	unsigned int	outputVertices;	// vertices dupliqus compris
+	unsigned int	parts;			// 0 si le mesh n'a pas t dcoup
+};
+
+// remplit parts si le mesh dpasse maxVertices (mesh n'est pas modifi), laisse parts vide sinon
+// chaque morceau garde le nom suivi de "_partN", la transformation et les matriaux dont il a des triangles,
+// plus un matriau vide si un seul matriau couvrirait aussi ses triangles sans matriau
+CPM_SPLIT_STATS SplitMesh(const CPM_MESH_DATA &mesh, unsigned int maxVertices, bool submeshes, std::vector<CPM_MESH_DATA> &parts);
+
+#endif // CPM_MESH_SPLITTER_H_INCLUDED
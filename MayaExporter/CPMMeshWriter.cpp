@@ -0,0 +1,627 @@
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "CPMMeshWriter.h"
+#include "CPMAttributeWriter.h"
+#include "CPMFormat.h"
+#include "CPMChecksum.h"
+#include "CPMIndexCodec.h"
+#include "CPMVertexLayout.h"
+#include "CPMProfiler.h"
+
+#define CPM_MATERIAL_FACE_BLOCK		(16 << 10)	// triangles d'un matriau lus ensemble dans CPMMaterialFaces
+
+
+CPM_MESH_DATA::CPM_MESH_DATA() : strings(NULL)
+{
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		for(unsigned int j = 0; j < 4; j++) transform[i][j] = i == j ? 1.0 : 0.0;
+	}
+}
+
+
+//
+//	Largeur des indices
+//
+CPM_SCALAR_TYPE GetIndexType(unsigned long long numVertices, unsigned int exportOptions)
+{
+	if(!(exportOptions & CPM_EXPORT_BINARY)) return CPM_SCALAR_UINT32;
+	return numVertices <= CPM_MAX_16BIT_VERTICES ? CPM_SCALAR_UINT16 : CPM_SCALAR_UINT32;
+}
+
+CPM_INDEX_LAYOUT GetIndexLayout(const CPM_MESH_DATA &mesh, unsigned int exportOptions)
+{
+	CPM_INDEX_LAYOUT layout;
+	layout.type = GetIndexType(mesh.points.size(), exportOptions);
+
+	// un objet trop grand peut encore utiliser des indices 16 bits si chaque sous-mesh tient dans 65536 vertices
+	if(layout.type == CPM_SCALAR_UINT32 && (exportOptions & CPM_EXPORT_BINARY) && (exportOptions & CPM_EXPORT_SUBMESHES))
+	{
+		bool fits = true;
+		unsigned int end = 0;
+		for(size_t m = 0; m < mesh.materials.size() && fits; m++)
+		{
+			const CPM_SUBMESH &range = mesh.materials[m].submesh;
+			fits = range.vertexCount <= CPM_MAX_16BIT_VERTICES;
+			end = range.firstVertex + range.vertexCount;
+		}
+
+		// triangles sans matriau, aprs le dernier sous-mesh
+		if(fits && mesh.points.size() - end <= CPM_MAX_16BIT_VERTICES)
+		{
+			layout.type = CPM_SCALAR_UINT16;
+			layout.baseVertex = true;
+		}
+	}
+
+	if(layout.type == CPM_SCALAR_UINT16) layout.savedBytes = (unsigned long long) mesh.triangles.size() * (sizeof(unsigned int) - sizeof(unsigned short));
+
+	// les indices compresss restent absolus: leurs diffrences sont dj petites, sous-meshes ou non
+	if((exportOptions & CPM_EXPORT_BINARY) && (exportOptions & CPM_EXPORT_INDEX_CODEC) && !mesh.triangles.empty())
+	{
+		const unsigned long long rawSize = (unsigned long long) mesh.triangles.size() * sizeof(unsigned int);
+		const unsigned long long encodedSize = EncodedIndexSize(&mesh.triangles[0], mesh.triangles.size());
+		if(encodedSize < rawSize - layout.savedBytes)
+		{
+			layout.type = CPM_SCALAR_UINT32;
+			layout.baseVertex = false;
+			layout.encoded = true;
+			layout.encodedSize = encodedSize;
+			layout.savedBytes = rawSize - encodedSize;
+		}
+	}
+
+	return layout;
+}
+
+
+//
+//	En-tte et fin du fichier
+//
+void WriteFileHeader(std::ostream &os, unsigned int exportOptions)
+{
+	const CPM_PRECISION precision = GetExportPrecision(exportOptions);
+
+	if(exportOptions & CPM_EXPORT_BINARY)
+	{
+		CPM_BINARY_HEADER header;
+		memcpy(header.magic, CPM_BINARY_MAGIC, 4);
+		header.version = CPM_BINARY_VERSION;
+		header.exportOptions = exportOptions;
+		header.positions = (unsigned char) precision.positions;
+		header.normals = (unsigned char) precision.normals;
+		header.tangents = (unsigned char) precision.tangents;
+		header.binormals = (unsigned char) precision.binormals;
+		header.uvs = (unsigned char) precision.uvs;
+		header.sectionAlignment = 0;
+		for(unsigned int alignment = GetSectionAlignment(exportOptions); alignment > 1; alignment >>= 1) header.sectionAlignment++;
+		memset(header.reserved, 0, sizeof(header.reserved));
+
+		WriteBinary(os, header);
+		return;
+	}
+
+	os << "CPM_FILE\n" << std::endl;
+	os << "Precision: positions " << ScalarTypeName(precision.positions) << " normals " << ScalarTypeName(precision.normals)
+		<< " tangents " << ScalarTypeName(precision.tangents) << " binormals " << ScalarTypeName(precision.binormals)
+		<< " uvs " << ScalarTypeName(precision.uvs) << "\n" << std::endl;
+}
+
+static unsigned long long WriteChecksums(CPMChecksumOStream &os)
+// Rsum: sommes de tout ce qui a t crit jusqu'ici, retourne la position de la section
+{
+	const unsigned long long position = (unsigned long long) os.tellp();
+
+	std::vector<unsigned int> checksums;
+	os.getChecksums(checksums);
+
+	CPM_CHECKSUM_TABLE table;
+	table.blockSize = os.getBlockSize();
+	table.reserved = 0;
+	table.size = position;
+
+	const unsigned int count = (unsigned int) checksums.size();
+	WriteSectionHeader(os, CPM_TAG_CHECKSUMS, count, CPM_SCALAR_NONE, 0, sizeof(table) + count * sizeof(unsigned int));
+	WriteBinary(os, table);
+	if(count) os.write((const char*) &checksums[0], count * sizeof(unsigned int));
+	return position;
+}
+
+void WriteFileFooter(std::ostream &os, unsigned int exportOptions, const CPMStringPool &strings, const CPMObjectTable &objects)
+{
+	if(exportOptions & CPM_EXPORT_BINARY)
+	{
+		// les matriaux de tous les meshes dsignent leurs textures par un offset dans cette section
+		if(strings.count())
+		{
+			const std::vector<char> &data = strings.data();
+			WriteSectionHeader(os, CPM_TAG_STRINGS, strings.count(), CPM_SCALAR_NONE, 0, data.size());
+			os.write(&data[0], data.size());
+		}
+
+		const unsigned long long table = objects.writeTable(os, exportOptions);
+
+		// seul le flux sait ce qui est pass par lui: les sommes sont calcules pendant l'criture, pas relues ici
+		CPMChecksumOStream *sink = dynamic_cast<CPMChecksumOStream*>(&os);
+		const unsigned long long checksums = sink ? WriteChecksums(*sink) : 0;
+
+		WriteSectionHeader(os, CPM_TAG_END, 0, CPM_SCALAR_NONE, 0, 0);
+		objects.writeTrailer(os, exportOptions, table, checksums);
+		return;
+	}
+
+	const unsigned long long table = objects.writeTable(os, exportOptions);
+	os << "CPM_FILE_END";
+	objects.writeTrailer(os, exportOptions, table, 0);
+}
+
+
+//
+//	CPMMeshWriter
+//
+CPMMeshWriter::CPMMeshWriter(const CPM_MESH_DATA &mesh, unsigned int exportOptions) : m_mesh(mesh), m_exportOptions(exportOptions),
+	m_precision(GetExportPrecision(exportOptions)), m_binary((exportOptions & CPM_EXPORT_BINARY) != 0)
+{
+
+}
+
+void CPMMeshWriter::write(std::ostream &os, CPMObjectTable *objects)
+// Rsum: chaque attribut est une colonne de la table des objets
+{
+	if(objects) objects->begin(os);
+
+	BeginColumn(objects, os, CPM_TAG_OBJECT);
+	writeObjectProperties(os);
+	BeginColumn(objects, os, CPM_TAG_TRIANGLES);
+	writeTriangles(os);
+	if(m_exportOptions & CPM_EXPORT_ADJACENCY)
+	{
+		BeginColumn(objects, os, CPM_TAG_ADJACENCY);
+		writeAdjacency(os);
+	}
+	if(m_binary && (m_exportOptions & CPM_EXPORT_INTERLEAVED))
+	{
+		BeginColumn(objects, os, CPM_TAG_VERTEX_BUFFER);
+		writeInterleavedVertices(os);
+	}
+	else
+	{
+		BeginColumn(objects, os, CPM_TAG_VERTICES);
+		writeVertices(os);
+		BeginColumn(objects, os, CPM_TAG_NORMALS);
+		writeNormals(os);
+		BeginColumn(objects, os, CPM_TAG_TANGENTS);
+		writeTangents(os);
+		BeginColumn(objects, os, CPM_TAG_BINORMALS);
+		writeBinormals(os);
+		BeginColumn(objects, os, CPM_TAG_UVS);
+		writeUVs(os);
+		BeginColumn(objects, os, CPM_TAG_COLORS);
+		writeColors(os);
+	}
+	BeginColumn(objects, os, CPM_TAG_MATERIALS);
+	writeMaterialSets(os);
+
+	if(objects) objects->end(os, m_mesh.name, ComputeBounds(m_mesh.points));
+}
+
+void CPMMeshWriter::writeObjectProperties(std::ostream &os)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeObjectProperties", os);
+	const double (&m)[4][4] = m_mesh.transform;
+
+	if(m_binary)
+	{
+		std::ostringstream data;
+		WriteBinaryString(data, m_mesh.name.c_str());
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			for(unsigned int j = 0; j < 4; j++) WriteBinary(data, m[i][j]);
+		}
+		WriteSection(os, CPM_TAG_OBJECT, 1, data.str());
+		return;
+	}
+
+	os << "Object: " << m_mesh.name << std::endl;
+	os << "TransformMatrix: " << std::endl;
+	for(unsigned int i = 0; i < 4; i++) os << m[i][0] << " " << m[i][1] << " " << m[i][2] << " " << m[i][3] << std::endl;
+	os << std::endl;
+}
+
+void CPMMeshWriter::writeTriangles(std::ostream &os)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeTriangles", os);
+	const CPM_INDEX_LAYOUT layout = GetIndexLayout(m_mesh, m_exportOptions);
+
+	if(layout.encoded) writeEncodedTriangles(os, layout);
+	else if(layout.type == CPM_SCALAR_UINT16) writeTrianglesAs<unsigned short>(os, layout);
+	else writeTrianglesAs<unsigned int>(os, layout);
+}
+
+void CPMMeshWriter::writeEncodedTriangles(std::ostream &os, const CPM_INDEX_LAYOUT &layout)
+// Rsum: format binaire seulement, la taille de la section a t calcule par GetIndexLayout
+{
+	WriteAlignedSectionHeader(os, GetSectionAlignment(m_exportOptions, layout.encodedSize), CPM_TAG_TRIANGLES, (unsigned int) m_mesh.triangles.size() / 3,
+		CPM_SCALAR_UINT32, 3, layout.encodedSize, CPM_SECTION_INDEX_CODEC);
+
+	CPMIndexEncoder encoder(&os);
+	encoder.encode(&m_mesh.triangles[0], m_mesh.triangles.size());
+	encoder.finish();
+}
+
+template<typename T>
+void CPMMeshWriter::writeTrianglesAs(std::ostream &os, const CPM_INDEX_LAYOUT &layout)
+{
+	const unsigned int numTriangles = (unsigned int) m_mesh.triangles.size() / 3;
+
+	// le sens des faces a dj t appliqu par ApplyAxisConversion
+	CPMAttributeWriter<T> writer(os, m_exportOptions);
+	writer.begin("Triangles", CPM_TAG_TRIANGLES, numTriangles, 3, layout.baseVertex ? CPM_SECTION_BASE_VERTEX : 0);
+	if(!layout.baseVertex)
+	{
+		if(numTriangles) writer.writeInterleaved(&m_mesh.triangles[0], numTriangles);
+		writer.end();
+		return;
+	}
+
+	// les sous-meshes se suivent dans le tableau des triangles, les triangles sans matriau sont  la fin
+	std::vector<unsigned int> relative;
+	unsigned int first = 0, baseVertex = 0;
+	for(size_t m = 0; m <= m_mesh.materials.size(); m++)
+	{
+		const bool last = m == m_mesh.materials.size();
+		const unsigned int count = last ? (unsigned int) m_mesh.triangles.size() - first : m_mesh.materials[m].submesh.indexCount;
+		if(!last) baseVertex = m_mesh.materials[m].submesh.firstVertex;
+
+		relative.resize(count);
+		for(unsigned int i = 0; i < count; i++) relative[i] = m_mesh.triangles[first + i] - baseVertex;
+		if(count) writer.writeInterleaved(&relative[0], count / 3);
+
+		first += count;
+		if(!last) baseVertex += m_mesh.materials[m].submesh.vertexCount;
+	}
+	writer.end();
+}
+
+void CPMMeshWriter::writeAdjacency(std::ostream &os)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeAdjacency", os);
+
+	if(GetIndexType(m_mesh.points.size(), m_exportOptions) == CPM_SCALAR_UINT16) writeAdjacencyAs<unsigned short>(os);
+	else writeAdjacencyAs<unsigned int>(os);
+}
+
+template<typename T>
+void CPMMeshWriter::writeAdjacencyAs(std::ostream &os)
+// Rsum: indices absolus, un mesh export sans BuildMeshAdjacency reoit une section vide
+{
+	const unsigned int numTriangles = (unsigned int) m_mesh.adjacency.size() / 6;
+
+	CPMAttributeWriter<T> writer(os, m_exportOptions);
+	writer.begin("Adjacency", CPM_TAG_ADJACENCY, numTriangles, 6, 0);
+	if(numTriangles) writer.writeInterleaved(&m_mesh.adjacency[0], numTriangles);
+	writer.end();
+}
+
+//
+//	Les fonctions write* choisissent la prcision de l'attribut, les fonctions write*As sont instancies pour chaque prcision
+//
+void CPMMeshWriter::writeVertices(std::ostream &os)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeVertices", os);
+	writeVector3(os, m_precision.positions, "Vertices", CPM_TAG_VERTICES, m_mesh.points);
+}
+
+void CPMMeshWriter::writeNormals(std::ostream &os)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeNormals", os);
+	if(m_exportOptions & CPM_EXPORT_NORMALS) writeVector3(os, m_precision.normals, "Normals", CPM_TAG_NORMALS, m_mesh.normals);
+}
+
+void CPMMeshWriter::writeTangents(std::ostream &os)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeTangents", os);
+	if(m_exportOptions & CPM_EXPORT_TGT_BINORMALS) writeVector3(os, m_precision.tangents, "Tangents", CPM_TAG_TANGENTS, m_mesh.tangents);
+}
+
+void CPMMeshWriter::writeBinormals(std::ostream &os)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeBinormals", os);
+	if(m_exportOptions & CPM_EXPORT_TGT_BINORMALS) writeVector3(os, m_precision.binormals, "Bitangents", CPM_TAG_BINORMALS, m_mesh.binormals);
+}
+
+void CPMMeshWriter::writeUVs(std::ostream &os)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeUVs", os);
+
+	if(m_exportOptions & CPM_EXPORT_UVS)
+	{
+		switch(m_precision.uvs)
+		{
+			case CPM_SCALAR_DOUBLE:		writeUVsAs<double>(os); break;
+			case CPM_SCALAR_HALF:		writeUVsAs<HALF>(os); break;
+			default:					writeUVsAs<float>(os); break;
+		}
+	}
+}
+
+void CPMMeshWriter::writeColors(std::ostream &os)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeColors", os);
+
+	if(m_exportOptions & CPM_EXPORT_COLORS)
+	{
+		switch(m_precision.colors)
+		{
+			case CPM_SCALAR_DOUBLE:		writeColorsAs<double>(os); break;
+			case CPM_SCALAR_HALF:		writeColorsAs<HALF>(os); break;
+			default:					writeColorsAs<float>(os); break;
+		}
+	}
+}
+
+template<typename S>
+static CPM_VERTEX_SOURCE VertexSource(const VECTOR3_ARRAY<S> &vectors, size_t numVertices)
+{
+	CPM_VERTEX_SOURCE source;
+	source.type = SCALAR_TRAITS<S>::type;
+	if(vectors.size() == numVertices && numVertices) { source.components[0] = &vectors.x[0]; source.components[1] = &vectors.y[0]; source.components[2] = &vectors.z[0]; }
+	return source;
+}
+
+void CPMMeshWriter::writeInterleavedVertices(std::ostream &os)
+// Rsum: format binaire seulement, remplace les sections des attributs par CPM_TAG_VERTEX_FORMAT et CPM_TAG_VERTEX_BUFFER
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeInterleavedVertices", os);
+
+	const CPM_VERTEX_LAYOUT layout = GetVertexLayout(m_exportOptions);
+	const size_t numVertices = m_mesh.points.size();
+
+	std::vector<CPM_VERTEX_SOURCE> sources(layout.attributes.size());
+	for(size_t a = 0; a < layout.attributes.size(); a++)
+	{
+		const char *tag = layout.attributes[a].tag;
+		if(memcmp(tag, CPM_TAG_VERTICES, 4) == 0) sources[a] = VertexSource(m_mesh.points, numVertices);
+		else if(memcmp(tag, CPM_TAG_NORMALS, 4) == 0) sources[a] = VertexSource(m_mesh.normals, numVertices);
+		else if(memcmp(tag, CPM_TAG_TANGENTS, 4) == 0) sources[a] = VertexSource(m_mesh.tangents, numVertices);
+		else if(memcmp(tag, CPM_TAG_BINORMALS, 4) == 0) sources[a] = VertexSource(m_mesh.binormals, numVertices);
+		else if(memcmp(tag, CPM_TAG_UVS, 4) == 0 && m_mesh.UVs.size() == numVertices && numVertices)
+		{
+			sources[a].components[0] = &m_mesh.UVs.u[0];
+			sources[a].components[1] = &m_mesh.UVs.v[0];
+		}
+		else if(memcmp(tag, CPM_TAG_COLORS, 4) == 0 && m_mesh.colors.size() == numVertices && numVertices)
+		{
+			sources[a].components[0] = &m_mesh.colors.r[0];
+			sources[a].components[1] = &m_mesh.colors.g[0];
+			sources[a].components[2] = &m_mesh.colors.b[0];
+			sources[a].components[3] = &m_mesh.colors.a[0];
+		}
+	}
+
+	const unsigned int alignment = GetSectionAlignment(m_exportOptions);
+	WriteVertexFormat(os, layout, alignment);
+	BeginVertexBuffer(os, layout, (unsigned int) numVertices, alignment);
+
+	const size_t block = (1 << 20) / layout.stride;
+	std::vector<unsigned char> buffer(block * layout.stride);
+	for(size_t first = 0; first < numVertices; first += block)
+	{
+		const size_t n = numVertices - first < block ? numVertices - first : block;
+		InterleaveVertices(layout, &sources[0], first, n, &buffer[0]);
+		os.write((const char*) &buffer[0], n * layout.stride);
+	}
+}
+
+template<typename S>
+void CPMMeshWriter::writeVector3(std::ostream &os, CPM_SCALAR_TYPE precision, const char *name, const char *tag, const VECTOR3_ARRAY<S> &vectors)
+{
+	switch(precision)
+	{
+		case CPM_SCALAR_DOUBLE:		writeVector3As<double>(os, name, tag, vectors); break;
+		case CPM_SCALAR_HALF:		writeVector3As<HALF>(os, name, tag, vectors); break;
+		default:					writeVector3As<float>(os, name, tag, vectors); break;
+	}
+}
+
+template<typename T, typename S>
+void CPMMeshWriter::writeVector3As(std::ostream &os, const char *name, const char *tag, const VECTOR3_ARRAY<S> &vectors)
+{
+	const S *arrays[3] = { NULL, NULL, NULL };
+	if(vectors.size()) { arrays[0] = &vectors.x[0]; arrays[1] = &vectors.y[0]; arrays[2] = &vectors.z[0]; }
+
+	CPMAttributeWriter<T> writer(os, m_exportOptions);
+	writer.begin(name, tag, (unsigned int) vectors.size(), 3);
+	writer.writeArrays(arrays, vectors.size());
+	writer.end();
+}
+
+template<typename T>
+void CPMMeshWriter::writeUVsAs(std::ostream &os)
+{
+	const float *arrays[2] = { NULL, NULL };
+	if(m_mesh.UVs.size()) { arrays[0] = &m_mesh.UVs.u[0]; arrays[1] = &m_mesh.UVs.v[0]; }
+
+	CPMAttributeWriter<T> writer(os, m_exportOptions);
+	writer.begin("UVs", CPM_TAG_UVS, (unsigned int) m_mesh.UVs.size(), 2);
+	writer.writeArrays(arrays, m_mesh.UVs.size());
+	writer.end();
+}
+
+template<typename T>
+void CPMMeshWriter::writeColorsAs(std::ostream &os)
+{
+	const float *arrays[4] = { NULL, NULL, NULL, NULL };
+	if(m_mesh.colors.size()) { arrays[0] = &m_mesh.colors.r[0]; arrays[1] = &m_mesh.colors.g[0]; arrays[2] = &m_mesh.colors.b[0]; arrays[3] = &m_mesh.colors.a[0]; }
+
+	CPMAttributeWriter<T> writer(os, m_exportOptions);
+	writer.begin("Colors", CPM_TAG_COLORS, (unsigned int) m_mesh.colors.size(), 4);
+	writer.writeArrays(arrays, m_mesh.colors.size());
+	writer.end();
+}
+
+
+//
+//	Matriaux
+//
+unsigned int CPMMeshWriter::textureName(unsigned int texName) const
+// Rsum: offset du nom de texture crit dans le fichier: le chemin complet ou seulement le nom du fichier, 0 sans texture
+{
+	if(!m_mesh.strings || !(m_exportOptions & CPM_EXPORT_TEXTURENAMES)) return 0;
+	return (m_exportOptions & CPM_EXPORT_TRUNCATE_TEXTURENAMES) ? m_mesh.strings->fileName(texName) : texName;
+}
+
+class CPMMaterialFaceIds : public CPMMaterialFaces
+// Triangles des matriaux en mmoire, dans leurs faceIds
+{
+	public:
+	CPMMaterialFaceIds(const std::vector<CPM_MATERIAL> &materials) : m_materials(materials) {}
+
+	virtual unsigned int count(size_t material) const { return (unsigned int) m_materials[material].faceIds.size(); }
+	virtual bool read(size_t material, unsigned int first, unsigned int count, unsigned int *faces)
+	{
+		if(count) memcpy(faces, &m_materials[material].faceIds[first], count * sizeof(unsigned int));
+		return true;
+	}
+
+	protected:
+	const std::vector<CPM_MATERIAL>	&m_materials;
+};
+
+void CPMMeshWriter::writeMaterialSets(std::ostream &os)
+{
+	CPMMaterialFaceIds faces(m_mesh.materials);
+	writeMaterialSets(os, faces);
+}
+
+bool CPMMeshWriter::writeMaterialSets(std::ostream &os, CPMMaterialFaces &faces)
+{
+	CPM_PROFILE_SECTION("CPMMeshWriter::writeMaterialSets", os);
+
+	if(!(m_exportOptions & CPM_EXPORT_MATERIALSETS)) return true;
+	if(m_binary) return writeBinaryMaterialSets(os, faces);
+
+	const unsigned int numSets = (unsigned int) m_mesh.materials.size();
+	std::vector<unsigned int> block;
+
+	os << "Materials: " << numSets << "\n" << std::endl;
+	for(size_t m = 0; m < numSets; m++)
+	{
+		const CPM_MATERIAL *it = &m_mesh.materials[m];
+		os << "material:" << std::endl;
+
+		if(textureName(it->colorTexName)) os << "colorTexName: " << m_mesh.strings->get(textureName(it->colorTexName)) << std::endl;
+		else os << "color: " << it->color[0] << " " << it->color[1] << " " << it->color[2] << " " << it->color[3] << std::endl;
+
+		if(textureName(it->specularColorTexName)) os << "specularColorTexName: " << m_mesh.strings->get(textureName(it->specularColorTexName)) << std::endl;
+		else os << "specularColor: " << it->specularColor[0] << " " << it->specularColor[1] << " " << it->specularColor[2] << " " << it->specularColor[3] << std::endl;
+
+		if(textureName(it->specularPowerTexName)) os << "specularPowerTexName: " << m_mesh.strings->get(textureName(it->specularPowerTexName)) << std::endl;
+		else os << "specularPower: " << it->specularPower << std::endl;
+
+		if(textureName(it->ambientTexName)) os << "ambientTexName: " << m_mesh.strings->get(textureName(it->ambientTexName)) << std::endl;
+		else os << "ambient: " << it->ambient[0] << " " << it->ambient[1] << " " << it->ambient[2] << " " << it->ambient[3] << std::endl;
+
+		if(textureName(it->transparencyTexName)) os << "transparencyTexName: " << m_mesh.strings->get(textureName(it->transparencyTexName)) << std::endl;
+		else os << "transparency: " << it->transparency[0] << " " << it->transparency[1] << " " << it->transparency[2] << " " << it->transparency[3] << std::endl;
+
+		if(textureName(it->normalTexName)) os << "normalTexName: " << m_mesh.strings->get(textureName(it->normalTexName)) << std::endl;
+		if(textureName(it->bumpTexName)) os << "bumpTexName: " << m_mesh.strings->get(textureName(it->bumpTexName)) << std::endl;
+
+		if(m_exportOptions & CPM_EXPORT_SUBMESHES)
+		{
+			os << "Range: " << it->submesh.firstIndex << " " << it->submesh.indexCount << " " << it->submesh.firstVertex << " " << it->submesh.vertexCount << std::endl;
+		}
+		else if(numSets != 1)
+		{
+			const unsigned int numFaces = faces.count(m);
+			os << "Faces: " << numFaces << std::endl;
+			for(unsigned int first = 0; first < numFaces; first += CPM_MATERIAL_FACE_BLOCK)
+			{
+				const unsigned int n = std::min<unsigned int>(CPM_MATERIAL_FACE_BLOCK, numFaces - first);
+				block.resize(n);
+				if(!faces.read(m, first, n, &block[0])) return false;
+				for(unsigned int i = 0; i < n; i++) os << block[i] << std::endl;
+			}
+		}
+		else
+		{
+			os << "faces: " << 0 << std::endl;
+		}
+
+		os << "\n";
+	}
+	os << "\n\n";
+	return true;
+}
+
+
+void CPMMeshWriter::writeMaterialSlot(std::ostream &os, unsigned int texName, const float *values, unsigned int numValues) const
+// Rsum: crit un paramtre de matriau au format binaire: 0 = absent, 1 = valeurs, 2 = offset du nom de texture dans la section CPM_TAG_STRINGS
+{
+	const unsigned int name = textureName(texName);
+	if(name)
+	{
+		WriteBinary(os, (unsigned char) 2);
+		WriteBinary(os, name);
+	}
+	else if(values)
+	{
+		WriteBinary(os, (unsigned char) 1);
+		os.write((const char*) values, numValues * sizeof(float));
+	}
+	else
+	{
+		WriteBinary(os, (unsigned char) 0);
+	}
+}
+
+bool CPMMeshWriter::writeBinaryMaterialSets(std::ostream &os, CPMMaterialFaces &faces)
+// Rsum: les paramtres des matriaux sont prpars en mmoire pour calculer la taille de la section, les triangles sont recopis par blocs
+{
+	const size_t numSets = m_mesh.materials.size();
+	std::vector<std::string> slots(numSets);
+	unsigned long long size = 0;
+
+	for(size_t m = 0; m < numSets; m++)
+	{
+		const CPM_MATERIAL *it = &m_mesh.materials[m];
+		std::ostringstream data;
+		writeMaterialSlot(data, it->colorTexName, it->color, 4);
+		writeMaterialSlot(data, it->specularColorTexName, it->specularColor, 4);
+		writeMaterialSlot(data, it->specularPowerTexName, &it->specularPower, 1);
+		writeMaterialSlot(data, it->ambientTexName, it->ambient, 4);
+		writeMaterialSlot(data, it->transparencyTexName, it->transparency, 4);
+		writeMaterialSlot(data, it->normalTexName, NULL, 0);
+		writeMaterialSlot(data, it->bumpTexName, NULL, 0);
+
+		if(m_exportOptions & CPM_EXPORT_SUBMESHES) WriteBinary(data, it->submesh);
+		slots[m] = data.str();
+
+		size += slots[m].size();
+		if(!(m_exportOptions & CPM_EXPORT_SUBMESHES)) size += sizeof(unsigned int) * (numSets != 1 ? 1ULL + faces.count(m) : 1ULL);
+	}
+
+	WriteSectionHeader(os, CPM_TAG_MATERIALS, (unsigned int) numSets, CPM_SCALAR_NONE, 0, size);
+
+	std::vector<unsigned int> block;
+	for(size_t m = 0; m < numSets; m++)
+	{
+		os.write(slots[m].data(), slots[m].size());
+		if(m_exportOptions & CPM_EXPORT_SUBMESHES) continue;
+
+		// le mesh entier est concern s'il n'y a qu'un matriau
+		const unsigned int numFaces = numSets != 1 ? faces.count(m) : 0;
+		WriteBinary(os, numFaces);
+		for(unsigned int first = 0; first < numFaces; first += CPM_MATERIAL_FACE_BLOCK)
+		{
+			const unsigned int n = std::min<unsigned int>(CPM_MATERIAL_FACE_BLOCK, numFaces - first);
+			block.resize(n);
+			if(!faces.read(m, first, n, &block[0])) return false;
+			os.write((const char*) &block[0], n * sizeof(unsigned int));
+		}
+	}
+	return true;
+}
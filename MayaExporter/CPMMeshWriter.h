@@ -0,0 +1,168 @@
+#ifndef CPM_MESH_WRITER_H_INCLUDED
+#define CPM_MESH_WRITER_H_INCLUDED
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "CPMMeshBuffers.h"
+#include "CPMExportOptions.h"
+#include "CPMStringPool.h"
+#include "CPMObjectTable.h"
+
+//
+//	Ecriture des fichiers CPM, indpendante de l'API Maya
+//	partage par le plugin (CPMPolyWriter) et les outils en ligne de commande
+//
+struct CPM_SUBMESH
+// Intervalles d'un matriau avec CPM_EXPORT_SUBMESHES: indices [firstIndex, firstIndex + indexCount) du tableau des triangles,
+// qui n'utilisent que les vertices [firstVertex, firstVertex + vertexCount)
+{
+	CPM_SUBMESH() : firstIndex(0), indexCount(0), firstVertex(0), vertexCount(0) {}
+
+	unsigned int	firstIndex;
+	unsigned int	indexCount;
+	unsigned int	firstVertex;
+	unsigned int	vertexCount;
+};
+
+struct CPM_MATERIAL_RECORD
+// Paramtres d'un matriau, sans allocation: les noms des textures sont des offsets dans le CPMStringPool du mesh, 0 = pas de texture
+{
+	CPM_MATERIAL_RECORD() : colorTexName(0), specularColorTexName(0), specularPower(255.0f), specularPowerTexName(0), ambientTexName(0), transparencyTexName(0),
+		normalTexName(0), bumpTexName(0)
+	{
+		SetColor(color, 1.0f, 1.0f, 1.0f, 1.0f);
+		SetColor(specularColor, 0.0f, 0.0f, 0.0f, 0.0f);
+		SetColor(ambient, 0.0f, 0.0f, 0.0f, 1.0f);
+		SetColor(transparency, 0.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	static void SetColor(float *c, float r, float g, float b, float a) { c[0] = r; c[1] = g; c[2] = b; c[3] = a; }
+
+	float			color[4];			// r, g, b, a
+	unsigned int	colorTexName;
+
+	float			specularColor[4];
+	unsigned int	specularColorTexName;
+
+	float			specularPower;
+	unsigned int	specularPowerTexName;
+
+	float			ambient[4];
+	unsigned int	ambientTexName;
+
+	float			transparency[4];
+	unsigned int	transparencyTexName;
+
+	unsigned int	normalTexName;
+	unsigned int	bumpTexName;
+};
+
+struct CPM_MATERIAL : public CPM_MATERIAL_RECORD
+{
+	std::vector<unsigned int>	faceIds; // triangles concerns par le matriau, ignors s'il n'y a qu'un matriau
+	CPM_SUBMESH					submesh; // remplace faceIds avec CPM_EXPORT_SUBMESHES, voir BuildSubmeshes
+};
+
+struct CPM_MESH_DATA
+// Mesh prt  tre crit: vertices assembls, conversion des axes dj applique
+{
+	CPM_MESH_DATA();
+
+	std::string					name;
+	double						transform[4][4];	// identit si les vertices sont dans l'espace monde
+
+	std::vector<unsigned int>	triangles;
+	std::vector<unsigned int>	adjacency;	// 6 indices par triangle avec CPM_EXPORT_ADJACENCY, voir BuildMeshAdjacency
+
+	VECTOR3_ARRAY<double>		points;
+	VECTOR3_ARRAY<float>		normals;
+	VECTOR3_ARRAY<float>		tangents;
+	VECTOR3_ARRAY<float>		binormals;
+	UV_ARRAY					UVs;
+	std::string					uvSetName;
+	COLOR_ARRAY					colors;
+	std::string					colorSetName;
+
+	std::vector<CPM_MATERIAL>	materials;
+	const CPMStringPool			*strings; // noms des textures des matriaux, NULL si aucun matriau n'a de texture
+};
+
+//
+//	Largeur des indices des triangles au format binaire, choisie pour chaque objet: 16 bits quand tous les indices tiennent,
+//	y compris quand ils sont relatifs aux sous-meshes (CPM_EXPORT_SUBMESHES); au format texte les indices restent des entiers
+//	avec CPM_EXPORT_INDEX_CODEC, les indices sont compresss si la section est plus petite qu'avec la largeur choisie
+//
+#define CPM_MAX_16BIT_VERTICES		65536
+
+struct CPM_INDEX_LAYOUT
+{
+	CPM_INDEX_LAYOUT() : type(CPM_SCALAR_UINT32), baseVertex(false), encoded(false), encodedSize(0), savedBytes(0) {}
+
+	CPM_SCALAR_TYPE		type;
+	bool				baseVertex;		// indices relatifs au premier vertex de chaque sous-mesh, voir CPM_SECTION_BASE_VERTEX
+	bool				encoded;		// indices absolus compresss, voir CPM_SECTION_INDEX_CODEC
+	unsigned long long	encodedSize;
+	unsigned long long	savedBytes;		// taille conomise par rapport  des indices 32 bits
+};
+
+CPM_SCALAR_TYPE GetIndexType(unsigned long long numVertices, unsigned int exportOptions);
+CPM_INDEX_LAYOUT GetIndexLayout(const CPM_MESH_DATA &mesh, unsigned int exportOptions);
+
+// dbut et fin du fichier, autour des meshes: la fin du fichier binaire contient la table des chanes de la session,
+// la fin des deux formats la table des objets et le trailer qui la dsigne
+// un fichier binaire crit  travers CPMChecksumOStream reoit en plus la section des sommes de contrle
+void WriteFileHeader(std::ostream &os, unsigned int exportOptions);
+void WriteFileFooter(std::ostream &os, unsigned int exportOptions, const CPMStringPool &strings, const CPMObjectTable &objects);
+
+class CPMMaterialFaces
+// Triangles des matriaux, lus par blocs  l'criture: les faceIds d'un mesh export hors mmoire restent dans un fichier temporaire
+{
+	public:
+	virtual ~CPMMaterialFaces() {}
+
+	virtual unsigned int count(size_t material) const = 0;
+	virtual bool read(size_t material, unsigned int first, unsigned int count, unsigned int *faces) = 0;
+};
+
+class CPMMeshWriter
+{
+	public:
+	CPMMeshWriter(const CPM_MESH_DATA &mesh, unsigned int exportOptions);
+
+	void write(std::ostream &os, CPMObjectTable *objects = NULL); // crit toutes les sections du mesh et les enregistre dans objects
+
+	void writeObjectProperties(std::ostream &os);
+	void writeTriangles(std::ostream &os);
+	void writeAdjacency(std::ostream &os);
+	void writeVertices(std::ostream &os);
+	void writeNormals(std::ostream &os);
+	void writeTangents(std::ostream &os);
+	void writeBinormals(std::ostream &os);
+	void writeUVs(std::ostream &os);
+	void writeColors(std::ostream &os);
+	void writeInterleavedVertices(std::ostream &os); // remplace writeVertices  writeColors avec CPM_EXPORT_INTERLEAVED
+	void writeMaterialSets(std::ostream &os);
+	bool writeMaterialSets(std::ostream &os, CPMMaterialFaces &faces); // triangles lus dans faces au lieu des faceIds, false si la lecture choue
+
+	protected:
+	template<typename S> void writeVector3(std::ostream &os, CPM_SCALAR_TYPE precision, const char *name, const char *tag, const VECTOR3_ARRAY<S> &vectors);
+	template<typename T, typename S> void writeVector3As(std::ostream &os, const char *name, const char *tag, const VECTOR3_ARRAY<S> &vectors);
+	template<typename T> void writeUVsAs(std::ostream &os);
+	template<typename T> void writeColorsAs(std::ostream &os);
+	template<typename T> void writeTrianglesAs(std::ostream &os, const CPM_INDEX_LAYOUT &layout);
+	template<typename T> void writeAdjacencyAs(std::ostream &os);
+	void writeEncodedTriangles(std::ostream &os, const CPM_INDEX_LAYOUT &layout);
+	bool writeBinaryMaterialSets(std::ostream &os, CPMMaterialFaces &faces);
+	void writeMaterialSlot(std::ostream &os, unsigned int texName, const float *values, unsigned int numValues) const;
+	unsigned int textureName(unsigned int texName) const;
+
+	protected:
+	const CPM_MESH_DATA		&m_mesh;
+	unsigned int			m_exportOptions;
+	CPM_PRECISION			m_precision;
+	bool					m_binary;
+};
+
+#endif // CPM_MESH_WRITER_H_INCLUDED
@@ -0,0 +1,441 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "CPMObjectTable.h"
+#include "CPMExportOptions.h"
+#include "CPMChecksum.h"
+#include "CPMParallel.h"
+
+//
+//	Botes englobantes
+//
+CPM_BOUNDS::CPM_BOUNDS()
+{
+	for(unsigned int c = 0; c < 3; c++)
+	{
+		min[c] = DBL_MAX;
+		max[c] = -DBL_MAX;
+	}
+}
+
+void CPM_BOUNDS::add(double x, double y, double z)
+{
+	const double p[3] = { x, y, z };
+	for(unsigned int c = 0; c < 3; c++)
+	{
+		if(p[c] < min[c]) min[c] = p[c];
+		if(p[c] > max[c]) max[c] = p[c];
+	}
+}
+
+void CPM_BOUNDS::add(const CPM_BOUNDS &other)
+{
+	if(other.empty()) return;
+	add(other.min[0], other.min[1], other.min[2]);
+	add(other.max[0], other.max[1], other.max[2]);
+}
+
+CPM_BOUNDS ComputeBounds(const VECTOR3_ARRAY<double> &points)
+{
+	CPM_BOUNDS bounds;
+	for(size_t i = 0; i < points.size(); i++) bounds.add(points.x[i], points.y[i], points.z[i]);
+	return bounds;
+}
+
+static void StoreBounds(const CPM_BOUNDS &bounds, float *min, float *max)
+// Rsum: une bote vide est crite avec min = 1 et max = -1, sans valeur infinie
+{
+	for(unsigned int c = 0; c < 3; c++)
+	{
+		min[c] = bounds.empty() ? 1.0f : (float) bounds.min[c];
+		max[c] = bounds.empty() ? -1.0f : (float) bounds.max[c];
+	}
+}
+
+
+const CPM_COLUMN_INFO *CPM_OBJECT_INFO::findColumn(const char *tag) const
+{
+	for(size_t c = 0; c < columns.size(); c++)
+	{
+		if(memcmp(columns[c].tag, tag, 4) == 0) return &columns[c];
+	}
+	return NULL;
+}
+
+
+//
+//	CPMObjectTable
+//
+CPMObjectTable::CPMObjectTable() : m_begin(-1)
+{
+
+}
+
+void CPMObjectTable::clear()
+{
+	m_objects.clear();
+	m_columns.clear();
+	m_begin = -1;
+}
+
+void CPMObjectTable::begin(std::ostream &os)
+{
+	m_begin = (long long) os.tellp();
+	m_columns.clear();
+}
+
+void CPMObjectTable::column(std::ostream &os, const char *tag)
+{
+	const long long position = (long long) os.tellp();
+	if(m_begin < 0 || position < m_begin) return;
+
+	CPM_COLUMN_INFO column;
+	memcpy(column.tag, tag, 4);
+	column.offset = (unsigned long long) position;
+	m_columns.push_back(column);
+}
+
+void CPMObjectTable::end(std::ostream &os, const std::string &name, const CPM_BOUNDS &bounds)
+{
+	const long long position = (long long) os.tellp();
+	if(m_begin < 0 || position < m_begin) return;
+
+	CPM_OBJECT_INFO object;
+	object.name = name;
+	object.offset = (unsigned long long) m_begin;
+	object.size = (unsigned long long) (position - m_begin);
+	object.bounds = bounds;
+
+	for(size_t c = 0; c < m_columns.size(); c++)
+	{
+		CPM_COLUMN_INFO &column = m_columns[c];
+		const unsigned long long next = c + 1 < m_columns.size() ? m_columns[c + 1].offset : (unsigned long long) position;
+		column.size = next - column.offset;
+		if(column.size) object.columns.push_back(column);
+	}
+
+	m_objects.push_back(object);
+	m_columns.clear();
+	m_begin = -1;
+}
+
+unsigned long long CPMObjectTable::writeTable(std::ostream &os, unsigned int exportOptions) const
+{
+	const long long position = (long long) os.tellp();
+	if(m_objects.empty() || position <= 0) return 0;
+
+	if(exportOptions & CPM_EXPORT_BINARY)
+	{
+		std::vector<CPM_OBJECT_ENTRY> entries(m_objects.size());
+		std::vector<CPM_COLUMN_ENTRY> columns;
+		std::string names;
+		for(size_t i = 0; i < m_objects.size(); i++)
+		{
+			const CPM_OBJECT_INFO &object = m_objects[i];
+			CPM_OBJECT_ENTRY &entry = entries[i];
+			entry.offset = object.offset;
+			entry.size = object.size;
+			StoreBounds(object.bounds, entry.boundsMin, entry.boundsMax);
+			entry.name = (unsigned int) names.size();
+			entry.firstColumn = (unsigned int) columns.size();
+			entry.columnCount = (unsigned int) object.columns.size();
+			entry.reserved = 0;
+
+			for(size_t c = 0; c < object.columns.size(); c++)
+			{
+				CPM_COLUMN_ENTRY column;
+				memcpy(column.tag, object.columns[c].tag, 4);
+				column.reserved = 0;
+				column.offset = object.columns[c].offset;
+				column.size = object.columns[c].size;
+				columns.push_back(column);
+			}
+
+			names.append(object.name.c_str(), object.name.size() + 1);
+		}
+
+		const size_t entriesSize = entries.size() * sizeof(CPM_OBJECT_ENTRY), columnsSize = columns.size() * sizeof(CPM_COLUMN_ENTRY);
+		WriteSectionHeader(os, CPM_TAG_OBJECT_TABLE, (unsigned int) entries.size(), CPM_SCALAR_NONE, 0, entriesSize + columnsSize + names.size());
+		os.write((const char*) &entries[0], entriesSize);
+		if(columnsSize) os.write((const char*) &columns[0], columnsSize);
+		os.write(names.data(), names.size());
+		return (unsigned long long) position;
+	}
+
+	const std::streamsize oldPrecision = os.precision(9);
+	os << "ObjectTable: " << m_objects.size() << std::endl;
+	for(size_t i = 0; i < m_objects.size(); i++)
+	{
+		const CPM_OBJECT_INFO &object = m_objects[i];
+		float min[3], max[3];
+		StoreBounds(object.bounds, min, max);
+
+		os << object.offset << " " << object.size << " " << min[0] << " " << min[1] << " " << min[2] << " " << max[0] << " " << max[1] << " " << max[2]
+			<< " " << object.name << std::endl;
+
+		os << "columns: " << object.columns.size();
+		for(size_t c = 0; c < object.columns.size(); c++) os << " " << object.columns[c].tag << " " << object.columns[c].offset << " " << object.columns[c].size;
+		os << std::endl;
+	}
+	os << std::endl;
+	os.precision(oldPrecision);
+	return (unsigned long long) position;
+}
+
+void CPMObjectTable::writeTrailer(std::ostream &os, unsigned int exportOptions, unsigned long long table, unsigned long long checksums) const
+{
+	if(exportOptions & CPM_EXPORT_BINARY)
+	{
+		CPM_FILE_TRAILER trailer;
+		trailer.objectTable = table;
+		trailer.checksums = checksums;
+		trailer.objectCount = table ? (unsigned int) m_objects.size() : 0;
+		memcpy(trailer.magic, CPM_FILE_TRAILER_MAGIC, 4);
+		WriteBinary(os, trailer);
+		return;
+	}
+
+	char trailer[64];
+	sprintf(trailer, CPM_TEXT_TRAILER "%020llu", table);
+	os << trailer;
+}
+
+
+//
+//	CPMObjectFile
+//
+CPMObjectFile::CPMObjectFile() : m_is(NULL), m_compressed(false), m_binary(false), m_size(0), m_checksums(0)
+{
+
+}
+
+bool CPMObjectFile::open(std::istream &is)
+{
+	m_is = &is;
+	m_objects.clear();
+	m_names.clear();
+	m_checksums = 0;
+
+	is.seekg(0, std::ios::end);
+	m_size = (unsigned long long) is.tellg();
+
+	char magic[4] = { 0 };
+	is.seekg(0, std::ios::beg);
+	is.read(magic, 4);
+	if(!is) return false;
+
+	m_compressed = memcmp(magic, CPM_CONTAINER_MAGIC, 4) == 0;
+	if(m_compressed)
+	{
+		if(!m_container.open(is)) return false;
+		m_size = m_container.getRawSize();
+
+		std::string header;
+		if(!read(0, 4, header)) return false;
+		memcpy(magic, header.data(), 4);
+	}
+
+	m_binary = memcmp(magic, CPM_BINARY_MAGIC, 4) == 0;
+	if(!(m_binary ? readBinaryTable() : readTextTable())) return false;
+
+	for(size_t i = 0; i < m_objects.size(); i++) m_names.insert(std::make_pair(m_objects[i].name, i));
+	return true;
+}
+
+const CPM_OBJECT_INFO *CPMObjectFile::find(const std::string &name) const
+{
+	std::unordered_map<std::string, size_t>::const_iterator it = m_names.find(name);
+	return it != m_names.end() ? &m_objects[it->second] : NULL;
+}
+
+bool CPMObjectFile::readObject(const CPM_OBJECT_INFO &object, std::string &data)
+{
+	return read(object.offset, (size_t) object.size, data);
+}
+
+bool CPMObjectFile::readColumn(const CPM_OBJECT_INFO &object, const char *tag, std::string &data)
+{
+	const CPM_COLUMN_INFO *column = object.findColumn(tag);
+	return column && read(column->offset, (size_t) column->size, data);
+}
+
+bool CPMObjectFile::validate(CPM_VALIDATION &result)
+{
+	result = CPM_VALIDATION();
+	if(m_compressed)
+	{
+		result.checksums = m_container.hasChecksums();
+		result.blockSize = m_container.getChunkSize();
+		result.blockCount = m_container.getChunkCount();
+		return !result.checksums || m_container.validate(result.corrupted);
+	}
+	if(!m_binary || !m_checksums) return true;
+
+	std::string bytes;
+	CPM_SECTION_HEADER header;
+	CPM_CHECKSUM_TABLE table;
+	if(!read(m_checksums, sizeof(header) + sizeof(table), bytes)) return false;
+	memcpy(&header, bytes.data(), sizeof(header));
+	memcpy(&table, bytes.data() + sizeof(header), sizeof(table));
+	if(memcmp(header.tag, CPM_TAG_CHECKSUMS, 4) != 0 || header.size != sizeof(table) + (unsigned long long) header.count * sizeof(unsigned int)) return false;
+	if(!table.blockSize || table.size != m_checksums || header.count != (table.size + table.blockSize - 1) / table.blockSize) return false;
+
+	std::vector<unsigned int> checksums(header.count);
+	if(!read(m_checksums + sizeof(header) + sizeof(table), checksums.size() * sizeof(unsigned int), bytes)) return false;
+	if(!bytes.empty()) memcpy(&checksums[0], bytes.data(), bytes.size());
+
+	result.checksums = true;
+	result.blockSize = table.blockSize;
+	result.blockCount = header.count;
+
+	// lecture par lots, vrification des blocs d'un lot en parallle
+	const size_t batchSize = 4 * (size_t) GetWorkerCount();
+	std::vector<char> valid(checksums.size());
+	for(size_t batch = 0; batch < checksums.size(); batch += batchSize)
+	{
+		const size_t end = std::min(batch + batchSize, checksums.size());
+		const unsigned long long begin = (unsigned long long) batch * table.blockSize;
+		if(!read(begin, (size_t) (std::min<unsigned long long>((unsigned long long) end * table.blockSize, table.size) - begin), bytes)) return false;
+
+		ParallelFor(end - batch, 1, [&](size_t first, size_t last)
+		{
+			for(size_t i = batch + first; i < batch + last; i++)
+			{
+				const size_t offset = (i - batch) * table.blockSize;
+				const size_t size = std::min<size_t>(table.blockSize, bytes.size() - offset);
+				valid[i] = Crc32c(0, bytes.data() + offset, size) == checksums[i];
+			}
+		});
+	}
+
+	for(size_t i = 0; i < valid.size(); i++) if(!valid[i]) result.corrupted.push_back((unsigned int) i);
+	return true;
+}
+
+bool CPMObjectFile::read(unsigned long long offset, size_t size, std::string &data)
+{
+	if(offset + size > m_size) return false;
+	if(m_compressed) return m_container.readRange(offset, size, data);
+
+	data.resize(size);
+	m_is->clear();
+	m_is->seekg((std::streamoff) offset, std::ios::beg);
+	if(size) m_is->read(&data[0], size);
+	return (bool) *m_is;
+}
+
+bool CPMObjectFile::readBinaryTable()
+{
+	std::string bytes;
+	if(m_size < sizeof(CPM_BINARY_HEADER) + sizeof(CPM_FILE_TRAILER) || !read(m_size - sizeof(CPM_FILE_TRAILER), sizeof(CPM_FILE_TRAILER), bytes)) return false;
+
+	CPM_FILE_TRAILER trailer;
+	memcpy(&trailer, bytes.data(), sizeof(trailer));
+	if(memcmp(trailer.magic, CPM_FILE_TRAILER_MAGIC, 4) != 0) return false;
+	m_checksums = trailer.checksums;
+	if(!trailer.objectTable) return true;
+
+	CPM_SECTION_HEADER header;
+	if(!read(trailer.objectTable, sizeof(header), bytes)) return false;
+	memcpy(&header, bytes.data(), sizeof(header));
+	if(memcmp(header.tag, CPM_TAG_OBJECT_TABLE, 4) != 0 || header.count != trailer.objectCount) return false;
+
+	const size_t entriesSize = (size_t) header.count * sizeof(CPM_OBJECT_ENTRY);
+	if(header.size < entriesSize || !read(trailer.objectTable + sizeof(header), (size_t) header.size, bytes)) return false;
+
+	// le nombre total de colonnes est celui de la dernire entre
+	size_t numColumns = 0;
+	if(header.count)
+	{
+		CPM_OBJECT_ENTRY last;
+		memcpy(&last, bytes.data() + entriesSize - sizeof(last), sizeof(last));
+		numColumns = (size_t) last.firstColumn + last.columnCount;
+	}
+	const size_t columnsSize = numColumns * sizeof(CPM_COLUMN_ENTRY);
+	if(header.size < entriesSize + columnsSize) return false;
+
+	const char *columns = bytes.data() + entriesSize;
+	const char *names = columns + columnsSize;
+	const size_t namesSize = (size_t) header.size - entriesSize - columnsSize;
+	m_objects.resize(header.count);
+	for(size_t i = 0; i < m_objects.size(); i++)
+	{
+		CPM_OBJECT_ENTRY entry;
+		memcpy(&entry, bytes.data() + i * sizeof(entry), sizeof(entry));
+		if(entry.name >= namesSize || !memchr(names + entry.name, '\0', namesSize - entry.name)) return false;
+		if((size_t) entry.firstColumn + entry.columnCount > numColumns) return false;
+
+		CPM_OBJECT_INFO &object = m_objects[i];
+		object.name = names + entry.name;
+		object.offset = entry.offset;
+		object.size = entry.size;
+		if(entry.boundsMin[0] <= entry.boundsMax[0])
+		{
+			object.bounds.add(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+			object.bounds.add(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+		}
+
+		object.columns.resize(entry.columnCount);
+		for(unsigned int c = 0; c < entry.columnCount; c++)
+		{
+			CPM_COLUMN_ENTRY column;
+			memcpy(&column, columns + (entry.firstColumn + c) * sizeof(column), sizeof(column));
+			memcpy(object.columns[c].tag, column.tag, 4);
+			object.columns[c].offset = column.offset;
+			object.columns[c].size = column.size;
+		}
+	}
+	return true;
+}
+
+bool CPMObjectFile::readTextTable()
+{
+	std::string bytes;
+	if(m_size < CPM_TEXT_TRAILER_SIZE || !read(m_size - CPM_TEXT_TRAILER_SIZE, CPM_TEXT_TRAILER_SIZE, bytes)) return false;
+	if(bytes.compare(0, sizeof(CPM_TEXT_TRAILER) - 1, CPM_TEXT_TRAILER) != 0) return false;
+
+	const unsigned long long table = strtoull(bytes.c_str() + sizeof(CPM_TEXT_TRAILER) - 1, NULL, 10);
+	if(!table) return true;
+	if(table >= m_size - CPM_TEXT_TRAILER_SIZE || !read(table, (size_t) (m_size - CPM_TEXT_TRAILER_SIZE - table), bytes)) return false;
+
+	std::istringstream is(bytes);
+	std::string label;
+	size_t count = 0;
+	if(!(is >> label >> count) || label != "ObjectTable:") return false;
+
+	m_objects.resize(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		CPM_OBJECT_INFO &object = m_objects[i];
+		float min[3], max[3];
+		if(!(is >> object.offset >> object.size >> min[0] >> min[1] >> min[2] >> max[0] >> max[1] >> max[2])) return false;
+
+		// le nom occupe la fin de la ligne
+		is.ignore(1);
+		if(!std::getline(is, object.name)) return false;
+		if(!object.name.empty() && object.name[object.name.size() - 1] == '\r') object.name.erase(object.name.size() - 1);
+
+		if(min[0] <= max[0])
+		{
+			object.bounds.add(min[0], min[1], min[2]);
+			object.bounds.add(max[0], max[1], max[2]);
+		}
+
+		size_t numColumns = 0;
+		if(!(is >> label >> numColumns) || label != "columns:") return false;
+		object.columns.resize(numColumns);
+		for(size_t c = 0; c < numColumns; c++)
+		{
+			CPM_COLUMN_INFO &column = object.columns[c];
+			std::string tag;
+			if(!(is >> tag >> column.offset >> column.size) || tag.size() != 4) return false;
+			memcpy(column.tag, tag.c_str(), 4);
+		}
+	}
+	return true;
+}
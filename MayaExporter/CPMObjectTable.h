@@ -0,0 +1,141 @@
+#ifndef CPM_OBJECT_TABLE_H_INCLUDED
+#define CPM_OBJECT_TABLE_H_INCLUDED
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CPMFormat.h"
+#include "CPMMeshBuffers.h"
+#include "CPMChunkedStream.h"
+
+//
+//	Table des objets d'un fichier (CPM_TAG_OBJECT_TABLE au format binaire, voir CPMFormat.h)
+//	chaque objet est enregistr pendant l'criture avec sa position, sa taille et sa bote englobante, puis WriteFileFooter
+//	crit la table et le trailer qui la dsigne: un lecteur va directement  un objet sans lire ceux qui le prcdent
+//	chaque objet est dcoup en colonnes (proprits, triangles, positions, normales...) que le lecteur charge  la demande:
+//	un outil qui n'a besoin que des positions et des triangles ne lit ni n'analyse les autres attributs
+//	les positions sont celles du fichier CPM dcompress, dans le conteneur seuls les blocs de la colonne ou de l'objet sont lus
+//	(CPMChunkedReader::readRange): le conteneur tient lieu de compression des colonnes
+//
+struct CPM_BOUNDS
+{
+	CPM_BOUNDS();
+
+	void add(double x, double y, double z);
+	void add(const CPM_BOUNDS &other);
+	bool empty() const { return min[0] > max[0]; }
+
+	double		min[3];
+	double		max[3];
+};
+
+CPM_BOUNDS ComputeBounds(const VECTOR3_ARRAY<double> &points);
+
+struct CPM_COLUMN_INFO
+{
+	CPM_COLUMN_INFO() : offset(0), size(0) { tag[0] = tag[1] = tag[2] = tag[3] = tag[4] = '\0'; }
+
+	char					tag[5];		// CPM_TAG_* termin par un zro
+	unsigned long long		offset;		// premier en-tte de section de la colonne (premire ligne au format texte)
+	unsigned long long		size;
+};
+
+struct CPM_OBJECT_INFO
+{
+	CPM_OBJECT_INFO() : offset(0), size(0) {}
+
+	std::string				name;
+	unsigned long long		offset;		// position de la premire section de l'objet ("Object:" au format texte)
+	unsigned long long		size;
+	CPM_BOUNDS				bounds;
+	std::vector<CPM_COLUMN_INFO>	columns;
+
+	const CPM_COLUMN_INFO *findColumn(const char *tag) const; // NULL si l'objet n'a pas cette colonne
+};
+
+class CPMObjectTable
+// Objets du fichier en cours d'criture: begin() avant la premire section d'un objet, column() avant la premire section
+// de chaque colonne, end() aprs la dernire section; une colonne s'tend jusqu' la suivante, les colonnes vides sont ignores
+// pas de protection contre les accs concurrents: une table par fichier crit, comme CPMStringPool
+{
+	public:
+	CPMObjectTable();
+
+	void clear(); //  appeler au dbut de chaque fichier
+
+	void begin(std::ostream &os);
+	void column(std::ostream &os, const char *tag);
+	void end(std::ostream &os, const std::string &name, const CPM_BOUNDS &bounds); // ignor si la position dans os est inconnue
+
+	size_t count() const { return m_objects.size(); }
+	const CPM_OBJECT_INFO &get(size_t i) const { return m_objects[i]; }
+
+	// appels par WriteFileFooter: la table avant la fin du fichier, le trailer tout  la fin
+	unsigned long long writeTable(std::ostream &os, unsigned int exportOptions) const; // position de la table, 0 si elle n'est pas crite
+	void writeTrailer(std::ostream &os, unsigned int exportOptions, unsigned long long table, unsigned long long checksums) const; // checksums: position de CPM_TAG_CHECKSUMS
+
+	protected:
+	std::vector<CPM_OBJECT_INFO>	m_objects;
+	std::vector<CPM_COLUMN_INFO>	m_columns; // colonnes de l'objet en cours, size calcule par end()
+	long long						m_begin;
+};
+
+inline void BeginColumn(CPMObjectTable *objects, std::ostream &os, const char *tag)
+// Rsum: pour les crivains dont la table des objets est facultative
+{
+	if(objects) objects->column(os, tag);
+}
+
+struct CPM_VALIDATION
+{
+	CPM_VALIDATION() : checksums(false), blockSize(0), blockCount(0) {}
+
+	bool						checksums;	// false: le fichier n'a pas de sommes de contrle, rien n'a t vrifi
+	unsigned int				blockSize;	// octets du fichier CPM couverts par chaque somme (le dernier bloc peut tre plus court)
+	unsigned int				blockCount;
+	std::vector<unsigned int>	corrupted;	// blocs dont la somme ne correspond pas
+};
+
+class CPMObjectFile
+// Accs direct aux objets d'un fichier binaire ou texte, compress ou non: seuls le trailer, la table et l'objet demand sont lus
+{
+	public:
+	CPMObjectFile();
+
+	bool open(std::istream &is); // false si le fichier n'a pas de table des objets (fichiers antrieurs  la version 7)
+
+	bool isBinary() const { return m_binary; }
+	bool isCompressed() const { return m_compressed; }
+
+	size_t getObjectCount() const { return m_objects.size(); }
+	const CPM_OBJECT_INFO &getObject(size_t i) const { return m_objects[i]; }
+	const CPM_OBJECT_INFO *find(const std::string &name) const; // premier objet de ce nom, NULL s'il est absent
+
+	bool readObject(const CPM_OBJECT_INFO &object, std::string &data); // sections de l'objet, telles qu'elles sont dans le fichier
+	bool readColumn(const CPM_OBJECT_INFO &object, const char *tag, std::string &data); // sections d'une colonne, false si elle est absente
+
+	// vrifie les sommes de contrle de tout le fichier avant de l'analyser, en parallle sur tous les coeurs:
+	// blocs du conteneur compress, ou section CPM_TAG_CHECKSUMS d'un fichier binaire; false si la lecture choue
+	bool validate(CPM_VALIDATION &result);
+
+	protected:
+	bool read(unsigned long long offset, size_t size, std::string &data);
+	bool readBinaryTable();
+	bool readTextTable();
+
+	protected:
+	std::istream					*m_is;
+	CPMChunkedReader				m_container;
+	bool							m_compressed;
+	bool							m_binary;
+	unsigned long long				m_size;		// taille du fichier CPM dcompress
+	unsigned long long				m_checksums;	// position de CPM_TAG_CHECKSUMS, 0 si elle est absente
+
+	std::vector<CPM_OBJECT_INFO>	m_objects;
+	std::unordered_map<std::string, size_t>	m_names;
+};
+
+#endif // CPM_OBJECT_TABLE_H_INCLUDED
@@ -0,0 +1,86 @@
+#include "CPMParallel.h"
+
+static unsigned int g_workerCount = 0;
+static thread_local const CPMThreadPool *t_pool = NULL;
+
+unsigned int GetWorkerCount()
+{
+	// les tches du pool se partagent ses coeurs: une tche seule (un mesh norme) les a tous, des tches nombreuses restent sur leur thread
+	if(t_pool) return t_pool->workerShare();
+	if(g_workerCount) return g_workerCount;
+
+	const unsigned int cores = std::thread::hardware_concurrency();
+	return cores ? cores : 1;
+}
+
+void SetWorkerCount(unsigned int count)
+{
+	g_workerCount = count;
+}
+
+
+//
+//	CPMThreadPool
+//
+CPMThreadPool::CPMThreadPool(unsigned int threadCount) : m_workers(GetWorkerCount()), m_running(0), m_stop(false)
+{
+	if(threadCount == 0) threadCount = m_workers;
+
+	m_threads.reserve(threadCount);
+	for(unsigned int i = 0; i < threadCount; i++) m_threads.push_back(std::thread(&CPMThreadPool::run, this));
+}
+
+CPMThreadPool::~CPMThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+
+	for(size_t i = 0; i < m_threads.size(); i++) m_threads[i].join();
+}
+
+unsigned int CPMThreadPool::size() const
+{
+	return (unsigned int) m_threads.size();
+}
+
+unsigned int CPMThreadPool::workerShare() const
+{
+	const unsigned int running = m_running.load();
+	const unsigned int share = m_workers / (running ? running : 1);
+	return share ? share : 1;
+}
+
+void CPMThreadPool::push(const std::function<void()> &task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(task);
+	}
+	m_condition.notify_one();
+}
+
+void CPMThreadPool::run()
+// Rsum: boucle d'un thread du pool, se termine quand la file est vide et que le pool est dtruit
+{
+	t_pool = this;
+
+	for(;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+
+			if(m_tasks.empty()) return;
+
+			task = m_tasks.front();
+			m_tasks.pop_front();
+		}
+		m_running++;
+		task();
+		m_running--;
+	}
+}
@@ -0,0 +1,96 @@
+#ifndef CPM_PARALLEL_H_INCLUDED
+#define CPM_PARALLEL_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+//
+//	Dcoupage d'un traitement en intervalles excuts sur plusieurs threads
+//	les traitements parallles ne doivent jamais appeler l'API Maya
+//
+unsigned int GetWorkerCount(); // sur un thread d'un CPMThreadPool: part de la tche, les coeurs du pool diviss par le nombre de ses tches en cours
+void SetWorkerCount(unsigned int count); // 0 = nombre de coeurs du processeur
+
+template<typename F>
+void ParallelFor(size_t count, size_t minChunk, F function)
+// Rsum: appelle function(begin, end) sur des intervalles disjoints couvrant [0, count)
+// Args: count - nombre d'lments
+//		 minChunk - taille minimale d'un intervalle: en dessous, le traitement reste sur le thread appelant
+//		 function - traitement d'un intervalle, appel simultanment depuis plusieurs threads
+{
+	const unsigned int workers = GetWorkerCount();
+	size_t numChunks = minChunk ? count / minChunk : count;
+	if(numChunks > workers) numChunks = workers;
+
+	if(numChunks <= 1)
+	{
+		if(count) function((size_t) 0, count);
+		return;
+	}
+
+	const size_t chunkSize = (count + numChunks - 1) / numChunks;
+
+	std::vector<std::thread> threads;
+	threads.reserve(numChunks - 1);
+	for(size_t begin = chunkSize; begin < count; begin += chunkSize)
+	{
+		const size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+		threads.push_back(std::thread(function, begin, end));
+	}
+
+	// le premier intervalle est trait par le thread appelant
+	function((size_t) 0, chunkSize);
+
+	for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+}
+
+
+//
+//	Pool de threads excutant des tches dans leur ordre de soumission
+//	utilis pour les traitements en pipeline (le thread appelant continue de produire pendant que le pool consomme)
+//
+class CPMThreadPool
+{
+	public:
+	explicit CPMThreadPool(unsigned int threadCount = 0); // 0 = GetWorkerCount()
+	~CPMThreadPool(); // attend la fin des tches dj soumises
+
+	unsigned int size() const;
+	unsigned int workerShare() const; // nombre de threads que peut occuper une tche en cours, au moins 1
+
+	template<typename F>
+	std::future<typename std::result_of<F()>::type> submit(F task)
+	// Rsum: ajoute une tche  la file, retourne un future donnant accs  son rsultat
+	{
+		typedef typename std::result_of<F()>::type RESULT;
+
+		std::shared_ptr< std::packaged_task<RESULT()> > packaged(new std::packaged_task<RESULT()>(task));
+		std::future<RESULT> result = packaged->get_future();
+
+		push([packaged]() { (*packaged)(); });
+		return result;
+	}
+
+	protected:
+	void push(const std::function<void()> &task);
+	void run();
+
+	protected:
+	unsigned int						m_workers;	// GetWorkerCount() du thread qui a cr le pool, partag entre les tches en cours
+	std::atomic<unsigned int>			m_running;
+	std::vector<std::thread>			m_threads;
+	std::deque< std::function<void()> >	m_tasks;
+	std::mutex							m_mutex;
+	std::condition_variable				m_condition;
+	bool								m_stop;
+};
+
+#endif // CPM_PARALLEL_H_INCLUDED
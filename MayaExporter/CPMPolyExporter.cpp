@@ -2,6 +2,8 @@
 
 #include "CPMPolyExporter.h"
 #include "CPMPolyWriter.h"
+#include "CPMMeshWriter.h"
+#include "CPMExportScheduler.h"
 
 
 //
@@ -98,21 +100,6 @@ const char *TruncateEndPath(const MString &path, const MString &word)
 	return str;
 }
 
-const char *TruncatePath(const MString &path)
-{
-	std::string str = path.asChar();
-	unsigned int length = path.length();
-	int p = length - 1;
-
-	for(; p >= 0 && str[p] != '/' && str[p] != '\\' && str[p] != '|'; p--)
-	{
-
-	}
-
-	if(p == -1) return str.c_str();
-	return &(str.c_str()[p + 1]);
-}
-
 //
 //	Fentre d'options du PolyExporter
 //
@@ -129,10 +116,24 @@ const char *TruncatePath(const MString &path)
 
 #define IDB_INVERTU					112
 #define IDB_INVERTV					113
+#define IDB_HALF_VECTORS			114
+#define IDB_BINARY					115
+#define IDB_COMPRESS_FAST			116
+#define IDB_COMPRESS_ARCHIVE		117
+#define IDB_WELD_BY_VALUE			118
+#define IDB_STREAMING				119
+#define IDB_SPLIT_16BIT				120
+#define IDB_INDEX_CODEC				121
+#define IDB_INTERLEAVED				122
+#define IDB_PAGE_ALIGNED			123
+#define IDB_ADJACENCY				124
+#define IDB_CLEAN_TRIANGLES			125
+#define IDB_MIKKTSPACE				126
 
 #define IDB_MATERIALSETS			200
 #define IDB_TEXTURENAMES			201
 #define IDB_TRUNC_TEXTURENAMES		202
+#define IDB_SUBMESHES				203
 
 #define IDB_OK						0
 #define	IDB_CANCEL					1
@@ -149,11 +150,11 @@ LRESULT CALLBACK CPMPolyExporter::WindowOptionsProc(HWND wnd, UINT uMsg, WPARAM
 	static HWND AxesGB;
 	static HWND MiscGB;
 
-	static HWND GeometryButtons[12];
+	static HWND GeometryButtons[25];
 
 	// Matriaux
 	static HWND MaterialGB;
-	static HWND MaterialButtons[3];
+	static HWND MaterialButtons[4];
 
 	// Choix
 	static HWND OkCancel[2];
@@ -166,17 +167,22 @@ LRESULT CALLBACK CPMPolyExporter::WindowOptionsProc(HWND wnd, UINT uMsg, WPARAM
 			CPMPolyExporter::SetWindowClosedWithOk(false);
 
 			// Gomtrie
-			GeometryGB = CreateWindow("BUTTON", "Gomtrie", BS_GROUPBOX | WS_CHILD | WS_VISIBLE, 10, 10, 570, 380, wnd, NULL, hInstance, NULL);
+			GeometryGB = CreateWindow("BUTTON", "Gomtrie", BS_GROUPBOX | WS_CHILD | WS_VISIBLE, 10, 10, 570, 620, wnd, NULL, hInstance, NULL);
 
 			ElementsGB = CreateWindow("BUTTON", "Elments  exporter", BS_GROUPBOX | WS_CHILD | WS_VISIBLE, 10, 20, 550, 110, GeometryGB, NULL, hInstance, NULL);
 			GeometryButtons[0] = CreateWindow("BUTTON", "exporter les normales", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 50, 400, 20, wnd, (HMENU) IDB_NORMALS, hInstance, NULL);
 			GeometryButtons[1] = CreateWindow("BUTTON", "exporter les coordonnes uv", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 70, 400, 20, wnd, (HMENU) IDB_UV, hInstance, NULL);
-			GeometryButtons[2] = CreateWindow("BUTTON", "exporter les tangentes et les binormales", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 50, 60, 400, 20, ElementsGB, (HMENU) IDB_TGT_BINORMALS, hInstance, NULL);
+			GeometryButtons[2] = CreateWindow("BUTTON", "exporter les tangentes et les binormales", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 50, 60, 250, 20, ElementsGB, (HMENU) IDB_TGT_BINORMALS, hInstance, NULL);
+			GeometryButtons[24] = CreateWindow("BUTTON", "calcules par MikkTSpace", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 310, 60, 230, 20, ElementsGB, (HMENU) IDB_MIKKTSPACE, hInstance, NULL);
 			GeometryButtons[3] = CreateWindow("BUTTON", "exporter les donnes de couleur", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 10, 80, 400, 20, ElementsGB, (HMENU) IDB_COLOR, hInstance, NULL);
 			CheckDlgButton(wnd, IDB_NORMALS, exportOptions & CPM_EXPORT_NORMALS);
 			CheckDlgButton(wnd, IDB_UV,  exportOptions & CPM_EXPORT_UVS);
 			CheckDlgButton(ElementsGB, IDB_TGT_BINORMALS,  (exportOptions & CPM_EXPORT_TGT_BINORMALS) && (exportOptions & CPM_EXPORT_NORMALS) && (exportOptions & CPM_EXPORT_UVS));
-			if(!((exportOptions & CPM_EXPORT_NORMALS) && (exportOptions & CPM_EXPORT_UVS))) EnableWindow(GeometryButtons[2], false);
+			CheckDlgButton(ElementsGB, IDB_MIKKTSPACE, exportOptions & CPM_EXPORT_MIKKTSPACE);
+			if(!((exportOptions & CPM_EXPORT_NORMALS) && (exportOptions & CPM_EXPORT_UVS))) {
+				EnableWindow(GeometryButtons[2], false);
+				EnableWindow(GeometryButtons[24], false);
+			}
 			CheckDlgButton(ElementsGB, IDB_COLOR,  exportOptions & CPM_EXPORT_COLORS);
 
 			AxesGB = CreateWindow("BUTTON", "Axes", BS_GROUPBOX | WS_CHILD | WS_VISIBLE, 10, 140, 550, 130, GeometryGB, NULL, hInstance, NULL);
@@ -196,31 +202,60 @@ LRESULT CALLBACK CPMPolyExporter::WindowOptionsProc(HWND wnd, UINT uMsg, WPARAM
 				EnableWindow(GeometryButtons[11], false);
 			}
 			
-			MiscGB = CreateWindow("BUTTON", "Divers", BS_GROUPBOX | WS_CHILD | WS_VISIBLE, 10, 280, 550, 90, GeometryGB, NULL, hInstance, NULL);
+			MiscGB = CreateWindow("BUTTON", "Divers", BS_GROUPBOX | WS_CHILD | WS_VISIBLE, 10, 280, 550, 330, GeometryGB, NULL, hInstance, NULL);
 			GeometryButtons[7] = CreateWindow("BUTTON", "fusionner les meshes", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 10, 20, 400, 20, MiscGB, (HMENU) IDB_JOIN_MESHES, hInstance, NULL);
 			GeometryButtons[8] = CreateWindow("BUTTON", "exporter en double prcision si possible (position des vertices)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 10, 40, 500, 20, MiscGB, (HMENU) IDB_DOUBLE, hInstance, NULL);
 			GeometryButtons[9] = CreateWindow("BUTTON", "dfinir les faces dans le sens contraire des aiguilles d'une montre", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 10, 60, 500, 20, MiscGB, (HMENU) IDB_COUNTERCLOCKWISE, hInstance, NULL);
+			GeometryButtons[12] = CreateWindow("BUTTON", "exporter les normales, tangentes et binormales en demi-prcision (16 bits)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 10, 80, 530, 20, MiscGB, (HMENU) IDB_HALF_VECTORS, hInstance, NULL);
+			GeometryButtons[13] = CreateWindow("BUTTON", "exporter au format binaire", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 10, 100, 500, 20, MiscGB, (HMENU) IDB_BINARY, hInstance, NULL);
 			CheckDlgButton(MiscGB, IDB_INVERTZ, exportOptions & CPM_EXPORT_JOINMESHES);
 			EnableWindow(GeometryButtons[7], false);
 			CheckDlgButton(MiscGB, IDB_DOUBLE, exportOptions & CPM_EXPORT_DOUBLE);
 			CheckDlgButton(MiscGB, IDB_COUNTERCLOCKWISE, exportOptions & CPM_EXPORT_COUNTERCLOCKWISE);
+			CheckDlgButton(MiscGB, IDB_HALF_VECTORS, exportOptions & CPM_EXPORT_HALF_VECTORS);
+			GeometryButtons[14] = CreateWindow("BUTTON", "compresser par blocs pour un chargement rapide (LZ4)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 470, 500, 20, wnd, (HMENU) IDB_COMPRESS_FAST, hInstance, NULL);
+			GeometryButtons[15] = CreateWindow("BUTTON", "compresser par blocs pour l'archivage (Zstd)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 490, 500, 20, wnd, (HMENU) IDB_COMPRESS_ARCHIVE, hInstance, NULL);
+			CheckDlgButton(MiscGB, IDB_BINARY, exportOptions & CPM_EXPORT_BINARY);
+			GeometryButtons[19] = CreateWindow("BUTTON", "compresser les indices des triangles (format binaire)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 10, 120, 500, 20, MiscGB, (HMENU) IDB_INDEX_CODEC, hInstance, NULL);
+			CheckDlgButton(MiscGB, IDB_INDEX_CODEC, exportOptions & CPM_EXPORT_INDEX_CODEC);
+			GeometryButtons[20] = CreateWindow("BUTTON", "entrelacer les attributs des vertices (format binaire, tampon prt pour le GPU)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 10, 140, 530, 20, MiscGB, (HMENU) IDB_INTERLEAVED, hInstance, NULL);
+			CheckDlgButton(MiscGB, IDB_INTERLEAVED, exportOptions & CPM_EXPORT_INTERLEAVED);
+			GeometryButtons[21] = CreateWindow("BUTTON", "aligner les grandes sections sur des pages de 4 Ko (format binaire, chargement par mmap)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 10, 160, 530, 20, MiscGB, (HMENU) IDB_PAGE_ALIGNED, hInstance, NULL);
+			CheckDlgButton(MiscGB, IDB_PAGE_ALIGNED, exportOptions & CPM_EXPORT_PAGE_ALIGNED);
+			CheckDlgButton(wnd, IDB_COMPRESS_FAST, exportOptions & CPM_EXPORT_COMPRESS_FAST);
+			CheckDlgButton(wnd, IDB_COMPRESS_ARCHIVE, exportOptions & CPM_EXPORT_COMPRESS_ARCHIVE);
+			GeometryButtons[16] = CreateWindow("BUTTON", "fusionner les vertices de mme valeur (coutures entre coquilles spares)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 510, 530, 20, wnd, (HMENU) IDB_WELD_BY_VALUE, hInstance, NULL);
+			CheckDlgButton(wnd, IDB_WELD_BY_VALUE, exportOptions & CPM_EXPORT_WELD_BY_VALUE);
+			GeometryButtons[17] = CreateWindow("BUTTON", "exporter hors mmoire (trs gros meshes, fichiers temporaires)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 530, 530, 20, wnd, (HMENU) IDB_STREAMING, hInstance, NULL);
+			CheckDlgButton(wnd, IDB_STREAMING, exportOptions & CPM_EXPORT_STREAMING);
+			GeometryButtons[18] = CreateWindow("BUTTON", "dcouper les meshes de plus de 65536 vertices (indices 16 bits partout)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 550, 530, 20, wnd, (HMENU) IDB_SPLIT_16BIT, hInstance, NULL);
+			CheckDlgButton(wnd, IDB_SPLIT_16BIT, exportOptions & CPM_EXPORT_SPLIT_16BIT);
+			GeometryButtons[22] = CreateWindow("BUTTON", "exporter l'adjacence des triangles (silhouettes, volumes d'ombre)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 570, 530, 20, wnd, (HMENU) IDB_ADJACENCY, hInstance, NULL);
+			CheckDlgButton(wnd, IDB_ADJACENCY, exportOptions & CPM_EXPORT_ADJACENCY);
+			GeometryButtons[23] = CreateWindow("BUTTON", "supprimer les triangles dgnrs et les triangles en double", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 590, 530, 20, wnd, (HMENU) IDB_CLEAN_TRIANGLES, hInstance, NULL);
+			CheckDlgButton(wnd, IDB_CLEAN_TRIANGLES, exportOptions & CPM_EXPORT_CLEAN_TRIANGLES);
 
 
 			// Matriaux
-			MaterialGB = CreateWindow("BUTTON", "Matriaux", BS_GROUPBOX | WS_CHILD | WS_VISIBLE, 10, 400, 570, 90, wnd, NULL, hInstance, NULL);
-			MaterialButtons[0] = CreateWindow("BUTTON", "exporter les sets de matriaux", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 420, 400, 20, wnd, (HMENU) IDB_MATERIALSETS, hInstance, NULL);
-			MaterialButtons[1] = CreateWindow("BUTTON", "exporter les noms des textures associes aux matriaux", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 440, 500, 20, wnd, (HMENU) IDB_TEXTURENAMES, hInstance, NULL);
-			MaterialButtons[2] = CreateWindow("BUTTON", "exporter le chemin complet des textures", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 80, 460, 500, 20, wnd, (HMENU) IDB_TRUNC_TEXTURENAMES, hInstance, NULL);
+			MaterialGB = CreateWindow("BUTTON", "Matriaux", BS_GROUPBOX | WS_CHILD | WS_VISIBLE, 10, 640, 570, 110, wnd, NULL, hInstance, NULL);
+			MaterialButtons[0] = CreateWindow("BUTTON", "exporter les sets de matriaux", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 660, 400, 20, wnd, (HMENU) IDB_MATERIALSETS, hInstance, NULL);
+			MaterialButtons[1] = CreateWindow("BUTTON", "exporter les noms des textures associes aux matriaux", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 680, 500, 20, wnd, (HMENU) IDB_TEXTURENAMES, hInstance, NULL);
+			MaterialButtons[2] = CreateWindow("BUTTON", "exporter le chemin complet des textures", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 80, 700, 500, 20, wnd, (HMENU) IDB_TRUNC_TEXTURENAMES, hInstance, NULL);
+			MaterialButtons[3] = CreateWindow("BUTTON", "regrouper les triangles par matriau (un intervalle de sous-mesh par matriau)", BS_AUTOCHECKBOX | WS_CHILD | WS_VISIBLE, 30, 720, 530, 20, wnd, (HMENU) IDB_SUBMESHES, hInstance, NULL);
 			CheckDlgButton(wnd, IDB_MATERIALSETS, exportOptions & CPM_EXPORT_MATERIALSETS);
 			CheckDlgButton(wnd, IDB_TEXTURENAMES, exportOptions & CPM_EXPORT_TEXTURENAMES);
 			CheckDlgButton(wnd, IDB_TRUNC_TEXTURENAMES, !(exportOptions & CPM_EXPORT_TRUNCATE_TEXTURENAMES));
-			if(!(exportOptions & CPM_EXPORT_MATERIALSETS)) EnableWindow(MaterialButtons[1], false);
+			CheckDlgButton(wnd, IDB_SUBMESHES, exportOptions & CPM_EXPORT_SUBMESHES);
+			if(!(exportOptions & CPM_EXPORT_MATERIALSETS)) {
+				EnableWindow(MaterialButtons[1], false);
+				EnableWindow(MaterialButtons[3], false);
+			}
 			if(!(exportOptions & CPM_EXPORT_TEXTURENAMES)) EnableWindow(MaterialButtons[2], false);
 
 
 			// OK/Cancel
-			OkCancel[0] = CreateWindow("BUTTON", "OK", BS_DEFPUSHBUTTON | WS_CHILD | WS_VISIBLE, 375, 500, 100, 20, wnd, (HMENU) IDB_OK, hInstance, NULL);
-			OkCancel[1] = CreateWindow("BUTTON", "Annuler", BS_DEFPUSHBUTTON | WS_CHILD | WS_VISIBLE, 480, 500, 100, 20, wnd, (HMENU) IDB_CANCEL, hInstance, NULL);
+			OkCancel[0] = CreateWindow("BUTTON", "OK", BS_DEFPUSHBUTTON | WS_CHILD | WS_VISIBLE, 375, 760, 100, 20, wnd, (HMENU) IDB_OK, hInstance, NULL);
+			OkCancel[1] = CreateWindow("BUTTON", "Annuler", BS_DEFPUSHBUTTON | WS_CHILD | WS_VISIBLE, 480, 760, 100, 20, wnd, (HMENU) IDB_CANCEL, hInstance, NULL);
 			
 			return 0;
 
@@ -231,8 +266,8 @@ LRESULT CALLBACK CPMPolyExporter::WindowOptionsProc(HWND wnd, UINT uMsg, WPARAM
 				case IDB_UV:
 					if(IsDlgButtonChecked(wnd, IDB_UV))
 					{
-						if(IsDlgButtonChecked(wnd, IDB_NORMALS)) EnableWindow(GeometryButtons[2], true);
-						else EnableWindow(GeometryButtons[2], false);
+						EnableWindow(GeometryButtons[2], IsDlgButtonChecked(wnd, IDB_NORMALS) != 0);
+						EnableWindow(GeometryButtons[24], IsDlgButtonChecked(wnd, IDB_NORMALS) != 0);
 
 						//EnableWindow(GeometryButtons[10], true);
 						EnableWindow(GeometryButtons[11], true);
@@ -240,22 +275,34 @@ LRESULT CALLBACK CPMPolyExporter::WindowOptionsProc(HWND wnd, UINT uMsg, WPARAM
 					else
 					{
 						EnableWindow(GeometryButtons[2], false);
+						EnableWindow(GeometryButtons[24], false);
 
 						//EnableWindow(GeometryButtons[10], false);
 						EnableWindow(GeometryButtons[11], false);
 					}
 					break;
 
+				// les deux prrglages de compression sont exclusifs
+				case IDB_COMPRESS_FAST:
+					if(IsDlgButtonChecked(wnd, IDB_COMPRESS_FAST)) CheckDlgButton(wnd, IDB_COMPRESS_ARCHIVE, false);
+					break;
+
+				case IDB_COMPRESS_ARCHIVE:
+					if(IsDlgButtonChecked(wnd, IDB_COMPRESS_ARCHIVE)) CheckDlgButton(wnd, IDB_COMPRESS_FAST, false);
+					break;
+
 				case IDB_MATERIALSETS:
 					if(IsDlgButtonChecked(wnd, IDB_MATERIALSETS))
 					{
 						EnableWindow(MaterialButtons[1], true);
 						if(IsDlgButtonChecked(wnd, IDB_TEXTURENAMES)) EnableWindow(MaterialButtons[2], true);
+						EnableWindow(MaterialButtons[3], true);
 					}
 					else
 					{
 						EnableWindow(MaterialButtons[1], false);
 						EnableWindow(MaterialButtons[2], false);
+						EnableWindow(MaterialButtons[3], false);
 					}
 					break;
 
@@ -288,6 +335,7 @@ LRESULT CALLBACK CPMPolyExporter::WindowOptionsProc(HWND wnd, UINT uMsg, WPARAM
 			if(IsDlgButtonChecked(wnd, IDB_NORMALS)) exportOptions |= CPM_EXPORT_NORMALS;
 			if(IsDlgButtonChecked(wnd, IDB_UV))  exportOptions |= CPM_EXPORT_UVS;
 			if(IsDlgButtonChecked(ElementsGB, IDB_TGT_BINORMALS) && (exportOptions & CPM_EXPORT_NORMALS) && (exportOptions & CPM_EXPORT_UVS))  exportOptions |= CPM_EXPORT_TGT_BINORMALS;
+			if(IsDlgButtonChecked(ElementsGB, IDB_MIKKTSPACE)) exportOptions |= CPM_EXPORT_MIKKTSPACE;
 			if(IsDlgButtonChecked(ElementsGB, IDB_COLOR))  exportOptions |= CPM_EXPORT_COLORS;
 
 			if(IsDlgButtonChecked(AxesGB, IDB_INVERTX)) exportOptions |= CPM_EXPORT_INVERTX;
@@ -302,10 +350,24 @@ LRESULT CALLBACK CPMPolyExporter::WindowOptionsProc(HWND wnd, UINT uMsg, WPARAM
 			if(IsDlgButtonChecked(MiscGB, IDB_INVERTZ)) exportOptions |= CPM_EXPORT_JOINMESHES;
 			if(IsDlgButtonChecked(MiscGB, IDB_DOUBLE)) exportOptions |= CPM_EXPORT_DOUBLE;
 			if(IsDlgButtonChecked(MiscGB, IDB_COUNTERCLOCKWISE)) exportOptions |= CPM_EXPORT_COUNTERCLOCKWISE;
+			if(IsDlgButtonChecked(MiscGB, IDB_HALF_VECTORS)) exportOptions |= CPM_EXPORT_HALF_VECTORS;
+			if(IsDlgButtonChecked(MiscGB, IDB_BINARY)) exportOptions |= CPM_EXPORT_BINARY;
+			if(IsDlgButtonChecked(MiscGB, IDB_INDEX_CODEC)) exportOptions |= CPM_EXPORT_INDEX_CODEC;
+			if(IsDlgButtonChecked(MiscGB, IDB_INTERLEAVED)) exportOptions |= CPM_EXPORT_INTERLEAVED;
+			if(IsDlgButtonChecked(MiscGB, IDB_PAGE_ALIGNED)) exportOptions |= CPM_EXPORT_PAGE_ALIGNED;
+			if(IsDlgButtonChecked(wnd, IDB_COMPRESS_FAST)) exportOptions |= CPM_EXPORT_COMPRESS_FAST;
+			else if(IsDlgButtonChecked(wnd, IDB_COMPRESS_ARCHIVE)) exportOptions |= CPM_EXPORT_COMPRESS_ARCHIVE;
+			if(IsDlgButtonChecked(wnd, IDB_WELD_BY_VALUE)) exportOptions |= CPM_EXPORT_WELD_BY_VALUE;
+			if(IsDlgButtonChecked(wnd, IDB_STREAMING)) exportOptions |= CPM_EXPORT_STREAMING;
+			else if(IsDlgButtonChecked(wnd, IDB_SPLIT_16BIT)) exportOptions |= CPM_EXPORT_SPLIT_16BIT; // le dcoupage a besoin du mesh entier en mmoire
+			if(IsDlgButtonChecked(wnd, IDB_ADJACENCY) && !(exportOptions & CPM_EXPORT_STREAMING)) exportOptions |= CPM_EXPORT_ADJACENCY;
+			if(IsDlgButtonChecked(wnd, IDB_CLEAN_TRIANGLES) && !(exportOptions & CPM_EXPORT_STREAMING)) exportOptions |= CPM_EXPORT_CLEAN_TRIANGLES;
 
 			if(IsDlgButtonChecked(wnd, IDB_MATERIALSETS)) exportOptions |= CPM_EXPORT_MATERIALSETS;
 			if(IsDlgButtonChecked(wnd, IDB_TEXTURENAMES) && (exportOptions & CPM_EXPORT_MATERIALSETS)) exportOptions |= CPM_EXPORT_TEXTURENAMES;
 			if(!IsDlgButtonChecked(wnd, IDB_TRUNC_TEXTURENAMES) && (exportOptions & CPM_EXPORT_TEXTURENAMES)) exportOptions |= CPM_EXPORT_TRUNCATE_TEXTURENAMES;
+			// les sous-meshes rordonnent le mesh en mmoire: ils ne sont pas disponibles avec l'exportation hors mmoire
+			if(IsDlgButtonChecked(wnd, IDB_SUBMESHES) && (exportOptions & CPM_EXPORT_MATERIALSETS) && !(exportOptions & CPM_EXPORT_STREAMING)) exportOptions |= CPM_EXPORT_SUBMESHES;
 
 			CPMPolyExporter::SetExportOptions(exportOptions);
 
@@ -332,7 +394,7 @@ bool CPMPolyExporter::m_endLoop(false);
 // m_exportOptions: dtermine les options d'exportation du PolyExporter: permet de sauvegarder les options
 // choisies par l'utilisateur d'une exportation  une autre et de communiquer ces options au PolyExporter
 // aprs avoir affich la fentre d'options,  travers les fonctions SetExportOptions() et GetExportOptions()
-unsigned int CPMPolyExporter::m_exportOptions(CPM_EXPORT_NORMALS | CPM_EXPORT_UVS | CPM_EXPORT_MATERIALSETS | CPM_EXPORT_TEXTURENAMES | CPM_EXPORT_INVERTZ | CPM_EXPORT_INVERTV | CPM_EXPORT_OBJECT_RELATIVE);
+unsigned int CPMPolyExporter::m_exportOptions(CPM_EXPORT_DEFAULT_OPTIONS);
 
 // m_closeWindowOk: dtermine si l'utilisateur a ferm la fentre d'options du PolyExporter avec le bouton OK (true) ou le bouton Annuler (false)
 bool CPMPolyExporter::m_windowClosedWithOk(false);
@@ -405,19 +467,46 @@ MString CPMPolyExporter::defaultExtension() const
 	return POLYEXPORTER_FORMAT;
 }
 
-PolyWriter *CPMPolyExporter::createPolyWriter(const MDagPath &dagPath, MStatus &status) const
+PolyWriter *CPMPolyExporter::createPolyWriter(const MDagPath &dagPath, MStatus &status)
 {
-	return new CPMPolyWriter(dagPath, m_exportOptions, status);
+	return new CPMPolyWriter(dagPath, m_exportOptions, m_strings, m_objects, status);
+}
+
+unsigned long long CPMPolyExporter::estimateMeshMemory(const MDagPath &dagPath)
+{
+	MStatus status;
+	MFnMesh mesh(dagPath, &status);
+	if(!status) return 0;
+
+	return EstimateMeshMemory(mesh.numPolygons(), mesh.numFaceVertices(), m_exportOptions);
 }
 
 void CPMPolyExporter::writeHeader(ostream &f)
 {
-	f << "CPM_FILE\n\n" << endl;
+	// l'exportateur n'est pas dtruit entre deux exportations
+	m_strings.clear();
+	m_objects.clear();
+	WriteFileHeader(f, m_exportOptions);
 }
 
 void CPMPolyExporter::writeFooter(ostream &f)
 {
-	f << "CPM_FILE_END";
+	WriteFileFooter(f, m_exportOptions, m_strings, m_objects);
+}
+
+bool CPMPolyExporter::isBinary() const
+{
+	return (m_exportOptions & CPM_EXPORT_BINARY) != 0;
+}
+
+bool CPMPolyExporter::isCompressed() const
+{
+	return IsExportCompressed(m_exportOptions);
+}
+
+CPM_CODEC CPMPolyExporter::getCodec() const
+{
+	return GetExportCodec(m_exportOptions);
 }
 
 bool CPMPolyExporter::displayExportWindow(const MFileObject &file, const MString &optionString, FileAccessMode mode)
@@ -426,7 +515,7 @@ bool CPMPolyExporter::displayExportWindow(const MFileObject &file, const MString
 
 	unsigned int screenW = GetSystemMetrics(SM_CXSCREEN);
 	unsigned int screenH = GetSystemMetrics(SM_CYSCREEN);
-	unsigned int w = 600, h = 570;
+	unsigned int w = 600, h = 830;
 	HWND wnd;
 	if( !(wnd = CreateWindow(POLYEXPORTER_OPTWNDCLASS_NAME, "Options d'exportation", WS_SYSMENU | WS_CAPTION, (screenW - w)/2, (screenH - h)/2, w, h, NULL, NULL, hModule, NULL)) )
 	{
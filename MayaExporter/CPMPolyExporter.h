@@ -4,6 +4,9 @@
 #include <Windows.h>
 
 #include "PolyExporter.h"
+#include "CPMExportOptions.h"
+#include "CPMStringPool.h"
+#include "CPMObjectTable.h"
 
 #define DLL_NAME	"CrowExporter"
 
@@ -14,28 +17,7 @@ MStatus uninitializePlugin(MObject obj);
 #define POLYEXPORTER_FORMAT				"cpm"
 #define POLYEXPORTER_OPTWNDCLASS_NAME	"CPMPolyExporterOptionsWindowClass"
 
-enum CPM_POLYEXPORT_OPTION
-{
-	CPM_EXPORT_NORMALS					= 0x1,
-	CPM_EXPORT_UVS						= 0x2,
-	CPM_EXPORT_TGT_BINORMALS			= 0x4,
-	CPM_EXPORT_COLORS					= 0x8,
-	CPM_EXPORT_INVERTX					= 0x10,
-	CPM_EXPORT_INVERTY					= 0x20,
-	CPM_EXPORT_INVERTZ					= 0x40,
-	CPM_EXPORT_JOINMESHES				= 0x80,
-	CPM_EXPORT_DOUBLE					= 0x100,
-	CPM_EXPORT_COUNTERCLOCKWISE			= 0x200,
-	CPM_EXPORT_MATERIALSETS				= 0x400,
-	CPM_EXPORT_TEXTURENAMES				= 0x800,
-	CPM_EXPORT_TRUNCATE_TEXTURENAMES	= 0x1000,
-	CPM_EXPORT_INVERTU					= 0x2000,
-	CPM_EXPORT_INVERTV					= 0x4000,
-	CPM_EXPORT_OBJECT_RELATIVE			= 0x8000,
-};
-
 const char *TruncateEndPath(const MString &path, const MString &word);
-const char *TruncatePath(const MString &path);
 
 class CPMPolyExporter : public PolyExporter
 {
@@ -57,10 +39,14 @@ class CPMPolyExporter : public PolyExporter
 	static void				SetWindowClosedWithOk(bool ok);
 
 	protected:
-	virtual PolyWriter		*createPolyWriter(const MDagPath &dagPath, MStatus &status) const;
+	virtual PolyWriter		*createPolyWriter(const MDagPath &dagPath, MStatus &status);
+	virtual unsigned long long	estimateMeshMemory(const MDagPath &dagPath);
 
 	virtual void			writeHeader(ostream &f);
 	virtual void			writeFooter(ostream &f);
+	virtual bool			isBinary() const;
+	virtual bool			isCompressed() const;
+	virtual CPM_CODEC		getCodec() const;
 
 	virtual bool			displayExportWindow(const MFileObject &file, const MString &optionString, FileAccessMode mode);
 
@@ -68,6 +54,9 @@ class CPMPolyExporter : public PolyExporter
 	static bool				m_endLoop;
 	static unsigned int		m_exportOptions;
 	static bool				m_windowClosedWithOk;
+
+	CPMStringPool			m_strings; // noms des textures du fichier en cours, crits par writeFooter
+	CPMObjectTable			m_objects; // objets du fichier en cours, enregistrs par CPMPolyWriter::writeToFile
 };
 
 #endif // CPM_POLYEXPORTER_H_INCLUDED
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <cstdio>
+
 #include <maya/MFnSet.h>
 #include <maya/MItMeshPolygon.h>
 #include <maya/MPlug.h>
@@ -8,39 +10,50 @@
 
 #include "CPMPolyWriter.h"
 #include "CPMPolyExporter.h"
-
-#define RET_VALUE(CONDITION, VALUE) (((CONDITION) != 0) ? (VALUE) : (0))
+#include "CPMProfiler.h"
+#include "CPMValueWelder.h"
+#include "CPMSubmeshBuilder.h"
+#include "CPMMeshSplitter.h"
+#include "CPMAdjacency.h"
+#include "CPMTriangleCleaner.h"
+#include "CPMTangentSpace.h"
 
 
 //
 //	CPMPolyWriter
 //
-CPMPolyWriter::CPMPolyWriter(const MDagPath &dagPath, unsigned int exportOptions, MStatus &status) : PolyWriter(dagPath, status), m_exportOptions(exportOptions)
+CPMPolyWriter::CPMPolyWriter(const MDagPath &dagPath, unsigned int exportOptions, CPMStringPool &strings, CPMObjectTable &objects, MStatus &status) :
+	PolyWriter(dagPath, status), m_exportOptions(exportOptions), m_axisConversion(GetExportAxisConversion(exportOptions)), m_strings(strings), m_objects(objects),
+	m_streamingMesh(NULL)
 {
-
+	m_mesh.strings = &m_strings;
 }
 
 CPMPolyWriter::~CPMPolyWriter()
 {
-
+	if(m_streamingMesh) delete m_streamingMesh;
 }
 
 MStatus CPMPolyWriter::extractGeometry()
 {
+	CPM_PROFILE_SCOPE("CPMPolyWriter::extractGeometry");
 	MStatus status;	
 
 	MFnDagNode dagNode(*m_dagPath);
 	MFnDagNode parentNode(dagNode.parent(0, &status));
 	if(!status) {
-		m_meshName = m_dagPath->partialPathName();
+		m_mesh.name = m_dagPath->partialPathName().asChar();
 	}
 	else {
-		m_meshName  = parentNode.partialPathName();
+		m_mesh.name = parentNode.partialPathName().asChar();
 	}
-	m_transformMatrix = m_dagPath->inclusiveMatrix(&status);
+	MMatrix transformMatrix = m_dagPath->inclusiveMatrix(&status);
 	if(!status) {
 		MGlobal::displayError("MDagPath::inclusiveMatrix");
 	}
+	// dans l'espace monde, la transformation est dj applique aux vertices
+	if(!(m_exportOptions & CPM_EXPORT_OBJECT_RELATIVE)) transformMatrix = MMatrix::identity;
+	transformMatrix.get(m_mesh.transform);
 
 	CPMMeshExtractor meshExtractor(*m_dagPath, !(m_exportOptions & CPM_EXPORT_OBJECT_RELATIVE), status);
 	if(!status) {
@@ -49,227 +62,194 @@ MStatus CPMPolyWriter::extractGeometry()
 	}
 
 	MESH_EXTRACTOR_INFO extractedMesh;
-	if(m_exportOptions & CPM_EXPORT_NORMALS) extractedMesh.normals = &m_normals;
-	if(m_exportOptions & CPM_EXPORT_TGT_BINORMALS) extractedMesh.tgtBinormals = &m_tgtBinormals;
-	if(m_exportOptions & CPM_EXPORT_UVS) extractedMesh.UVs = &m_UVs;
-	if(m_exportOptions & CPM_EXPORT_COLORS) extractedMesh.colors = &m_colors;
-	if(m_exportOptions & CPM_EXPORT_MATERIALSETS) extractedMesh.materials = &m_materials;
-
-	status = meshExtractor.extractMesh(extractedMesh);
-	if(!status) {
-		MGlobal::displayError("CPMPolyWriter::extractGeometry : CPMMeshExtractor::extractMesh");
-		return MS::kFailure;
+	if(m_exportOptions & CPM_EXPORT_NORMALS) extractedMesh.normals = &m_mesh.normals;
+	// les tangentes MikkTSpace sont calcules sur le mesh final, sans MFnMesh::getTangents ni getTangentId; l'exportation
+	// hors mmoire n'a jamais le mesh entier et garde celles de Maya
+	const bool mikkTSpace = (m_exportOptions & CPM_EXPORT_MIKKTSPACE) && !(m_exportOptions & CPM_EXPORT_STREAMING);
+	if((m_exportOptions & CPM_EXPORT_TGT_BINORMALS) && !mikkTSpace) {
+		extractedMesh.tangents = &m_mesh.tangents;
+		extractedMesh.binormals = &m_mesh.binormals;
+	}
+	if(m_exportOptions & CPM_EXPORT_UVS) extractedMesh.UVs = &m_mesh.UVs;
+	if(m_exportOptions & CPM_EXPORT_COLORS) extractedMesh.colors = &m_mesh.colors;
+	if(m_exportOptions & CPM_EXPORT_MATERIALSETS) {
+		extractedMesh.materials = &m_mesh.materials;
+		if(m_exportOptions & CPM_EXPORT_TEXTURENAMES) extractedMesh.strings = &m_strings;
 	}
 
-	m_triangles = extractedMesh.triangles;
-	m_points = extractedMesh.points;
-	m_uvSetName = extractedMesh.uvSetName;
-	m_colorSetName = extractedMesh.colorSetName;
-
-	return MS::kSuccess;
-}
-
-MStatus CPMPolyWriter::writeToFile(ostream &os)
-{
-	if(outputObjectProperties(os) == MS::kFailure) return MS::kFailure;
-	if(outputTriangles(os) == MS::kFailure) return MS::kFailure;
-	if(outputVertices(os) == MS::kFailure) return MS::kFailure;
-	if(outputNormals(os) == MS::kFailure) return MS::kFailure;
-	if(outputTangents(os) == MS::kFailure) return MS::kFailure;
-	if(outputBinormals(os) == MS::kFailure) return MS::kFailure;
-	if(outputUVs(os) == MS::kFailure) return MS::kFailure;
-	if(outputColors(os) == MS::kFailure) return MS::kFailure;
-	if(outputMaterialSets(os) == MS::kFailure) return MS::kFailure;
-
-	return MS::kSuccess;
-}
+	// exportation hors mmoire: la conversion des axes est faite par CPMStreamingMesh, au fil de l'criture des fichiers temporaires
+	if(m_exportOptions & CPM_EXPORT_STREAMING)
+	{
+		m_streamingMesh = new CPMStreamingMesh(m_exportOptions);
+		status = meshExtractor.extractStreamingMesh(extractedMesh, *m_streamingMesh);
+		if(!status) {
+			MGlobal::displayError("CPMPolyWriter::extractGeometry : CPMMeshExtractor::extractStreamingMesh");
+			return MS::kFailure;
+		}
+		if(m_exportOptions & CPM_EXPORT_WELD_BY_VALUE) MGlobal::displayWarning("La fusion par valeur n'est pas disponible avec l'exportation hors mmoire de " + m_dagPath->partialPathName());
+		if(m_exportOptions & CPM_EXPORT_CLEAN_TRIANGLES) MGlobal::displayWarning("Le nettoyage des triangles n'est pas disponible avec l'exportation hors mmoire de " + m_dagPath->partialPathName());
+		if(m_exportOptions & CPM_EXPORT_ADJACENCY) MGlobal::displayWarning("L'adjacence des triangles n'est pas disponible avec l'exportation hors mmoire de " + m_dagPath->partialPathName());
+		if((m_exportOptions & CPM_EXPORT_TGT_BINORMALS) && (m_exportOptions & CPM_EXPORT_MIKKTSPACE)) MGlobal::displayWarning("Les tangentes MikkTSpace ne sont pas disponibles avec l'exportation hors mmoire de " + m_dagPath->partialPathName() + ", les tangentes de Maya sont exportes");
+	}
+	else
+	{
+		status = meshExtractor.extractMesh(extractedMesh);
+		if(!status) {
+			MGlobal::displayError("CPMPolyWriter::extractGeometry : CPMMeshExtractor::extractMesh");
+			return MS::kFailure;
+		}
+	}
 
-MStatus CPMPolyWriter::outputObjectProperties(ostream &os)
-{
-	os << "Object: " << m_meshName.asChar() << endl;
-	os << "TransformMatrix: " << endl;
-	os << m_transformMatrix[0][0] << " " << m_transformMatrix[0][1] << " " << m_transformMatrix[0][2] << " " << m_transformMatrix[0][3] << endl;
-	os << m_transformMatrix[1][0] << " " << m_transformMatrix[1][1] << " " << m_transformMatrix[1][2] << " " << m_transformMatrix[1][3] << endl;
-	os << m_transformMatrix[2][0] << " " << m_transformMatrix[2][1] << " " << m_transformMatrix[2][2] << " " << m_transformMatrix[2][3] << endl;
-	os << m_transformMatrix[3][0] << " " << m_transformMatrix[3][1] << " " << m_transformMatrix[3][2] << " " << m_transformMatrix[3][3] << endl;
-	os << endl;
+	m_mesh.triangles.swap(extractedMesh.triangles);
+	m_mesh.points.swap(extractedMesh.points);
+	m_mesh.uvSetName = extractedMesh.uvSetName.asChar();
+	m_mesh.colorSetName = extractedMesh.colorSetName.asChar();
 
 	return MS::kSuccess;
 }
 
-MStatus CPMPolyWriter::outputTriangles(ostream &os)
+MStatus CPMPolyWriter::processGeometry()
 {
-	unsigned int numTriangles = m_triangles.length() / 3;
+	CPM_PROFILE_SCOPE("CPMPolyWriter::processGeometry");
+	if(m_streamingMesh) return MS::kSuccess;
 
-	os << "Triangles: " << numTriangles << endl;
-	for(unsigned int i = 0; i < numTriangles; i++)
+	// On convertit les donnes dans le repre demand avant l'criture
 	{
-		((m_exportOptions & CPM_EXPORT_COUNTERCLOCKWISE) != 0 ? os << m_triangles[3*i] << " " << m_triangles[3*i + 1] << " " << m_triangles[3*i + 2] << endl
-		: os << m_triangles[3*i] << " " << m_triangles[3*i + 2] << " " << m_triangles[3*i + 1] << endl);
+		CPM_PROFILE_SCOPE("ApplyAxisConversion");
+		ApplyAxisConversion(m_axisConversion, m_mesh.triangles);
+		ApplyAxisConversion(m_axisConversion, m_mesh.points);
+		ApplyAxisConversion(m_axisConversion, m_mesh.normals);
+		ApplyAxisConversion(m_axisConversion, m_mesh.tangents);
+		ApplyAxisConversion(m_axisConversion, m_mesh.binormals);
+		ApplyAxisConversion(m_axisConversion, m_mesh.UVs);
 	}
-	os << "\n\n";
-
-	return MS::kSuccess;
-}
-
-MStatus CPMPolyWriter::outputVertices(ostream &os)
-{
-	unsigned int numVertices = m_points.length();
 
-	os << "Vertices: " << numVertices << endl;
-	for(unsigned int i = 0; i < numVertices; i++)
+	if(m_exportOptions & CPM_EXPORT_WELD_BY_VALUE)
 	{
-		os << ((m_exportOptions & CPM_EXPORT_INVERTX) != 0 ? -m_points[i].x : m_points[i].x) << " "
-		<< ((m_exportOptions & CPM_EXPORT_INVERTY) != 0 ? -m_points[i].y : m_points[i].y) << " " <<
-		((m_exportOptions & CPM_EXPORT_INVERTZ) != 0 ? -m_points[i].z : m_points[i].z) << endl;
-	}
-	os << "\n\n";
+		const CPM_VALUE_WELD_STATS stats = WeldMeshByValue(m_mesh, GetWeldTolerance());
 
-	return MS::kSuccess;
-}
+		char info[256];
+		sprintf(info, "Fusion par valeur de %s: %u -> %u vertices (-%.1f%%)", m_mesh.name.c_str(), stats.inputVertices, stats.outputVertices, 100.0 * stats.reduction());
+		addMessage(false, info);
+	}
 
-MStatus CPMPolyWriter::outputNormals(ostream &os)
-{
-	if(m_exportOptions & CPM_EXPORT_NORMALS)
+	// aprs la fusion par valeur, qui peut rendre des triangles dgnrs ou identiques
+	if(m_exportOptions & CPM_EXPORT_CLEAN_TRIANGLES)
 	{
-		unsigned int numNormals = m_normals.length();
-
-		os << "Normals: " << numNormals << endl;
-		for(unsigned int i = 0; i < numNormals; i++)
+		const CPM_TRIANGLE_CLEANUP_STATS stats = CleanMeshTriangles(m_mesh, GetAreaEpsilon());
+		if(stats.removed())
 		{
-			os << ((m_exportOptions & CPM_EXPORT_INVERTX) != 0 ? -m_normals[i].x : m_normals[i].x) << " "
-			<< ((m_exportOptions & CPM_EXPORT_INVERTY) != 0 ? -m_normals[i].y : m_normals[i].y) << " " <<
-			((m_exportOptions & CPM_EXPORT_INVERTZ) != 0 ? -m_normals[i].z : m_normals[i].z) << endl;
+			char info[256];
+			sprintf(info, "Nettoyage de %s: %u triangles supprims sur %u (%u dgnrs par indices, %u d'aire nulle, %u en double)", m_mesh.name.c_str(),
+				stats.removed(), stats.inputTriangles, stats.indexDegenerate, stats.areaDegenerate, stats.duplicates);
+			addMessage(false, info);
 		}
-		os << "\n\n";
 	}
 
-	return MS::kSuccess;
-}
-
-MStatus CPMPolyWriter::outputTangents(ostream &os)
-{
-	if(m_exportOptions & CPM_EXPORT_TGT_BINORMALS)
+	// sur les triangles nettoys et avant le dcoupage: les vertices dupliqus restent dans le mme morceau que leur original
+	if((m_exportOptions & CPM_EXPORT_TGT_BINORMALS) && (m_exportOptions & CPM_EXPORT_MIKKTSPACE))
 	{
-		unsigned int numTangents = (unsigned int) m_tgtBinormals.size();
-
-		os << "Tangents: " << numTangents << endl;
-		for(unsigned int i = 0; i < numTangents; i++)
+		const CPM_TANGENT_STATS stats = GenerateMeshTangents(m_mesh);
+		if(m_mesh.tangents.size() != m_mesh.points.size()) addMessage(true, "Les tangentes de " + m_mesh.name + " demandent des normales et des UVs, elles ne sont pas exportes");
+		else
 		{
-			os << ((m_exportOptions & CPM_EXPORT_INVERTX) != 0 ? -m_tgtBinormals[i].tangent.x : m_tgtBinormals[i].tangent.x) << " "
-			<< ((m_exportOptions & CPM_EXPORT_INVERTY) != 0 ? -m_tgtBinormals[i].tangent.y : m_tgtBinormals[i].tangent.y) << " " <<
-			((m_exportOptions & CPM_EXPORT_INVERTZ) != 0 ? -m_tgtBinormals[i].tangent.z : m_tgtBinormals[i].tangent.z) << endl;
+			char info[256];
+			sprintf(info, "Tangentes MikkTSpace de %s: %u groupes, %u -> %u vertices, %u triangles dgnrs", m_mesh.name.c_str(),
+				stats.groups, stats.inputVertices, stats.outputVertices, stats.degenerateTriangles);
+			addMessage(false, info);
 		}
-		os << "\n\n";
 	}
 
-	return MS::kSuccess;
-}
-
-MStatus CPMPolyWriter::outputBinormals(ostream &os)
-{
-	if(m_exportOptions & CPM_EXPORT_TGT_BINORMALS)
+	// aprs la fusion par valeur, qui peut runir des vertices de deux sous-meshes
+	const bool submeshes = (m_exportOptions & CPM_EXPORT_SUBMESHES) && (m_exportOptions & CPM_EXPORT_MATERIALSETS);
+	if(m_exportOptions & CPM_EXPORT_SPLIT_16BIT)
 	{
-		unsigned int numBitangents = (unsigned int) m_tgtBinormals.size();
-
-		os << "Bitangents: " << numBitangents << endl;
-		for(unsigned int i = 0; i < numBitangents; i++)
+		const CPM_SPLIT_STATS stats = SplitMesh(m_mesh, CPM_MAX_16BIT_VERTICES, submeshes, m_parts);
+		if(stats.parts)
 		{
-			os << ((m_exportOptions & CPM_EXPORT_INVERTX) != 0 ? -m_tgtBinormals[i].binormal.x : m_tgtBinormals[i].binormal.x) << " "
-			<< ((m_exportOptions & CPM_EXPORT_INVERTY) != 0 ? -m_tgtBinormals[i].binormal.y : m_tgtBinormals[i].binormal.y) << " " <<
-			((m_exportOptions & CPM_EXPORT_INVERTZ) != 0 ? -m_tgtBinormals[i].binormal.z : m_tgtBinormals[i].binormal.z) << endl;
+			char info[256];
+			sprintf(info, "Dcoupage de %s en %u morceaux: %u -> %u vertices", m_mesh.name.c_str(), stats.parts, stats.inputVertices, stats.outputVertices);
+			addMessage(false, info);
 		}
-		os << "\n\n";
 	}
 
-	return MS::kSuccess;
-}
-
-MStatus CPMPolyWriter::outputUVs(ostream &os)
-{
-	if(m_exportOptions & CPM_EXPORT_UVS)
+	// chaque morceau construit ses propres sous-meshes
+	if(submeshes)
 	{
-		unsigned int numUVs = (int) m_UVs.size();
+		if(m_parts.empty()) BuildSubmeshes(m_mesh);
+		for(size_t i = 0; i < m_parts.size(); i++) BuildSubmeshes(m_parts[i]);
+	}
 
-		os << "UVs: " << numUVs << endl;
-		for(unsigned int i = 0; i < numUVs; i++)
+	// sur l'ordre final des triangles de chaque morceau
+	if(m_exportOptions & CPM_EXPORT_ADJACENCY)
+	{
+		CPM_ADJACENCY_STATS stats;
+		if(m_parts.empty()) stats = BuildMeshAdjacency(m_mesh);
+		for(size_t i = 0; i < m_parts.size(); i++)
 		{
-			os << m_UVs[i].u << " " << ((m_exportOptions & CPM_EXPORT_INVERTV) != 0 ? -m_UVs[i].v + 1.0f : m_UVs[i].v) << endl;
+			const CPM_ADJACENCY_STATS part = BuildMeshAdjacency(m_parts[i]);
+			stats.triangles += part.triangles;
+			stats.boundaryEdges += part.boundaryEdges;
+			stats.nonManifoldEdges += part.nonManifoldEdges;
+			stats.degenerateEdges += part.degenerateEdges;
 		}
-		os << "\n\n";
+
+		char info[256];
+		sprintf(info, "Adjacence de %s: %u triangles, %u artes ouvertes, %u non-manifold, %u dgnres", m_mesh.name.c_str(),
+			stats.triangles, stats.boundaryEdges, stats.nonManifoldEdges, stats.degenerateEdges);
+		if(stats.nonManifoldEdges) addMessage(true, info);
+		else addMessage(false, info);
 	}
 
 	return MS::kSuccess;
 }
 
-MStatus CPMPolyWriter::outputColors(ostream &os)
+void CPMPolyWriter::addMessage(bool warning, const std::string &text)
 {
-	return MS::kSuccess;
+	DEFERRED_MESSAGE message;
+	message.warning = warning;
+	message.text = text;
+	m_messages.push_back(message);
 }
 
-MStatus CPMPolyWriter::outputMaterialSets(ostream &os)
+MStatus CPMPolyWriter::writeToFile(ostream &os)
 {
-	if(m_exportOptions & CPM_EXPORT_MATERIALSETS)
+	for(size_t i = 0; i < m_messages.size(); i++)
 	{
-		unsigned int numSets = (unsigned int) m_materials.size();
-
-		os << "Materials: " << numSets << "\n" << endl;
-		for(std::list<MATERIAL_INFO>::iterator it = m_materials.begin(); it != m_materials.end(); it++)
-		{
-			os << "material:" << endl;
-
-			if(it->colorTexName != "" && (m_exportOptions & CPM_EXPORT_TEXTURENAMES)) {
-				os << "colorTexName: " << ((m_exportOptions & CPM_EXPORT_TRUNCATE_TEXTURENAMES) != 0 ? TruncatePath(it->colorTexName) : it->colorTexName.asChar()) << endl;
-			}
-			else { os << "color: " << it->color.r << " " << it->color.g << " " << it->color.b << " " << it->color.a << endl; }
-
-			if(it->specularColorTexName != "" && (m_exportOptions & CPM_EXPORT_TEXTURENAMES)) {
-				os << "specularColorTexName: " << ((m_exportOptions & CPM_EXPORT_TRUNCATE_TEXTURENAMES) != 0 ? TruncatePath(it->specularColorTexName) : it->specularColorTexName.asChar()) << endl;
-			}
-			else { os << "specularColor: " << it->specularColor.r << " " << it->specularColor.g << " " << it->specularColor.b << " " << it->specularColor.a << endl; }
-
-			if(it->specularPowerTexName != "" && (m_exportOptions & CPM_EXPORT_TEXTURENAMES)) {
-				os << "specularPowerTexName: " << ((m_exportOptions & CPM_EXPORT_TRUNCATE_TEXTURENAMES) != 0 ? TruncatePath(it->specularPowerTexName) : it->specularPowerTexName.asChar()) << endl;
-			}
-			else { os << "specularPower: " << it->specularPower << endl; }
-
-			if(it->ambientTexName != "" && (m_exportOptions & CPM_EXPORT_TEXTURENAMES)) {
-				os << "ambientTexName: " << ((m_exportOptions & CPM_EXPORT_TRUNCATE_TEXTURENAMES) != 0 ? TruncatePath(it->ambientTexName) : it->ambientTexName.asChar()) << endl;
-			}
-			else { os << "ambient: " << it->ambient.r << " " << it->ambient.g << " " << it->ambient.b << " " << it->ambient.a << endl; }
-
-			if(it->transparencyTexName != "" && (m_exportOptions & CPM_EXPORT_TEXTURENAMES)) {
-				os << "transparencyTexName: " << ((m_exportOptions & CPM_EXPORT_TRUNCATE_TEXTURENAMES) != 0 ? TruncatePath(it->transparencyTexName) : it->transparencyTexName.asChar()) << endl;
-			}
-			else { os << "transparency: " << it->transparency.r << " " << it->transparency.g << " " << it->transparency.b << " " << it->transparency.a << endl; }
-
-			if(it->normalTexName != "" && (m_exportOptions & CPM_EXPORT_TEXTURENAMES)) {
-				os << "normalTexName: " << ((m_exportOptions & CPM_EXPORT_TRUNCATE_TEXTURENAMES) != 0 ? TruncatePath(it->normalTexName) : it->normalTexName.asChar()) << endl;
-			}
+		if(m_messages[i].warning) MGlobal::displayWarning(m_messages[i].text.c_str());
+		else MGlobal::displayInfo(m_messages[i].text.c_str());
+	}
 
-			if(it->bumpTexName != "" && (m_exportOptions & CPM_EXPORT_TEXTURENAMES)) {
-				os << "bumpTexName: " << ((m_exportOptions & CPM_EXPORT_TRUNCATE_TEXTURENAMES) != 0 ? TruncatePath(it->bumpTexName) : it->bumpTexName.asChar()) << endl;
-			}
+	unsigned long long savedIndexBytes = 0;
 
-			if(m_materials.size() != 1)
-			{
-				unsigned int numFaces;
-				numFaces = (unsigned int) it->faceIds.size();
-				os << "Faces: " << numFaces << endl;
-				for(unsigned int i = 0; i < numFaces; i++)
-				{
-					os << it->faceIds[i] << endl;
-				}
-			}
-			else
-			{
-				os << "faces: " << 0 << endl;
-			}
+	if(m_streamingMesh)
+	{
+		if(!m_streamingMesh->write(os, m_mesh, &m_objects)) {
+			MGlobal::displayError(m_streamingMesh->getError().c_str());
+			return MS::kFailure;
+		}
+		savedIndexBytes = m_streamingMesh->getStats().savedIndexBytes;
+	}
+	else
+	{
+		// un mesh dcoup est crit comme un objet par morceau
+		const size_t numObjects = m_parts.empty() ? 1 : m_parts.size();
+		for(size_t i = 0; i < numObjects; i++)
+		{
+			const CPM_MESH_DATA &mesh = m_parts.empty() ? m_mesh : m_parts[i];
 
-			os << "\n";
+			CPMMeshWriter writer(mesh, m_exportOptions);
+			writer.write(os, &m_objects);
+			savedIndexBytes += GetIndexLayout(mesh, m_exportOptions).savedBytes;
 		}
-		os << "\n\n";
 	}
 
-	return MS::kSuccess;
-}
\ No newline at end of file
+	if(savedIndexBytes)
+	{
+		char info[256];
+		sprintf(info, "Indices 16 bits ou compresss pour %s: %.1f Ko conomiss", m_mesh.name.c_str(), savedIndexBytes / 1024.0);
+		MGlobal::displayInfo(info);
+	}
+
+	return os ? MS::kSuccess : MS::kFailure;
+}
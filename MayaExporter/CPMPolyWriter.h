@@ -1,60 +1,44 @@
 #ifndef CPM_POLYWRITER_H_INCLUDED
 #define CPM_POLYWRITER_H_INCLUDED
 
-#include <vector>
-#include <list>
-
 #include <maya/MGlobal.h>
-#include <maya/MPointArray.h>
-#include <maya/MColorArray.h>
-#include <maya/MFloatVector.h>
-#include <maya/MFloatArray.h>
-#include <maya/MFloatVectorArray.h>
-#include <maya/MStringArray.h>
 #include <maya/MMatrix.h>
 
 #include "PolyWriter.h"
 #include "CPMMeshExtractor.h"
+#include "CPMMeshWriter.h"
+#include "CPMStreamingExport.h"
 
 class CPMPolyWriter : public PolyWriter
 {
+	// extrait le mesh de Maya, l'criture du fichier est confie  CPMMeshWriter
 	public:
-	CPMPolyWriter(const MDagPath &dagPath, unsigned int exportOptions, MStatus &status);
+	CPMPolyWriter(const MDagPath &dagPath, unsigned int exportOptions, CPMStringPool &strings, CPMObjectTable &objects, MStatus &status);
 	virtual ~CPMPolyWriter();
 
 	virtual MStatus extractGeometry();
+	virtual MStatus processGeometry();
 	virtual MStatus writeToFile(ostream &os);
 
 	protected:
-	virtual MStatus outputObjectProperties(ostream &os);
-	virtual MStatus outputTriangles(ostream &os);
-	virtual MStatus outputVertices(ostream &os);
-	virtual MStatus outputNormals(ostream &os);
-	virtual MStatus outputTangents(ostream &os);
-	virtual MStatus outputBinormals(ostream &os);
-	virtual MStatus outputUVs(ostream &os);
-	virtual MStatus outputColors(ostream &os);
-	virtual MStatus outputMaterialSets(ostream &os);
-
-	private:
+	void addMessage(bool warning, const std::string &text); // affich par writeToFile, sur le thread principal
 
 	protected:
-	unsigned int						m_exportOptions;
-
-	MString								m_meshName;
-	MMatrix								m_transformMatrix;
+	struct DEFERRED_MESSAGE
+	{
+		bool			warning;
+		std::string		text;
+	};
 
-	MIntArray							m_triangles;
-
-	MPointArray							m_points;
-	MFloatVectorArray					m_normals;
-	std::vector<TGT_BINORMAL>			m_tgtBinormals;
-	std::vector<UV>						m_UVs;
-	MString								m_uvSetName;
-	MColorArray							m_colors;
-	MString								m_colorSetName;
-
-	std::list<MATERIAL_INFO>			m_materials;
+	unsigned int						m_exportOptions;
+	AXIS_CONVERSION						m_axisConversion;
+
+	CPMStringPool						&m_strings; // pool de la session d'exportation, partag par les meshes du fichier
+	CPMObjectTable						&m_objects; // table des objets du fichier, complte par writeToFile
+	CPM_MESH_DATA						m_mesh;
+	std::vector<CPM_MESH_DATA>			m_parts; // CPM_EXPORT_SPLIT_16BIT: morceaux crits  la place de m_mesh quand il est trop grand
+	CPMStreamingMesh					*m_streamingMesh; // CPM_EXPORT_STREAMING: triangles et vertices dans des fichiers temporaires, m_mesh ne contient que les proprits
+	std::vector<DEFERRED_MESSAGE>		m_messages; // messages de processGeometry
 };
 
 #endif // CPM_POLYWRITER_H_INCLUDED
\ No newline at end of file
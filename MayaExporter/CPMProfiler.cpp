@@ -0,0 +1,241 @@
+#include "CPMProfiler.h"
+
+#ifdef CPM_PROFILING
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <fstream>
+
+struct PROFILE_EVENT
+{
+	const char		*name;
+	long long		start;
+	long long		end;
+	unsigned int	thread;
+};
+
+struct PROFILE_MESH
+{
+	std::string							name;
+	long long							start;
+	long long							end;
+	std::vector<unsigned long long>		values;		// valeur de chaque compteur pendant l'exportation du mesh
+};
+
+static std::mutex								g_mutex;
+static std::chrono::steady_clock::time_point	g_epoch = std::chrono::steady_clock::now();
+static std::deque<CPM_PROFILE_COUNTER>			g_counters;
+static std::vector<PROFILE_EVENT>				g_events;
+static std::vector<PROFILE_MESH>				g_meshes;
+static std::vector<unsigned long long>			g_meshBegin;
+static std::map<std::thread::id, unsigned int>	g_threads;
+
+static void SnapshotCounters(std::vector<unsigned long long> &values)
+//  appeler avec g_mutex verrouill
+{
+	values.resize(g_counters.size());
+	for(size_t i = 0; i < g_counters.size(); i++) values[i] = g_counters[i].value.load();
+}
+
+static std::string EscapeJson(const std::string &str)
+{
+	std::string escaped;
+	for(size_t i = 0; i < str.size(); i++)
+	{
+		if(str[i] == '"' || str[i] == '\\') escaped += '\\';
+		escaped += str[i];
+	}
+	return escaped;
+}
+
+long long CPMProfiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void CPMProfiler::BeginSession()
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	g_epoch = std::chrono::steady_clock::now();
+	g_events.clear();
+	g_meshes.clear();
+	g_threads.clear();
+	for(size_t i = 0; i < g_counters.size(); i++)
+	{
+		g_counters[i].value = 0;
+		g_counters[i].calls = 0;
+	}
+}
+
+void CPMProfiler::BeginMesh(const char *meshName)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	PROFILE_MESH mesh;
+	mesh.name = meshName;
+	mesh.start = Now();
+	mesh.end = mesh.start;
+	g_meshes.push_back(mesh);
+
+	SnapshotCounters(g_meshBegin);
+}
+
+void CPMProfiler::EndMesh()
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+	if(g_meshes.empty()) return;
+
+	PROFILE_MESH &mesh = g_meshes.back();
+	mesh.end = Now();
+
+	// les compteurs crs pendant l'exportation du mesh partent de 0
+	SnapshotCounters(mesh.values);
+	for(size_t i = 0; i < g_meshBegin.size(); i++) mesh.values[i] -= g_meshBegin[i];
+}
+
+CPM_PROFILE_COUNTER *CPMProfiler::GetCounter(const char *name, CPM_PROFILE_COUNTER_KIND kind)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	for(size_t i = 0; i < g_counters.size(); i++)
+	{
+		if(g_counters[i].kind == kind && strcmp(g_counters[i].name, name) == 0) return &g_counters[i];
+	}
+
+	g_counters.emplace_back();
+	CPM_PROFILE_COUNTER &counter = g_counters.back();
+	counter.name = name;
+	counter.kind = kind;
+	counter.value = 0;
+	counter.calls = 0;
+
+	return &counter;
+}
+
+void CPMProfiler::AddEvent(const char *name, long long start, long long end)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	std::map<std::thread::id, unsigned int>::iterator it = g_threads.find(std::this_thread::get_id());
+	if(it == g_threads.end()) it = g_threads.insert(std::make_pair(std::this_thread::get_id(), (unsigned int) g_threads.size())).first;
+
+	PROFILE_EVENT event = { name, start, end, it->second };
+	g_events.push_back(event);
+}
+
+static void WriteChromeTrace(const char *fileName)
+// Rsum: trace lisible par chrome://tracing ou Perfetto, les compteurs de chaque mesh sont les arguments de son vnement
+{
+	std::ofstream os(fileName);
+	if(!os) return;
+
+	os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	char line[512];
+	bool first = true;
+	for(size_t i = 0; i < g_events.size(); i++)
+	{
+		const PROFILE_EVENT &event = g_events[i];
+		sprintf(line, "%s{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n",
+			event.name, event.thread, event.start * 1e-3, (event.end - event.start) * 1e-3);
+		os << line;
+		first = false;
+	}
+
+	for(size_t i = 0; i < g_meshes.size(); i++)
+	{
+		const PROFILE_MESH &mesh = g_meshes[i];
+		sprintf(line, "%s{\"name\":\"%s\",\"cat\":\"mesh\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{", first ? "" : ",\n",
+			EscapeJson(mesh.name).c_str(), mesh.start * 1e-3, (mesh.end - mesh.start) * 1e-3);
+		os << line;
+		first = false;
+
+		for(size_t c = 0; c < mesh.values.size(); c++)
+		{
+			os << (c ? "," : "") << "\"" << g_counters[c].name << (g_counters[c].kind == CPM_PROFILE_COUNTER_TIME ? " (ns)" : "") << "\":" << mesh.values[c];
+		}
+		os << "}}";
+	}
+
+	os << "\n]}\n";
+}
+
+void CPMProfiler::EndSession(const char *traceFileName, std::vector<std::string> &summary)
+{
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	if(traceFileName) WriteChromeTrace(traceFileName);
+
+	char line[512];
+	const double sessionMs = Now() * 1e-6;
+	summary.clear();
+
+	sprintf(line, "Profil de l'exportation: %u meshes, %.2f ms", (unsigned int) g_meshes.size(), sessionMs);
+	summary.push_back(line);
+
+	// phases: vnements regroups par nom, puis dures cumules
+	std::vector<const char*> phases;
+	std::vector<double> phaseMs;
+	std::vector<unsigned long long> phaseCalls;
+	for(size_t i = 0; i < g_events.size(); i++)
+	{
+		size_t p = 0;
+		for(; p < phases.size() && strcmp(phases[p], g_events[i].name) != 0; p++) {}
+		if(p == phases.size())
+		{
+			phases.push_back(g_events[i].name);
+			phaseMs.push_back(0.0);
+			phaseCalls.push_back(0);
+		}
+		phaseMs[p] += (g_events[i].end - g_events[i].start) * 1e-6;
+		phaseCalls[p]++;
+	}
+	for(size_t c = 0; c < g_counters.size(); c++)
+	{
+		if(g_counters[c].kind != CPM_PROFILE_COUNTER_TIME) continue;
+		phases.push_back(g_counters[c].name);
+		phaseMs.push_back(g_counters[c].value * 1e-6);
+		phaseCalls.push_back(g_counters[c].calls);
+	}
+
+	sprintf(line, "  %-40s %12s %12s %7s", "phase", "appels", "total (ms)", "%");
+	summary.push_back(line);
+	for(size_t p = 0; p < phases.size(); p++)
+	{
+		sprintf(line, "  %-40s %12llu %12.2f %7.1f", phases[p], phaseCalls[p], phaseMs[p], sessionMs > 0.0 ? 100.0 * phaseMs[p] / sessionMs : 0.0);
+		summary.push_back(line);
+	}
+
+	sprintf(line, "  %-40s %20s", "compteur", "total");
+	summary.push_back(line);
+	for(size_t c = 0; c < g_counters.size(); c++)
+	{
+		if(g_counters[c].kind == CPM_PROFILE_COUNTER_TIME) continue;
+		sprintf(line, "  %-40s %20llu%s", g_counters[c].name, g_counters[c].value.load(), g_counters[c].kind == CPM_PROFILE_COUNTER_BYTES ? " octets" : "");
+		summary.push_back(line);
+	}
+
+	// un tableau par mesh: dure et compteurs non nuls
+	for(size_t i = 0; i < g_meshes.size(); i++)
+	{
+		const PROFILE_MESH &mesh = g_meshes[i];
+		std::string text = "  " + mesh.name;
+		sprintf(line, ": %.2f ms", (mesh.end - mesh.start) * 1e-6);
+		text += line;
+
+		for(size_t c = 0; c < mesh.values.size(); c++)
+		{
+			if(mesh.values[c] == 0 || g_counters[c].kind == CPM_PROFILE_COUNTER_TIME) continue;
+			sprintf(line, ", %s %llu", g_counters[c].name, mesh.values[c]);
+			text += line;
+		}
+		summary.push_back(text);
+	}
+}
+
+#endif // CPM_PROFILING
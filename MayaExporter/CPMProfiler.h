@@ -0,0 +1,111 @@
+#ifndef CPM_PROFILER_H_INCLUDED
+#define CPM_PROFILER_H_INCLUDED
+
+//
+//	Instrumentation de l'exportation: dure des phases, compteurs, trace au format Chrome (chrome://tracing)
+//	n'est compile que si CPM_PROFILING est dfini, les macros CPM_PROFILE_* ne gnrent aucun code sinon
+//
+//	CPM_PROFILE_SCOPE(name)				dure du bloc, enregistre comme un vnement de la trace
+//	CPM_PROFILE_SECTION(name, os)		dure du bloc et nombre d'octets crits dans os
+//	CPM_PROFILE_ACCUMULATE(name)		dure cumule d'une fonction appele trs souvent, sans vnement individuel
+//	CPM_PROFILE_COUNT(name, value)		ajoute value au compteur name
+//
+#ifdef CPM_PROFILING
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+enum CPM_PROFILE_COUNTER_KIND
+{
+	CPM_PROFILE_COUNTER_VALUE,
+	CPM_PROFILE_COUNTER_BYTES,
+	CPM_PROFILE_COUNTER_TIME,		// nanosecondes
+};
+
+struct CPM_PROFILE_COUNTER
+{
+	const char							*name;
+	CPM_PROFILE_COUNTER_KIND			kind;
+	std::atomic<unsigned long long>		value;
+	std::atomic<unsigned long long>		calls;
+};
+
+class CPMProfiler
+{
+	public:
+	static void BeginSession();
+	static void EndSession(const char *traceFileName, std::vector<std::string> &summary); // crit la trace et prpare le tableau rcapitulatif
+
+	static void BeginMesh(const char *meshName);
+	static void EndMesh();
+
+	static CPM_PROFILE_COUNTER *GetCounter(const char *name, CPM_PROFILE_COUNTER_KIND kind); // adresse stable,  conserver par le site d'appel
+	static void AddEvent(const char *name, long long start, long long end);
+
+	static long long Now(); // nanosecondes depuis le dbut de la session
+};
+
+class CPMProfileScope
+{
+	public:
+	CPMProfileScope(const char *name) : m_name(name), m_start(CPMProfiler::Now()) {}
+	~CPMProfileScope() { CPMProfiler::AddEvent(m_name, m_start, CPMProfiler::Now()); }
+
+	protected:
+	const char		*m_name;
+	long long		m_start;
+};
+
+class CPMProfileSection : public CPMProfileScope
+{
+	public:
+	CPMProfileSection(const char *name, std::ostream &os) : CPMProfileScope(name), m_os(os), m_begin(os.tellp()) {}
+	~CPMProfileSection()
+	{
+		const std::streamoff end = m_os.tellp();
+		if(m_begin >= 0 && end >= m_begin) CPMProfiler::GetCounter(m_name, CPM_PROFILE_COUNTER_BYTES)->value += (unsigned long long) (end - m_begin);
+	}
+
+	protected:
+	std::ostream	&m_os;
+	std::streamoff	m_begin;
+};
+
+class CPMProfileAccumulate
+{
+	public:
+	CPMProfileAccumulate(CPM_PROFILE_COUNTER *counter) : m_counter(counter), m_start(std::chrono::steady_clock::now()) {}
+	~CPMProfileAccumulate()
+	{
+		m_counter->value.fetch_add((unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count(), std::memory_order_relaxed);
+		m_counter->calls.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	protected:
+	CPM_PROFILE_COUNTER						*m_counter;
+	std::chrono::steady_clock::time_point	m_start;
+};
+
+#define CPM_PROFILE_CONCAT_(a, b)		a##b
+#define CPM_PROFILE_CONCAT(a, b)		CPM_PROFILE_CONCAT_(a, b)
+
+#define CPM_PROFILE_SCOPE(name)			CPMProfileScope CPM_PROFILE_CONCAT(cpmProfileScope, __LINE__)(name)
+#define CPM_PROFILE_SECTION(name, os)	CPMProfileSection CPM_PROFILE_CONCAT(cpmProfileSection, __LINE__)(name, os)
+#define CPM_PROFILE_ACCUMULATE(name)	static CPM_PROFILE_COUNTER *CPM_PROFILE_CONCAT(cpmProfileTimer, __LINE__) = CPMProfiler::GetCounter(name, CPM_PROFILE_COUNTER_TIME); \
+										CPMProfileAccumulate CPM_PROFILE_CONCAT(cpmProfileAccumulate, __LINE__)(CPM_PROFILE_CONCAT(cpmProfileTimer, __LINE__))
+#define CPM_PROFILE_COUNT(name, count)	do { static CPM_PROFILE_COUNTER *cpmProfileCounter = CPMProfiler::GetCounter(name, CPM_PROFILE_COUNTER_VALUE); \
+										cpmProfileCounter->value.fetch_add((unsigned long long) (count), std::memory_order_relaxed); } while(0)
+
+#else
+
+#define CPM_PROFILE_SCOPE(name)
+#define CPM_PROFILE_SECTION(name, os)
+#define CPM_PROFILE_ACCUMULATE(name)
+#define CPM_PROFILE_COUNT(name, count)	do {} while(0)
+
+#endif // CPM_PROFILING
+
+#endif // CPM_PROFILER_H_INCLUDED
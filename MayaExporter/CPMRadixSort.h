@@ -0,0 +1,118 @@
+#ifndef CPM_RADIX_SORT_H_INCLUDED
+#define CPM_RADIX_SORT_H_INCLUDED
+
+#include <vector>
+
+#include "CPMParallel.h"
+
+//
+//	Tri par base (LSD) parallle et stable d'enregistrements portant une cl entire de 64 ou 128 bits
+//	la mmoire utilise ne dpend que du nombre d'enregistrements: un tampon de mme taille que le tableau tri
+//
+struct CPM_KEY128
+{
+	CPM_KEY128() : lo(0), hi(0) {}
+
+	bool operator==(const CPM_KEY128 &other) const { return lo == other.lo && hi == other.hi; }
+	bool operator!=(const CPM_KEY128 &other) const { return !(*this == other); }
+	bool operator<(const CPM_KEY128 &other) const { return hi < other.hi || (hi == other.hi && lo < other.lo); }
+
+	unsigned long long	lo;
+	unsigned long long	hi;
+};
+
+inline unsigned int RadixDigit(unsigned long long key, unsigned int shift) { return (unsigned int) (key >> shift) & 0xff; }
+inline unsigned int RadixDigit(const CPM_KEY128 &key, unsigned int shift) { return (unsigned int) (shift < 64 ? key.lo >> shift : key.hi >> (shift - 64)) & 0xff; }
+
+inline void SetKeyBits(unsigned long long &key, unsigned int shift, unsigned long long value) { key |= value << shift; }
+inline void SetKeyBits(CPM_KEY128 &key, unsigned int shift, unsigned long long value)
+// Rsum: place value (64 bits au plus)  partir du bit shift, ventuellement  cheval sur les deux mots
+{
+	if(shift < 64)
+	{
+		key.lo |= value << shift;
+		if(shift) key.hi |= value >> (64 - shift);
+	}
+	else
+	{
+		key.hi |= value << (shift - 64);
+	}
+}
+
+inline unsigned long long GetKeyBits(unsigned long long key, unsigned int shift, unsigned int bits) { return bits ? (key >> shift) & (~0ULL >> (64 - bits)) : 0; }
+inline unsigned long long GetKeyBits(const CPM_KEY128 &key, unsigned int shift, unsigned int bits)
+// Rsum: lit 'bits' bits (64 au plus)  partir du bit shift
+{
+	if(!bits) return 0;
+	unsigned long long value = shift < 64 ? key.lo >> shift : key.hi >> (shift - 64);
+	if(shift < 64 && shift + bits > 64) value |= key.hi << (64 - shift);
+	return value & (~0ULL >> (64 - bits));
+}
+
+inline unsigned int BitsFor(unsigned long long maxValue)
+// Rsum: nombre de bits ncessaires pour reprsenter les valeurs de 0  maxValue
+{
+	unsigned int bits = 0;
+	while(maxValue) { bits++; maxValue >>= 1; }
+	return bits;
+}
+
+template<typename RECORD>
+void RadixSort(std::vector<RECORD> &records, unsigned int keyBits, std::vector<RECORD> &buffer)
+// Rsum: trie records par ordre croissant de leur membre 'key', l'ordre des enregistrements de mme cl est conserv
+// Args: keyBits - nombre de bits significatifs des cls: les passes au-del sont omises
+//		 buffer - tampon de travail, redimensionn si ncessaire
+{
+	const size_t count = records.size();
+	buffer.resize(count);
+	if(count < 2) return;
+
+	const unsigned int numChunks = GetWorkerCount();
+	const size_t chunkSize = (count + numChunks - 1) / numChunks;
+	std::vector<size_t> histograms((size_t) numChunks * 256);
+
+	RECORD *source = &records[0], *destination = &buffer[0];
+	for(unsigned int shift = 0; shift < keyBits; shift += 8)
+	{
+		// histogramme des chiffres de chaque intervalle
+		std::fill(histograms.begin(), histograms.end(), 0);
+		ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+		{
+			for(size_t c = begin; c < end; c++)
+			{
+				size_t *histogram = &histograms[c * 256];
+				const size_t last = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+				for(size_t i = c * chunkSize; i < last; i++) histogram[RadixDigit(source[i].key, shift)]++;
+			}
+		});
+
+		// position de dpart de chaque (chiffre, intervalle): par chiffre puis par intervalle pour que le tri reste stable
+		size_t offset = 0;
+		for(unsigned int d = 0; d < 256; d++)
+		{
+			for(unsigned int c = 0; c < numChunks; c++)
+			{
+				const size_t n = histograms[(size_t) c * 256 + d];
+				histograms[(size_t) c * 256 + d] = offset;
+				offset += n;
+			}
+		}
+
+		ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+		{
+			for(size_t c = begin; c < end; c++)
+			{
+				size_t *positions = &histograms[c * 256];
+				const size_t last = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+				for(size_t i = c * chunkSize; i < last; i++) destination[positions[RadixDigit(source[i].key, shift)]++] = source[i];
+			}
+		});
+
+		std::swap(source, destination);
+	}
+
+	// aprs un nombre impair de passes le rsultat est dans le tampon
+	if(source != &records[0]) records.swap(buffer);
+}
+
+#endif // CPM_RADIX_SORT_H_INCLUDED
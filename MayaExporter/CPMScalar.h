@@ -0,0 +1,178 @@
+#ifndef CPM_SCALAR_H_INCLUDED
+#define CPM_SCALAR_H_INCLUDED
+
+#include <cstring>
+
+//
+//	Types scalaires utiliss pour l'exportation des attributs
+//
+enum CPM_SCALAR_TYPE
+{
+	CPM_SCALAR_NONE			= 0,
+	CPM_SCALAR_HALF			= 1,
+	CPM_SCALAR_FLOAT		= 2,
+	CPM_SCALAR_DOUBLE		= 3,
+	CPM_SCALAR_UINT16		= 4,
+	CPM_SCALAR_UINT32		= 5,
+};
+
+inline const char *ScalarTypeName(CPM_SCALAR_TYPE type)
+{
+	switch(type)
+	{
+		case CPM_SCALAR_HALF:		return "half";
+		case CPM_SCALAR_FLOAT:		return "float";
+		case CPM_SCALAR_DOUBLE:		return "double";
+		case CPM_SCALAR_UINT16:		return "uint16";
+		case CPM_SCALAR_UINT32:		return "uint32";
+		default:					return "none";
+	}
+}
+
+inline unsigned int ScalarTypeSize(CPM_SCALAR_TYPE type)
+{
+	switch(type)
+	{
+		case CPM_SCALAR_HALF:		return 2;
+		case CPM_SCALAR_FLOAT:		return 4;
+		case CPM_SCALAR_DOUBLE:		return 8;
+		case CPM_SCALAR_UINT16:		return 2;
+		case CPM_SCALAR_UINT32:		return 4;
+		default:					return 0;
+	}
+}
+
+// Prcision de chaque attribut export, choisie une fois par exportation
+struct CPM_PRECISION
+{
+	CPM_PRECISION() : positions(CPM_SCALAR_FLOAT), normals(CPM_SCALAR_FLOAT), tangents(CPM_SCALAR_FLOAT), binormals(CPM_SCALAR_FLOAT), uvs(CPM_SCALAR_FLOAT), colors(CPM_SCALAR_FLOAT) {}
+
+	CPM_SCALAR_TYPE		positions;
+	CPM_SCALAR_TYPE		normals;
+	CPM_SCALAR_TYPE		tangents;
+	CPM_SCALAR_TYPE		binormals;
+	CPM_SCALAR_TYPE		uvs;
+	CPM_SCALAR_TYPE		colors;
+};
+
+
+//
+//	Flottant 16 bits (IEEE 754 binary16)
+//
+inline unsigned short FloatToHalf(float value)
+// Rsum: convertit un flottant 32 bits en flottant 16 bits, arrondi au plus proche (pair)
+{
+	unsigned int u;
+	memcpy(&u, &value, sizeof(u));
+
+	const unsigned int sign = (u >> 16) & 0x8000;
+	const unsigned int absu = u & 0x7fffffff;
+
+	if(absu >= 0x47800000) // >= 65536, infini ou NaN
+	{
+		if(absu > 0x7f800000) return (unsigned short) (sign | 0x7e00);
+		return (unsigned short) (sign | 0x7c00);
+	}
+
+	if(absu < 0x38800000) // < 2^-14 : nombre dnormalis
+	{
+		if(absu < 0x33000000) return (unsigned short) sign;
+
+		const unsigned int e = absu >> 23;
+		const unsigned int m = (absu & 0x7fffff) | 0x800000;
+		const unsigned int shift = 126 - e;
+		unsigned int h = m >> shift;
+		const unsigned int rem = m & ((1u << shift) - 1);
+		const unsigned int halfway = 1u << (shift - 1);
+		if(rem > halfway || (rem == halfway && (h & 1))) h++;
+
+		return (unsigned short) (sign | h);
+	}
+
+	// la retenue de l'arrondi peut se propager dans l'exposant, jusqu' l'infini
+	unsigned int h = (absu - 0x38000000) >> 13;
+	const unsigned int rem = absu & 0x1fff;
+	if(rem > 0x1000 || (rem == 0x1000 && (h & 1))) h++;
+
+	return (unsigned short) (sign | h);
+}
+
+inline float HalfToFloat(unsigned short h)
+// Rsum: convertit un flottant 16 bits en flottant 32 bits (sans perte)
+{
+	const unsigned int sign = (h & 0x8000) << 16;
+	const unsigned int e = (h >> 10) & 0x1f;
+	const unsigned int m = h & 0x3ff;
+
+	unsigned int u;
+	if(e == 0)
+	{
+		const float f = m * (1.0f / 16777216.0f); // m * 2^-24
+		return sign ? -f : f;
+	}
+	else if(e == 31)	u = sign | 0x7f800000 | (m << 13);
+	else				u = sign | ((e + 112) << 23) | (m << 13);
+
+	float value;
+	memcpy(&value, &u, sizeof(value));
+	return value;
+}
+
+struct HALF
+{
+	HALF() : bits(0) {}
+	explicit HALF(float value) : bits(FloatToHalf(value)) {}
+
+	operator float() const { return HalfToFloat(bits); }
+
+	unsigned short	bits;
+};
+
+
+//
+//	SCALAR_TRAITS: proprits de chaque type scalaire exportable
+//	textDigits: nombre de chiffres significatifs ncessaires pour relire la valeur sans perte
+//
+template<typename T> struct SCALAR_TRAITS;
+
+template<> struct SCALAR_TRAITS<HALF>
+{
+	typedef float TextType;
+	static const CPM_SCALAR_TYPE type = CPM_SCALAR_HALF;
+	static const int textDigits = 5;
+	template<typename S> static HALF convert(S value) { return HALF((float) value); }
+};
+
+template<> struct SCALAR_TRAITS<float>
+{
+	typedef float TextType;
+	static const CPM_SCALAR_TYPE type = CPM_SCALAR_FLOAT;
+	static const int textDigits = 9;
+	template<typename S> static float convert(S value) { return (float) value; }
+};
+
+template<> struct SCALAR_TRAITS<double>
+{
+	typedef double TextType;
+	static const CPM_SCALAR_TYPE type = CPM_SCALAR_DOUBLE;
+	static const int textDigits = 17;
+	template<typename S> static double convert(S value) { return (double) value; }
+};
+
+template<> struct SCALAR_TRAITS<unsigned short>
+{
+	typedef unsigned int TextType;
+	static const CPM_SCALAR_TYPE type = CPM_SCALAR_UINT16;
+	static const int textDigits = 5;
+	template<typename S> static unsigned short convert(S value) { return (unsigned short) value; }
+};
+
+template<> struct SCALAR_TRAITS<unsigned int>
+{
+	typedef unsigned int TextType;
+	static const CPM_SCALAR_TYPE type = CPM_SCALAR_UINT32;
+	static const int textDigits = 10;
+	template<typename S> static unsigned int convert(S value) { return (unsigned int) value; }
+};
+
+#endif // CPM_SCALAR_H_INCLUDED
@@ -0,0 +1,52 @@
+#include "CPMSimd.h"
+
+#if defined(_MSC_VER) && defined(CPM_X86)
+#include <intrin.h>
+#endif
+
+static CPM_SIMD_LEVEL DetectSimdLevel()
+{
+	CPM_SIMD_LEVEL level = CPM_SIMD_SCALAR;
+
+#ifdef CPM_USE_SSE2
+	level = CPM_SIMD_SSE2;
+#endif
+
+#if defined(CPM_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if(info[0] >= 7)
+	{
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+
+		__cpuidex(info, 7, 0);
+		const bool avx2 = (info[1] & (1 << 5)) != 0;
+
+		// le systme doit sauvegarder les registres ymm
+		if(osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6) level = CPM_SIMD_AVX2;
+	}
+#elif defined(CPM_X86) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")) level = CPM_SIMD_AVX2;
+#endif
+
+	return level;
+}
+
+CPM_SIMD_LEVEL GetSimdLevel()
+{
+	static const CPM_SIMD_LEVEL level = DetectSimdLevel();
+	return level;
+}
+
+const char *SimdLevelName(CPM_SIMD_LEVEL level)
+{
+	switch(level)
+	{
+		case CPM_SIMD_AVX2:		return "avx2";
+		case CPM_SIMD_SSE2:		return "sse2";
+		default:				return "scalar";
+	}
+}
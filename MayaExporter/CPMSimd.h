@@ -0,0 +1,38 @@
+#ifndef CPM_SIMD_H_INCLUDED
+#define CPM_SIMD_H_INCLUDED
+
+//
+//	Jeux d'instructions vectorielles
+//	SSE2 est toujours disponible en x64, AVX2 est dtect  l'excution
+//
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPM_X86
+#endif
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPM_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(CPM_X86)
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define CPM_TARGET_AVX2 __attribute__((target("avx2")))
+#define CPM_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define CPM_TARGET_AVX2
+#define CPM_TARGET_SSE42
+#endif
+#endif
+
+enum CPM_SIMD_LEVEL
+{
+	CPM_SIMD_SCALAR		= 0,
+	CPM_SIMD_SSE2		= 1,
+	CPM_SIMD_AVX2		= 2,
+};
+
+CPM_SIMD_LEVEL GetSimdLevel(); // meilleur jeu d'instructions support par le processeur
+const char *SimdLevelName(CPM_SIMD_LEVEL level);
+
+#endif // CPM_SIMD_H_INCLUDED
@@ -0,0 +1,866 @@
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <queue>
+#include <sstream>
+
+#include "CPMStreamingExport.h"
+#include "CPMMeshWriter.h"
+#include "CPMAttributeWriter.h"
+#include "CPMIndexCodec.h"
+#include "CPMVertexLayout.h"
+#include "CPMRadixSort.h"
+#include "CPMProfiler.h"
+
+#define CPM_STREAMING_MIN_BUDGET		(16 << 20)
+#define CPM_STREAMING_VERTEX_CHUNK		(16 << 10)	// vertices transforms et crits ensemble pendant la fusion
+#define CPM_STREAMING_MATERIAL_BLOCK	(16 << 10)	// triangles au plus par bloc d'un matriau
+
+static CPM_STREAMING_SETTINGS s_streamingSettings;
+
+const CPM_STREAMING_SETTINGS &GetStreamingSettings()
+{
+	return s_streamingSettings;
+}
+
+void SetStreamingSettings(const CPM_STREAMING_SETTINGS &settings)
+{
+	s_streamingSettings = settings;
+}
+
+
+//
+//	CPMTempFile
+//
+static int Seek(FILE *file, unsigned long long offset)
+{
+#ifdef _MSC_VER
+	return _fseeki64(file, (long long) offset, SEEK_SET);
+#else
+	return fseeko(file, (off_t) offset, SEEK_SET);
+#endif
+}
+
+CPMTempFile::CPMTempFile() : m_file(NULL), m_size(0), m_position(0), m_writing(false)
+{
+
+}
+
+CPMTempFile::~CPMTempFile()
+{
+	close();
+}
+
+bool CPMTempFile::open(const std::string &directory)
+{
+	close();
+
+	if(directory.empty())
+	{
+		m_file = tmpfile();
+		return m_file != NULL;
+	}
+
+	// nom unique dans le processus, le prfixe distingue les exportations simultanes de plusieurs processus
+	static std::atomic<unsigned int> counter(0);
+	std::ostringstream path;
+	path << directory;
+	if(directory[directory.size() - 1] != '/' && directory[directory.size() - 1] != '\\') path << '/';
+	path << "cpm_" << (const void*) this << "_" << counter++ << ".tmp";
+
+	m_path = path.str();
+	m_file = fopen(m_path.c_str(), "w+b");
+	if(!m_file) m_path.clear();
+	return m_file != NULL;
+}
+
+void CPMTempFile::close()
+{
+	if(m_file) fclose(m_file);
+	if(!m_path.empty()) remove(m_path.c_str());
+
+	m_file = NULL;
+	m_path.clear();
+	m_size = 0;
+	m_position = 0;
+	m_writing = false;
+}
+
+bool CPMTempFile::write(const void *data, size_t size)
+{
+	return writeAt(m_size, data, size);
+}
+
+bool CPMTempFile::writeAt(unsigned long long offset, const void *data, size_t size)
+{
+	if(!m_file) return false;
+	if((offset != m_position || !m_writing) && Seek(m_file, offset) != 0) return false;
+	m_writing = true;
+
+	const bool written = fwrite(data, 1, size, m_file) == size;
+	m_position = offset + size;
+	if(m_position > m_size) m_size = m_position;
+	return written;
+}
+
+bool CPMTempFile::read(unsigned long long offset, void *data, size_t size)
+{
+	if(!m_file) return false;
+	if((offset != m_position || m_writing) && Seek(m_file, offset) != 0) return false;
+	m_writing = false;
+
+	const bool read = fread(data, 1, size, m_file) == size;
+	m_position = offset + size;
+	return read;
+}
+
+
+//
+//	Sources de polygones
+//
+void POLYGON_BATCH::clear()
+{
+	points.clear();
+	normals.clear();
+	uvs.clear();
+	tgtBinormals.clear();
+	colors.clear();
+	triangles.clear();
+	triangleMaterials.clear();
+}
+
+CPMFaceVertexStream::CPMFaceVertexStream(const FACE_VERTEX_IDS &ids, const std::vector<unsigned int> &polygonSizes, const std::vector<int> *polygonMaterials) : m_ids(ids),
+	m_polygonSizes(polygonSizes), m_polygonMaterials(polygonMaterials), m_polygon(0), m_faceVertex(0)
+{
+
+}
+
+bool CPMFaceVertexStream::read(size_t maxFaceVertices, POLYGON_BATCH &batch)
+{
+	batch.clear();
+
+	while(m_polygon < m_polygonSizes.size() && (batch.points.empty() || batch.points.size() + m_polygonSizes[m_polygon] <= maxFaceVertices))
+	{
+		const unsigned int size = m_polygonSizes[m_polygon];
+		const unsigned int first = (unsigned int) batch.points.size();
+
+		for(unsigned int k = 0; k < size; k++)
+		{
+			const size_t f = m_faceVertex + k;
+			batch.points.push_back((int) m_ids.points[f]);
+			if(m_ids.normals)		batch.normals.push_back((int) m_ids.normals[f]);
+			if(m_ids.uvs)			batch.uvs.push_back((int) m_ids.uvs[f]);
+			if(m_ids.tgtBinormals)	batch.tgtBinormals.push_back((int) m_ids.tgtBinormals[f]);
+			if(m_ids.colors)		batch.colors.push_back((int) m_ids.colors[f]);
+		}
+
+		for(unsigned int k = 1; k + 1 < size; k++)
+		{
+			batch.triangles.push_back(first);
+			batch.triangles.push_back(first + k);
+			batch.triangles.push_back(first + k + 1);
+			if(m_polygonMaterials) batch.triangleMaterials.push_back((*m_polygonMaterials)[m_polygon]);
+		}
+
+		m_faceVertex += size;
+		m_polygon++;
+	}
+
+	return true;
+}
+
+
+//
+//	Sources des attributs et triangles des matriaux
+//
+bool CPMArrayVertexSource::read(const int *ids, size_t count, STREAMING_VERTICES &vertices)
+{
+	for(size_t v = 0; v < count; v++, ids += 5)
+	{
+		vertices.points->x[v] = m_arrays.points[4*ids[0]];
+		vertices.points->y[v] = m_arrays.points[4*ids[0] + 1];
+		vertices.points->z[v] = m_arrays.points[4*ids[0] + 2];
+		if(vertices.normals) {
+			vertices.normals->x[v] = m_arrays.normals[3*ids[1]];
+			vertices.normals->y[v] = m_arrays.normals[3*ids[1] + 1];
+			vertices.normals->z[v] = m_arrays.normals[3*ids[1] + 2];
+		}
+		if(vertices.UVs) {
+			vertices.UVs->u[v] = m_arrays.u[ids[2]];
+			vertices.UVs->v[v] = m_arrays.v[ids[2]];
+		}
+		if(vertices.tangents) {
+			vertices.tangents->x[v] = m_arrays.tangents[3*ids[3]];
+			vertices.tangents->y[v] = m_arrays.tangents[3*ids[3] + 1];
+			vertices.tangents->z[v] = m_arrays.tangents[3*ids[3] + 2];
+			vertices.binormals->x[v] = m_arrays.binormals[3*ids[3]];
+			vertices.binormals->y[v] = m_arrays.binormals[3*ids[3] + 1];
+			vertices.binormals->z[v] = m_arrays.binormals[3*ids[3] + 2];
+		}
+		if(vertices.colors) {
+			vertices.colors->r[v] = m_arrays.colors[4*ids[4]];
+			vertices.colors->g[v] = m_arrays.colors[4*ids[4] + 1];
+			vertices.colors->b[v] = m_arrays.colors[4*ids[4] + 2];
+			vertices.colors->a[v] = m_arrays.colors[4*ids[4] + 3];
+		}
+	}
+	return true;
+}
+
+CPMTempMaterialFaces::CPMTempMaterialFaces() : m_blockSize(CPM_STREAMING_MATERIAL_BLOCK)
+{
+
+}
+
+bool CPMTempMaterialFaces::open(const std::string &directory, size_t numMaterials, size_t memoryBudget)
+// Rsum: les blocs en cours de tous les matriaux prennent au plus un huitime du budget
+{
+	m_blockSize = std::min<size_t>(CPM_STREAMING_MATERIAL_BLOCK, std::max<size_t>(256, memoryBudget / 8 / sizeof(unsigned int) / (numMaterials ? numMaterials : 1)));
+	m_pending.assign(numMaterials, std::vector<unsigned int>());
+	m_blocks.assign(numMaterials, std::vector<unsigned long long>());
+	m_counts.assign(numMaterials, 0);
+	return m_file.open(directory);
+}
+
+bool CPMTempMaterialFaces::add(size_t material, unsigned int triangle)
+{
+	std::vector<unsigned int> &pending = m_pending[material];
+	pending.push_back(triangle);
+	m_counts[material]++;
+	if(pending.size() < m_blockSize) return true;
+
+	m_blocks[material].push_back(m_file.size());
+	const bool written = m_file.write(&pending[0], pending.size() * sizeof(unsigned int));
+	pending.clear();
+	return written;
+}
+
+bool CPMTempMaterialFaces::read(size_t material, unsigned int first, unsigned int count, unsigned int *faces)
+// Rsum: les blocs complets sont dans le fichier, dans l'ordre, suivis du bloc en cours
+{
+	const std::vector<unsigned long long> &blocks = m_blocks[material];
+	while(count)
+	{
+		const size_t b = first / m_blockSize, offset = first % m_blockSize;
+		const unsigned int n = (unsigned int) std::min<size_t>(count, m_blockSize - offset);
+
+		if(b < blocks.size())
+		{
+			if(!m_file.read(blocks[b] + offset * sizeof(unsigned int), faces, n * sizeof(unsigned int))) return false;
+		}
+		else
+		{
+			const std::vector<unsigned int> &pending = m_pending[material];
+			if(offset + n > pending.size()) return false;
+			memcpy(faces, &pending[offset], n * sizeof(unsigned int));
+		}
+
+		first += n;
+		faces += n;
+		count -= n;
+	}
+	return true;
+}
+
+
+//
+//	CPMStreamingMesh
+//
+template<typename KEY>
+struct STREAM_RECORD
+{
+	KEY				key;
+	unsigned int	corner; // sommet de triangle, dans l'ordre du mesh
+};
+
+struct CORNER_VERTEX
+{
+	unsigned int	corner; // sommet dans son intervalle
+	unsigned int	vertex;
+};
+
+CPMStreamingMesh::CPMStreamingMesh(unsigned int exportOptions, const CPM_STREAMING_SETTINGS &settings) : m_exportOptions(exportOptions), m_settings(settings),
+	m_conversion(GetExportAxisConversion(exportOptions)), m_keyTotalBits(0), m_numCorners(0), m_bucketCorners(0), m_chunkCount(0)
+{
+	if(m_settings.memoryBudget < CPM_STREAMING_MIN_BUDGET) m_settings.memoryBudget = CPM_STREAMING_MIN_BUDGET;
+}
+
+bool CPMStreamingMesh::fail(const std::string &error)
+{
+	m_error = error;
+	return false;
+}
+
+void CPMStreamingMesh::setKeyLayout(const STREAMING_SOURCE &source)
+// Rsum: largeur de chaque champ d'aprs le nombre d'lments des tableaux source, les attributs non assigns (-1) sont dcals de 1
+{
+	const unsigned int counts[5] = { source.numPoints, source.numNormals, source.numUVs, source.numTgtBinormals, source.numColors };
+	m_keyUsed[0] = true;
+	m_keyUsed[1] = (m_exportOptions & CPM_EXPORT_NORMALS) != 0;
+	m_keyUsed[2] = (m_exportOptions & CPM_EXPORT_UVS) != 0;
+	m_keyUsed[3] = (m_exportOptions & CPM_EXPORT_TGT_BINORMALS) != 0;
+	m_keyUsed[4] = (m_exportOptions & CPM_EXPORT_COLORS) != 0;
+
+	m_keyTotalBits = 0;
+	for(int k = 4; k >= 0; k--)
+	{
+		m_keyBits[k] = m_keyUsed[k] ? BitsFor(k == 0 ? (counts[k] ? counts[k] - 1 : 0) : counts[k]) : 0;
+		m_keyShift[k] = m_keyTotalBits;
+		m_keyTotalBits += m_keyBits[k];
+	}
+}
+
+bool CPMStreamingMesh::build(CPMPolygonStream &polygons, const STREAMING_SOURCE &source)
+{
+	CPM_PROFILE_SCOPE("CPMStreamingMesh::build");
+
+	m_source = source;
+	if(!m_source.vertices) return fail("streaming export: no vertex source");
+	setKeyLayout(source);
+	if(m_keyTotalBits > 128) return fail("streaming export: face-vertex ids do not fit in a 128-bit key");
+
+	if(!m_runs.open(m_settings.tempDirectory)) return fail("streaming export: cannot create a temporary file in '" + m_settings.tempDirectory + "'");
+	if(source.numMaterials && !m_materialFaces.open(m_settings.tempDirectory, source.numMaterials, m_settings.memoryBudget)) return fail("streaming export: cannot create a temporary file");
+
+	if(m_keyTotalBits <= 64)	return buildRuns<unsigned long long>(polygons) && mergeRuns<unsigned long long>();
+	else						return buildRuns<CPM_KEY128>(polygons) && mergeRuns<CPM_KEY128>();
+}
+
+template<typename KEY>
+bool CPMStreamingMesh::buildRuns(CPMPolygonStream &polygons)
+// Rsum: passe 1, une suite trie par lot de polygones
+{
+	CPM_PROFILE_SCOPE("CPMStreamingMesh::buildRuns");
+
+	// un sommet de triangle cote deux enregistrements (tri par base) et au plus les ids d'un face-vertex
+	const size_t maxCorners = m_settings.memoryBudget / (2 * sizeof(STREAM_RECORD<KEY>) + 6 * sizeof(int));
+	const size_t maxFaceVertices = maxCorners / 3;
+
+	POLYGON_BATCH batch;
+	std::vector< STREAM_RECORD<KEY> > records, buffer;
+	const std::vector<int> *ids[5] = { &batch.points, &batch.normals, &batch.uvs, &batch.tgtBinormals, &batch.colors };
+
+	m_runOffsets.assign(1, 0);
+	m_numCorners = 0;
+
+	for(;;)
+	{
+		if(!polygons.read(maxFaceVertices, batch)) return fail("streaming export: cannot read the polygons");
+		if(batch.points.empty()) break;
+
+		for(unsigned int k = 1; k < 5; k++)
+		{
+			if(m_keyUsed[k] && ids[k]->size() != batch.points.size()) return fail("streaming export: incomplete face-vertex attributes");
+		}
+
+		const size_t numCorners = batch.triangles.size();
+		if(m_numCorners + numCorners > 0xffffffffULL) return fail("streaming export: too many triangles for 32-bit indices");
+
+		// triangles des matriaux, numrots dans l'ordre du mesh
+		if(m_source.numMaterials)
+		{
+			if(batch.triangleMaterials.size() != numCorners / 3) return fail("streaming export: incomplete triangle materials");
+
+			const unsigned int firstTriangle = (unsigned int) (m_numCorners / 3);
+			for(size_t t = 0; t < batch.triangleMaterials.size(); t++)
+			{
+				const int material = batch.triangleMaterials[t];
+				if(material < 0 || material >= (int) m_source.numMaterials) continue;
+				if(!m_materialFaces.add(material, firstTriangle + (unsigned int) t)) return fail("streaming export: cannot write a temporary file");
+			}
+		}
+
+		records.resize(numCorners);
+		ParallelFor(numCorners, 1 << 14, [&](size_t begin, size_t end)
+		{
+			for(size_t c = begin; c < end; c++)
+			{
+				const unsigned int f = batch.triangles[c];
+
+				KEY key = KEY();
+				for(unsigned int k = 0; k < 5; k++)
+				{
+					if(m_keyUsed[k]) SetKeyBits(key, m_keyShift[k], (unsigned long long) (unsigned int) ((*ids[k])[f] + (k ? 1 : 0)));
+				}
+				records[c].key = key;
+				records[c].corner = (unsigned int) (m_numCorners + c);
+			}
+		});
+
+		RadixSort(records, m_keyTotalBits, buffer);
+
+		if(numCorners && !m_runs.write(&records[0], numCorners * sizeof(records[0]))) return fail("streaming export: cannot write a temporary file");
+		m_numCorners += numCorners;
+		m_runOffsets.push_back(m_numCorners);
+	}
+
+	m_stats.triangles = m_numCorners / 3;
+	m_stats.runs = (unsigned int) m_runOffsets.size() - 1;
+	m_stats.spilledBytes += m_runs.size() + m_materialFaces.size();
+	return true;
+}
+
+template<typename KEY>
+struct RUN_HEAD
+{
+	KEY				key;
+	unsigned int	corner;
+	unsigned int	run;
+
+	bool operator<(const RUN_HEAD &other) const // invers: std::priority_queue place le plus grand lment en tte
+	{
+		if(other.key < key) return true;
+		if(key < other.key) return false;
+		return corner > other.corner;
+	}
+};
+
+template<typename KEY>
+bool CPMStreamingMesh::mergeRuns()
+// Rsum: passe 2, fusion des suites; un vertex est cr  chaque nouvelle cl
+{
+	CPM_PROFILE_SCOPE("CPMStreamingMesh::mergeRuns");
+	typedef STREAM_RECORD<KEY> RECORD;
+
+	const unsigned int numRuns = (unsigned int) m_runOffsets.size() - 1;
+	if(!m_corners.open(m_settings.tempDirectory)) return fail("streaming export: cannot create a temporary file");
+
+	// intervalles de sommets: un intervalle doit tenir dans le budget  la passe 3 (paire lue et indice crit)
+	m_bucketCorners = m_settings.memoryBudget / (sizeof(CORNER_VERTEX) + sizeof(unsigned int)) / 3 * 3;
+	const unsigned int numBuckets = (unsigned int) ((m_numCorners + m_bucketCorners - 1) / m_bucketCorners);
+	m_stats.buckets = numBuckets;
+
+	// la moiti du budget pour la lecture des suites, un quart pour l'criture des intervalles
+	const size_t runBufferSize = std::max<size_t>(256, m_settings.memoryBudget / 2 / sizeof(RECORD) / (numRuns ? numRuns : 1));
+	const size_t bucketBufferSize = std::max<size_t>(1024, m_settings.memoryBudget / 4 / sizeof(CORNER_VERTEX) / (numBuckets ? numBuckets : 1));
+
+	std::vector< std::vector<RECORD> > runBuffers(numRuns);
+	std::vector<size_t> runPositions(numRuns, 0);
+	std::vector<unsigned long long> runNext(m_runOffsets.begin(), m_runOffsets.end() - 1);
+
+	std::vector< std::vector<CORNER_VERTEX> > bucketBuffers(numBuckets);
+	std::vector<unsigned long long> bucketWritten(numBuckets, 0);
+
+	// attributs exports des vertices
+	const bool normals = m_keyUsed[1] && m_source.numNormals, UVs = m_keyUsed[2] && m_source.numUVs, tangents = m_keyUsed[3] && m_source.numTgtBinormals;
+	const bool colors = m_keyUsed[4] && m_source.numColors;
+	if((normals && !m_normals.open(m_settings.tempDirectory)) || (UVs && !m_UVs.open(m_settings.tempDirectory)) || (colors && !m_colors.open(m_settings.tempDirectory)) ||
+	   (tangents && (!m_tangents.open(m_settings.tempDirectory) || !m_binormals.open(m_settings.tempDirectory))) || !m_points.open(m_settings.tempDirectory))
+	{
+		return fail("streaming export: cannot create a temporary file");
+	}
+	m_chunkIds.resize(5 * CPM_STREAMING_VERTEX_CHUNK);
+	m_chunkPoints.resize(CPM_STREAMING_VERTEX_CHUNK);
+	if(normals)		m_chunkNormals.resize(CPM_STREAMING_VERTEX_CHUNK);
+	if(UVs)			m_chunkUVs.resize(CPM_STREAMING_VERTEX_CHUNK);
+	if(colors)		m_chunkColors.resize(CPM_STREAMING_VERTEX_CHUNK);
+	if(tangents) {
+		m_chunkTangents.resize(CPM_STREAMING_VERTEX_CHUNK);
+		m_chunkBinormals.resize(CPM_STREAMING_VERTEX_CHUNK);
+	}
+	m_chunkCount = 0;
+
+	auto fillRun = [&](unsigned int r) -> bool
+	{
+		const size_t n = (size_t) std::min<unsigned long long>(runBufferSize, m_runOffsets[r + 1] - runNext[r]);
+		runBuffers[r].resize(n);
+		runPositions[r] = 0;
+		if(n && !m_runs.read(runNext[r] * sizeof(RECORD), &runBuffers[r][0], n * sizeof(RECORD))) return false;
+		runNext[r] += n;
+		return true;
+	};
+
+	auto flushBucket = [&](unsigned int b) -> bool
+	{
+		std::vector<CORNER_VERTEX> &buffer = bucketBuffers[b];
+		if(buffer.empty()) return true;
+
+		const unsigned long long offset = (b * m_bucketCorners + bucketWritten[b]) * sizeof(CORNER_VERTEX);
+		if(!m_corners.writeAt(offset, &buffer[0], buffer.size() * sizeof(CORNER_VERTEX))) return false;
+		bucketWritten[b] += buffer.size();
+		buffer.clear();
+		return true;
+	};
+
+	std::priority_queue< RUN_HEAD<KEY> > heads;
+	for(unsigned int r = 0; r < numRuns; r++)
+	{
+		if(!fillRun(r)) return fail("streaming export: cannot read a temporary file");
+		if(runBuffers[r].empty()) continue;
+
+		RUN_HEAD<KEY> head = { runBuffers[r][0].key, runBuffers[r][0].corner, r };
+		heads.push(head);
+	}
+
+	unsigned long long numVertices = 0;
+	KEY previous = KEY();
+	int ids[5];
+
+	while(!heads.empty())
+	{
+		const RUN_HEAD<KEY> head = heads.top();
+		heads.pop();
+
+		if(numVertices == 0 || head.key != previous)
+		{
+			if(numVertices == 0xffffffffULL) return fail("streaming export: too many vertices for 32-bit indices");
+
+			for(unsigned int k = 0; k < 5; k++) ids[k] = m_keyUsed[k] ? (int) GetKeyBits(head.key, m_keyShift[k], m_keyBits[k]) - (k ? 1 : 0) : 0;
+			addVertex(ids);
+			if(m_chunkCount == CPM_STREAMING_VERTEX_CHUNK && !flushVertices()) return false;
+
+			previous = head.key;
+			numVertices++;
+		}
+
+		const unsigned int b = (unsigned int) (head.corner / m_bucketCorners);
+		CORNER_VERTEX pair = { (unsigned int) (head.corner - b * m_bucketCorners), (unsigned int) (numVertices - 1) };
+		bucketBuffers[b].push_back(pair);
+		if(bucketBuffers[b].size() >= bucketBufferSize && !flushBucket(b)) return fail("streaming export: cannot write a temporary file");
+
+		// enregistrement suivant de la mme suite
+		const unsigned int r = head.run;
+		if(++runPositions[r] == runBuffers[r].size())
+		{
+			if(!fillRun(r)) return fail("streaming export: cannot read a temporary file");
+			if(runBuffers[r].empty()) continue;
+		}
+
+		RUN_HEAD<KEY> next = { runBuffers[r][runPositions[r]].key, runBuffers[r][runPositions[r]].corner, r };
+		heads.push(next);
+	}
+
+	for(unsigned int b = 0; b < numBuckets; b++)
+	{
+		if(!flushBucket(b)) return fail("streaming export: cannot write a temporary file");
+	}
+	if(!flushVertices()) return false;
+
+	// les suites ne servent plus
+	m_runs.close();
+
+	m_stats.vertices = numVertices;
+	m_stats.spilledBytes += m_corners.size() + m_points.size() + m_normals.size() + m_tangents.size() + m_binormals.size() + m_UVs.size() + m_colors.size();
+	return true;
+}
+
+void CPMStreamingMesh::addVertex(const int *ids)
+// Rsum: ajoute le vertex au bloc en attente, ids contient le point puis les indices des attributs; ses valeurs sont lues avec le bloc
+{
+	memcpy(&m_chunkIds[5 * m_chunkCount++], ids, 5 * sizeof(int));
+}
+
+template<typename T>
+static bool WriteInterleaved(CPMTempFile &file, const VECTOR3_ARRAY<T> &vectors, std::vector<T> &buffer)
+{
+	const size_t count = vectors.size();
+	buffer.resize(count * 3);
+	for(size_t i = 0; i < count; i++)
+	{
+		buffer[3*i] = vectors.x[i];
+		buffer[3*i + 1] = vectors.y[i];
+		buffer[3*i + 2] = vectors.z[i];
+	}
+	return !count || file.write(&buffer[0], buffer.size() * sizeof(T));
+}
+
+bool CPMStreamingMesh::flushVertices()
+// Rsum: lecture des attributs du bloc en attente, transformation dans l'espace monde et conversion des axes, comme CPMMeshExtractor et CPMPolyWriter
+{
+	if(!m_chunkCount) return true;
+
+	const bool normals = m_chunkNormals.size() != 0, UVs = m_chunkUVs.size() != 0, tangents = m_chunkTangents.size() != 0, colors = m_chunkColors.size() != 0;
+	m_chunkPoints.resize(m_chunkCount);
+	if(normals)		m_chunkNormals.resize(m_chunkCount);
+	if(UVs)			m_chunkUVs.resize(m_chunkCount);
+	if(colors)		m_chunkColors.resize(m_chunkCount);
+	if(tangents) {
+		m_chunkTangents.resize(m_chunkCount);
+		m_chunkBinormals.resize(m_chunkCount);
+	}
+
+	STREAMING_VERTICES vertices = { &m_chunkPoints, normals ? &m_chunkNormals : NULL, UVs ? &m_chunkUVs : NULL, tangents ? &m_chunkTangents : NULL, tangents ? &m_chunkBinormals : NULL, colors ? &m_chunkColors : NULL };
+	if(!m_source.vertices->read(&m_chunkIds[0], m_chunkCount, vertices)) return fail("streaming export: cannot read the vertex attributes");
+
+	if(m_source.transform) TransformMesh(*m_source.transform, &m_chunkPoints, normals ? &m_chunkNormals : NULL, tangents ? &m_chunkTangents : NULL, tangents ? &m_chunkBinormals : NULL);
+
+	ApplyAxisConversion(m_conversion, m_chunkPoints);
+	ApplyAxisConversion(m_conversion, m_chunkNormals);
+	ApplyAxisConversion(m_conversion, m_chunkTangents);
+	ApplyAxisConversion(m_conversion, m_chunkBinormals);
+	ApplyAxisConversion(m_conversion, m_chunkUVs);
+	m_bounds.add(ComputeBounds(m_chunkPoints));
+
+	std::vector<double> doubles;
+	std::vector<float> floats;
+	bool written = WriteInterleaved(m_points, m_chunkPoints, doubles);
+	if(normals)		written = written && WriteInterleaved(m_normals, m_chunkNormals, floats);
+	if(tangents)	written = written && WriteInterleaved(m_tangents, m_chunkTangents, floats) && WriteInterleaved(m_binormals, m_chunkBinormals, floats);
+	if(UVs)
+	{
+		floats.resize(m_chunkCount * 2);
+		for(size_t i = 0; i < m_chunkCount; i++)
+		{
+			floats[2*i] = m_chunkUVs.u[i];
+			floats[2*i + 1] = m_chunkUVs.v[i];
+		}
+		written = written && m_UVs.write(&floats[0], floats.size() * sizeof(float));
+	}
+	if(colors)
+	{
+		floats.resize(m_chunkCount * 4);
+		for(size_t i = 0; i < m_chunkCount; i++)
+		{
+			floats[4*i] = m_chunkColors.r[i];
+			floats[4*i + 1] = m_chunkColors.g[i];
+			floats[4*i + 2] = m_chunkColors.b[i];
+			floats[4*i + 3] = m_chunkColors.a[i];
+		}
+		written = written && m_colors.write(&floats[0], floats.size() * sizeof(float));
+	}
+
+	m_chunkCount = 0;
+	m_chunkPoints.resize(CPM_STREAMING_VERTEX_CHUNK);
+	if(normals)		m_chunkNormals.resize(CPM_STREAMING_VERTEX_CHUNK);
+	if(UVs)			m_chunkUVs.resize(CPM_STREAMING_VERTEX_CHUNK);
+	if(colors)		m_chunkColors.resize(CPM_STREAMING_VERTEX_CHUNK);
+	if(tangents) {
+		m_chunkTangents.resize(CPM_STREAMING_VERTEX_CHUNK);
+		m_chunkBinormals.resize(CPM_STREAMING_VERTEX_CHUNK);
+	}
+
+	if(!written) return fail("streaming export: cannot write a temporary file");
+	return true;
+}
+
+template<typename T, typename S>
+bool CPMStreamingMesh::copySectionAs(std::ostream &os, const char *name, const char *tag, CPMTempFile &file, unsigned int components)
+// Rsum: recopie une section depuis un fichier temporaire de valeurs S entrelaces, par blocs
+{
+	const size_t elementSize = components * sizeof(S);
+	const unsigned long long count = file.size() / elementSize;
+	const size_t block = (1 << 20) / elementSize;
+	std::vector<S> values(block * components);
+
+	CPMAttributeWriter<T> writer(os, m_exportOptions);
+	writer.begin(name, tag, (unsigned int) count, components);
+	for(unsigned long long first = 0; first < count; first += block)
+	{
+		const size_t n = (size_t) std::min<unsigned long long>(block, count - first);
+		if(!file.read(first * elementSize, &values[0], n * elementSize)) return fail("streaming export: cannot read a temporary file");
+		writer.writeInterleaved(&values[0], n);
+	}
+	writer.end();
+	return true;
+}
+
+template<typename SINK>
+bool CPMStreamingMesh::readTriangles(SINK sink)
+// Rsum: chaque intervalle de sommets est replac dans l'ordre des sommets, puis pass  sink(sommets, nombre de sommets)
+{
+	std::vector<CORNER_VERTEX> pairs;
+	std::vector<unsigned int> triangles;
+
+	for(unsigned long long first = 0; first < m_numCorners; first += m_bucketCorners)
+	{
+		const size_t n = (size_t) std::min<unsigned long long>(m_bucketCorners, m_numCorners - first);
+		pairs.resize(n);
+		triangles.resize(n);
+		if(!m_corners.read(first * sizeof(CORNER_VERTEX), &pairs[0], n * sizeof(CORNER_VERTEX))) return fail("streaming export: cannot read a temporary file");
+
+		for(size_t i = 0; i < n; i++) triangles[pairs[i].corner] = pairs[i].vertex;
+		ApplyAxisConversion(m_conversion, triangles);
+		sink(&triangles[0], n);
+	}
+	return true;
+}
+
+template<typename T>
+bool CPMStreamingMesh::writeTriangles(std::ostream &os)
+{
+	CPMAttributeWriter<T> writer(os, m_exportOptions);
+	writer.begin("Triangles", CPM_TAG_TRIANGLES, (unsigned int) (m_numCorners / 3), 3);
+	if(!readTriangles([&](const unsigned int *triangles, size_t n) { writer.writeInterleaved(triangles, n / 3); })) return false;
+	writer.end();
+	return true;
+}
+
+bool CPMStreamingMesh::writeEncodedTriangles(std::ostream &os, unsigned long long encodedSize)
+{
+	WriteAlignedSectionHeader(os, GetSectionAlignment(m_exportOptions, encodedSize), CPM_TAG_TRIANGLES, (unsigned int) (m_numCorners / 3),
+		CPM_SCALAR_UINT32, 3, encodedSize, CPM_SECTION_INDEX_CODEC);
+
+	CPMIndexEncoder encoder(&os);
+	if(!readTriangles([&](const unsigned int *triangles, size_t n) { encoder.encode(triangles, n); })) return false;
+	encoder.finish();
+	return true;
+}
+
+template<typename S>
+bool CPMStreamingMesh::copySection(std::ostream &os, CPM_SCALAR_TYPE precision, const char *name, const char *tag, CPMTempFile &file, unsigned int components)
+{
+	switch(precision)
+	{
+		case CPM_SCALAR_DOUBLE:		return copySectionAs<double, S>(os, name, tag, file, components);
+		case CPM_SCALAR_HALF:		return copySectionAs<HALF, S>(os, name, tag, file, components);
+		default:					return copySectionAs<float, S>(os, name, tag, file, components);
+	}
+}
+
+bool CPMStreamingMesh::writeInterleavedVertices(std::ostream &os)
+// Rsum: les fichiers temporaires des attributs sont lus ensemble, par blocs de vertices
+{
+	const CPM_VERTEX_LAYOUT layout = GetVertexLayout(m_exportOptions);
+	const unsigned long long numVertices = m_stats.vertices;
+	const size_t block = (1 << 20) / layout.stride;
+
+	// valeurs S entrelaces de chaque attribut, dans l'ordre de layout
+	struct ATTRIBUTE_FILE
+	{
+		CPMTempFile			*file;
+		unsigned int		components;
+		size_t				scalarSize;
+		std::vector<char>	values;
+	};
+	std::vector<ATTRIBUTE_FILE> files(layout.attributes.size());
+	std::vector<CPM_VERTEX_SOURCE> sources(layout.attributes.size());
+	for(size_t a = 0; a < layout.attributes.size(); a++)
+	{
+		const char *tag = layout.attributes[a].tag;
+		ATTRIBUTE_FILE &file = files[a];
+		file.components = layout.attributes[a].components;
+		file.scalarSize = sizeof(float);
+		sources[a].type = CPM_SCALAR_FLOAT;
+		sources[a].step = file.components;
+
+		if(memcmp(tag, CPM_TAG_VERTICES, 4) == 0) { file.file = &m_points; file.scalarSize = sizeof(double); sources[a].type = CPM_SCALAR_DOUBLE; }
+		else if(memcmp(tag, CPM_TAG_NORMALS, 4) == 0) file.file = &m_normals;
+		else if(memcmp(tag, CPM_TAG_TANGENTS, 4) == 0) file.file = &m_tangents;
+		else if(memcmp(tag, CPM_TAG_BINORMALS, 4) == 0) file.file = &m_binormals;
+		else if(memcmp(tag, CPM_TAG_UVS, 4) == 0) file.file = &m_UVs;
+		else file.file = &m_colors;
+
+		// un attribut absent du mesh reste  zro
+		if(file.file->size() != numVertices * file.components * file.scalarSize) file.file = NULL;
+		else file.values.resize(block * file.components * file.scalarSize);
+	}
+
+	const unsigned int alignment = GetSectionAlignment(m_exportOptions);
+	WriteVertexFormat(os, layout, alignment);
+	BeginVertexBuffer(os, layout, (unsigned int) numVertices, alignment);
+
+	std::vector<unsigned char> buffer(block * layout.stride);
+	for(unsigned long long first = 0; first < numVertices; first += block)
+	{
+		const size_t n = (size_t) std::min<unsigned long long>(block, numVertices - first);
+		for(size_t a = 0; a < files.size(); a++)
+		{
+			ATTRIBUTE_FILE &file = files[a];
+			if(!file.file) continue;
+
+			const size_t elementSize = file.components * file.scalarSize;
+			if(!file.file->read(first * elementSize, &file.values[0], n * elementSize)) return fail("streaming export: cannot read a temporary file");
+			for(unsigned int c = 0; c < file.components; c++) sources[a].components[c] = &file.values[c * file.scalarSize];
+		}
+
+		InterleaveVertices(layout, &sources[0], 0, n, &buffer[0]);
+		os.write((const char*) &buffer[0], n * layout.stride);
+	}
+	return true;
+}
+
+bool CPMStreamingMesh::write(std::ostream &os, const CPM_MESH_DATA &properties, CPMObjectTable *objects)
+// Rsum: passe 3, mmes sections, mme ordre et mmes colonnes que CPMMeshWriter::write
+{
+	CPM_PROFILE_SCOPE("CPMStreamingMesh::write");
+	const CPM_PRECISION precision = GetExportPrecision(m_exportOptions);
+
+	if(objects) objects->begin(os);
+
+	CPMMeshWriter writer(properties, m_exportOptions);
+	BeginColumn(objects, os, CPM_TAG_OBJECT);
+	writer.writeObjectProperties(os);
+	BeginColumn(objects, os, CPM_TAG_TRIANGLES);
+
+	// triangles: indices 16 bits si le mesh a au plus 65536 vertices, ou compresss (CPM_EXPORT_INDEX_CODEC) si la section est plus petite
+	{
+		CPM_PROFILE_SECTION("CPMStreamingMesh::writeTriangles", os);
+		const CPM_SCALAR_TYPE indexType = GetIndexType(m_stats.vertices, m_exportOptions);
+		const unsigned long long rawSize = m_numCorners * sizeof(unsigned int);
+		const unsigned long long plainSize = indexType == CPM_SCALAR_UINT16 ? m_numCorners * sizeof(unsigned short) : rawSize;
+
+		// indices compresss: une premire lecture des sommets calcule la taille de la section, crite avant les donnes
+		unsigned long long encodedSize = plainSize;
+		if((m_exportOptions & CPM_EXPORT_BINARY) && (m_exportOptions & CPM_EXPORT_INDEX_CODEC) && m_numCorners)
+		{
+			CPMIndexEncoder counter(NULL);
+			if(!readTriangles([&](const unsigned int *triangles, size_t n) { counter.encode(triangles, n); })) return false;
+			counter.finish();
+			encodedSize = counter.size();
+		}
+
+		if(encodedSize < plainSize)
+		{
+			if(!writeEncodedTriangles(os, encodedSize)) return false;
+			m_stats.savedIndexBytes = rawSize - encodedSize;
+		}
+		else if(indexType == CPM_SCALAR_UINT16)
+		{
+			if(!writeTriangles<unsigned short>(os)) return false;
+			m_stats.savedIndexBytes = rawSize - plainSize;
+		}
+		else if(!writeTriangles<unsigned int>(os)) return false;
+	}
+
+	if((m_exportOptions & CPM_EXPORT_BINARY) && (m_exportOptions & CPM_EXPORT_INTERLEAVED))
+	{
+		CPM_PROFILE_SECTION("CPMStreamingMesh::writeInterleavedVertices", os);
+		BeginColumn(objects, os, CPM_TAG_VERTEX_BUFFER);
+		if(!writeInterleavedVertices(os)) return false;
+	}
+	else
+	{
+		{
+			CPM_PROFILE_SECTION("CPMStreamingMesh::writeVertices", os);
+			BeginColumn(objects, os, CPM_TAG_VERTICES);
+			if(!copySection<double>(os, precision.positions, "Vertices", CPM_TAG_VERTICES, m_points, 3)) return false;
+		}
+		if(m_exportOptions & CPM_EXPORT_NORMALS)
+		{
+			CPM_PROFILE_SECTION("CPMStreamingMesh::writeNormals", os);
+			BeginColumn(objects, os, CPM_TAG_NORMALS);
+			if(!copySection<float>(os, precision.normals, "Normals", CPM_TAG_NORMALS, m_normals, 3)) return false;
+		}
+		if(m_exportOptions & CPM_EXPORT_TGT_BINORMALS)
+		{
+			CPM_PROFILE_SECTION("CPMStreamingMesh::writeTangents", os);
+			BeginColumn(objects, os, CPM_TAG_TANGENTS);
+			if(!copySection<float>(os, precision.tangents, "Tangents", CPM_TAG_TANGENTS, m_tangents, 3)) return false;
+			BeginColumn(objects, os, CPM_TAG_BINORMALS);
+			if(!copySection<float>(os, precision.binormals, "Bitangents", CPM_TAG_BINORMALS, m_binormals, 3)) return false;
+		}
+		if(m_exportOptions & CPM_EXPORT_UVS)
+		{
+			CPM_PROFILE_SECTION("CPMStreamingMesh::writeUVs", os);
+			BeginColumn(objects, os, CPM_TAG_UVS);
+			if(!copySection<float>(os, precision.uvs, "UVs", CPM_TAG_UVS, m_UVs, 2)) return false;
+		}
+		if(m_exportOptions & CPM_EXPORT_COLORS)
+		{
+			CPM_PROFILE_SECTION("CPMStreamingMesh::writeColors", os);
+			BeginColumn(objects, os, CPM_TAG_COLORS);
+			if(!copySection<float>(os, precision.colors, "Colors", CPM_TAG_COLORS, m_colors, 4)) return false;
+		}
+	}
+
+	BeginColumn(objects, os, CPM_TAG_MATERIALS);
+	if(m_source.numMaterials)
+	{
+		if(!writer.writeMaterialSets(os, m_materialFaces)) return fail("streaming export: cannot read a temporary file");
+	}
+	else writer.writeMaterialSets(os);
+
+	if(!os) return fail("streaming export: write error");
+	if(objects) objects->end(os, properties.name, m_bounds);
+	return true;
+}
@@ -0,0 +1,264 @@
+#ifndef CPM_STREAMING_EXPORT_H_INCLUDED
+#define CPM_STREAMING_EXPORT_H_INCLUDED
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "CPMMeshAssembler.h"
+#include "CPMTransformKernels.h"
+#include "CPMVertexKernels.h"
+#include "CPMScalar.h"
+#include "CPMObjectTable.h"
+#include "CPMMeshWriter.h"
+
+//
+//	Exportation hors mmoire des trs gros meshes (option CPM_EXPORT_STREAMING)
+//	les polygones sont lus par lots de taille borne, les donnes proportionnelles au nombre de triangles ou de vertices
+//	passent par des fichiers temporaires: la mmoire de travail dpend du budget et non de la taille du mesh
+//
+//	1. chaque lot produit une suite trie de (cl du face-vertex, sommet de triangle), crite dans un fichier temporaire
+//	2. la fusion des suites numrote les vertices dans l'ordre des cls (point puis attributs): les attributs des vertices
+//	   sont crits au fil de la fusion, les indices des sommets de triangles sont rpartis par intervalles dans un second fichier
+//	3. les sections du fichier CPM sont crites squentiellement  partir des fichiers temporaires
+//	les attributs des vertices sont lus dans la source par blocs au fil de la fusion, les triangles de chaque matriau
+//	sont crits dans un fichier temporaire ds la premire passe
+//
+struct CPM_STREAMING_SETTINGS
+{
+	CPM_STREAMING_SETTINGS() : memoryBudget(256 << 20) {}
+
+	size_t			memoryBudget;	// octets de mmoire de travail, 16 Mo au minimum
+	std::string		tempDirectory;	// vide = rpertoire temporaire du systme
+};
+
+// rglages utiliss par l'option CPM_EXPORT_STREAMING
+const CPM_STREAMING_SETTINGS &GetStreamingSettings();
+void SetStreamingSettings(const CPM_STREAMING_SETTINGS &settings);
+
+
+class CPMTempFile
+// Fichier temporaire binaire, supprim  la destruction
+{
+	public:
+	CPMTempFile();
+	~CPMTempFile();
+
+	bool open(const std::string &directory); // rpertoire vide = tmpfile()
+	void close();
+
+	bool write(const void *data, size_t size);
+	bool writeAt(unsigned long long offset, const void *data, size_t size);
+	bool read(unsigned long long offset, void *data, size_t size);
+
+	unsigned long long size() const { return m_size; }
+
+	protected:
+	FILE				*m_file;
+	std::string			m_path;
+	unsigned long long	m_size;
+	unsigned long long	m_position; // position du curseur du FILE, vite les dplacements inutiles
+	bool				m_writing; // un fseek est obligatoire entre une criture et une lecture
+};
+
+
+struct POLYGON_BATCH
+// Lot de polygones: indices des attributs de chaque face-vertex (vides si l'attribut n'est pas export)
+// et sommets des triangles, dcrits par l'indice de leur face-vertex dans le lot
+{
+	void clear();
+
+	std::vector<int>			points;
+	std::vector<int>			normals;
+	std::vector<int>			uvs;
+	std::vector<int>			tgtBinormals;
+	std::vector<int>			colors;
+
+	std::vector<unsigned int>	triangles;
+	std::vector<int>			triangleMaterials; // matriau de chaque triangle, -1 sans matriau (vide si les matriaux ne sont pas exports)
+};
+
+class CPMPolygonStream
+// Source des polygones d'un mesh, lus dans l'ordre par lots successifs
+{
+	public:
+	virtual ~CPMPolygonStream() {}
+
+	// lit les polygones suivants, jusqu' maxFaceVertices face-vertices (au moins un polygone)
+	// retourne false en cas d'erreur, un lot vide signale la fin du mesh
+	virtual bool read(size_t maxFaceVertices, POLYGON_BATCH &batch) = 0;
+};
+
+class CPMFaceVertexStream : public CPMPolygonStream
+// Polygones dcrits par des tableaux de face-vertices dj en mmoire, trianguls en ventail comme ObjMeshBuilder
+// polygonMaterials, s'il est fourni, donne le matriau de chaque polygone
+{
+	public:
+	CPMFaceVertexStream(const FACE_VERTEX_IDS &ids, const std::vector<unsigned int> &polygonSizes, const std::vector<int> *polygonMaterials = NULL);
+
+	virtual bool read(size_t maxFaceVertices, POLYGON_BATCH &batch);
+
+	protected:
+	FACE_VERTEX_IDS						m_ids;
+	const std::vector<unsigned int>		&m_polygonSizes;
+	const std::vector<int>				*m_polygonMaterials;
+	size_t								m_polygon;
+	size_t								m_faceVertex;
+};
+
+
+struct STREAMING_VERTICES
+// Bloc de vertices rempli par CPMVertexSource, les tableaux des attributs non exports sont NULL
+{
+	VECTOR3_ARRAY<double>	*points;
+	VECTOR3_ARRAY<float>	*normals;
+	UV_ARRAY				*UVs;
+	VECTOR3_ARRAY<float>	*tangents;
+	VECTOR3_ARRAY<float>	*binormals;
+	COLOR_ARRAY				*colors;
+};
+
+class CPMVertexSource
+// Attributs des vertices, lus par blocs pendant la fusion: seuls les vertices du bloc en cours sont en mmoire
+{
+	public:
+	virtual ~CPMVertexSource() {}
+
+	// ids contient 5 indices par vertex (point, normale, uv, tangente et couleur), comme les cls des face-vertices
+	virtual bool read(const int *ids, size_t count, STREAMING_VERTICES &vertices) = 0;
+};
+
+class CPMArrayVertexSource : public CPMVertexSource
+// Attributs dj en mmoire, dcrits par ASSEMBLY_SOURCE
+{
+	public:
+	CPMArrayVertexSource(const ASSEMBLY_SOURCE &arrays) : m_arrays(arrays) {}
+
+	virtual bool read(const int *ids, size_t count, STREAMING_VERTICES &vertices);
+
+	protected:
+	ASSEMBLY_SOURCE			m_arrays;
+};
+
+struct STREAMING_SOURCE
+// Source des attributs et nombre d'lments de chaque tableau (les cls sont dimensionnes d'aprs ces nombres, un attribut sans lment n'est pas crit)
+{
+	STREAMING_SOURCE() : vertices(NULL), numPoints(0), numNormals(0), numUVs(0), numTgtBinormals(0), numColors(0), numMaterials(0), transform(NULL) {}
+
+	CPMVertexSource			*vertices;
+	unsigned int			numPoints;
+	unsigned int			numNormals;
+	unsigned int			numUVs;
+	unsigned int			numTgtBinormals;
+	unsigned int			numColors;
+	unsigned int			numMaterials; // matriaux dsigns par POLYGON_BATCH::triangleMaterials, 0: les faceIds des matriaux sont fournis  write
+
+	const MESH_TRANSFORM	*transform;	// transformation vers l'espace monde, NULL dans l'espace objet
+};
+
+class CPMTempMaterialFaces : public CPMMaterialFaces
+// Triangles de chaque matriau, crits dans un fichier temporaire par blocs de taille fixe; seul le bloc en cours de chaque matriau est en mmoire
+{
+	public:
+	CPMTempMaterialFaces();
+
+	bool open(const std::string &directory, size_t numMaterials, size_t memoryBudget);
+	bool add(size_t material, unsigned int triangle);
+
+	virtual unsigned int count(size_t material) const { return m_counts[material]; }
+	virtual bool read(size_t material, unsigned int first, unsigned int count, unsigned int *faces);
+
+	unsigned long long size() const { return m_file.size(); }
+
+	protected:
+	CPMTempFile										m_file;
+	size_t											m_blockSize;
+	std::vector< std::vector<unsigned int> >		m_pending;	// bloc en cours de chaque matriau
+	std::vector< std::vector<unsigned long long> >	m_blocks;	// offsets des blocs complets de chaque matriau
+	std::vector<unsigned int>						m_counts;
+};
+
+struct CPM_STREAMING_STATS
+{
+	CPM_STREAMING_STATS() : triangles(0), vertices(0), runs(0), buckets(0), spilledBytes(0), savedIndexBytes(0) {}
+
+	unsigned long long	triangles;
+	unsigned long long	vertices;
+	unsigned int		runs;			// suites tries crites par la premire passe
+	unsigned int		buckets;		// intervalles de sommets de triangles
+	unsigned long long	spilledBytes;	// octets crits dans les fichiers temporaires
+	unsigned long long	savedIndexBytes; // indices crits sur 16 bits ou compresss au lieu de 32 bits
+};
+
+class CPMStreamingMesh
+{
+	public:
+	CPMStreamingMesh(unsigned int exportOptions, const CPM_STREAMING_SETTINGS &settings = GetStreamingSettings());
+
+	// passes 1 et 2: assemblage des vertices et rpartition des triangles dans les fichiers temporaires
+	bool build(CPMPolygonStream &polygons, const STREAMING_SOURCE &source);
+
+	// passe 3: crit le mesh, properties fournit le nom, la transformation et les matriaux (ses tableaux de vertices sont ignors)
+	// objects, s'il est fourni, reoit l'objet et ses colonnes comme avec CPMMeshWriter::write
+	bool write(std::ostream &os, const CPM_MESH_DATA &properties, CPMObjectTable *objects = NULL);
+
+	const CPM_STREAMING_SETTINGS &getSettings() const { return m_settings; }
+	const CPM_STREAMING_STATS &getStats() const { return m_stats; }
+	const CPM_BOUNDS &getBounds() const { return m_bounds; } // vertices crits par build, axes convertis
+	const std::string &getError() const { return m_error; }
+
+	protected:
+	template<typename KEY> bool buildRuns(CPMPolygonStream &polygons);
+	template<typename KEY> bool mergeRuns();
+
+	void setKeyLayout(const STREAMING_SOURCE &source);
+	void addVertex(const int *ids);
+	bool flushVertices();
+	bool fail(const std::string &error);
+
+	template<typename SINK> bool readTriangles(SINK sink);
+	template<typename T> bool writeTriangles(std::ostream &os);
+	bool writeEncodedTriangles(std::ostream &os, unsigned long long encodedSize);
+	bool writeInterleavedVertices(std::ostream &os);
+	template<typename T, typename S> bool copySectionAs(std::ostream &os, const char *name, const char *tag, CPMTempFile &file, unsigned int components);
+	template<typename S> bool copySection(std::ostream &os, CPM_SCALAR_TYPE precision, const char *name, const char *tag, CPMTempFile &file, unsigned int components);
+
+	protected:
+	unsigned int				m_exportOptions;
+	CPM_STREAMING_SETTINGS		m_settings;
+	AXIS_CONVERSION				m_conversion;
+	STREAMING_SOURCE			m_source;
+
+	// cl des face-vertices: point, normale, uv, tangente et couleur, le point occupant les bits de poids fort
+	unsigned int				m_keyShift[5];
+	unsigned int				m_keyBits[5];
+	bool						m_keyUsed[5];
+	unsigned int				m_keyTotalBits;
+
+	// passe 1
+	CPMTempFile					m_runs;
+	std::vector<unsigned long long>	m_runOffsets; // premier enregistrement de chaque suite, plus la fin
+	unsigned long long			m_numCorners;
+	CPMTempMaterialFaces		m_materialFaces;
+
+	// passe 2
+	CPMTempFile					m_corners; // (sommet dans l'intervalle, vertex) par intervalle de sommets
+	unsigned long long			m_bucketCorners;
+	CPMTempFile					m_points, m_normals, m_tangents, m_binormals, m_UVs, m_colors;
+
+	std::vector<int>			m_chunkIds; // ids des vertices en attente de lecture dans la source, 5 par vertex
+	VECTOR3_ARRAY<double>		m_chunkPoints; // vertices en attente de transformation et d'criture
+	VECTOR3_ARRAY<float>		m_chunkNormals;
+	VECTOR3_ARRAY<float>		m_chunkTangents;
+	VECTOR3_ARRAY<float>		m_chunkBinormals;
+	UV_ARRAY					m_chunkUVs;
+	COLOR_ARRAY					m_chunkColors;
+	size_t						m_chunkCount;
+
+	CPM_STREAMING_STATS			m_stats;
+	CPM_BOUNDS					m_bounds;
+	std::string					m_error;
+};
+
+#endif // CPM_STREAMING_EXPORT_H_INCLUDED
@@ -0,0 +1,82 @@
+#include <cstring>
+
+#include "CPMStringPool.h"
+
+static unsigned int HashString(const char *str, size_t length)
+// Rsum: FNV-1a 32 bits
+{
+	unsigned int hash = 2166136261u;
+	for(size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char) str[i]) * 16777619u;
+	return hash;
+}
+
+CPMStringPool::CPMStringPool() : m_count(0)
+{
+	clear();
+}
+
+void CPMStringPool::clear()
+{
+	m_data.assign(1, '\0');
+	m_slots.assign(64, 0);
+	m_count = 0;
+}
+
+unsigned int CPMStringPool::intern(const char *str)
+{
+	return intern(str, strlen(str));
+}
+
+unsigned int CPMStringPool::intern(const char *str, size_t length)
+{
+	if(length == 0) return 0;
+
+	const size_t mask = m_slots.size() - 1;
+	size_t slot = HashString(str, length) & mask;
+	for(; m_slots[slot]; slot = (slot + 1) & mask)
+	{
+		// strncmp s'arrte au zro de la chane du pool: si elle est plus courte, elle diffre de str
+		const unsigned int offset = m_slots[slot];
+		if(strncmp(&m_data[offset], str, length) == 0 && m_data[offset + length] == '\0') return offset;
+	}
+
+	const unsigned int offset = (unsigned int) m_data.size();
+	m_data.insert(m_data.end(), str, str + length);
+	m_data.push_back('\0');
+
+	m_slots[slot] = offset;
+	m_count++;
+	if(2 * m_count > m_slots.size()) grow(); // taux de remplissage de 50% au plus
+
+	return offset;
+}
+
+unsigned int CPMStringPool::fileName(unsigned int offset) const
+{
+	const char *path = get(offset);
+	unsigned int name = offset;
+	for(const char *c = path; *c; c++)
+	{
+		if(*c == '/' || *c == '\\' || *c == '|') name = offset + (unsigned int) (c - path) + 1;
+	}
+	return name;
+}
+
+void CPMStringPool::grow()
+{
+	std::vector<unsigned int> slots(2 * m_slots.size(), 0);
+	const size_t mask = slots.size() - 1;
+
+	for(size_t i = 0; i < m_slots.size(); i++)
+	{
+		const unsigned int offset = m_slots[i];
+		if(!offset) continue;
+
+		const char *str = &m_data[offset];
+		size_t slot = HashString(str, strlen(str)) & mask;
+		while(slots[slot]) slot = (slot + 1) & mask;
+		slots[slot] = offset;
+	}
+
+	m_slots.swap(slots);
+}
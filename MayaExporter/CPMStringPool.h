@@ -0,0 +1,39 @@
+#ifndef CPM_STRING_POOL_H_INCLUDED
+#define CPM_STRING_POOL_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+//
+//	Chanes d'une session d'exportation (noms des textures des matriaux)
+//	chaque chane distincte est stocke une seule fois,  la suite des prcdentes et termine par un zro:
+//	une chane est dsigne par son offset dans le pool, qui ne change plus, 0 = chane vide
+//	le pool entier est crit une fois, dans la section CPM_TAG_STRINGS en fin de fichier
+//	pas de protection contre les accs concurrents: un pool par fichier crit
+//
+class CPMStringPool
+{
+	public:
+	CPMStringPool();
+
+	void clear(); // ne garde que la chane vide,  appeler au dbut de chaque fichier
+
+	unsigned int intern(const char *str); // offset de la chane, ajoute si elle est absente du pool
+	unsigned int intern(const char *str, size_t length);
+
+	const char *get(unsigned int offset) const { return &m_data[offset]; }
+	unsigned int fileName(unsigned int offset) const; // offset du nom de fichier qui termine le chemin, sans allocation
+
+	unsigned int count() const { return m_count; } // chanes non vides
+	const std::vector<char> &data() const { return m_data; }
+
+	protected:
+	void grow();
+
+	protected:
+	std::vector<char>			m_data;
+	std::vector<unsigned int>	m_slots; // table de hachage ouverte: offset des chanes, 0 = case libre
+	unsigned int				m_count;
+};
+
+#endif // CPM_STRING_POOL_H_INCLUDED
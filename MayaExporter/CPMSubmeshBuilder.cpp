@@ -0,0 +1,108 @@
+#include "CPMSubmeshBuilder.h"
+#include "CPMMeshWriter.h"
+#include "CPMProfiler.h"
+
+template<typename ARRAY>
+static void Gather(ARRAY &values, const std::vector<unsigned int> &sources, size_t numVertices)
+// Rsum: values[i] = ancien values[sources[i]], les attributs non exports (tableaux vides) sont ignors
+{
+	if(values.size() != numVertices) return;
+
+	ARRAY gathered;
+	gathered.gather(values, sources);
+	values.swap(gathered);
+}
+
+CPM_SUBMESH_STATS BuildSubmeshes(CPM_MESH_DATA &mesh)
+{
+	CPM_PROFILE_SCOPE("BuildSubmeshes");
+	CPM_SUBMESH_STATS stats;
+
+	const unsigned int numTriangles = (unsigned int) mesh.triangles.size() / 3;
+	const unsigned int numVertices = (unsigned int) mesh.points.size();
+	const unsigned int numMaterials = (unsigned int) mesh.materials.size();
+	stats.inputVertices = numVertices;
+
+	// ordre des triangles: ceux de chaque matriau, puis ceux d'aucun matriau
+	// un seul matriau concerne le mesh entier, quelle que soit sa liste de triangles
+	std::vector<unsigned char> assigned(numTriangles, 0);
+	std::vector<unsigned int> order;
+	std::vector<unsigned int> materialEnds(numMaterials);
+	order.reserve(numTriangles);
+	for(unsigned int m = 0; m < numMaterials; m++)
+	{
+		const std::vector<unsigned int> &faceIds = mesh.materials[m].faceIds;
+		if(numMaterials == 1)
+		{
+			for(unsigned int t = 0; t < numTriangles; t++) order.push_back(t);
+			assigned.assign(numTriangles, 1);
+		}
+		else
+		{
+			for(size_t i = 0; i < faceIds.size(); i++)
+			{
+				const unsigned int t = faceIds[i];
+				if(t < numTriangles && !assigned[t])
+				{
+					assigned[t] = 1;
+					order.push_back(t);
+				}
+			}
+		}
+		materialEnds[m] = (unsigned int) order.size();
+	}
+	for(unsigned int t = 0; t < numTriangles; t++) if(!assigned[t]) order.push_back(t);
+	stats.unassignedTriangles = numTriangles - (numMaterials ? materialEnds[numMaterials - 1] : 0);
+
+	// numrotation des vertices par sous-mesh: un vertex dj numrot par un sous-mesh prcdent est dupliqu
+	std::vector<unsigned int> owner(numVertices, ~0u), newIds(numVertices), sources;
+	std::vector<unsigned int> triangles(mesh.triangles.size());
+	sources.reserve(numVertices);
+
+	// le dernier groupe, sans matriau, est trait comme un sous-mesh de plus
+	unsigned int begin = 0;
+	for(unsigned int submesh = 0; submesh <= numMaterials; submesh++)
+	{
+		const unsigned int end = submesh < numMaterials ? materialEnds[submesh] : numTriangles;
+		const unsigned int firstVertex = (unsigned int) sources.size();
+
+		for(unsigned int i = begin; i < end; i++)
+		{
+			const unsigned int *triangle = &mesh.triangles[3 * order[i]];
+			for(unsigned int k = 0; k < 3; k++)
+			{
+				const unsigned int v = triangle[k];
+				if(owner[v] != submesh)
+				{
+					owner[v] = submesh;
+					newIds[v] = (unsigned int) sources.size();
+					sources.push_back(v);
+				}
+				triangles[3*i + k] = newIds[v];
+			}
+		}
+
+		if(submesh < numMaterials)
+		{
+			CPM_SUBMESH &range = mesh.materials[submesh].submesh;
+			range.firstIndex = 3 * begin;
+			range.indexCount = 3 * (end - begin);
+			range.firstVertex = firstVertex;
+			range.vertexCount = (unsigned int) sources.size() - firstVertex;
+		}
+		begin = end;
+	}
+
+	mesh.triangles.swap(triangles);
+	Gather(mesh.points, sources, numVertices);
+	Gather(mesh.normals, sources, numVertices);
+	Gather(mesh.tangents, sources, numVertices);
+	Gather(mesh.binormals, sources, numVertices);
+	Gather(mesh.UVs, sources, numVertices);
+	Gather(mesh.colors, sources, numVertices);
+
+	for(unsigned int m = 0; m < numMaterials; m++) std::vector<unsigned int>().swap(mesh.materials[m].faceIds);
+
+	stats.outputVertices = (unsigned int) sources.size();
+	return stats;
+}
@@ -0,0 +1,25 @@
+#ifndef CPM_SUBMESH_BUILDER_H_INCLUDED
+#define CPM_SUBMESH_BUILDER_H_INCLUDED
+
+struct CPM_MESH_DATA;
+
+//
+//	Sous-meshes par matriau (option CPM_EXPORT_SUBMESHES)
+//	les triangles de chaque matriau sont rendus contigus: un matriau est crit comme un intervalle d'indices au lieu d'une liste de triangles
+//	les vertices sont renumrots sous-mesh par sous-mesh, dans l'ordre de leur premire utilisation: chaque sous-mesh utilise
+//	un intervalle de vertices contigu, les vertices partags par plusieurs sous-meshes sont dupliqus
+//
+struct CPM_SUBMESH_STATS
+{
+	CPM_SUBMESH_STATS() : inputVertices(0), outputVertices(0), unassignedTriangles(0) {}
+
+	unsigned int	inputVertices;
+	unsigned int	outputVertices;			// vertices dupliqus compris
+	unsigned int	unassignedTriangles;	// triangles d'aucun matriau, placs aprs le dernier sous-mesh
+};
+
+// rordonne les triangles et les vertices du mesh, remplit CPM_MATERIAL::submesh et vide les listes faceIds
+// l'ordre des triangles d'un matriau et leur sens sont conservs
+CPM_SUBMESH_STATS BuildSubmeshes(CPM_MESH_DATA &mesh);
+
+#endif // CPM_SUBMESH_BUILDER_H_INCLUDED
@@ -0,0 +1,604 @@
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "CPMTangentSpace.h"
+#include "CPMMeshWriter.h"
+#include "CPMParallel.h"
+#include "CPMProfiler.h"
+
+#define NO_INDEX			0xFFFFFFFF
+
+#define MARK_DEGENERATE		0x1		// deux coins au mme sommet
+#define GROUP_WITH_ANY		0x2		// drives nulles (UVs sans aire): le triangle rejoint le groupe de ses voisins
+#define ORIENT_PRESERVING	0x4		// aire UV positive
+
+#define TANGENT_ANGULAR_THRESHOLD	180.0f	// degrs, valeur par dfaut de la rfrence: tous les triangles d'un groupe sont moyenns ensemble
+
+//
+//	Vecteurs en float: la rfrence travaille en simple prcision, les mmes oprations donnent les mmes tangentes
+//
+struct VEC3
+{
+	float	x, y, z;
+};
+
+static inline VEC3 Vec3(float x, float y, float z) { VEC3 v = { x, y, z }; return v; }
+static inline VEC3 Add(const VEC3 &a, const VEC3 &b) { return Vec3(a.x + b.x, a.y + b.y, a.z + b.z); }
+static inline VEC3 Sub(const VEC3 &a, const VEC3 &b) { return Vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+static inline VEC3 Scale(float s, const VEC3 &v) { return Vec3(s * v.x, s * v.y, s * v.z); }
+static inline float Dot(const VEC3 &a, const VEC3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static inline float Length(const VEC3 &v) { return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z); }
+static inline VEC3 Normalize(const VEC3 &v) { return Scale(1 / Length(v), v); }
+static inline bool NotZero(float f) { return fabsf(f) > FLT_MIN; }
+static inline bool NotZero(const VEC3 &v) { return NotZero(v.x) || NotZero(v.y) || NotZero(v.z); }
+
+static inline VEC3 Project(const VEC3 &v, const VEC3 &n)
+// Rsum: composante de v dans le plan de normale n, normalise si elle n'est pas nulle
+{
+	VEC3 p = Sub(v, Scale(Dot(n, v), n));
+	if(NotZero(p)) p = Normalize(p);
+	return p;
+}
+
+struct TANGENT_INPUT
+{
+	VEC3 position(unsigned int v) const { return Vec3((float) points->x[v], (float) points->y[v], (float) points->z[v]); }
+	VEC3 normal(unsigned int v) const { return Vec3(normals->x[v], normals->y[v], normals->z[v]); }
+
+	const std::vector<unsigned int>	*triangles;
+	const VECTOR3_ARRAY<double>		*points;
+	const VECTOR3_ARRAY<float>		*normals;
+	const UV_ARRAY					*UVs;
+	std::vector<unsigned int>		ids;		// sommet de chaque coin: premier vertex de mme position, normale et UV
+};
+
+struct TANGENT_TRIANGLE
+{
+	VEC3			os;			// drives de la position selon u et v, normalises et orientes
+	VEC3			ot;
+	float			magS;
+	float			magT;
+	unsigned int	flags;
+};
+
+struct TANGENT_GROUP
+{
+	unsigned int	vertex;
+	bool			orientPreserving;
+	unsigned int	firstFace;	// triangles [firstFace, firstFace + faceCount) de la liste des groupes
+	unsigned int	faceCount;
+};
+
+struct TANGENT_SPACE
+{
+	VEC3	os;
+	VEC3	ot;
+	float	magS;
+	float	magT;
+};
+
+static inline unsigned int NextCorner(unsigned int i) { return i < 2 ? i + 1 : 0; }
+static inline unsigned int PreviousCorner(unsigned int i) { return i > 0 ? i - 1 : 2; }
+
+static inline unsigned int CornerOf(const unsigned int *ids, unsigned int t, unsigned int vertex)
+{
+	return ids[3 * t] == vertex ? 0 : (ids[3 * t + 1] == vertex ? 1 : 2);
+}
+
+
+//
+//	Sommets: les vertices assembls sont aussi distincts par leurs couleurs ou leurs indices Maya, la rfrence ne compare que
+//	la position, la normale et l'UV (en float, -0 et +0 sont gaux)
+//
+static inline unsigned int FloatBits(float value)
+{
+	if(value == 0.0f) value = 0.0f;
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static inline unsigned long long Mix(unsigned long long h)
+{
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static void BuildVertexIds(TANGENT_INPUT &input)
+{
+	const unsigned int numVertices = (unsigned int) input.points->size();
+
+	std::vector<unsigned int> vertexIds(numVertices);
+	size_t tableSize = 16;
+	while(tableSize < 2 * (size_t) numVertices) tableSize <<= 1;
+	std::vector<unsigned int> table(tableSize, 0); // vertex + 1, 0 = case libre
+
+	for(unsigned int v = 0; v < numVertices; v++)
+	{
+		const VEC3 p = input.position(v), n = input.normal(v);
+		const float key[8] = { p.x, p.y, p.z, n.x, n.y, n.z, input.UVs->u[v], input.UVs->v[v] };
+
+		unsigned long long h = 0;
+		for(unsigned int k = 0; k < 8; k++) h = Mix(h ^ FloatBits(key[k]));
+
+		for(size_t slot = (size_t) h & (tableSize - 1); ; slot = (slot + 1) & (tableSize - 1))
+		{
+			if(!table[slot])
+			{
+				table[slot] = v + 1;
+				vertexIds[v] = v;
+				break;
+			}
+
+			const unsigned int w = table[slot] - 1;
+			const VEC3 q = input.position(w), m = input.normal(w);
+			if(q.x == p.x && q.y == p.y && q.z == p.z && m.x == n.x && m.y == n.y && m.z == n.z && input.UVs->u[w] == key[6] && input.UVs->v[w] == key[7])
+			{
+				vertexIds[v] = w;
+				break;
+			}
+		}
+	}
+
+	const std::vector<unsigned int> &triangles = *input.triangles;
+	input.ids.resize(triangles.size());
+	ParallelFor(triangles.size(), 3 * CPM_TANGENT_PARALLEL_MIN_TRIANGLES, [&](size_t begin, size_t end)
+	{
+		for(size_t c = begin; c < end; c++) input.ids[c] = vertexIds[triangles[c]];
+	});
+}
+
+
+//
+//	Drives premires de chaque triangle
+//
+static void InitTriangle(const TANGENT_INPUT &input, unsigned int t, TANGENT_TRIANGLE &triangle)
+{
+	const unsigned int *ids = &input.ids[3 * t];
+	triangle.os = triangle.ot = Vec3(0.0f, 0.0f, 0.0f);
+	triangle.magS = triangle.magT = 0.0f;
+	triangle.flags = GROUP_WITH_ANY;
+	if(ids[0] == ids[1] || ids[1] == ids[2] || ids[2] == ids[0])
+	{
+		triangle.flags |= MARK_DEGENERATE;
+		return;
+	}
+
+	const unsigned int *corners = &(*input.triangles)[3 * t];
+	const VEC3 v1 = input.position(corners[0]), v2 = input.position(corners[1]), v3 = input.position(corners[2]);
+	const UV_ARRAY &uv = *input.UVs;
+	const float t21x = uv.u[corners[1]] - uv.u[corners[0]], t21y = uv.v[corners[1]] - uv.v[corners[0]];
+	const float t31x = uv.u[corners[2]] - uv.u[corners[0]], t31y = uv.v[corners[2]] - uv.v[corners[0]];
+	const VEC3 d1 = Sub(v2, v1), d2 = Sub(v3, v1);
+
+	const float signedAreaSTx2 = t21x * t31y - t21y * t31x;
+	VEC3 os = Sub(Scale(t31y, d1), Scale(t21y, d2));
+	VEC3 ot = Add(Scale(-t31x, d1), Scale(t21x, d2));
+	if(signedAreaSTx2 > 0) triangle.flags |= ORIENT_PRESERVING;
+
+	if(NotZero(signedAreaSTx2))
+	{
+		const float absArea = fabsf(signedAreaSTx2);
+		const float lenOs = Length(os), lenOt = Length(ot);
+		const float sign = (triangle.flags & ORIENT_PRESERVING) ? 1.0f : -1.0f;
+		if(NotZero(lenOs)) os = Scale(sign / lenOs, os);
+		if(NotZero(lenOt)) ot = Scale(sign / lenOt, ot);
+
+		triangle.magS = lenOs / absArea;
+		triangle.magT = lenOt / absArea;
+		if(NotZero(triangle.magS) && NotZero(triangle.magT)) triangle.flags &= ~GROUP_WITH_ANY;
+	}
+
+	triangle.os = os;
+	triangle.ot = ot;
+}
+
+
+//
+//	Voisins: triangle qui partage l'arte (coin i, coin suivant) en sens oppos, entre triangles non dgnrs
+//	une arte partage par plus de deux triangles est apparie comme dans la rfrence: dans l'ordre des triangles,
+//	chaque arte libre prend la premire arte oppose encore libre d'un triangle suivant
+//
+#define NEIGHBOR_UNRESOLVED		-2
+
+static void BuildNeighbors(const TANGENT_INPUT &input, const std::vector<TANGENT_TRIANGLE> &triangles, std::vector<int> &neighbors,
+	std::vector<unsigned int> &vertexTriangles, std::vector<unsigned int> &vertexOffsets)
+{
+	const unsigned int *ids = input.ids.empty() ? NULL : &input.ids[0];
+	const size_t numTriangles = triangles.size();
+	const size_t numVertices = input.points->size();
+
+	// triangles de chaque sommet, dans l'ordre croissant
+	vertexOffsets.assign(numVertices + 1, 0);
+	for(size_t t = 0; t < numTriangles; t++)
+	{
+		if(triangles[t].flags & MARK_DEGENERATE) continue;
+		for(unsigned int i = 0; i < 3; i++) vertexOffsets[ids[3 * t + i] + 1]++;
+	}
+	for(size_t v = 0; v < numVertices; v++) vertexOffsets[v + 1] += vertexOffsets[v];
+	vertexTriangles.resize(vertexOffsets[numVertices]);
+	std::vector<unsigned int> positions(vertexOffsets.begin(), vertexOffsets.end() - 1);
+	for(size_t t = 0; t < numTriangles; t++)
+	{
+		if(triangles[t].flags & MARK_DEGENERATE) continue;
+		for(unsigned int i = 0; i < 3; i++) vertexTriangles[positions[ids[3 * t + i]]++] = (unsigned int) t;
+	}
+
+	// artes manifold en parallle: une seule arte dans chaque sens
+	neighbors.assign(3 * numTriangles, -1);
+	ParallelFor(numTriangles, CPM_TANGENT_PARALLEL_MIN_TRIANGLES, [&](size_t begin, size_t end)
+	{
+		for(size_t t = begin; t < end; t++)
+		{
+			if(triangles[t].flags & MARK_DEGENERATE) continue;
+			for(unsigned int i = 0; i < 3; i++)
+			{
+				const unsigned int a = ids[3 * t + i], b = ids[3 * t + NextCorner(i)];
+
+				unsigned int numOpposite = 0, opposite = 0;
+				for(unsigned int k = vertexOffsets[b]; k < vertexOffsets[b + 1]; k++)
+				{
+					const unsigned int u = vertexTriangles[k];
+					if(ids[3 * u + NextCorner(CornerOf(ids, u, b))] == a && !numOpposite++) opposite = u;
+				}
+				if(!numOpposite) continue;
+
+				unsigned int numSame = 0;
+				for(unsigned int k = vertexOffsets[a]; k < vertexOffsets[a + 1]; k++)
+				{
+					const unsigned int u = vertexTriangles[k];
+					if(ids[3 * u + NextCorner(CornerOf(ids, u, a))] == b) numSame++;
+				}
+				neighbors[3 * t + i] = numOpposite == 1 && numSame == 1 ? (int) opposite : NEIGHBOR_UNRESOLVED;
+			}
+		}
+	});
+
+	for(size_t t = 0; t < numTriangles; t++)
+	{
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			if(neighbors[3 * t + i] != NEIGHBOR_UNRESOLVED) continue;
+
+			const unsigned int a = ids[3 * t + i], b = ids[3 * t + NextCorner(i)];
+			neighbors[3 * t + i] = -1;
+			for(unsigned int k = vertexOffsets[b]; k < vertexOffsets[b + 1]; k++)
+			{
+				const unsigned int u = vertexTriangles[k];
+				const unsigned int corner = CornerOf(ids, u, b);
+				if(u > t && ids[3 * u + NextCorner(corner)] == a && neighbors[3 * u + corner] == NEIGHBOR_UNRESOLVED)
+				{
+					neighbors[3 * t + i] = (int) u;
+					neighbors[3 * u + corner] = (int) t;
+					break;
+				}
+			}
+		}
+	}
+}
+
+
+//
+//	Groupes: parcours en profondeur autour du sommet, premier voisin de l'arte qui part du coin puis de celle qui y arrive
+//
+static void BuildGroups(const TANGENT_INPUT &input, std::vector<TANGENT_TRIANGLE> &triangles, const std::vector<int> &neighbors,
+	std::vector<unsigned int> &cornerGroups, std::vector<TANGENT_GROUP> &groups, std::vector<unsigned int> &groupFaces)
+{
+	const unsigned int *ids = input.ids.empty() ? NULL : &input.ids[0];
+	const size_t numTriangles = triangles.size();
+
+	cornerGroups.assign(3 * numTriangles, NO_INDEX);
+	groups.clear();
+	groupFaces.clear();
+	groupFaces.reserve(3 * numTriangles);
+
+	std::vector<int> stack;
+	for(size_t t = 0; t < numTriangles; t++)
+	{
+		// comme la rfrence, un triangle sans UV ne commence jamais un groupe: il n'en rejoint un que par un voisin
+		if(triangles[t].flags & (MARK_DEGENERATE | GROUP_WITH_ANY)) continue;
+
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			if(cornerGroups[3 * t + i] != NO_INDEX) continue;
+
+			const unsigned int g = (unsigned int) groups.size();
+			TANGENT_GROUP group;
+			group.vertex = ids[3 * t + i];
+			group.orientPreserving = (triangles[t].flags & ORIENT_PRESERVING) != 0;
+			group.firstFace = (unsigned int) groupFaces.size();
+			group.faceCount = 0;
+
+			cornerGroups[3 * t + i] = g;
+			groupFaces.push_back((unsigned int) t);
+
+			stack.clear();
+			stack.push_back(neighbors[3 * t + PreviousCorner(i)]);
+			stack.push_back(neighbors[3 * t + i]);
+			while(!stack.empty())
+			{
+				const int neighbor = stack.back();
+				stack.pop_back();
+				if(neighbor < 0) continue;
+
+				const unsigned int u = (unsigned int) neighbor;
+				const unsigned int corner = CornerOf(ids, u, group.vertex);
+				if(cornerGroups[3 * u + corner] != NO_INDEX) continue;
+
+				// un triangle sans UV prend l'orientation du premier groupe qui l'atteint
+				TANGENT_TRIANGLE &triangle = triangles[u];
+				if((triangle.flags & GROUP_WITH_ANY) && cornerGroups[3 * u] == NO_INDEX && cornerGroups[3 * u + 1] == NO_INDEX && cornerGroups[3 * u + 2] == NO_INDEX)
+				{
+					triangle.flags &= ~ORIENT_PRESERVING;
+					if(group.orientPreserving) triangle.flags |= ORIENT_PRESERVING;
+				}
+				if(((triangle.flags & ORIENT_PRESERVING) != 0) != group.orientPreserving) continue;
+
+				cornerGroups[3 * u + corner] = g;
+				groupFaces.push_back(u);
+				stack.push_back(neighbors[3 * u + PreviousCorner(corner)]);
+				stack.push_back(neighbors[3 * u + corner]);
+			}
+
+			group.faceCount = (unsigned int) groupFaces.size() - group.firstFace;
+			groups.push_back(group);
+		}
+	}
+}
+
+
+//
+//	Tangente d'un sous-groupe: moyenne des drives projetes dans le plan de la normale, pondres par l'angle au sommet
+//
+static TANGENT_SPACE EvalTangentSpace(const TANGENT_INPUT &input, const std::vector<TANGENT_TRIANGLE> &triangles, const unsigned int *faces, size_t count, unsigned int vertex)
+{
+	const unsigned int *ids = &input.ids[0];
+	const std::vector<unsigned int> &corners = *input.triangles;
+
+	TANGENT_SPACE result;
+	result.os = result.ot = Vec3(0.0f, 0.0f, 0.0f);
+	result.magS = result.magT = 0.0f;
+	float angleSum = 0.0f;
+
+	for(size_t k = 0; k < count; k++)
+	{
+		const unsigned int f = faces[k];
+		const TANGENT_TRIANGLE &triangle = triangles[f];
+		if(triangle.flags & GROUP_WITH_ANY) continue;
+
+		const unsigned int i = CornerOf(ids, f, vertex);
+		const VEC3 n = input.normal(corners[3 * f + i]);
+		const VEC3 os = Project(triangle.os, n), ot = Project(triangle.ot, n);
+
+		const VEC3 p0 = input.position(corners[3 * f + PreviousCorner(i)]);
+		const VEC3 p1 = input.position(corners[3 * f + i]);
+		const VEC3 p2 = input.position(corners[3 * f + NextCorner(i)]);
+		const VEC3 v1 = Project(Sub(p0, p1), n), v2 = Project(Sub(p2, p1), n);
+
+		float cosine = Dot(v1, v2);
+		cosine = cosine > 1 ? 1 : (cosine < -1 ? -1 : cosine);
+		const float angle = (float) acos(cosine);
+
+		result.os = Add(result.os, Scale(angle, os));
+		result.ot = Add(result.ot, Scale(angle, ot));
+		result.magS += angle * triangle.magS;
+		result.magT += angle * triangle.magT;
+		angleSum += angle;
+	}
+
+	if(NotZero(result.os)) result.os = Normalize(result.os);
+	if(NotZero(result.ot)) result.ot = Normalize(result.ot);
+	if(angleSum > 0)
+	{
+		result.magS /= angleSum;
+		result.magT /= angleSum;
+	}
+	return result;
+}
+
+static void EvalGroup(const TANGENT_INPUT &input, const std::vector<TANGENT_TRIANGLE> &triangles, const TANGENT_GROUP &group, const unsigned int *faces,
+	float threshold, std::vector<float> &cornerTangents)
+// Rsum: chaque triangle du groupe a pour sous-groupe les triangles de tangente proche de la sienne (tous, avec le seuil par dfaut)
+{
+	const unsigned int *ids = &input.ids[0];
+	const size_t count = group.faceCount;
+
+	std::vector<VEC3> os(count), ot(count);
+	for(size_t k = 0; k < count; k++)
+	{
+		const TANGENT_TRIANGLE &triangle = triangles[faces[k]];
+		const VEC3 n = input.normal((*input.triangles)[3 * faces[k] + CornerOf(ids, faces[k], group.vertex)]);
+		os[k] = Project(triangle.os, n);
+		ot[k] = Project(triangle.ot, n);
+	}
+
+	std::vector< std::vector<unsigned int> > subgroups;
+	std::vector<TANGENT_SPACE> spaces;
+	std::vector<unsigned int> members;
+	for(size_t k = 0; k < count; k++)
+	{
+		const unsigned int f = faces[k];
+
+		members.clear();
+		for(size_t j = 0; j < count; j++)
+		{
+			const bool any = ((triangles[f].flags | triangles[faces[j]].flags) & GROUP_WITH_ANY) != 0;
+			if(any || j == k || (Dot(os[k], os[j]) > threshold && Dot(ot[k], ot[j]) > threshold)) members.push_back(faces[j]);
+		}
+		std::sort(members.begin(), members.end());
+
+		size_t s = 0;
+		while(s < subgroups.size() && subgroups[s] != members) s++;
+		if(s == subgroups.size())
+		{
+			subgroups.push_back(members);
+			spaces.push_back(EvalTangentSpace(input, triangles, &members[0], members.size(), group.vertex));
+		}
+
+		float *tangent = &cornerTangents[4 * (3 * (size_t) f + CornerOf(ids, f, group.vertex))];
+		tangent[0] = spaces[s].os.x;
+		tangent[1] = spaces[s].os.y;
+		tangent[2] = spaces[s].os.z;
+		tangent[3] = group.orientPreserving ? 1.0f : -1.0f;
+	}
+}
+
+CPM_TANGENT_STATS GenerateCornerTangents(const std::vector<unsigned int> &triangles, const VECTOR3_ARRAY<double> &points, const VECTOR3_ARRAY<float> &normals,
+	const UV_ARRAY &UVs, std::vector<float> &cornerTangents)
+{
+	CPM_PROFILE_SCOPE("GenerateCornerTangents");
+
+	const size_t numTriangles = triangles.size() / 3;
+	CPM_TANGENT_STATS stats;
+	stats.triangles = (unsigned int) numTriangles;
+	stats.inputVertices = stats.outputVertices = (unsigned int) points.size();
+
+	// coins sans groupe (triangles dgnrs ou sans UV qu'aucun groupe n'atteint): base par dfaut de la rfrence,
+	// tangente (1, 0, 0) et orientation non prserve
+	cornerTangents.resize(4 * triangles.size());
+	for(size_t c = 0; c < triangles.size(); c++)
+	{
+		cornerTangents[4 * c] = 1.0f;
+		cornerTangents[4 * c + 1] = cornerTangents[4 * c + 2] = 0.0f;
+		cornerTangents[4 * c + 3] = -1.0f;
+	}
+	if(!numTriangles) return stats;
+
+	TANGENT_INPUT input;
+	input.triangles = &triangles;
+	input.points = &points;
+	input.normals = &normals;
+	input.UVs = &UVs;
+	BuildVertexIds(input);
+
+	std::vector<TANGENT_TRIANGLE> infos(numTriangles);
+	ParallelFor(numTriangles, CPM_TANGENT_PARALLEL_MIN_TRIANGLES, [&](size_t begin, size_t end)
+	{
+		for(size_t t = begin; t < end; t++) InitTriangle(input, (unsigned int) t, infos[t]);
+	});
+
+	std::vector<int> neighbors;
+	std::vector<unsigned int> vertexTriangles, vertexOffsets;
+	BuildNeighbors(input, infos, neighbors, vertexTriangles, vertexOffsets);
+
+	std::vector<unsigned int> cornerGroups, groupFaces;
+	std::vector<TANGENT_GROUP> groups;
+	BuildGroups(input, infos, neighbors, cornerGroups, groups, groupFaces);
+	stats.groups = (unsigned int) groups.size();
+
+	// chaque coin appartient  un seul groupe: les groupes crivent leurs coins sans se gner
+	const float threshold = cosf(TANGENT_ANGULAR_THRESHOLD * 3.14159265358979f / 180.0f);
+	ParallelFor(groups.size(), CPM_TANGENT_PARALLEL_MIN_TRIANGLES / 4, [&](size_t begin, size_t end)
+	{
+		for(size_t g = begin; g < end; g++) EvalGroup(input, infos, groups[g], &groupFaces[groups[g].firstFace], threshold, cornerTangents);
+	});
+
+	// un triangle dgnr reprend, pour chaque coin, la tangente du premier triangle valide qui a le mme sommet
+	for(size_t t = 0; t < numTriangles; t++)
+	{
+		if(!(infos[t].flags & MARK_DEGENERATE)) continue;
+		stats.degenerateTriangles++;
+
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			const unsigned int vertex = input.ids[3 * t + i];
+			if(vertexOffsets[vertex] == vertexOffsets[vertex + 1]) continue;
+
+			const unsigned int u = vertexTriangles[vertexOffsets[vertex]];
+			memcpy(&cornerTangents[4 * (3 * t + i)], &cornerTangents[4 * (3 * (size_t) u + CornerOf(&input.ids[0], u, vertex))], 4 * sizeof(float));
+		}
+	}
+
+	return stats;
+}
+
+CPM_TANGENT_STATS GenerateMeshTangents(CPM_MESH_DATA &mesh)
+{
+	CPM_PROFILE_SCOPE("GenerateMeshTangents");
+
+	const unsigned int numVertices = (unsigned int) mesh.points.size();
+	if(mesh.normals.size() != numVertices || mesh.UVs.size() != numVertices)
+	{
+		mesh.tangents.clear();
+		mesh.binormals.clear();
+		CPM_TANGENT_STATS stats;
+		stats.inputVertices = stats.outputVertices = numVertices;
+		return stats;
+	}
+
+	std::vector<float> cornerTangents;
+	CPM_TANGENT_STATS stats = GenerateCornerTangents(mesh.triangles, mesh.points, mesh.normals, mesh.UVs, cornerTangents);
+
+	// un vertex garde la tangente de son premier coin, les coins de tangente diffrente reoivent une copie du vertex
+	std::vector<unsigned int> spaces(numVertices, NO_INDEX), duplicates(numVertices, NO_INDEX), sources;
+	for(size_t c = 0; c < mesh.triangles.size(); c++)
+	{
+		unsigned int v = mesh.triangles[c];
+		if(spaces[v] == NO_INDEX) { spaces[v] = (unsigned int) c; continue; }
+
+		while(memcmp(&cornerTangents[4 * c], &cornerTangents[4 * (size_t) spaces[v]], 4 * sizeof(float)) != 0)
+		{
+			if(duplicates[v] == NO_INDEX)
+			{
+				if(sources.empty()) for(unsigned int k = 0; k < numVertices; k++) sources.push_back(k);
+
+				duplicates[v] = (unsigned int) sources.size();
+				sources.push_back(sources[v]);
+				spaces.push_back((unsigned int) c);
+				duplicates.push_back(NO_INDEX);
+			}
+			v = duplicates[v];
+		}
+		mesh.triangles[c] = v;
+	}
+
+	if(!sources.empty())
+	{
+		VECTOR3_ARRAY<double> points;
+		points.gather(mesh.points, sources);
+		mesh.points.swap(points);
+		VECTOR3_ARRAY<float> normals;
+		normals.gather(mesh.normals, sources);
+		mesh.normals.swap(normals);
+		UV_ARRAY UVs;
+		UVs.gather(mesh.UVs, sources);
+		mesh.UVs.swap(UVs);
+		if(mesh.colors.size() == numVertices)
+		{
+			COLOR_ARRAY colors;
+			colors.gather(mesh.colors, sources);
+			mesh.colors.swap(colors);
+		}
+	}
+
+	// binormale reconstruite comme dans le shader: signe * (normale x tangente)
+	const size_t numOutput = mesh.points.size();
+	stats.outputVertices = (unsigned int) numOutput;
+	mesh.tangents.resize(numOutput);
+	mesh.binormals.resize(numOutput);
+	ParallelFor(numOutput, 4 * CPM_TANGENT_PARALLEL_MIN_TRIANGLES, [&](size_t begin, size_t end)
+	{
+		for(size_t v = begin; v < end; v++)
+		{
+			const float *tangent = spaces[v] == NO_INDEX ? NULL : &cornerTangents[4 * (size_t) spaces[v]];
+			const VEC3 t = tangent ? Vec3(tangent[0], tangent[1], tangent[2]) : Vec3(1.0f, 0.0f, 0.0f);
+			const float sign = tangent ? tangent[3] : 1.0f;
+			const VEC3 n = Vec3(mesh.normals.x[v], mesh.normals.y[v], mesh.normals.z[v]);
+
+			mesh.tangents.x[v] = t.x;
+			mesh.tangents.y[v] = t.y;
+			mesh.tangents.z[v] = t.z;
+			mesh.binormals.x[v] = sign * (n.y * t.z - n.z * t.y);
+			mesh.binormals.y[v] = sign * (n.z * t.x - n.x * t.z);
+			mesh.binormals.z[v] = sign * (n.x * t.y - n.y * t.x);
+		}
+	});
+
+	return stats;
+}
@@ -0,0 +1,45 @@
+#ifndef CPM_TANGENT_SPACE_H_INCLUDED
+#define CPM_TANGENT_SPACE_H_INCLUDED
+
+#include <vector>
+
+#include "CPMMeshBuffers.h"
+
+struct CPM_MESH_DATA;
+
+//
+//	Tangentes MikkTSpace (option CPM_EXPORT_MIKKTSPACE avec CPM_EXPORT_TGT_BINORMALS)
+//	calcules sur les buffers finaux (aprs la conversion des axes, la fusion et le nettoyage des triangles), comme les recalcule
+//	le moteur: mmes rgles que l'implmentation de rfrence de Morten Mikkelsen pour des triangles, avec le seuil angulaire
+//	par dfaut (180 degrs) et la base simple (tangente et signe); la binormale crite est signe * (normale x tangente)
+//
+//	- les coins de mme position, normale et UV sont un mme sommet, quels que soient les autres attributs
+//	- un groupe runit les triangles autour d'un sommet relis par leurs artes et de mme orientation UV, chaque groupe
+//	  reoit la moyenne des tangentes de ses triangles pondre par leur angle au sommet
+//	- un vertex partag par plusieurs groupes de tangentes diffrentes est dupliqu
+//
+//	les drives des triangles, les voisins et la moyenne des groupes sont calculs en parallle par blocs de triangles,
+//	seule la construction des groupes est squentielle: l'ordre de parcours de la rfrence fixe l'orientation des triangles sans UV
+//
+#define CPM_TANGENT_PARALLEL_MIN_TRIANGLES	(1 << 14)
+
+struct CPM_TANGENT_STATS
+{
+	CPM_TANGENT_STATS() : triangles(0), groups(0), degenerateTriangles(0), inputVertices(0), outputVertices(0) {}
+
+	unsigned int	triangles;
+	unsigned int	groups;
+	unsigned int	degenerateTriangles;	// deux coins au mme sommet: tangentes reprises d'un autre triangle
+	unsigned int	inputVertices;
+	unsigned int	outputVertices;			// vertices dupliqus compris
+};
+
+// tangentes de chaque coin de triangle: 4 floats par coin (x, y, z, signe de la binormale)
+CPM_TANGENT_STATS GenerateCornerTangents(const std::vector<unsigned int> &triangles, const VECTOR3_ARRAY<double> &points, const VECTOR3_ARRAY<float> &normals,
+	const UV_ARRAY &UVs, std::vector<float> &cornerTangents);
+
+// remplit mesh.tangents et mesh.binormals et duplique les vertices dont les coins ont des tangentes diffrentes
+// le mesh doit avoir des normales et des UVs, avant le dcoupage et les sous-meshes (les faceIds ne changent pas)
+CPM_TANGENT_STATS GenerateMeshTangents(CPM_MESH_DATA &mesh);
+
+#endif // CPM_TANGENT_SPACE_H_INCLUDED
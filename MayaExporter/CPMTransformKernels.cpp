@@ -0,0 +1,281 @@
+#include <cmath>
+
+#include "CPMTransformKernels.h"
+#include "CPMParallel.h"
+
+// en dessous de cette taille, un intervalle n'est pas confi  un autre thread
+#define TRANSFORM_MIN_CHUNK		32768
+
+void BuildMeshTransform(const double matrix[4][4], MESH_TRANSFORM &transform)
+// Rsum: prpare les matrices appliques aux positions, aux tangentes et aux normales
+{
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		for(unsigned int j = 0; j < 4; j++) transform.points[i][j] = matrix[i][j];
+	}
+
+	const double (*a)[4] = matrix;
+	for(unsigned int i = 0; i < 3; i++)
+	{
+		for(unsigned int j = 0; j < 3; j++) transform.vectors[i][j] = a[i][j];
+	}
+
+	// inverse transpose = comatrice / dterminant
+	// seul le signe du dterminant compte puisque les normales sont renormalises, ce qui reste valable pour une matrice singulire
+	double c[3][3];
+	c[0][0] = a[1][1]*a[2][2] - a[1][2]*a[2][1];
+	c[0][1] = a[1][2]*a[2][0] - a[1][0]*a[2][2];
+	c[0][2] = a[1][0]*a[2][1] - a[1][1]*a[2][0];
+	c[1][0] = a[0][2]*a[2][1] - a[0][1]*a[2][2];
+	c[1][1] = a[0][0]*a[2][2] - a[0][2]*a[2][0];
+	c[1][2] = a[0][1]*a[2][0] - a[0][0]*a[2][1];
+	c[2][0] = a[0][1]*a[1][2] - a[0][2]*a[1][1];
+	c[2][1] = a[0][2]*a[1][0] - a[0][0]*a[1][2];
+	c[2][2] = a[0][0]*a[1][1] - a[0][1]*a[1][0];
+
+	const double det = a[0][0]*c[0][0] + a[0][1]*c[0][1] + a[0][2]*c[0][2];
+	const double sign = det < 0.0 ? -1.0 : 1.0;
+
+	for(unsigned int i = 0; i < 3; i++)
+	{
+		for(unsigned int j = 0; j < 3; j++) transform.normals[i][j] = sign*c[i][j];
+	}
+}
+
+
+//
+//	Positions
+//
+static void TransformPointsScalar(const double m[4][4], double *x, double *y, double *z, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		const double px = x[i], py = y[i], pz = z[i];
+		x[i] = px*m[0][0] + py*m[1][0] + pz*m[2][0] + m[3][0];
+		y[i] = px*m[0][1] + py*m[1][1] + pz*m[2][1] + m[3][1];
+		z[i] = px*m[0][2] + py*m[1][2] + pz*m[2][2] + m[3][2];
+	}
+}
+
+#ifdef CPM_USE_SSE2
+static size_t TransformPointsSSE2(const double m[4][4], double *x, double *y, double *z, size_t count)
+{
+	__m128d c[4][3];
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		for(unsigned int j = 0; j < 3; j++) c[i][j] = _mm_set1_pd(m[i][j]);
+	}
+
+	size_t i = 0;
+	for(; i + 2 <= count; i += 2)
+	{
+		const __m128d px = _mm_loadu_pd(x + i);
+		const __m128d py = _mm_loadu_pd(y + i);
+		const __m128d pz = _mm_loadu_pd(z + i);
+
+		for(unsigned int j = 0; j < 3; j++)
+		{
+			__m128d r = _mm_add_pd(_mm_mul_pd(px, c[0][j]), _mm_mul_pd(py, c[1][j]));
+			r = _mm_add_pd(r, _mm_add_pd(_mm_mul_pd(pz, c[2][j]), c[3][j]));
+			_mm_storeu_pd((j == 0 ? x : (j == 1 ? y : z)) + i, r);
+		}
+	}
+	return i;
+}
+#endif
+
+#ifdef CPM_TARGET_AVX2
+CPM_TARGET_AVX2 static size_t TransformPointsAVX2(const double m[4][4], double *x, double *y, double *z, size_t count)
+{
+	__m256d c[4][3];
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		for(unsigned int j = 0; j < 3; j++) c[i][j] = _mm256_set1_pd(m[i][j]);
+	}
+
+	size_t i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m256d px = _mm256_loadu_pd(x + i);
+		const __m256d py = _mm256_loadu_pd(y + i);
+		const __m256d pz = _mm256_loadu_pd(z + i);
+
+		__m256d rx = _mm256_add_pd(_mm256_mul_pd(px, c[0][0]), _mm256_mul_pd(py, c[1][0]));
+		__m256d ry = _mm256_add_pd(_mm256_mul_pd(px, c[0][1]), _mm256_mul_pd(py, c[1][1]));
+		__m256d rz = _mm256_add_pd(_mm256_mul_pd(px, c[0][2]), _mm256_mul_pd(py, c[1][2]));
+		rx = _mm256_add_pd(rx, _mm256_add_pd(_mm256_mul_pd(pz, c[2][0]), c[3][0]));
+		ry = _mm256_add_pd(ry, _mm256_add_pd(_mm256_mul_pd(pz, c[2][1]), c[3][1]));
+		rz = _mm256_add_pd(rz, _mm256_add_pd(_mm256_mul_pd(pz, c[2][2]), c[3][2]));
+
+		_mm256_storeu_pd(x + i, rx);
+		_mm256_storeu_pd(y + i, ry);
+		_mm256_storeu_pd(z + i, rz);
+	}
+	return i;
+}
+#endif
+
+void TransformPoints(const double m[4][4], double *x, double *y, double *z, size_t count, CPM_SIMD_LEVEL level)
+{
+	size_t done = 0;
+
+#ifdef CPM_TARGET_AVX2
+	if(level >= CPM_SIMD_AVX2) done = TransformPointsAVX2(m, x, y, z, count);
+	else
+#endif
+#ifdef CPM_USE_SSE2
+	if(level >= CPM_SIMD_SSE2) done = TransformPointsSSE2(m, x, y, z, count);
+#endif
+
+	TransformPointsScalar(m, x + done, y + done, z + done, count - done);
+}
+
+
+//
+//	Normales, tangentes et binormales: transformation puis renormalisation
+//	un vecteur nul reste nul
+//
+static void TransformDirectionsScalar(const float m[3][3], float *x, float *y, float *z, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		float rx = vx*m[0][0] + vy*m[1][0] + vz*m[2][0];
+		float ry = vx*m[0][1] + vy*m[1][1] + vz*m[2][1];
+		float rz = vx*m[0][2] + vy*m[1][2] + vz*m[2][2];
+
+		const float length2 = rx*rx + ry*ry + rz*rz;
+		if(length2 > 0.0f)
+		{
+			const float invLength = 1.0f / sqrtf(length2);
+			rx *= invLength;
+			ry *= invLength;
+			rz *= invLength;
+		}
+
+		x[i] = rx;
+		y[i] = ry;
+		z[i] = rz;
+	}
+}
+
+#ifdef CPM_USE_SSE2
+static size_t TransformDirectionsSSE2(const float m[3][3], float *x, float *y, float *z, size_t count)
+{
+	__m128 c[3][3];
+	for(unsigned int i = 0; i < 3; i++)
+	{
+		for(unsigned int j = 0; j < 3; j++) c[i][j] = _mm_set1_ps(m[i][j]);
+	}
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	size_t i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128 vx = _mm_loadu_ps(x + i);
+		const __m128 vy = _mm_loadu_ps(y + i);
+		const __m128 vz = _mm_loadu_ps(z + i);
+
+		const __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, c[0][0]), _mm_mul_ps(vy, c[1][0])), _mm_mul_ps(vz, c[2][0]));
+		const __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, c[0][1]), _mm_mul_ps(vy, c[1][1])), _mm_mul_ps(vz, c[2][1]));
+		const __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, c[0][2]), _mm_mul_ps(vy, c[1][2])), _mm_mul_ps(vz, c[2][2]));
+
+		const __m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz));
+		const __m128 nonZero = _mm_cmpgt_ps(length2, zero);
+		const __m128 invLength = _mm_and_ps(nonZero, _mm_div_ps(one, _mm_sqrt_ps(length2)));
+		const __m128 scale = _mm_or_ps(invLength, _mm_andnot_ps(nonZero, one));
+
+		_mm_storeu_ps(x + i, _mm_mul_ps(rx, scale));
+		_mm_storeu_ps(y + i, _mm_mul_ps(ry, scale));
+		_mm_storeu_ps(z + i, _mm_mul_ps(rz, scale));
+	}
+	return i;
+}
+#endif
+
+#ifdef CPM_TARGET_AVX2
+CPM_TARGET_AVX2 static size_t TransformDirectionsAVX2(const float m[3][3], float *x, float *y, float *z, size_t count)
+{
+	__m256 c[3][3];
+	for(unsigned int i = 0; i < 3; i++)
+	{
+		for(unsigned int j = 0; j < 3; j++) c[i][j] = _mm256_set1_ps(m[i][j]);
+	}
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	size_t i = 0;
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m256 vx = _mm256_loadu_ps(x + i);
+		const __m256 vy = _mm256_loadu_ps(y + i);
+		const __m256 vz = _mm256_loadu_ps(z + i);
+
+		const __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, c[0][0]), _mm256_mul_ps(vy, c[1][0])), _mm256_mul_ps(vz, c[2][0]));
+		const __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, c[0][1]), _mm256_mul_ps(vy, c[1][1])), _mm256_mul_ps(vz, c[2][1]));
+		const __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, c[0][2]), _mm256_mul_ps(vy, c[1][2])), _mm256_mul_ps(vz, c[2][2]));
+
+		const __m256 length2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rx, rx), _mm256_mul_ps(ry, ry)), _mm256_mul_ps(rz, rz));
+		const __m256 nonZero = _mm256_cmp_ps(length2, zero, _CMP_GT_OQ);
+		const __m256 scale = _mm256_blendv_ps(one, _mm256_div_ps(one, _mm256_sqrt_ps(length2)), nonZero);
+
+		_mm256_storeu_ps(x + i, _mm256_mul_ps(rx, scale));
+		_mm256_storeu_ps(y + i, _mm256_mul_ps(ry, scale));
+		_mm256_storeu_ps(z + i, _mm256_mul_ps(rz, scale));
+	}
+	return i;
+}
+#endif
+
+void TransformDirections(const double m[3][3], float *x, float *y, float *z, size_t count, CPM_SIMD_LEVEL level)
+{
+	float mf[3][3];
+	for(unsigned int i = 0; i < 3; i++)
+	{
+		for(unsigned int j = 0; j < 3; j++) mf[i][j] = (float) m[i][j];
+	}
+
+	size_t done = 0;
+
+#ifdef CPM_TARGET_AVX2
+	if(level >= CPM_SIMD_AVX2) done = TransformDirectionsAVX2(mf, x, y, z, count);
+	else
+#endif
+#ifdef CPM_USE_SSE2
+	if(level >= CPM_SIMD_SSE2) done = TransformDirectionsSSE2(mf, x, y, z, count);
+#endif
+
+	TransformDirectionsScalar(mf, x + done, y + done, z + done, count - done);
+}
+
+
+//
+//	Mesh entier
+//
+static void TransformDirectionArray(const double m[3][3], VECTOR3_ARRAY<float> *vectors, CPM_SIMD_LEVEL level)
+{
+	if(!vectors || vectors->size() == 0) return;
+
+	float *x = &vectors->x[0], *y = &vectors->y[0], *z = &vectors->z[0];
+	ParallelFor(vectors->size(), TRANSFORM_MIN_CHUNK, [=](size_t begin, size_t end) {
+		TransformDirections(m, x + begin, y + begin, z + begin, end - begin, level);
+	});
+}
+
+void TransformMesh(const MESH_TRANSFORM &transform, VECTOR3_ARRAY<double> *points, VECTOR3_ARRAY<float> *normals,
+				   VECTOR3_ARRAY<float> *tangents, VECTOR3_ARRAY<float> *binormals, CPM_SIMD_LEVEL level)
+{
+	if(points && points->size())
+	{
+		double *x = &points->x[0], *y = &points->y[0], *z = &points->z[0];
+		const double (*m)[4] = transform.points;
+		ParallelFor(points->size(), TRANSFORM_MIN_CHUNK, [=](size_t begin, size_t end) {
+			TransformPoints(m, x + begin, y + begin, z + begin, end - begin, level);
+		});
+	}
+
+	TransformDirectionArray(transform.normals, normals, level);
+	TransformDirectionArray(transform.vectors, tangents, level);
+	TransformDirectionArray(transform.vectors, binormals, level);
+}
@@ -0,0 +1,29 @@
+#ifndef CPM_TRANSFORM_KERNELS_H_INCLUDED
+#define CPM_TRANSFORM_KERNELS_H_INCLUDED
+
+#include "CPMMeshBuffers.h"
+#include "CPMSimd.h"
+
+//
+//	Transformation des attributs d'un mesh dans l'espace monde
+//	convention de Maya: vecteurs lignes, p' = p * M, la dernire ligne de M contient la translation
+//
+struct MESH_TRANSFORM
+{
+	double		points[4][4];		// transformation des positions
+	double		vectors[3][3];		// partie linaire, pour les tangentes et les binormales
+	double		normals[3][3];		// inverse transpose de la partie linaire, pour les normales
+};
+
+void BuildMeshTransform(const double matrix[4][4], MESH_TRANSFORM &transform);
+
+// noyaux de calcul sur un intervalle de tableaux contigus
+void TransformPoints(const double m[4][4], double *x, double *y, double *z, size_t count, CPM_SIMD_LEVEL level);
+void TransformDirections(const double m[3][3], float *x, float *y, float *z, size_t count, CPM_SIMD_LEVEL level);
+
+// transformation d'un mesh entier, rpartie sur plusieurs threads pour les gros meshes
+// les normales, tangentes et binormales sont renormalises
+void TransformMesh(const MESH_TRANSFORM &transform, VECTOR3_ARRAY<double> *points, VECTOR3_ARRAY<float> *normals,
+				   VECTOR3_ARRAY<float> *tangents, VECTOR3_ARRAY<float> *binormals, CPM_SIMD_LEVEL level = GetSimdLevel());
+
+#endif // CPM_TRANSFORM_KERNELS_H_INCLUDED
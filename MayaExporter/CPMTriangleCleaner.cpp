@@ -0,0 +1,140 @@
+#include "CPMTriangleCleaner.h"
+#include "CPMMeshWriter.h"
+#include "CPMParallel.h"
+#include "CPMProfiler.h"
+
+static double s_areaEpsilon = CPM_DEFAULT_AREA_EPSILON;
+
+double GetAreaEpsilon()
+{
+	return s_areaEpsilon;
+}
+
+void SetAreaEpsilon(double epsilon)
+{
+	s_areaEpsilon = epsilon;
+}
+
+enum TRIANGLE_CLASS
+{
+	TRIANGLE_KEPT,
+	TRIANGLE_INDEX_DEGENERATE,
+	TRIANGLE_AREA_DEGENERATE,
+};
+
+static unsigned char ClassifyTriangle(const unsigned int *tri, const VECTOR3_ARRAY<double> &points, double epsilon2)
+// Rsum: |(b - a) x (c - a)| est le double de l'aire, soit la hauteur fois le plus grand ct
+{
+	const unsigned int a = tri[0], b = tri[1], c = tri[2];
+	if(a == b || b == c || c == a) return TRIANGLE_INDEX_DEGENERATE;
+
+	const double abx = points.x[b] - points.x[a], aby = points.y[b] - points.y[a], abz = points.z[b] - points.z[a];
+	const double acx = points.x[c] - points.x[a], acy = points.y[c] - points.y[a], acz = points.z[c] - points.z[a];
+	const double bcx = acx - abx, bcy = acy - aby, bcz = acz - abz;
+
+	const double cx = aby * acz - abz * acy, cy = abz * acx - abx * acz, cz = abx * acy - aby * acx;
+	const double cross2 = cx * cx + cy * cy + cz * cz;
+
+	double longest2 = abx * abx + aby * aby + abz * abz;
+	const double ac2 = acx * acx + acy * acy + acz * acz, bc2 = bcx * bcx + bcy * bcy + bcz * bcz;
+	if(ac2 > longest2) longest2 = ac2;
+	if(bc2 > longest2) longest2 = bc2;
+
+	// cross2 <= (epsilon * longest2)^2: les sommets confondus (longest2 nul) sont dgnrs, les positions NaN sont conserves
+	return cross2 <= epsilon2 * longest2 * longest2 ? TRIANGLE_AREA_DEGENERATE : TRIANGLE_KEPT;
+}
+
+static inline void Canonical(const unsigned int *tri, unsigned int key[3])
+// Rsum: rotation qui commence par le plus petit indice, le sens du triangle est conserv
+{
+	const unsigned int first = tri[0] < tri[1] ? (tri[0] < tri[2] ? 0 : 2) : (tri[1] < tri[2] ? 1 : 2);
+	key[0] = tri[first];
+	key[1] = tri[(first + 1) % 3];
+	key[2] = tri[(first + 2) % 3];
+}
+
+static inline unsigned long long HashTriangle(const unsigned int key[3])
+{
+	unsigned long long h = key[0] * 0x9E3779B97F4A7C15ULL;
+	h ^= key[1] * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+	h ^= key[2] * 0x165667B19E3779F9ULL + (h << 6) + (h >> 2);
+	return h ^ (h >> 29);
+}
+
+CPM_TRIANGLE_CLEANUP_STATS CleanTriangles(std::vector<unsigned int> &triangles, const VECTOR3_ARRAY<double> &points, double areaEpsilon, std::vector<unsigned int> &remap)
+{
+	CPM_PROFILE_SCOPE("CleanTriangles");
+
+	const size_t numTriangles = triangles.size() / 3;
+	CPM_TRIANGLE_CLEANUP_STATS stats;
+	stats.inputTriangles = (unsigned int) numTriangles;
+	remap.resize(numTriangles);
+
+	// les tests gomtriques sont indpendants, la recherche des doublons suit l'ordre des triangles pour garder le premier
+	std::vector<unsigned char> classes(numTriangles);
+	const double epsilon2 = areaEpsilon * areaEpsilon;
+	ParallelFor(numTriangles, 1 << 14, [&](size_t begin, size_t end)
+	{
+		for(size_t t = begin; t < end; t++) classes[t] = ClassifyTriangle(&triangles[3 * t], points, epsilon2);
+	});
+
+	size_t tableSize = 16;
+	while(tableSize < 2 * numTriangles) tableSize <<= 1;
+	std::vector<unsigned int> table(tableSize, 0); // triangle conserv + 1, 0 = case libre
+
+	unsigned int kept = 0;
+	for(size_t t = 0; t < numTriangles; t++)
+	{
+		remap[t] = CPM_REMOVED_TRIANGLE;
+		if(classes[t] == TRIANGLE_INDEX_DEGENERATE) { stats.indexDegenerate++; continue; }
+		if(classes[t] == TRIANGLE_AREA_DEGENERATE) { stats.areaDegenerate++; continue; }
+
+		unsigned int key[3];
+		Canonical(&triangles[3 * t], key);
+
+		// les triangles conservs sont dj compacts: la table dsigne leur nouvel indice
+		bool duplicate = false;
+		size_t slot = (size_t) HashTriangle(key) & (tableSize - 1);
+		for(; table[slot]; slot = (slot + 1) & (tableSize - 1))
+		{
+			unsigned int other[3];
+			Canonical(&triangles[3 * (table[slot] - 1)], other);
+			if(other[0] == key[0] && other[1] == key[1] && other[2] == key[2]) { duplicate = true; break; }
+		}
+		if(duplicate) { stats.duplicates++; continue; }
+
+		table[slot] = kept + 1;
+		if(kept != t)
+		{
+			triangles[3 * kept] = triangles[3 * t];
+			triangles[3 * kept + 1] = triangles[3 * t + 1];
+			triangles[3 * kept + 2] = triangles[3 * t + 2];
+		}
+		remap[t] = kept++;
+	}
+
+	triangles.resize(3 * (size_t) kept);
+	return stats;
+}
+
+CPM_TRIANGLE_CLEANUP_STATS CleanMeshTriangles(CPM_MESH_DATA &mesh, double areaEpsilon)
+{
+	std::vector<unsigned int> remap;
+	const CPM_TRIANGLE_CLEANUP_STATS stats = CleanTriangles(mesh.triangles, mesh.points, areaEpsilon, remap);
+	if(!stats.removed()) return stats;
+
+	// un doublon supprim dans un matriau garde le triangle conserv dans le matriau de sa premire occurrence
+	for(size_t m = 0; m < mesh.materials.size(); m++)
+	{
+		std::vector<unsigned int> &faceIds = mesh.materials[m].faceIds;
+		size_t count = 0;
+		for(size_t i = 0; i < faceIds.size(); i++)
+		{
+			const unsigned int t = faceIds[i] < remap.size() ? remap[faceIds[i]] : CPM_REMOVED_TRIANGLE;
+			if(t != CPM_REMOVED_TRIANGLE) faceIds[count++] = t;
+		}
+		faceIds.resize(count);
+	}
+
+	return stats;
+}
@@ -0,0 +1,44 @@
+#ifndef CPM_TRIANGLE_CLEANER_H_INCLUDED
+#define CPM_TRIANGLE_CLEANER_H_INCLUDED
+
+#include <vector>
+
+#include "CPMMeshBuffers.h"
+
+struct CPM_MESH_DATA;
+
+//
+//	Nettoyage des triangles (option CPM_EXPORT_CLEAN_TRIANGLES)
+//	MFnMesh::getTriangles donne des triangles d'aire nulle sur les vertices confondus, et la fusion des vertices
+//	peut produire des triangles rpts: ils sont supprims avant le dcoupage et les sous-meshes
+//	- dgnr par indices: deux sommets ont le mme indice
+//	- dgnr par aire: la hauteur du triangle est infrieure  epsilon fois son plus grand ct (le critre ne dpend pas de l'chelle)
+//	- doublon: mmes indices dans le mme sens qu'un triangle prcdent, quel que soit le premier sommet; le triangle retourn
+//	  (sens oppos) est une face arrire et reste
+//	les vertices ne sont pas modifis, les triangles conservs restent dans leur ordre
+//
+#define CPM_DEFAULT_AREA_EPSILON	1e-6
+
+struct CPM_TRIANGLE_CLEANUP_STATS
+{
+	CPM_TRIANGLE_CLEANUP_STATS() : inputTriangles(0), indexDegenerate(0), areaDegenerate(0), duplicates(0) {}
+
+	unsigned int removed() const { return indexDegenerate + areaDegenerate + duplicates; }
+
+	unsigned int	inputTriangles;
+	unsigned int	indexDegenerate;
+	unsigned int	areaDegenerate;
+	unsigned int	duplicates;
+};
+
+#define CPM_REMOVED_TRIANGLE	0xFFFFFFFF
+
+// epsilon utilis par l'option CPM_EXPORT_CLEAN_TRIANGLES
+double GetAreaEpsilon();
+void SetAreaEpsilon(double epsilon);
+
+// compacte triangles, remap[t] reoit le nouvel indice de l'ancien triangle t ou CPM_REMOVED_TRIANGLE
+CPM_TRIANGLE_CLEANUP_STATS CleanTriangles(std::vector<unsigned int> &triangles, const VECTOR3_ARRAY<double> &points, double areaEpsilon, std::vector<unsigned int> &remap);
+CPM_TRIANGLE_CLEANUP_STATS CleanMeshTriangles(CPM_MESH_DATA &mesh, double areaEpsilon); // renumrote aussi les faceIds des matriaux
+
+#endif // CPM_TRIANGLE_CLEANER_H_INCLUDED
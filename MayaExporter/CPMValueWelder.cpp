@@ -0,0 +1,166 @@
+#include <cmath>
+#include <unordered_map>
+
+#include "CPMValueWelder.h"
+#include "CPMMeshWriter.h"
+#include "CPMProfiler.h"
+
+static CPM_WELD_TOLERANCE s_weldTolerance;
+
+const CPM_WELD_TOLERANCE &GetWeldTolerance()
+{
+	return s_weldTolerance;
+}
+
+void SetWeldTolerance(const CPM_WELD_TOLERANCE &tolerance)
+{
+	s_weldTolerance = tolerance;
+}
+
+static inline unsigned long long HashCell(long long x, long long y, long long z)
+// Rsum: cl de la grille de hachage, les cellules diffrentes de mme cl sont dpartages par la comparaison des positions
+{
+	unsigned long long h = (unsigned long long) x * 0x9E3779B97F4A7C15ULL;
+	h ^= (unsigned long long) y * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+	h ^= (unsigned long long) z * 0x165667B19E3779F9ULL + (h << 6) + (h >> 2);
+	return h;
+}
+
+template<typename T>
+static inline bool Near(const std::vector<T> &values, unsigned int a, unsigned int b, T tolerance)
+{
+	return std::fabs(values[a] - values[b]) <= tolerance;
+}
+
+template<typename T>
+static inline bool Near(const VECTOR3_ARRAY<T> *vectors, unsigned int a, unsigned int b, T tolerance)
+{
+	return !vectors || (Near(vectors->x, a, b, tolerance) && Near(vectors->y, a, b, tolerance) && Near(vectors->z, a, b, tolerance));
+}
+
+template<typename T>
+static void Compact(std::vector<T> &values, const std::vector<unsigned int> &kept)
+// Rsum: ne garde que les lments kept, dans cet ordre (kept est croissant: la copie peut se faire sur place)
+{
+	for(size_t k = 0; k < kept.size(); k++) values[k] = values[kept[k]];
+	values.resize(kept.size());
+}
+
+template<typename T>
+static void Compact(VECTOR3_ARRAY<T> *vectors, const std::vector<unsigned int> &kept)
+{
+	if(!vectors) return;
+	Compact(vectors->x, kept);
+	Compact(vectors->y, kept);
+	Compact(vectors->z, kept);
+}
+
+CPM_VALUE_WELD_STATS WeldVerticesByValue(ASSEMBLY_OUTPUT &vertices, std::vector<unsigned int> &triangles, const CPM_WELD_TOLERANCE &tolerance)
+// Rsum: chaque vertex est compar aux vertices conservs des 27 cellules voisines d'une grille de hachage dont les cellules mesurent
+//		   la tolrance de position: le cot reste linaire tant que les vertices ne s'accumulent pas dans quelques cellules
+{
+	CPM_PROFILE_SCOPE("WeldVerticesByValue");
+
+	const VECTOR3_ARRAY<double> &points = *vertices.points;
+	const unsigned int numVertices = (unsigned int) points.size();
+	const double cellSize = tolerance.position > 0.0 ? tolerance.position : 1.0;
+
+	CPM_VALUE_WELD_STATS stats;
+	stats.inputVertices = numVertices;
+
+	std::unordered_map<unsigned long long, unsigned int> cells; // premier vertex conserv de chaque cl
+	std::vector<unsigned int> next(numVertices, ~0u); // vertex conserv suivant de mme cl
+	std::vector<unsigned int> remap(numVertices);
+	std::vector<unsigned int> kept;
+	cells.reserve(numVertices);
+
+	for(unsigned int i = 0; i < numVertices; i++)
+	{
+		const long long cx = (long long) std::floor(points.x[i] / cellSize);
+		const long long cy = (long long) std::floor(points.y[i] / cellSize);
+		const long long cz = (long long) std::floor(points.z[i] / cellSize);
+
+		unsigned int match = ~0u;
+		for(int dz = -1; dz <= 1 && match == ~0u; dz++)
+		{
+			for(int dy = -1; dy <= 1 && match == ~0u; dy++)
+			{
+				for(int dx = -1; dx <= 1 && match == ~0u; dx++)
+				{
+					std::unordered_map<unsigned long long, unsigned int>::const_iterator cell = cells.find(HashCell(cx + dx, cy + dy, cz + dz));
+					if(cell == cells.end()) continue;
+
+					for(unsigned int j = cell->second; j != ~0u; j = next[j])
+					{
+						CPM_PROFILE_COUNT("valueWeldProbes", 1);
+
+						if(!Near(vertices.points, j, i, tolerance.position)) continue;
+						if(!Near(vertices.normals, j, i, tolerance.normal)) continue;
+						if(!Near(vertices.tangents, j, i, tolerance.normal)) continue;
+						if(!Near(vertices.binormals, j, i, tolerance.normal)) continue;
+						if(vertices.UVs && !(Near(vertices.UVs->u, j, i, tolerance.uv) && Near(vertices.UVs->v, j, i, tolerance.uv))) continue;
+						if(vertices.colors && !(Near(vertices.colors->r, j, i, tolerance.color) && Near(vertices.colors->g, j, i, tolerance.color) &&
+												Near(vertices.colors->b, j, i, tolerance.color) && Near(vertices.colors->a, j, i, tolerance.color))) continue;
+
+						match = j;
+						break;
+					}
+				}
+			}
+		}
+
+		if(match != ~0u)
+		{
+			remap[i] = remap[match];
+			continue;
+		}
+
+		// nouveau vertex conserv, ajout en tte de la liste de sa cellule
+		remap[i] = (unsigned int) kept.size();
+		kept.push_back(i);
+
+		std::pair<std::unordered_map<unsigned long long, unsigned int>::iterator, bool> cell = cells.insert(std::make_pair(HashCell(cx, cy, cz), i));
+		if(!cell.second)
+		{
+			next[i] = cell.first->second;
+			cell.first->second = i;
+		}
+	}
+
+	stats.outputVertices = (unsigned int) kept.size();
+	if(stats.outputVertices == numVertices) return stats;
+
+	for(size_t t = 0; t < triangles.size(); t++) triangles[t] = remap[triangles[t]];
+
+	Compact(vertices.points, kept);
+	Compact(vertices.normals, kept);
+	Compact(vertices.tangents, kept);
+	Compact(vertices.binormals, kept);
+	if(vertices.UVs) {
+		Compact(vertices.UVs->u, kept);
+		Compact(vertices.UVs->v, kept);
+	}
+	if(vertices.colors) {
+		Compact(vertices.colors->r, kept);
+		Compact(vertices.colors->g, kept);
+		Compact(vertices.colors->b, kept);
+		Compact(vertices.colors->a, kept);
+	}
+
+	return stats;
+}
+
+CPM_VALUE_WELD_STATS WeldMeshByValue(CPM_MESH_DATA &mesh, const CPM_WELD_TOLERANCE &tolerance)
+{
+	ASSEMBLY_OUTPUT vertices;
+	vertices.points = &mesh.points;
+	if(mesh.normals.size())		vertices.normals = &mesh.normals;
+	if(mesh.tangents.size()) {
+		vertices.tangents = &mesh.tangents;
+		vertices.binormals = &mesh.binormals;
+	}
+	if(mesh.UVs.size())			vertices.UVs = &mesh.UVs;
+	if(mesh.colors.size())		vertices.colors = &mesh.colors;
+
+	return WeldVerticesByValue(vertices, mesh.triangles, tolerance);
+}
@@ -0,0 +1,44 @@
+#ifndef CPM_VALUE_WELDER_H_INCLUDED
+#define CPM_VALUE_WELDER_H_INCLUDED
+
+#include <vector>
+
+#include "CPMMeshAssembler.h"
+
+struct CPM_MESH_DATA;
+
+//
+//	Fusion des vertices assembls d'aprs leurs valeurs et non plus leurs indices Maya
+//	les coutures entre coquilles spares (kitbash, meshes combins) ont des points distincts mais des valeurs identiques:
+//	deux vertices sont fusionns quand leurs positions et chacun de leurs attributs diffrent de moins que la tolrance
+//
+struct CPM_WELD_TOLERANCE
+{
+	CPM_WELD_TOLERANCE() : position(1e-4), normal(1e-3f), uv(1e-5f), color(1.0f / 1024.0f) {}
+
+	double	position;	// cart maximal par composante, dans l'unit de la scne; 0 = positions identiques
+	float	normal;		// normales, tangentes et binormales
+	float	uv;
+	float	color;
+};
+
+struct CPM_VALUE_WELD_STATS
+{
+	CPM_VALUE_WELD_STATS() : inputVertices(0), outputVertices(0) {}
+
+	double reduction() const { return inputVertices ? 1.0 - (double) outputVertices / inputVertices : 0.0; } // fraction de vertices supprims
+
+	unsigned int	inputVertices;
+	unsigned int	outputVertices;
+};
+
+// tolrance utilise par l'option CPM_EXPORT_WELD_BY_VALUE
+const CPM_WELD_TOLERANCE &GetWeldTolerance();
+void SetWeldTolerance(const CPM_WELD_TOLERANCE &tolerance);
+
+// fusionne les vertices de mme valeur, compacte les tableaux (NULL si l'attribut n'est pas export) et renumrote les triangles
+// les vertices conservs restent dans l'ordre de leur premire occurrence
+CPM_VALUE_WELD_STATS WeldVerticesByValue(ASSEMBLY_OUTPUT &vertices, std::vector<unsigned int> &triangles, const CPM_WELD_TOLERANCE &tolerance);
+CPM_VALUE_WELD_STATS WeldMeshByValue(CPM_MESH_DATA &mesh, const CPM_WELD_TOLERANCE &tolerance);
+
+#endif // CPM_VALUE_WELDER_H_INCLUDED
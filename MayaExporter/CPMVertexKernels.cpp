@@ -0,0 +1,104 @@
+#include "CPMVertexKernels.h"
+#include "CPMSimd.h"
+
+//
+//	Traitements vectoriels sur des tableaux contigus
+//	chaque fonction traite 4 (ou 2) lments par itration puis termine les lments restants un par un
+//
+void NegateArray(float *values, size_t count)
+{
+	size_t i = 0;
+
+#ifdef CPM_USE_SSE2
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	for(; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(values + i, _mm_xor_ps(_mm_loadu_ps(values + i), signMask));
+	}
+#endif
+
+	for(; i < count; i++) values[i] = -values[i];
+}
+
+void NegateArray(double *values, size_t count)
+{
+	size_t i = 0;
+
+#ifdef CPM_USE_SSE2
+	const __m128d signMask = _mm_set1_pd(-0.0);
+	for(; i + 2 <= count; i += 2)
+	{
+		_mm_storeu_pd(values + i, _mm_xor_pd(_mm_loadu_pd(values + i), signMask));
+	}
+#endif
+
+	for(; i < count; i++) values[i] = -values[i];
+}
+
+void InvertV(float *v, size_t count)
+// Rsum: dplace l'origine du repre UV en haut  gauche: v = 1 - v
+{
+	size_t i = 0;
+
+#ifdef CPM_USE_SSE2
+	const __m128 one = _mm_set1_ps(1.0f);
+	for(; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(v + i, _mm_sub_ps(one, _mm_loadu_ps(v + i)));
+	}
+#endif
+
+	for(; i < count; i++) v[i] = 1.0f - v[i];
+}
+
+void SwapWinding(unsigned int *triangles, size_t numTriangles)
+// Rsum: inverse le sens de parcours des triangles: (a, b, c) -> (a, c, b)
+{
+	size_t i = 0;
+
+#ifdef CPM_USE_SSE2
+	// 4 triangles = 12 indices = 3 registres:
+	// [a0 b0 c0 a1] [b1 c1 a2 b2] [c2 a3 b3 c3] -> [a0 c0 b0 a1] [c1 b1 a2 c2] [b2 a3 c3 b3]
+	for(; i + 4 <= numTriangles; i += 4)
+	{
+		float *p = (float*) (triangles + 3*i);
+
+		const __m128i r0 = _mm_loadu_si128((const __m128i*) p);
+		const __m128 r1 = _mm_loadu_ps(p + 4);
+		const __m128 r2 = _mm_loadu_ps(p + 8);
+
+		const __m128i o0 = _mm_shuffle_epi32(r0, _MM_SHUFFLE(3, 1, 2, 0));
+
+		const __m128 t = _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(0, 0, 2, 2));
+		const __m128 o1 = _mm_shuffle_ps(r1, t, _MM_SHUFFLE(2, 0, 0, 1));
+
+		const __m128 u = _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(1, 1, 3, 3));
+		const __m128 o2 = _mm_shuffle_ps(u, r2, _MM_SHUFFLE(2, 3, 2, 0));
+
+		_mm_storeu_si128((__m128i*) p, o0);
+		_mm_storeu_ps(p + 4, o1);
+		_mm_storeu_ps(p + 8, o2);
+	}
+#endif
+
+	for(; i < numTriangles; i++)
+	{
+		const unsigned int b = triangles[3*i + 1];
+		triangles[3*i + 1] = triangles[3*i + 2];
+		triangles[3*i + 2] = b;
+	}
+}
+
+void ApplyAxisConversion(const AXIS_CONVERSION &conversion, UV_ARRAY &UVs)
+{
+	if(UVs.size() == 0) return;
+
+	if(conversion.invertV) InvertV(&UVs.v[0], UVs.size());
+}
+
+void ApplyAxisConversion(const AXIS_CONVERSION &conversion, std::vector<unsigned int> &triangles)
+{
+	if(triangles.size() < 3) return;
+
+	if(conversion.swapWinding) SwapWinding(&triangles[0], triangles.size() / 3);
+}
@@ -0,0 +1,40 @@
+#ifndef CPM_VERTEX_KERNELS_H_INCLUDED
+#define CPM_VERTEX_KERNELS_H_INCLUDED
+
+#include <vector>
+
+#include "CPMMeshBuffers.h"
+
+//
+//	Conversion du repre vers celui du moteur, rsolue une fois  partir des options d'exportation
+//	les traitements s'appliquent ensuite tableau par tableau, sans test lment par lment
+//
+struct AXIS_CONVERSION
+{
+	AXIS_CONVERSION() : invertV(false), swapWinding(false) { invert[0] = invert[1] = invert[2] = false; }
+
+	bool	invert[3];		// inversion des axes x, y et z
+	bool	invertV;		// v = 1 - v
+	bool	swapWinding;	// (a, b, c) -> (a, c, b)
+};
+
+void NegateArray(float *values, size_t count);
+void NegateArray(double *values, size_t count);
+void InvertV(float *v, size_t count);
+void SwapWinding(unsigned int *triangles, size_t numTriangles);
+
+template<typename T>
+void ApplyAxisConversion(const AXIS_CONVERSION &conversion, VECTOR3_ARRAY<T> &vectors)
+// Rsum: inverse les axes demands d'un tableau de positions ou de vecteurs
+{
+	if(vectors.size() == 0) return;
+
+	if(conversion.invert[0]) NegateArray(&vectors.x[0], vectors.size());
+	if(conversion.invert[1]) NegateArray(&vectors.y[0], vectors.size());
+	if(conversion.invert[2]) NegateArray(&vectors.z[0], vectors.size());
+}
+
+void ApplyAxisConversion(const AXIS_CONVERSION &conversion, UV_ARRAY &UVs);
+void ApplyAxisConversion(const AXIS_CONVERSION &conversion, std::vector<unsigned int> &triangles);
+
+#endif // CPM_VERTEX_KERNELS_H_INCLUDED
@@ -0,0 +1,109 @@
+#include <cstring>
+
+#include "CPMVertexLayout.h"
+#include "CPMExportOptions.h"
+#include "CPMScalar.h"
+
+//
+//	Format des vertices
+//
+static void AddAttribute(CPM_VERTEX_LAYOUT &layout, const char *tag, CPM_SCALAR_TYPE type, unsigned int components, unsigned int &maxAlignment)
+{
+	const unsigned int size = ScalarTypeSize(type);
+	const unsigned int alignment = size > 4 ? size : 4;
+
+	CPM_VERTEX_ATTRIBUTE attribute;
+	memcpy(attribute.tag, tag, 4);
+	attribute.scalarType = (unsigned char) type;
+	attribute.components = (unsigned char) components;
+	attribute.offset = (unsigned short) ((layout.stride + alignment - 1) / alignment * alignment);
+	layout.attributes.push_back(attribute);
+
+	layout.stride = attribute.offset + components * size;
+	if(alignment > maxAlignment) maxAlignment = alignment;
+}
+
+CPM_VERTEX_LAYOUT GetVertexLayout(unsigned int exportOptions)
+{
+	const CPM_PRECISION precision = GetExportPrecision(exportOptions);
+	CPM_VERTEX_LAYOUT layout;
+	unsigned int maxAlignment = 4;
+
+	AddAttribute(layout, CPM_TAG_VERTICES, precision.positions, 3, maxAlignment);
+	if(exportOptions & CPM_EXPORT_NORMALS) AddAttribute(layout, CPM_TAG_NORMALS, precision.normals, 3, maxAlignment);
+	if(exportOptions & CPM_EXPORT_TGT_BINORMALS)
+	{
+		AddAttribute(layout, CPM_TAG_TANGENTS, precision.tangents, 3, maxAlignment);
+		AddAttribute(layout, CPM_TAG_BINORMALS, precision.binormals, 3, maxAlignment);
+	}
+	if(exportOptions & CPM_EXPORT_UVS) AddAttribute(layout, CPM_TAG_UVS, precision.uvs, 2, maxAlignment);
+	if(exportOptions & CPM_EXPORT_COLORS) AddAttribute(layout, CPM_TAG_COLORS, precision.colors, 4, maxAlignment);
+
+	layout.stride = (layout.stride + maxAlignment - 1) / maxAlignment * maxAlignment;
+	return layout;
+}
+
+
+//
+//	Entrelacement
+//
+template<typename T, typename S>
+static void StoreAttribute(unsigned char *dst, unsigned int stride, const CPM_VERTEX_SOURCE &source, unsigned int components, size_t first, size_t count)
+{
+	for(unsigned int c = 0; c < components; c++)
+	{
+		const S *values = (const S*) source.components[c] + first * source.step;
+		unsigned char *out = dst + c * sizeof(T);
+		for(size_t i = 0; i < count; i++, out += stride)
+		{
+			const T value = SCALAR_TRAITS<T>::convert(values[i * source.step]);
+			memcpy(out, &value, sizeof(T));
+		}
+	}
+}
+
+template<typename S>
+static void StoreAttributeFrom(unsigned char *dst, unsigned int stride, const CPM_VERTEX_ATTRIBUTE &attribute, const CPM_VERTEX_SOURCE &source, size_t first, size_t count)
+{
+	switch(attribute.scalarType)
+	{
+		case CPM_SCALAR_DOUBLE:		StoreAttribute<double, S>(dst, stride, source, attribute.components, first, count); break;
+		case CPM_SCALAR_HALF:		StoreAttribute<HALF, S>(dst, stride, source, attribute.components, first, count); break;
+		default:					StoreAttribute<float, S>(dst, stride, source, attribute.components, first, count); break;
+	}
+}
+
+void InterleaveVertices(const CPM_VERTEX_LAYOUT &layout, const CPM_VERTEX_SOURCE *sources, size_t first, size_t count, unsigned char *dst)
+{
+	memset(dst, 0, count * layout.stride);
+
+	for(size_t a = 0; a < layout.attributes.size(); a++)
+	{
+		const CPM_VERTEX_ATTRIBUTE &attribute = layout.attributes[a];
+		if(!sources[a].components[0]) continue;
+
+		if(sources[a].type == CPM_SCALAR_DOUBLE) StoreAttributeFrom<double>(dst + attribute.offset, layout.stride, attribute, sources[a], first, count);
+		else StoreAttributeFrom<float>(dst + attribute.offset, layout.stride, attribute, sources[a], first, count);
+	}
+}
+
+
+//
+//	Sections
+//
+void WriteVertexFormat(std::ostream &os, const CPM_VERTEX_LAYOUT &layout, unsigned int alignment)
+{
+	CPM_VERTEX_FORMAT format;
+	format.stride = layout.stride;
+	format.alignment = alignment;
+
+	const unsigned int count = (unsigned int) layout.attributes.size();
+	WriteSectionHeader(os, CPM_TAG_VERTEX_FORMAT, count, CPM_SCALAR_NONE, 0, sizeof(format) + count * sizeof(CPM_VERTEX_ATTRIBUTE));
+	WriteBinary(os, format);
+	if(count) os.write((const char*) &layout.attributes[0], count * sizeof(CPM_VERTEX_ATTRIBUTE));
+}
+
+void BeginVertexBuffer(std::ostream &os, const CPM_VERTEX_LAYOUT &layout, unsigned int count, unsigned int alignment)
+{
+	WriteAlignedSectionHeader(os, alignment, CPM_TAG_VERTEX_BUFFER, count, CPM_SCALAR_NONE, 0, (unsigned long long) count * layout.stride);
+}
@@ -0,0 +1,47 @@
+#ifndef CPM_VERTEX_LAYOUT_H_INCLUDED
+#define CPM_VERTEX_LAYOUT_H_INCLUDED
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "CPMFormat.h"
+
+//
+//	Vertices entrelacs (option CPM_EXPORT_INTERLEAVED, format binaire)
+//	les attributs exports sont rangs dans une seule structure par vertex, dans l'ordre des sections qu'ils remplacent:
+//	chaque attribut commence  un multiple de 4 octets (un vecteur de 3 demi-flottants occupe donc 8 octets) et la taille du vertex
+//	est un multiple de l'alignement de son plus grand scalaire, pour que le tampon soit utilisable tel quel par le GPU
+//
+struct CPM_VERTEX_LAYOUT
+{
+	CPM_VERTEX_LAYOUT() : stride(0) {}
+
+	unsigned int						stride;
+	std::vector<CPM_VERTEX_ATTRIBUTE>	attributes;
+};
+
+// attributs exports avec ces options, dans la prcision choisie par GetExportPrecision
+CPM_VERTEX_LAYOUT GetVertexLayout(unsigned int exportOptions);
+
+struct CPM_VERTEX_SOURCE
+// Valeurs d'un attribut pour un bloc de vertices: composante c de l'lment i en components[c][i * step]
+{
+	CPM_VERTEX_SOURCE() : type(CPM_SCALAR_FLOAT), step(1) { components[0] = components[1] = components[2] = components[3] = NULL; }
+
+	CPM_SCALAR_TYPE		type;			// CPM_SCALAR_FLOAT ou CPM_SCALAR_DOUBLE
+	const void			*components[4];
+	size_t				step;
+};
+
+// convertit les vertices [first, first + count) dans dst (count * stride octets), une source par attribut de layout
+// un attribut sans valeurs (components[0] == NULL) reste  zro
+void InterleaveVertices(const CPM_VERTEX_LAYOUT &layout, const CPM_VERTEX_SOURCE *sources, size_t first, size_t count, unsigned char *dst);
+
+// crit la section CPM_TAG_VERTEX_FORMAT, puis l'en-tte de CPM_TAG_VERTEX_BUFFER et son remplissage:
+// l'appelant crit ensuite exactement count * layout.stride octets
+// alignment = GetSectionAlignment(exportOptions): le tampon est toujours align, quelle que soit sa taille
+void WriteVertexFormat(std::ostream &os, const CPM_VERTEX_LAYOUT &layout, unsigned int alignment);
+void BeginVertexBuffer(std::ostream &os, const CPM_VERTEX_LAYOUT &layout, unsigned int count, unsigned int alignment);
+
+#endif // CPM_VERTEX_LAYOUT_H_INCLUDED
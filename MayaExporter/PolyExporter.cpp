@@ -1,3 +1,5 @@
+#include <cstdio>
+
 #include <maya/MGlobal.h>
 #include <maya/MString.h>
 #include <maya/MItDag.h>
@@ -5,13 +7,20 @@
 #include <maya/MItSelectionList.h>
 #include <maya/MDagPath.h>
 #include <maya/MFnDagNode.h>
+#include <maya/MFnMesh.h>
 #include <maya/MPlug.h>
+#include <maya/MObjectHandle.h>
 
 #include <maya/MIOStream.h>
 #include <maya/MFStream.h>
 
 #include "PolyExporter.h"
 #include "PolyWriter.h"
+#include "CPMChunkedStream.h"
+#include "CPMChecksum.h"
+#include "CPMProfiler.h"
+#include "CPMDagVisibility.h"
+#include "CPMExportScheduler.h"
 
 
 PolyExporter::PolyExporter()
@@ -77,9 +86,13 @@ MStatus PolyExporter::writer(const MFileObject &file, const MString &optionStrin
 	}
 	
 
+#ifdef CPM_PROFILING
+	CPMProfiler::BeginSession();
+#endif
+
 	// on cre le fichier
 	const MString fileName = file.fullName();
-	ofstream newFile(fileName.asChar(), ios::out);
+	ofstream newFile(fileName.asChar(), isBinary() || isCompressed() ? ios::out | ios::binary : ios::out);
 	if(!newFile)
 	{
 		MGlobal::displayError(fileName + " n'a pas pu tre ouvert pour l'criture");
@@ -88,38 +101,83 @@ MStatus PolyExporter::writer(const MFileObject &file, const MString &optionStrin
 	}
 	newFile.setf(ios::unitbuf);
 
+	// en mode compress, les meshes sont crits dans un conteneur dont les blocs sont compresss pendant l'exportation
+	CPMChunkedOStream *container = NULL;
+	if(isCompressed())
+	{
+		if(!IsCodecAvailable(getCodec()))
+		{
+			MGlobal::displayWarning(MString("Compression ") + CodecName(getCodec()) + " indisponible: les blocs ne seront pas compresss");
+		}
+		container = new CPMChunkedOStream(newFile, getCodec());
+	}
+
+	// un fichier binaire non compress passe par un flux qui calcule les sommes de contrle de ses blocs pendant l'criture
+	// (celles du conteneur compress sont dans son index)
+	CPMChecksumOStream *checksums = isBinary() && !isCompressed() ? new CPMChecksumOStream(newFile) : NULL;
+	ostream &os = container ? (ostream&) *container : checksums ? (ostream&) *checksums : (ostream&) newFile;
+
 	// on crit le header
-	writeHeader(newFile);
+	writeHeader(os);
+
+	// on exporte les meshes, crits dans l'ordre de m_polyMeshes
+	MDagPath failedMesh;
+	if(processPolyMeshes(os, failedMesh) == MS::kFailure)
+	{
+		MString meshName = failedMesh.fullPathName(&status);
+		MGlobal::displayError("Echec lors de l'exportation du mesh " + meshName);
+
+		delete container;
+		delete checksums;
 
-	// on exporte les meshes un  un
-	for(std::list<MDagPath>::iterator it = m_polyMeshes.begin(); it != m_polyMeshes.end(); it++)
+		newFile.flush();
+		newFile.close();
+
+		remove(fileName.asChar());
+		
+		clear();
+		return MS::kFailure;
+	}
+
+	// on ecrit le footer et on ferme le fichier
+	writeFooter(os);
+	delete checksums; // transmet ses derniers octets au fichier
+
+	if(container)
 	{
-		if(processPolyMesh(*it, newFile) == MS::kFailure)
+		const bool closed = container->close();
+		const CPM_CONTAINER_STATS stats = container->getStats();
+		delete container;
+
+		if(!closed)
 		{
-			MString meshName = it->fullPathName(&status);
-			MGlobal::displayError("Echec lors de l'exportation du mesh " + meshName);
+			MGlobal::displayError(fileName + ": erreur lors de l'criture du conteneur compress");
 
-			newFile.flush();
 			newFile.close();
-
 			remove(fileName.asChar());
-			
+
 			clear();
 			return MS::kFailure;
 		}
-		else
-		{
-			MString meshName = it->fullPathName(&status);
-			MGlobal::displayInfo("Mesh " + meshName + " export");
-		}
-	}
 
-	// on ecrit le footer et on ferme le fichier
-	writeFooter(newFile);
+		const double megabytes = stats.rawSize / (1024.0 * 1024.0);
+		char info[256];
+		sprintf(info, "Compression %s: %.2f Mo -> %.2f Mo en %u blocs, ratio %.2f, %.1f Mo/s", CodecName(getCodec()), megabytes,
+			stats.compressedSize / (1024.0 * 1024.0), stats.chunkCount, stats.compressedSize ? (double) stats.rawSize / stats.compressedSize : 0.0,
+			stats.seconds > 0.0 ? megabytes / stats.seconds : 0.0);
+		MGlobal::displayInfo(info);
+	}
 
 	newFile.flush();
 	newFile.close();
 
+#ifdef CPM_PROFILING
+	// la trace est crite  ct du fichier export
+	std::vector<std::string> summary;
+	CPMProfiler::EndSession((fileName + ".trace.json").asChar(), summary);
+	for(size_t i = 0; i < summary.size(); i++) MGlobal::displayInfo(summary[i].c_str());
+#endif
+
 	clear();
 
 	return MS::kSuccess;
@@ -154,35 +212,74 @@ void PolyExporter::clear()
 	m_polyMeshes.clear();
 }
 
-MStatus PolyExporter::getSceneMeshesDagPaths()
-// Rsum:	enregistre les noms de tous les meshes visibles de la scne pour les exporter
+//
+//	Parcours de la scne pour CollectVisibleShapes: MItDag sur tous les noeuds DAG, lagu sous les noeuds cachs
+//
+struct MOBJECT_HANDLE_HASH
 {
-	MStatus status;
+	size_t operator()(const MObjectHandle &handle) const { return handle.hashCode(); }
+};
 
-	MItDag itDag(MItDag::kDepthFirst, MFn::kMesh, &status);
-	if(status == MS::kFailure)
+class MAYA_DAG_ITERATOR
+{
+	public:
+	MAYA_DAG_ITERATOR(PolyExporter &exporter, MStatus &status) : m_exporter(exporter), m_itDag(MItDag::kDepthFirst, MFn::kInvalid, &status), m_status(MS::kSuccess) {}
+
+	bool isDone() const { return m_status == MS::kFailure || m_itDag.isDone(); }
+	void next() { m_itDag.next(); }
+	void prune() { m_itDag.prune(); }
+	bool isShape() const { return m_itDag.currentItem().hasFn(MFn::kMesh); }
+	MObjectHandle node() const { return MObjectHandle(m_itDag.currentItem()); }
+
+	unsigned int state()
 	{
-		MGlobal::displayError("itDag");
-		return MS::kFailure;
+		// le monde (profondeur 0) n'a pas d'attribut de visibilit
+		if(m_itDag.depth() == 0) return 0;
+		MStatus status;
+		const unsigned int visibility = m_exporter.getNodeVisibility(m_itDag.currentItem(), status);
+		if(status == MS::kFailure) m_status = MS::kFailure;
+		return visibility;
 	}
 
-	for(; !itDag.isDone(); itDag.next())
+	MDagPath path()
 	{
 		MDagPath dagPath;
-
-		// On rcupre le chemin d'accs au mesh
-		if(itDag.getPath(dagPath) == MS::kFailure)
+		if(m_itDag.getPath(dagPath) == MS::kFailure)
 		{
 			MGlobal::displayError("MItDag::getPath");
-			return MS::kFailure;
+			m_status = MS::kFailure;
 		}
+		return dagPath;
+	}
 
-		if(isVisible(dagPath, status) == true && status == MS::kSuccess)
-		{
-			m_polyMeshes.push_back(dagPath);
-		}
+	MStatus status() const { return m_status; }
+
+	protected:
+	PolyExporter	&m_exporter;
+	MItDag			m_itDag;
+	MStatus			m_status;
+};
+
+MStatus PolyExporter::getSceneMeshesDagPaths()
+// Rsum:	enregistre les chemins de tous les meshes visibles de la scne pour les exporter
+//			un mesh sous un transform cach ou dans un calque cach n'est pas visible, les objets intermdiaires non plus
+{
+	CPM_PROFILE_SCOPE("PolyExporter::getSceneMeshesDagPaths");
+	MStatus status;
+
+	MAYA_DAG_ITERATOR itDag(*this, status);
+	if(status == MS::kFailure)
+	{
+		MGlobal::displayError("itDag");
+		return MS::kFailure;
 	}
 
+	CPMVisibilityCache<MObjectHandle, MOBJECT_HANDLE_HASH> cache;
+	std::vector<MDagPath> meshes;
+	CollectVisibleShapes(itDag, cache, meshes);
+	if(itDag.status() == MS::kFailure) return MS::kFailure;
+
+	m_polyMeshes.insert(m_polyMeshes.end(), meshes.begin(), meshes.end());
 	return MS::kSuccess;
 }
 
@@ -247,63 +344,143 @@ void PolyExporter::writeFooter(ostream &os)
 	os << "";
 }
 
-MStatus PolyExporter::processPolyMesh(const MDagPath &dagPath, ostream &os)
-// Rsum:	exporte le mesh dsign par dagPath
-// Args:	dagPath - dsigne le mesh
-//			os - sortie
+bool PolyExporter::isBinary() const
+// Rsum: retourne true si le fichier doit tre ouvert en mode binaire
 {
-	MStatus status;
+	return false;
+}
 
-	PolyWriter *writer = createPolyWriter(dagPath, status);
-	if(status == MS::kFailure)
-	{
-		delete writer;
-		return MS::kFailure;
-	}
+bool PolyExporter::isCompressed() const
+// Rsum: retourne true si le fichier doit tre crit dans un conteneur compress par blocs (voir CPMChunkedStream.h)
+{
+	return false;
+}
 
-	if(writer->extractGeometry() == MS::kFailure)
+CPM_CODEC PolyExporter::getCodec() const
+// Rsum: codec utilis pour les blocs du conteneur quand isCompressed() retourne true
+{
+	return CPM_CODEC_STORE;
+}
+
+MStatus PolyExporter::processPolyMeshes(ostream &os, MDagPath &failedMesh)
+// Rsum:	exporte les meshes de m_polyMeshes
+//			l'extraction (API Maya) et l'criture restent sur ce thread, le traitement des meshes extraits est confi au pool;
+//			les meshes sont extraits du plus gros au plus petit dans la limite du budget mmoire et crits dans l'ordre de m_polyMeshes
+// Args:	os - sortie
+//			failedMesh - mesh dont l'exportation a chou (sortie)
+{
+	CPM_PROFILE_SCOPE("PolyExporter::processPolyMeshes");
+
+	const std::vector<MDagPath> dagPaths(m_polyMeshes.begin(), m_polyMeshes.end());
+	std::vector<PolyWriter*> writers(dagPaths.size(), NULL);
+
+	CPMExportScheduler scheduler(GetExportMemoryBudget());
+	for(size_t i = 0; i < dagPaths.size(); i++) scheduler.add(estimateMeshMemory(dagPaths[i]));
+
+	size_t failed = 0;
+	const bool exported = RunScheduledExport(scheduler,
+		[&](size_t mesh) -> bool
+		{
+			CPM_PROFILE_SCOPE("PolyExporter::extractMesh");
+			MStatus status;
+			writers[mesh] = createPolyWriter(dagPaths[mesh], status);
+			if(status == MS::kFailure) return false;
+
+			return writers[mesh]->extractGeometry() != MS::kFailure;
+		},
+		[&](size_t mesh) -> bool
+		{
+			return writers[mesh]->processGeometry() != MS::kFailure;
+		},
+		[&](size_t mesh) -> bool
+		{
+			// les compteurs du mesh couvrent son criture: son extraction et son traitement se mlent  ceux des autres meshes
+#ifdef CPM_PROFILING
+			CPMProfiler::BeginMesh(dagPaths[mesh].fullPathName().asChar());
+#endif
+			MStatus status;
+			{
+				CPM_PROFILE_SCOPE("PolyWriter::writeToFile");
+				status = writers[mesh]->writeToFile(os);
+			}
+#ifdef CPM_PROFILING
+			CPMProfiler::EndMesh();
+#endif
+			if(status == MS::kFailure) return false;
+
+			delete writers[mesh];
+			writers[mesh] = NULL;
+
+			MGlobal::displayInfo("Mesh " + dagPaths[mesh].fullPathName() + " export");
+			return true;
+		},
+		failed);
+
+	// les meshes lancs sont termins au retour de RunScheduledExport
+	for(size_t i = 0; i < writers.size(); i++) delete writers[i];
+
+	const CPM_SCHEDULER_STATS &stats = scheduler.getStats();
+	if(stats.deferred || stats.forced)
 	{
-		delete writer;
-		return MS::kFailure;
+		char info[256];
+		sprintf(info, "Budget mmoire de l'exportation: %u lancements retards, %u meshes hors budget, %.1f Mo au plus haut (estimation)",
+			stats.deferred, stats.forced, stats.peakMemory / 1048576.0);
+		MGlobal::displayInfo(info);
 	}
 
-	if(writer->writeToFile(os) == MS::kFailure)
+	if(!exported)
 	{
-		delete writer;
+		failedMesh = dagPaths[failed];
 		return MS::kFailure;
 	}
+	return MS::kSuccess;
+}
 
-	if(writer) delete writer;
+unsigned long long PolyExporter::estimateMeshMemory(const MDagPath &dagPath)
+// Rsum: mmoire de travail estime du mesh avant son extraction, sans ses attributs (voir CPMPolyExporter)
+{
+	MStatus status;
+	MFnMesh mesh(dagPath, &status);
+	if(!status) return 0; // l'chec est signal par createPolyWriter
 
-	return MS::kSuccess;
+	return EstimateMeshMemory(mesh.numPolygons(), mesh.numFaceVertices(), 0);
 }
 
-bool PolyExporter::isVisible(const MDagPath &dagPath, MStatus &status)
-// Rsum: dtermine si le mesh reprsent par le chemin dagPath est visible
-// Args: dagPath - chemin d'accs au mesh
+unsigned int PolyExporter::getNodeVisibility(const MObject &node, MStatus &status)
+// Rsum: lit l'tat de visibilit propre d'un noeud DAG, sans tenir compte de ses anctres
+// Args: node - transform ou forme
 //		 status - dtermine si la fonction a chou on non (sortie)
-// Sortie: status
-//		   true si le mesh est visible
-//		   false sinon
+// Sortie: combinaison de CPM_NODE_VISIBILITY, 0 si le noeud est visible
 {
-	MFnDagNode dagNode(dagPath);
+	status = MS::kSuccess;
 
-	if(dagNode.isIntermediateObject()) return true;
+	// seuls les transforms (qui portent les sous-arbres) et les meshes dcident de l'exportation
+	if(!node.hasFn(MFn::kTransform) && !node.hasFn(MFn::kMesh)) return 0;
 
-	MPlug visPlug = dagNode.findPlug("visibility", &status);
-	if(status == MS::kFailure)
-	{
-		MGlobal::displayError("MFnDagNode::findPlug");
-		return false;
-	}
+	MFnDagNode dagNode(node);
+	unsigned int visibility = 0;
+	if(dagNode.isIntermediateObject()) visibility |= CPM_NODE_INTERMEDIATE;
 
-	bool visible;
-	status = visPlug.getValue(visible);
-	if(status == MS::kFailure)
+	const char *plugNames[3] = { "visibility", "overrideEnabled", "overrideVisibility" };
+	bool values[3];
+	for(unsigned int i = 0; i < 3; i++)
 	{
-		MGlobal::displayError("MPlug::getValue");
-		return false;
+		MPlug plug = dagNode.findPlug(plugNames[i], &status);
+		if(status == MS::kFailure)
+		{
+			MGlobal::displayError("MFnDagNode::findPlug");
+			return CPM_NODE_HIDDEN;
+		}
+
+		status = plug.getValue(values[i]);
+		if(status == MS::kFailure)
+		{
+			MGlobal::displayError("MPlug::getValue");
+			return CPM_NODE_HIDDEN;
+		}
 	}
 
-	return visible;
+	if(!values[0]) visibility |= CPM_NODE_HIDDEN;
+	if(values[1] && !values[2]) visibility |= CPM_NODE_OVERRIDE_HIDDEN;
+	return visibility;
 }
\ No newline at end of file
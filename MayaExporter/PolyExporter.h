@@ -3,8 +3,12 @@
 
 #include <list>
 #include <maya/MPxFileTranslator.h>
+#include <maya/MDagPath.h>
+
+#include "CPMCompression.h"
 
 class MDagPath;
+class MObject;
 class PolyWriter;
 
 class PolyExporter : public MPxFileTranslator
@@ -22,6 +26,8 @@ class PolyExporter : public MPxFileTranslator
 	virtual MString defaultExtension() const = 0;
 	virtual MString filter() const;
 
+	virtual unsigned int getNodeVisibility(const MObject &node, MStatus &status); // combinaison de CPM_NODE_VISIBILITY, voir CPMDagVisibility.h
+
 	protected:
 	virtual void clear(); //  appeler avant le retour de la fonction writer: le PolyExporter n'est pas dtruit aprs son appel
 
@@ -32,11 +38,14 @@ class PolyExporter : public MPxFileTranslator
 
 	virtual void writeHeader(ostream &f);
 	virtual void writeFooter(ostream &f);
+	virtual bool isBinary() const;
+	virtual bool isCompressed() const;
+	virtual CPM_CODEC getCodec() const;
 
-	virtual MStatus processPolyMesh(const MDagPath &dagPath, ostream &os);
-	virtual bool isVisible(const MDagPath &dagPath, MStatus &status);
+	virtual MStatus processPolyMeshes(ostream &os, MDagPath &failedMesh);
+	virtual unsigned long long estimateMeshMemory(const MDagPath &dagPath); // voir CPMExportScheduler.h
 
-	virtual PolyWriter *createPolyWriter(const MDagPath &dagPath, MStatus &status) const = 0;
+	virtual PolyWriter *createPolyWriter(const MDagPath &dagPath, MStatus &status) = 0;
 
 	protected:
 	std::list<MDagPath>		m_polyMeshes;
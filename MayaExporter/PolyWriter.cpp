@@ -16,6 +16,11 @@ PolyWriter::~PolyWriter()
 	if(m_mesh) delete m_mesh;
 }
 
+MStatus PolyWriter::processGeometry()
+{
+	return MS::kSuccess;
+}
+
 MObject PolyWriter::findShader(const MObject &setNode)
 {
 	MFnDependencyNode fnNode(setNode);
@@ -11,6 +11,7 @@ class PolyWriter
 	virtual ~PolyWriter();
 
 	virtual MStatus extractGeometry() = 0;
+	virtual MStatus processGeometry(); // entre l'extraction et l'criture, sur un thread du pool: pas d'appel  l'API Maya
 	virtual MStatus writeToFile(ostream &os) = 0;
 
 	virtual MObject findShader(const MObject &setNode);
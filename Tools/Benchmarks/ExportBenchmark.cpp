@@ -0,0 +1,504 @@
+//
+//	Benchmark des tapes de l'exportation sur des meshes synthtiques (MeshGenerator)
+//	assemblage des vertices, remappage des triangles, recopie des attributs, triangles des matriaux, puis chaque mode d'criture
+//	les rsultats sont crits au format JSON pour tre compars d'une version  l'autre
+//
+//	usage: cpmbench_export [-min triangles] [-max triangles] [-mesh grid|sphere|ngons|hardEdges] [-threads n] [-memoryBudget Mo] [-o rsultats.json]
+//	les tailles vont de -min  -max par puissances de 10 (1K  1M par dfaut, jusqu' 100M avec -max 100000000)
+//	la phase streaming exporte le mesh avec CPMStreamingMesh et le budget -memoryBudget (16 Mo par dfaut)
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <streambuf>
+
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+#include "MeshGenerator.h"
+#include "CPMMeshAssembler.h"
+#include "CPMAttributeWriter.h"
+#include "CPMChunkedStream.h"
+#include "CPMChecksum.h"
+#include "CPMStreamingExport.h"
+#include "CPMMeshWriter.h"
+#include "CPMSimd.h"
+#include "CPMParallel.h"
+
+
+//
+//	Comptage des allocations: chaque bloc est prcd de sa taille
+//
+static std::atomic<unsigned long long>	g_allocations(0);
+static std::atomic<long long>			g_heapBytes(0);
+static std::atomic<long long>			g_heapPeak(0);
+
+static void *CountedAlloc(size_t size)
+{
+	void *block = malloc(size + 16);
+	if(!block) throw std::bad_alloc();
+
+	*(size_t*) block = size;
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+	const long long current = g_heapBytes.fetch_add((long long) size, std::memory_order_relaxed) + (long long) size;
+	long long peak = g_heapPeak.load(std::memory_order_relaxed);
+	while(current > peak && !g_heapPeak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+
+	return (char*) block + 16;
+}
+
+static void CountedFree(void *ptr)
+{
+	if(!ptr) return;
+
+	void *block = (char*) ptr - 16;
+	g_heapBytes.fetch_sub((long long) *(size_t*) block, std::memory_order_relaxed);
+	free(block);
+}
+
+void *operator new(size_t size) { return CountedAlloc(size); }
+void *operator new[](size_t size) { return CountedAlloc(size); }
+void *operator new(size_t size, const std::nothrow_t&) noexcept { try { return CountedAlloc(size); } catch(...) { return NULL; } }
+void *operator new[](size_t size, const std::nothrow_t&) noexcept { try { return CountedAlloc(size); } catch(...) { return NULL; } }
+void operator delete(void *ptr) noexcept { CountedFree(ptr); }
+void operator delete[](void *ptr) noexcept { CountedFree(ptr); }
+void operator delete(void *ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { CountedFree(ptr); }
+
+
+//
+//	Sortie qui compte les octets sans les crire
+//
+class NULL_STREAMBUF : public std::streambuf
+{
+	public:
+	NULL_STREAMBUF() : m_bytes(0) { setp(m_buffer, m_buffer + sizeof(m_buffer)); }
+
+	unsigned long long bytes() const { return m_bytes + (pptr() - pbase()); }
+
+	protected:
+	virtual int_type overflow(int_type c)
+	{
+		m_bytes += pptr() - pbase() + 1;
+		setp(m_buffer, m_buffer + sizeof(m_buffer));
+		return traits_type::not_eof(c);
+	}
+
+	virtual std::streamsize xsputn(const char*, std::streamsize n)
+	{
+		m_bytes += n;
+		return n;
+	}
+
+	char				m_buffer[4096];
+	unsigned long long	m_bytes;
+};
+
+
+//
+//	Mesures
+//
+struct PHASE_RESULT
+{
+	double				seconds;
+	unsigned long long	allocations;
+	long long			peakBytes;		// mmoire alloue au-del de celle prsente au dbut de la phase
+	unsigned long long	bytes;			// octets crits pour les phases d'criture
+};
+
+class PHASE_TIMER
+{
+	public:
+	PHASE_TIMER() : m_allocations(g_allocations.load()), m_heap(g_heapBytes.load()), m_start(std::chrono::steady_clock::now())
+	{
+		g_heapPeak = m_heap;
+	}
+
+	PHASE_RESULT stop(unsigned long long bytes = 0) const
+	{
+		PHASE_RESULT result;
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+		result.allocations = g_allocations.load() - m_allocations;
+		result.peakBytes = g_heapPeak.load() - m_heap;
+		result.bytes = bytes;
+		return result;
+	}
+
+	protected:
+	unsigned long long						m_allocations;
+	long long								m_heap;
+	std::chrono::steady_clock::time_point	m_start;
+};
+
+struct BENCH_STATE
+// donnes produites par une phase et utilises par les suivantes, comme dans CPMMeshExtractor
+{
+	CPMVertexWelder				welder;
+	std::vector<unsigned int>	faceVertexIds;		// vertex final de chaque face-vertex
+	std::vector<unsigned int>	triangles;
+
+	VECTOR3_ARRAY<double>		points;
+	VECTOR3_ARRAY<float>		normals;
+	UV_ARRAY					UVs;
+
+	std::vector< std::vector<unsigned int> >	materialTriangles;
+};
+
+static void Weld(const SYNTHETIC_MESH &mesh, CPM_WELD_MODE mode, CPMVertexWelder &welder, std::vector<unsigned int> &faceVertexIds)
+{
+	FACE_VERTEX_IDS ids;
+	ids.count = mesh.numFaceVertices();
+	ids.points = &mesh.faceVertexPoints[0];
+	ids.normals = &mesh.faceVertexNormals[0];
+	ids.uvs = &mesh.faceVertexUVs[0];
+
+	welder.reset(mesh.numPoints);
+	faceVertexIds.resize(ids.count);
+	welder.weld(ids, &faceVertexIds[0], mode);
+}
+
+static void Remap(const SYNTHETIC_MESH &mesh, BENCH_STATE &state)
+{
+	state.triangles.resize(mesh.trianglePoints.size());
+
+	size_t faceVertex = 0;
+	unsigned int triangleVertex = 0;
+	for(size_t p = 0; p < mesh.polygonSizes.size(); p++)
+	{
+		const unsigned int end = triangleVertex + mesh.triangleCounts[p] * 3;
+		RemapPolygonTriangles(&mesh.faceVertexPoints[faceVertex], &state.faceVertexIds[faceVertex], mesh.polygonSizes[p], mesh.trianglePoints,
+							  triangleVertex, end, &state.triangles[0]);
+
+		faceVertex += mesh.polygonSizes[p];
+		triangleVertex = end;
+	}
+}
+
+static void Assemble(const SYNTHETIC_MESH &mesh, BENCH_STATE &state)
+{
+	ASSEMBLY_SOURCE source;
+	source.points = &mesh.points[0];
+	source.normals = &mesh.normals[0];
+	source.u = &mesh.u[0];
+	source.v = &mesh.v[0];
+
+	ASSEMBLY_OUTPUT output;
+	output.points = &state.points;
+	output.normals = &state.normals;
+	output.UVs = &state.UVs;
+
+	state.welder.assemble(source, output);
+}
+
+static void BuildMaterials(const SYNTHETIC_MESH &mesh, BENCH_STATE &state)
+{
+	std::vector<unsigned int> offsets;
+	BuildTriangleOffsets(mesh.triangleCounts, (unsigned int) mesh.triangleCounts.size(), offsets);
+
+	state.materialTriangles.resize(mesh.materialFaces.size());
+	for(size_t m = 0; m < mesh.materialFaces.size(); m++) BuildMaterialTriangleIds(offsets, mesh.materialFaces[m], state.materialTriangles[m]);
+}
+
+template<typename T>
+static void WriteMesh(std::ostream &os, bool binary, const BENCH_STATE &state)
+// Rsum: crit les sections de CPMPolyWriter (triangles, positions, normales, UVs) dans la prcision T
+{
+	const unsigned int options = binary ? CPM_EXPORT_BINARY : 0;
+
+	CPMAttributeWriter<unsigned int> triangles(os, options);
+	triangles.begin("Triangles", CPM_TAG_TRIANGLES, (unsigned int) state.triangles.size() / 3, 3);
+	triangles.writeInterleaved(&state.triangles[0], state.triangles.size() / 3);
+	triangles.end();
+
+	const double *points[3] = { &state.points.x[0], &state.points.y[0], &state.points.z[0] };
+	CPMAttributeWriter<T> vertices(os, options);
+	vertices.begin("Vertices", CPM_TAG_VERTICES, (unsigned int) state.points.size(), 3);
+	vertices.writeArrays(points, state.points.size());
+	vertices.end();
+
+	const float *normals[3] = { &state.normals.x[0], &state.normals.y[0], &state.normals.z[0] };
+	CPMAttributeWriter<T> normalWriter(os, options);
+	normalWriter.begin("Normals", CPM_TAG_NORMALS, (unsigned int) state.normals.size(), 3);
+	normalWriter.writeArrays(normals, state.normals.size());
+	normalWriter.end();
+
+	const float *uvs[2] = { &state.UVs.u[0], &state.UVs.v[0] };
+	CPMAttributeWriter<T> uvWriter(os, options);
+	uvWriter.begin("UVs", CPM_TAG_UVS, (unsigned int) state.UVs.size(), 2);
+	uvWriter.writeArrays(uvs, state.UVs.size());
+	uvWriter.end();
+}
+
+struct OUTPUT_MODE
+{
+	const char		*name;
+	bool			binary;
+	CPM_SCALAR_TYPE	precision;
+	bool			compressed;
+	CPM_CODEC		codec;
+	bool			checksums;	// fichier non compress crit  travers CPMChecksumOStream
+};
+
+static const OUTPUT_MODE g_outputModes[] =
+{
+	{ "textFloat",		false,	CPM_SCALAR_FLOAT,	false,	CPM_CODEC_STORE,	false },
+	{ "textDouble",		false,	CPM_SCALAR_DOUBLE,	false,	CPM_CODEC_STORE,	false },
+	{ "textHalf",		false,	CPM_SCALAR_HALF,	false,	CPM_CODEC_STORE,	false },
+	{ "binaryFloat",	true,	CPM_SCALAR_FLOAT,	false,	CPM_CODEC_STORE,	false },
+	{ "binaryDouble",	true,	CPM_SCALAR_DOUBLE,	false,	CPM_CODEC_STORE,	false },
+	{ "binaryHalf",		true,	CPM_SCALAR_HALF,	false,	CPM_CODEC_STORE,	false },
+	{ "binaryFloatCrc",	true,	CPM_SCALAR_FLOAT,	false,	CPM_CODEC_STORE,	true },
+	{ "binaryFloatLz4",	true,	CPM_SCALAR_FLOAT,	true,	CPM_CODEC_LZ4,		false },
+	{ "binaryFloatZstd",true,	CPM_SCALAR_FLOAT,	true,	CPM_CODEC_ZSTD,		false },
+};
+
+static unsigned long long WriteOutputMode(const OUTPUT_MODE &mode, const BENCH_STATE &state)
+// Rsum: retourne le nombre d'octets crits dans le fichier
+{
+	NULL_STREAMBUF nullBuffer;
+	std::ostream file(&nullBuffer);
+
+	CPMChunkedOStream *container = mode.compressed ? new CPMChunkedOStream(file, mode.codec) : NULL;
+	CPMChecksumOStream *checksums = mode.checksums ? new CPMChecksumOStream(file) : NULL;
+	std::ostream &os = container ? (std::ostream&) *container : checksums ? (std::ostream&) *checksums : file;
+
+	switch(mode.precision)
+	{
+		case CPM_SCALAR_DOUBLE:		WriteMesh<double>(os, mode.binary, state); break;
+		case CPM_SCALAR_HALF:		WriteMesh<HALF>(os, mode.binary, state); break;
+		default:					WriteMesh<float>(os, mode.binary, state); break;
+	}
+
+	delete checksums;
+	if(container)
+	{
+		container->close();
+		delete container;
+	}
+	os.flush();
+
+	return nullBuffer.bytes();
+}
+
+static unsigned long long StreamMesh(const SYNTHETIC_MESH &mesh, CPM_STREAMING_STATS &stats)
+// Rsum: exportation hors mmoire complte (assemblage, fichiers temporaires, criture binaire), retourne le nombre d'octets crits
+{
+	FACE_VERTEX_IDS ids;
+	ids.count = mesh.numFaceVertices();
+	ids.points = &mesh.faceVertexPoints[0];
+	ids.normals = &mesh.faceVertexNormals[0];
+	ids.uvs = &mesh.faceVertexUVs[0];
+
+	ASSEMBLY_SOURCE arrays;
+	arrays.points = &mesh.points[0];
+	arrays.normals = &mesh.normals[0];
+	arrays.u = &mesh.u[0];
+	arrays.v = &mesh.v[0];
+
+	CPMArrayVertexSource vertices(arrays);
+	STREAMING_SOURCE source;
+	source.vertices = &vertices;
+	source.numPoints = mesh.numPoints;
+	source.numNormals = (unsigned int) mesh.normals.size() / 3;
+	source.numUVs = (unsigned int) mesh.u.size();
+
+	NULL_STREAMBUF nullBuffer;
+	std::ostream file(&nullBuffer);
+
+	CPM_MESH_DATA properties;
+	CPMStreamingMesh streamingMesh(CPM_EXPORT_NORMALS | CPM_EXPORT_UVS | CPM_EXPORT_BINARY);
+	CPMFaceVertexStream polygons(ids, mesh.polygonSizes);
+	if(!streamingMesh.build(polygons, source) || !streamingMesh.write(file, properties))
+	{
+		fprintf(stderr, "cpmbench_export: %s\n", streamingMesh.getError().c_str());
+		exit(1);
+	}
+
+	stats = streamingMesh.getStats();
+	return nullBuffer.bytes();
+}
+
+
+//
+//	Rsultats JSON
+//
+class JSON_RESULTS
+{
+	public:
+	JSON_RESULTS() : m_first(true) {}
+
+	void add(const SYNTHETIC_MESH &mesh, const BENCH_STATE &state, const char *phase, const char *unit, double items, const PHASE_RESULT &result)
+	{
+		char line[1024];
+		sprintf(line, "%s    {\"mesh\": \"%s\", \"triangles\": %lu, \"faceVertices\": %lu, \"vertices\": %u, \"phase\": \"%s\", \"seconds\": %.6f, "
+			"\"throughput\": %.3f, \"unit\": \"%s\", \"bytes\": %llu, \"allocations\": %llu, \"peakBytes\": %lld}",
+			m_first ? "" : ",\n", mesh.name.c_str(), (unsigned long) mesh.numTriangles(), (unsigned long) mesh.numFaceVertices(), state.welder.getNumVertices(),
+			phase, result.seconds, result.seconds > 0.0 ? items / result.seconds * 1e-6 : 0.0, unit, result.bytes, result.allocations, result.peakBytes);
+		m_text += line;
+		m_first = false;
+
+		fprintf(stderr, "%-10s %10lu tris  %-16s %10.3f ms %10.1f %-7s %10llu allocs %10.2f MiB peak\n", mesh.name.c_str(), (unsigned long) mesh.numTriangles(),
+			phase, result.seconds * 1000.0, result.seconds > 0.0 ? items / result.seconds * 1e-6 : 0.0, unit, result.allocations, result.peakBytes / (1024.0 * 1024.0));
+	}
+
+	std::string finish() const
+	{
+		long maxRss = 0;
+#ifdef __unix__
+		struct rusage usage;
+		if(getrusage(RUSAGE_SELF, &usage) == 0) maxRss = usage.ru_maxrss;
+#endif
+		char header[256];
+		sprintf(header, "{\n  \"benchmark\": \"cpmbench_export\",\n  \"simd\": \"%s\",\n  \"threads\": %u,\n  \"maxRssKiB\": %ld,\n  \"results\": [\n",
+			SimdLevelName(GetSimdLevel()), GetWorkerCount(), maxRss);
+		return header + m_text + "\n  ]\n}\n";
+	}
+
+	protected:
+	std::string		m_text;
+	bool			m_first;
+};
+
+static void RunMesh(const SYNTHETIC_MESH &mesh, JSON_RESULTS &results)
+{
+	BENCH_STATE state;
+	const double faceVertices = (double) mesh.numFaceVertices(), triangles = (double) mesh.numTriangles();
+
+	// les trois modes d'assemblage doivent donner exactement la mme numrotation
+	CPMVertexWelder serialWelder;
+	std::vector<unsigned int> serialIds;
+	PHASE_TIMER serialTimer;
+	Weld(mesh, CPM_WELD_SERIAL, serialWelder, serialIds);
+	results.add(mesh, state, "weldSerial", "Mfv/s", faceVertices, serialTimer.stop());
+
+	PHASE_TIMER parallelTimer;
+	Weld(mesh, CPM_WELD_PARALLEL, state.welder, state.faceVertexIds);
+	results.add(mesh, state, "weldParallel", "Mfv/s", faceVertices, parallelTimer.stop());
+
+	if(serialIds != state.faceVertexIds || serialWelder.getNumVertices() != state.welder.getNumVertices())
+	{
+		fprintf(stderr, "cpmbench_export: parallel welding differs from serial welding on %s\n", mesh.name.c_str());
+		exit(1);
+	}
+
+	CPMVertexWelder radixWelder;
+	std::vector<unsigned int> radixIds;
+	PHASE_TIMER radixTimer;
+	Weld(mesh, CPM_WELD_RADIX_SORT, radixWelder, radixIds);
+	results.add(mesh, state, "weldRadix", "Mfv/s", faceVertices, radixTimer.stop());
+
+	if(serialIds != radixIds || serialWelder.getNumVertices() != radixWelder.getNumVertices())
+	{
+		fprintf(stderr, "cpmbench_export: radix sort welding differs from serial welding on %s\n", mesh.name.c_str());
+		exit(1);
+	}
+
+	PHASE_TIMER remapTimer;
+	Remap(mesh, state);
+	results.add(mesh, state, "remap", "Mtri/s", triangles, remapTimer.stop());
+
+	PHASE_TIMER assembleTimer;
+	Assemble(mesh, state);
+	results.add(mesh, state, "assemble", "Mvert/s", state.welder.getNumVertices(), assembleTimer.stop());
+
+	PHASE_TIMER materialTimer;
+	BuildMaterials(mesh, state);
+	results.add(mesh, state, "materials", "Mtri/s", triangles, materialTimer.stop());
+
+	for(size_t m = 0; m < sizeof(g_outputModes) / sizeof(g_outputModes[0]); m++)
+	{
+		const OUTPUT_MODE &mode = g_outputModes[m];
+		if(mode.compressed && !IsCodecAvailable(mode.codec)) continue;
+
+		PHASE_TIMER writeTimer;
+		const unsigned long long bytes = WriteOutputMode(mode, state);
+		PHASE_RESULT result = writeTimer.stop(bytes);
+		results.add(mesh, state, mode.name, "MB/s", (double) bytes, result);
+	}
+
+	// la mmoire de pointe de l'exportation hors mmoire ne doit dpendre que du budget
+	CPM_STREAMING_STATS streamingStats;
+	PHASE_TIMER streamingTimer;
+	const unsigned long long streamingBytes = StreamMesh(mesh, streamingStats);
+	results.add(mesh, state, "streaming", "Mtri/s", triangles, streamingTimer.stop(streamingBytes));
+
+	if(streamingStats.vertices != state.welder.getNumVertices())
+	{
+		fprintf(stderr, "cpmbench_export: streaming export found %llu vertices instead of %u on %s\n", streamingStats.vertices, state.welder.getNumVertices(), mesh.name.c_str());
+		exit(1);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	size_t minTriangles = 1000, maxTriangles = 1000000;
+	int onlyType = -1;
+	const char *output = NULL;
+	CPM_STREAMING_SETTINGS streamingSettings;
+	streamingSettings.memoryBudget = 16 << 20;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-min") == 0 && i + 1 < argc) minTriangles = (size_t) atof(argv[++i]);
+		else if(strcmp(argv[i], "-max") == 0 && i + 1 < argc) maxTriangles = (size_t) atof(argv[++i]);
+		else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) output = argv[++i];
+		else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc) SetWorkerCount((unsigned int) atoi(argv[++i]));
+		else if(strcmp(argv[i], "-memoryBudget") == 0 && i + 1 < argc) streamingSettings.memoryBudget = (size_t) atoi(argv[++i]) << 20;
+		else if(strcmp(argv[i], "-mesh") == 0 && i + 1 < argc)
+		{
+			++i;
+			for(int t = 0; t < SYNTHETIC_MESH_TYPE_COUNT; t++) if(strcmp(argv[i], SyntheticMeshName((SYNTHETIC_MESH_TYPE) t)) == 0) onlyType = t;
+			if(onlyType < 0)
+			{
+				fprintf(stderr, "cpmbench_export: unknown mesh type %s\n", argv[i]);
+				return 2;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "usage: cpmbench_export [-min triangles] [-max triangles] [-mesh grid|sphere|ngons|hardEdges] [-threads n] [-memoryBudget MiB] [-o results.json]\n");
+			return 2;
+		}
+	}
+	SetStreamingSettings(streamingSettings);
+
+	JSON_RESULTS results;
+	for(size_t size = minTriangles; size <= maxTriangles; size *= 10)
+	{
+		for(int t = 0; t < SYNTHETIC_MESH_TYPE_COUNT; t++)
+		{
+			if(onlyType >= 0 && t != onlyType) continue;
+
+			SYNTHETIC_MESH mesh;
+			GenerateMesh((SYNTHETIC_MESH_TYPE) t, size, mesh);
+			RunMesh(mesh, results);
+		}
+	}
+
+	const std::string json = results.finish();
+	if(output)
+	{
+		FILE *file = fopen(output, "w");
+		if(!file)
+		{
+			fprintf(stderr, "cpmbench_export: cannot open %s\n", output);
+			return 1;
+		}
+		fputs(json.c_str(), file);
+		fclose(file);
+	}
+	else
+	{
+		fputs(json.c_str(), stdout);
+	}
+
+	return 0;
+}
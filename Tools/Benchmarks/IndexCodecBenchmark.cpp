@@ -0,0 +1,117 @@
+//
+//	Benchmark de la compression des indices des triangles (CPMIndexCodec)
+//	taille compresse et dbit de l'encodage et du dcodage, chemin scalaire et chemin SIMD, sur les meshes de MeshGenerator
+//	les vertices sont renumrots dans l'ordre de leur premire utilisation comme le fait l'assemblage, puis les triangles
+//	sont mlangs pour mesurer le pire cas
+//
+//	usage: cpmbench_indices [nombre de triangles]
+//
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MeshGenerator.h"
+#include "CPMIndexCodec.h"
+#include "CPMSimd.h"
+
+static void RenumberByFirstUse(std::vector<unsigned int> &indices, unsigned int numVertices)
+{
+	std::vector<unsigned int> remap(numVertices, ~0u);
+	unsigned int next = 0;
+	for(size_t i = 0; i < indices.size(); i++)
+	{
+		if(remap[indices[i]] == ~0u) remap[indices[i]] = next++;
+		indices[i] = remap[indices[i]];
+	}
+}
+
+static void ShuffleTriangles(std::vector<unsigned int> &indices)
+{
+	srand(1);
+	const size_t numTriangles = indices.size() / 3;
+	for(size_t t = numTriangles; t > 1; t--)
+	{
+		const size_t other = (size_t) (((unsigned long long) rand() * (RAND_MAX + 1ull) + rand()) % t);
+		for(unsigned int k = 0; k < 3; k++) std::swap(indices[3*(t - 1) + k], indices[3*other + k]);
+	}
+}
+
+static double Decode(const std::string &encoded, std::vector<unsigned int> &decoded, CPM_SIMD_LEVEL level, bool &ok)
+// Rsum: retourne le meilleur temps (en secondes) sur quelques rptitions
+{
+	double best = 1e30;
+	for(unsigned int r = 0; r < 10; r++)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		ok = DecodeIndices((const unsigned char*) encoded.data(), encoded.size(), &decoded[0], decoded.size(), level);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if(seconds < best) best = seconds;
+	}
+	return best;
+}
+
+static bool Run(const char *name, const std::vector<unsigned int> &indices)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::ostringstream os;
+	CPMIndexEncoder encoder(&os);
+	encoder.encode(&indices[0], indices.size());
+	encoder.finish();
+	const std::string encoded = os.str();
+	const double encodeTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const double rawBytes = (double) indices.size() * sizeof(unsigned int);
+	printf("%-18s %10lu %9.2f %8.2f %10.0f", name, (unsigned long) (indices.size() / 3), encoded.size() * 8.0 / (indices.size() / 3), encoded.size() / rawBytes,
+		rawBytes / encodeTime * 1e-6);
+
+	const CPM_SIMD_LEVEL levels[] = { CPM_SIMD_SCALAR, CPM_SIMD_AVX2 };
+	for(unsigned int l = 0; l < 2; l++)
+	{
+		if(levels[l] > GetSimdLevel())
+		{
+			printf(" %12s", "-");
+			continue;
+		}
+
+		std::vector<unsigned int> decoded(indices.size());
+		bool ok = false;
+		const double time = Decode(encoded, decoded, levels[l], ok);
+		if(!ok || decoded != indices)
+		{
+			printf("\ncpmbench_indices: %s decoding differs from the source indices on %s\n", SimdLevelName(levels[l]), name);
+			return false;
+		}
+		printf(" %12.2f", rawBytes / time * 1e-9);
+	}
+	printf("\n");
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t targetTriangles = argc > 1 ? (size_t) atol(argv[1]) : 4000000;
+
+	printf("best SIMD level: %s, decoding throughput in GB/s of 32-bit indices\n", SimdLevelName(GetSimdLevel()));
+	printf("%-18s %10s %9s %8s %10s %12s %12s\n", "mesh", "triangles", "bits/tri", "ratio", "enc MB/s", "scalar", "simd");
+
+	bool ok = true;
+	for(unsigned int type = 0; type < SYNTHETIC_MESH_TYPE_COUNT; type++)
+	{
+		SYNTHETIC_MESH mesh;
+		GenerateMesh((SYNTHETIC_MESH_TYPE) type, targetTriangles, mesh);
+
+		std::vector<unsigned int> indices(mesh.trianglePoints.begin(), mesh.trianglePoints.end());
+		RenumberByFirstUse(indices, mesh.numPoints);
+		ok = Run(mesh.name.c_str(), indices) && ok;
+
+		ShuffleTriangles(indices);
+		RenumberByFirstUse(indices, mesh.numPoints);
+		ok = Run((mesh.name + " shuffled").c_str(), indices) && ok;
+	}
+
+	return ok ? 0 : 1;
+}
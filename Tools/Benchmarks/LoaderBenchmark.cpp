@@ -0,0 +1,411 @@
+//
+//	Benchmark du chargement des fichiers binaires projets en mmoire (mmap), avec et sans sections alignes (CPM_EXPORT_PAGE_ALIGNED)
+//	le transfert vers le GPU est simul par une copie dans un tampon de destination: une section dont les donnes commencent
+//	sur une page du fichier est importe telle quelle comme mmoire hte (une copie), les autres passent d'abord par un tampon
+//	de transfert align (deux copies)
+//	la taille aprs compression LZ4 montre le cot du remplissage une fois le fichier mis dans le conteneur compress
+//	la seconde partie compare, sur une scne de plusieurs objets, le chargement des seules colonnes positions et triangles
+//	(CPMObjectFile::readColumn) au chargement complet de chaque objet (readObject), en binaire, en binaire compress et en texte
+//
+//	usage: cpmbench_loader [nombre de triangles] [-interleaved]
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MeshGenerator.h"
+#include "CPMMeshWriter.h"
+#include "CPMChunkedStream.h"
+#include "CPMCompression.h"
+#include "CPMObjectTable.h"
+
+#define STAGING_ALIGNMENT	4096	// alignement exig pour importer de la mmoire hte (VK_EXT_external_memory_host, pages du systme)
+
+static void BuildMesh(const SYNTHETIC_MESH &source, CPM_MESH_DATA &mesh)
+// Rsum: la grille partage ses normales et ses UVs: un vertex par point
+{
+	mesh.name = source.name;
+	mesh.triangles.assign(source.trianglePoints.begin(), source.trianglePoints.end());
+
+	const unsigned int numPoints = source.numPoints;
+	mesh.points.resize(numPoints);
+	mesh.normals.resize(numPoints);
+	mesh.UVs.resize(numPoints);
+	for(unsigned int p = 0; p < numPoints; p++)
+	{
+		mesh.points.x[p] = source.points[4*p];
+		mesh.points.y[p] = source.points[4*p + 1];
+		mesh.points.z[p] = source.points[4*p + 2];
+	}
+
+	for(size_t fv = 0; fv < source.numFaceVertices(); fv++)
+	{
+		const unsigned int p = source.faceVertexPoints[fv], n = source.faceVertexNormals[fv], uv = source.faceVertexUVs[fv];
+		mesh.normals.x[p] = source.normals[3*n];
+		mesh.normals.y[p] = source.normals[3*n + 1];
+		mesh.normals.z[p] = source.normals[3*n + 2];
+		mesh.UVs.u[p] = source.u[uv];
+		mesh.UVs.v[p] = source.v[uv];
+	}
+}
+
+static void WriteFile(std::ostream &os, const CPM_MESH_DATA &mesh, unsigned int exportOptions)
+{
+	CPMStringPool strings;
+	CPMObjectTable objects;
+	WriteFileHeader(os, exportOptions);
+	CPMMeshWriter(mesh, exportOptions).write(os, &objects);
+	WriteFileFooter(os, exportOptions, strings, objects);
+}
+
+class COUNTING_STREAMBUF : public std::streambuf
+{
+	public:
+	COUNTING_STREAMBUF() : m_bytes(0) {}
+	unsigned long long bytes() const { return m_bytes; }
+
+	protected:
+	virtual std::streamsize xsputn(const char*, std::streamsize n) { m_bytes += n; return n; }
+	virtual int_type overflow(int_type c) { if(c != traits_type::eof()) m_bytes++; return traits_type::not_eof(c); }
+
+	unsigned long long m_bytes;
+};
+
+static unsigned long long CompressedSize(const CPM_MESH_DATA &mesh, unsigned int exportOptions)
+{
+	COUNTING_STREAMBUF counter;
+	std::ostream file(&counter);
+	{
+		CPMChunkedOStream os(file, CPM_CODEC_LZ4);
+		WriteFile(os, mesh, exportOptions);
+		os.close();
+	}
+	file.flush();
+	return counter.bytes();
+}
+
+
+//
+//	Fichier projet en mmoire
+//
+class MAPPED_FILE
+{
+	public:
+	MAPPED_FILE() : m_data(NULL), m_size(0) {}
+	~MAPPED_FILE() { close(); }
+
+	bool open(const char *path)
+	{
+#ifdef __unix__
+		const int fd = ::open(path, O_RDONLY);
+		if(fd < 0) return false;
+
+		struct stat st;
+		if(fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(data != MAP_FAILED) { m_data = (const unsigned char*) data; m_size = (size_t) st.st_size; }
+		}
+		::close(fd);
+		return m_data != NULL;
+#else
+		// sans mmap, le fichier est lu dans un tampon align sur une page comme le serait une projection
+		std::ifstream is(path, std::ios::binary);
+		m_buffer.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+		m_aligned.resize(m_buffer.size() + STAGING_ALIGNMENT);
+		unsigned char *data = &m_aligned[0] + (STAGING_ALIGNMENT - (size_t) &m_aligned[0] % STAGING_ALIGNMENT) % STAGING_ALIGNMENT;
+		if(!m_buffer.empty()) memcpy(data, &m_buffer[0], m_buffer.size());
+		m_data = data;
+		m_size = m_buffer.size();
+		return m_size != 0;
+#endif
+	}
+
+	void close()
+	{
+#ifdef __unix__
+		if(m_data) munmap((void*) m_data, m_size);
+#endif
+		m_data = NULL;
+		m_size = 0;
+	}
+
+	const unsigned char *data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+	protected:
+	const unsigned char			*m_data;
+	size_t						m_size;
+#ifndef __unix__
+	std::vector<char>			m_buffer;
+	std::vector<unsigned char>	m_aligned;
+#endif
+};
+
+struct ARRAY_SECTION
+{
+	size_t		offset;		// position des lments dans le fichier
+	size_t		size;
+};
+
+static bool FindArraySections(const MAPPED_FILE &file, std::vector<ARRAY_SECTION> &sections, unsigned long long &padding)
+// Rsum: parcourt les sections jusqu' CPM_TAG_END, garde les tableaux (indices, attributs, vertices entrelacs)
+{
+	size_t position = sizeof(CPM_BINARY_HEADER);
+	padding = 0;
+	while(position + sizeof(CPM_SECTION_HEADER) <= file.size())
+	{
+		CPM_SECTION_HEADER header;
+		memcpy(&header, file.data() + position, sizeof(header));
+		position += sizeof(header);
+		if(memcmp(header.tag, CPM_TAG_END, 4) == 0) return true;
+		if(header.size > file.size() - position || header.padding > header.size) return false;
+
+		if(header.scalarType != CPM_SCALAR_NONE || memcmp(header.tag, CPM_TAG_VERTEX_BUFFER, 4) == 0)
+		{
+			ARRAY_SECTION section;
+			section.offset = position + header.padding;
+			section.size = (size_t) (header.size - header.padding);
+			sections.push_back(section);
+		}
+		padding += header.padding;
+		position += (size_t) header.size;
+	}
+	return false;
+}
+
+static double Stage(const MAPPED_FILE &file, const std::vector<ARRAY_SECTION> &sections, unsigned char *staging, unsigned char *device, unsigned int &aligned)
+// Rsum: meilleur temps (en secondes) de quelques transferts de toutes les sections
+{
+	double best = 1e30;
+	for(unsigned int r = 0; r < 10; r++)
+	{
+		aligned = 0;
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(size_t s = 0; s < sections.size(); s++)
+		{
+			const unsigned char *data = file.data() + sections[s].offset;
+			if(sections[s].offset % STAGING_ALIGNMENT == 0)
+			{
+				memcpy(device, data, sections[s].size);
+				aligned++;
+			}
+			else
+			{
+				memcpy(staging, data, sections[s].size);
+				memcpy(device, staging, sections[s].size);
+			}
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if(seconds < best) best = seconds;
+	}
+	return best;
+}
+
+struct LOADER_MODE
+{
+	const char		*name;
+	unsigned int	options;
+	unsigned int	pageAlignment;
+};
+
+static const LOADER_MODE g_loaderModes[] =
+{
+	{ "default",		0,							CPM_DEFAULT_PAGE_ALIGNMENT },
+	{ "page4K",			CPM_EXPORT_PAGE_ALIGNED,	4096 },
+	{ "page64K",		CPM_EXPORT_PAGE_ALIGNED,	65536 },
+};
+
+
+
+//
+//	Colonnes
+//
+#define COLUMN_OBJECTS	8
+
+struct COLUMN_MODE
+{
+	const char		*name;
+	unsigned int	options;
+	bool			compressed;	// fichier CPM dans le conteneur compress LZ4
+};
+
+static const COLUMN_MODE g_columnModes[] =
+{
+	{ "binary",		CPM_EXPORT_BINARY,	false },
+	{ "binaryLZ4",	CPM_EXPORT_BINARY,	true },
+	{ "text",		0,					false },
+};
+
+static void WriteScene(std::ostream &os, const CPM_MESH_DATA &mesh, unsigned int exportOptions)
+// Rsum: COLUMN_OBJECTS copies du maillage, chacune un objet de la table
+{
+	CPMStringPool strings;
+	CPMObjectTable objects;
+	WriteFileHeader(os, exportOptions);
+	CPM_MESH_DATA object = mesh;
+	for(unsigned int i = 0; i < COLUMN_OBJECTS; i++)
+	{
+		char name[32];
+		sprintf(name, "%s%u", mesh.name.c_str(), i);
+		object.name = name;
+		CPMMeshWriter(object, exportOptions).write(os, &objects);
+	}
+	WriteFileFooter(os, exportOptions, strings, objects);
+}
+
+static bool LoadObjects(const char *path, bool positionsOnly, double &seconds, unsigned long long &bytes)
+// Rsum: meilleur temps de quelques chargements, la table des objets comprise; positionsOnly: colonnes VERT (ou VBUF) et TRIS
+{
+	seconds = 1e30;
+	for(unsigned int r = 0; r < 5; r++)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::ifstream is(path, std::ios::binary);
+		CPMObjectFile file;
+		if(!file.open(is)) return false;
+
+		bytes = 0;
+		std::string data;
+		for(size_t i = 0; i < file.getObjectCount(); i++)
+		{
+			const CPM_OBJECT_INFO &object = file.getObject(i);
+			if(positionsOnly)
+			{
+				if(!file.readColumn(object, object.findColumn(CPM_TAG_VERTICES) ? CPM_TAG_VERTICES : CPM_TAG_VERTEX_BUFFER, data)) return false;
+				bytes += data.size();
+				if(!file.readColumn(object, CPM_TAG_TRIANGLES, data)) return false;
+			}
+			else if(!file.readObject(object, data)) return false;
+			bytes += data.size();
+		}
+
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if(elapsed < seconds) seconds = elapsed;
+	}
+	return true;
+}
+
+static bool BenchmarkColumns(const CPM_MESH_DATA &mesh, unsigned int exportOptions)
+{
+	printf("\n%u objects of %lu triangles, positions and triangles columns against whole objects\n", COLUMN_OBJECTS, (unsigned long) mesh.triangles.size() / 3);
+	printf("%-10s %12s %12s %10s %12s %10s %8s\n", "file", "bytes", "column bytes", "column ms", "object bytes", "object ms", "speedup");
+
+	bool ok = true;
+	for(size_t m = 0; m < sizeof(g_columnModes) / sizeof(g_columnModes[0]); m++)
+	{
+		const COLUMN_MODE &mode = g_columnModes[m];
+		const unsigned int options = (exportOptions & ~CPM_EXPORT_BINARY) | mode.options;
+		const std::string path = std::string("cpmbench_columns_") + mode.name + ".cpm";
+		{
+			std::ofstream file(path.c_str(), std::ios::binary);
+			if(!mode.compressed) WriteScene(file, mesh, options);
+			else
+			{
+				CPMChunkedOStream os(file, CPM_CODEC_LZ4);
+				WriteScene(os, mesh, options);
+				os.close();
+			}
+		}
+
+		double columnSeconds = 0, objectSeconds = 0;
+		unsigned long long columnBytes = 0, objectBytes = 0;
+		if(!LoadObjects(path.c_str(), true, columnSeconds, columnBytes) || !LoadObjects(path.c_str(), false, objectSeconds, objectBytes))
+		{
+			fprintf(stderr, "cpmbench_loader: cannot read the columns of %s\n", path.c_str());
+			ok = false;
+		}
+		else
+		{
+			std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+			printf("%-10s %12llu %12llu %10.3f %12llu %10.3f %7.2fx\n", mode.name, (unsigned long long) file.tellg(), columnBytes, columnSeconds * 1e3,
+				objectBytes, objectSeconds * 1e3, objectSeconds / columnSeconds);
+		}
+		remove(path.c_str());
+	}
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	size_t targetTriangles = 2000000;
+	unsigned int exportOptions = CPM_EXPORT_BINARY | CPM_EXPORT_NORMALS | CPM_EXPORT_UVS;
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-interleaved") == 0) exportOptions |= CPM_EXPORT_INTERLEAVED;
+		else targetTriangles = (size_t) atol(argv[i]);
+	}
+
+	SYNTHETIC_MESH source;
+	GenerateMesh(SYNTHETIC_GRID, targetTriangles, source);
+	CPM_MESH_DATA mesh;
+	BuildMesh(source, mesh);
+
+	printf("%lu triangles, %u vertices, %s sections, staging alignment %u, lz4 %s\n", (unsigned long) mesh.triangles.size() / 3, (unsigned int) mesh.points.size(),
+		(exportOptions & CPM_EXPORT_INTERLEAVED) ? "interleaved" : "separate", STAGING_ALIGNMENT, IsCodecAvailable(CPM_CODEC_LZ4) ? "available" : "unavailable (stored)");
+	printf("%-10s %12s %10s %12s %9s %10s %8s\n", "layout", "bytes", "padding", "lz4 bytes", "aligned", "stage ms", "GB/s");
+
+	bool ok = true;
+	for(size_t m = 0; m < sizeof(g_loaderModes) / sizeof(g_loaderModes[0]); m++)
+	{
+		const LOADER_MODE &mode = g_loaderModes[m];
+		SetPageAlignment(mode.pageAlignment);
+		const unsigned int options = exportOptions | mode.options;
+
+		const std::string path = std::string("cpmbench_loader_") + mode.name + ".cpm";
+		{
+			std::ofstream os(path.c_str(), std::ios::binary);
+			WriteFile(os, mesh, options);
+		}
+
+		MAPPED_FILE file;
+		std::vector<ARRAY_SECTION> sections;
+		unsigned long long padding = 0;
+		if(!file.open(path.c_str()) || !FindArraySections(file, sections, padding))
+		{
+			fprintf(stderr, "cpmbench_loader: cannot read %s\n", path.c_str());
+			ok = false;
+			continue;
+		}
+
+		size_t largest = 0, total = 0;
+		for(size_t s = 0; s < sections.size(); s++)
+		{
+			if(sections[s].size > largest) largest = sections[s].size;
+			total += sections[s].size;
+		}
+
+		std::vector<unsigned char> stagingBuffer(largest + STAGING_ALIGNMENT), device(largest + 1);
+		unsigned char *staging = &stagingBuffer[0] + (STAGING_ALIGNMENT - (size_t) &stagingBuffer[0] % STAGING_ALIGNMENT) % STAGING_ALIGNMENT;
+
+		unsigned int aligned = 0;
+		const double seconds = Stage(file, sections, staging, &device[0], aligned);
+
+		printf("%-10s %12lu %10llu %12llu %5u/%-3u %10.3f %8.2f\n", mode.name, (unsigned long) file.size(), padding, CompressedSize(mesh, options),
+			aligned, (unsigned int) sections.size(), seconds * 1e3, total / seconds * 1e-9);
+
+		file.close();
+		remove(path.c_str());
+	}
+
+	SetPageAlignment(CPM_DEFAULT_PAGE_ALIGNMENT);
+	SYNTHETIC_MESH objectSource;
+	GenerateMesh(SYNTHETIC_GRID, targetTriangles / COLUMN_OBJECTS, objectSource);
+	CPM_MESH_DATA object;
+	BuildMesh(objectSource, object);
+	if(!BenchmarkColumns(object, exportOptions)) ok = false;
+
+	return ok ? 0 : 1;
+}
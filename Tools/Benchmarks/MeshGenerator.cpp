@@ -0,0 +1,223 @@
+#include <cmath>
+
+#include "MeshGenerator.h"
+
+const char *SyntheticMeshName(SYNTHETIC_MESH_TYPE type)
+{
+	switch(type)
+	{
+		case SYNTHETIC_GRID:		return "grid";
+		case SYNTHETIC_SPHERE:		return "sphere";
+		case SYNTHETIC_NGONS:		return "ngons";
+		case SYNTHETIC_HARD_EDGES:	return "hardEdges";
+		default:					return "unknown";
+	}
+}
+
+static void AddPoint(SYNTHETIC_MESH &mesh, double x, double y, double z)
+{
+	mesh.points.push_back(x);
+	mesh.points.push_back(y);
+	mesh.points.push_back(z);
+	mesh.points.push_back(1.0);
+}
+
+static void AddNormal(SYNTHETIC_MESH &mesh, float x, float y, float z)
+{
+	const float length = sqrtf(x*x + y*y + z*z);
+	mesh.normals.push_back(x / length);
+	mesh.normals.push_back(y / length);
+	mesh.normals.push_back(z / length);
+}
+
+static void AddPolygon(SYNTHETIC_MESH &mesh, const unsigned int *points, const unsigned int *normals, const unsigned int *uvs, unsigned int size)
+// Rsum: ajoute un polygone convexe, triangul en ventail depuis son premier sommet
+{
+	mesh.polygonSizes.push_back(size);
+	mesh.faceVertexPoints.insert(mesh.faceVertexPoints.end(), points, points + size);
+	mesh.faceVertexNormals.insert(mesh.faceVertexNormals.end(), normals, normals + size);
+	mesh.faceVertexUVs.insert(mesh.faceVertexUVs.end(), uvs, uvs + size);
+
+	mesh.triangleCounts.push_back(size - 2);
+	for(unsigned int i = 1; i + 1 < size; i++)
+	{
+		mesh.trianglePoints.push_back(points[0]);
+		mesh.trianglePoints.push_back(points[i]);
+		mesh.trianglePoints.push_back(points[i + 1]);
+	}
+}
+
+static void GenerateGrid(size_t targetTriangles, unsigned int blockSize, SYNTHETIC_MESH &mesh)
+// Rsum: grille de n x n quads, blockSize > 0 spare la grille en blocs de blockSize x blockSize quads par des artes dures
+{
+	const unsigned int n = (unsigned int) ceil(sqrt(targetTriangles / 2.0));
+	const unsigned int row = n + 1;
+
+	mesh.numPoints = row * row;
+	for(unsigned int j = 0; j <= n; j++)
+	{
+		for(unsigned int i = 0; i <= n; i++)
+		{
+			const double x = (double) i / n, y = (double) j / n;
+			AddPoint(mesh, x, y, 0.1 * sin(6.0 * x) * cos(6.0 * y));
+			mesh.u.push_back((float) x);
+			mesh.v.push_back((float) y);
+			if(blockSize == 0) AddNormal(mesh, (float) (-0.6 * cos(6.0 * x) * cos(6.0 * y)), (float) (0.6 * sin(6.0 * x) * sin(6.0 * y)), 1.0f);
+		}
+	}
+
+	// avec des artes dures, chaque bloc a ses propres normales: (blockSize + 1) normales par bloc
+	const unsigned int blocksPerRow = blockSize ? (n + blockSize - 1) / blockSize : 0;
+	const unsigned int blockRow = blockSize + 1;
+	for(unsigned int b = 0; b < blocksPerRow * blocksPerRow; b++)
+	{
+		const float tiltX = (float) (b % 7) * 0.1f - 0.3f, tiltY = (float) (b % 5) * 0.1f - 0.2f;
+		for(unsigned int k = 0; k < blockRow * blockRow; k++) AddNormal(mesh, tiltX, tiltY, 1.0f);
+	}
+
+	mesh.materialFaces.resize(2);
+	for(unsigned int j = 0; j < n; j++)
+	{
+		for(unsigned int i = 0; i < n; i++)
+		{
+			const unsigned int points[4] = { j*row + i, j*row + i + 1, (j + 1)*row + i + 1, (j + 1)*row + i };
+			unsigned int normals[4] = { points[0], points[1], points[2], points[3] };
+			if(blockSize)
+			{
+				const unsigned int block = (j / blockSize) * blocksPerRow + i / blockSize;
+				const unsigned int li = i % blockSize, lj = j % blockSize;
+				const unsigned int base = block * blockRow * blockRow;
+				normals[0] = base + lj*blockRow + li;
+				normals[1] = base + lj*blockRow + li + 1;
+				normals[2] = base + (lj + 1)*blockRow + li + 1;
+				normals[3] = base + (lj + 1)*blockRow + li;
+			}
+
+			mesh.materialFaces[(i < n / 2) ? 0 : 1].push_back((unsigned int) mesh.polygonSizes.size());
+			AddPolygon(mesh, points, normals, points, 4);
+		}
+	}
+}
+
+static void GenerateSphere(size_t targetTriangles, SYNTHETIC_MESH &mesh)
+// Rsum: sphre UV de r anneaux et s segments, la colonne s des UVs double la colonne 0 (couture)
+{
+	const unsigned int s = (unsigned int) ceil(sqrt((double) targetTriangles)) < 3 ? 3 : (unsigned int) ceil(sqrt((double) targetTriangles));
+	const unsigned int r = s / 2 < 2 ? 2 : s / 2;
+	const double pi = 3.14159265358979323846;
+
+	// points: ple sud, anneaux 1..r-1, ple nord; normales gales aux positions
+	mesh.numPoints = 2 + (r - 1) * s;
+	AddPoint(mesh, 0.0, 0.0, -1.0);
+	AddNormal(mesh, 0.0f, 0.0f, -1.0f);
+	for(unsigned int j = 1; j < r; j++)
+	{
+		const double phi = pi * j / r - pi / 2.0;
+		for(unsigned int i = 0; i < s; i++)
+		{
+			const double theta = 2.0 * pi * i / s;
+			AddPoint(mesh, cos(phi) * cos(theta), cos(phi) * sin(theta), sin(phi));
+			AddNormal(mesh, (float) (cos(phi) * cos(theta)), (float) (cos(phi) * sin(theta)), (float) sin(phi));
+		}
+	}
+	AddPoint(mesh, 0.0, 0.0, 1.0);
+	AddNormal(mesh, 0.0f, 0.0f, 1.0f);
+
+	// UVs: (r + 1) lignes de (s + 1) UVs
+	for(unsigned int j = 0; j <= r; j++)
+	{
+		for(unsigned int i = 0; i <= s; i++)
+		{
+			mesh.u.push_back((float) i / s);
+			mesh.v.push_back((float) j / r);
+		}
+	}
+
+	const unsigned int south = 0, north = mesh.numPoints - 1;
+	mesh.materialFaces.resize(4);
+	for(unsigned int j = 0; j < r; j++)
+	{
+		for(unsigned int i = 0; i < s; i++)
+		{
+			const unsigned int i1 = (i + 1) % s;
+			const unsigned int uvs[4] = { j*(s + 1) + i, j*(s + 1) + i + 1, (j + 1)*(s + 1) + i + 1, (j + 1)*(s + 1) + i };
+
+			mesh.materialFaces[j * 4 / r].push_back((unsigned int) mesh.polygonSizes.size());
+			if(j == 0)
+			{
+				const unsigned int points[3] = { south, 1 + i1, 1 + i };
+				const unsigned int triUVs[3] = { uvs[0], uvs[2], uvs[3] };
+				AddPolygon(mesh, points, points, triUVs, 3);
+			}
+			else if(j == r - 1)
+			{
+				const unsigned int points[3] = { 1 + (j - 1)*s + i, 1 + (j - 1)*s + i1, north };
+				const unsigned int triUVs[3] = { uvs[0], uvs[1], uvs[2] };
+				AddPolygon(mesh, points, points, triUVs, 3);
+			}
+			else
+			{
+				const unsigned int points[4] = { 1 + (j - 1)*s + i, 1 + (j - 1)*s + i1, 1 + j*s + i1, 1 + j*s + i };
+				AddPolygon(mesh, points, points, uvs, 4);
+			}
+		}
+	}
+}
+
+static void GenerateNgons(size_t targetTriangles, SYNTHETIC_MESH &mesh)
+// Rsum: bandes de polygones  2(m + 1) cts, une normale par face comme les modles CAO  facettes
+{
+	const unsigned int m = 6; // subdivisions du bord haut et du bord bas de chaque polygone
+	const unsigned int trianglesPerPolygon = 2 * (m + 1) - 2;
+	const unsigned int cells = (unsigned int) ceil(sqrt((double) targetTriangles / trianglesPerPolygon));
+	const unsigned int row = cells * m + 1;
+
+	mesh.numPoints = row * (cells + 1);
+	for(unsigned int j = 0; j <= cells; j++)
+	{
+		for(unsigned int i = 0; i < row; i++)
+		{
+			const double x = (double) i / (row - 1), y = (double) j / cells;
+			AddPoint(mesh, x, y, 0.05 * ((i / m + j) % 3));
+			mesh.u.push_back((float) x);
+			mesh.v.push_back((float) y);
+		}
+	}
+
+	std::vector<unsigned int> points(2 * (m + 1)), normals(2 * (m + 1));
+	mesh.materialFaces.resize(3);
+	for(unsigned int j = 0; j < cells; j++)
+	{
+		for(unsigned int c = 0; c < cells; c++)
+		{
+			const unsigned int face = (unsigned int) mesh.polygonSizes.size();
+			AddNormal(mesh, (float) ((c % 3) * 0.2 - 0.2), (float) ((j % 3) * 0.2 - 0.2), 1.0f);
+
+			// bord bas de gauche  droite, puis bord haut de droite  gauche
+			for(unsigned int k = 0; k <= m; k++)
+			{
+				points[k] = j*row + c*m + k;
+				points[m + 1 + k] = (j + 1)*row + c*m + m - k;
+			}
+			for(unsigned int k = 0; k < normals.size(); k++) normals[k] = face;
+
+			mesh.materialFaces[(c + j) % 3].push_back(face);
+			AddPolygon(mesh, &points[0], &normals[0], &points[0], (unsigned int) points.size());
+		}
+	}
+}
+
+void GenerateMesh(SYNTHETIC_MESH_TYPE type, size_t targetTriangles, SYNTHETIC_MESH &mesh)
+{
+	mesh = SYNTHETIC_MESH();
+	mesh.name = SyntheticMeshName(type);
+
+	switch(type)
+	{
+		case SYNTHETIC_GRID:		GenerateGrid(targetTriangles, 0, mesh); break;
+		case SYNTHETIC_SPHERE:		GenerateSphere(targetTriangles, mesh); break;
+		case SYNTHETIC_NGONS:		GenerateNgons(targetTriangles, mesh); break;
+		case SYNTHETIC_HARD_EDGES:	GenerateGrid(targetTriangles, 4, mesh); break;
+		default:					break;
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef CPM_MESH_GENERATOR_H_INCLUDED
+#define CPM_MESH_GENERATOR_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//
+//	Meshes paramtriques pour les benchmarks, dcrits comme MFnMesh les fournit  CPMMeshExtractor:
+//	points, polygones avec les indices de point, de normale et d'UV de chaque face-vertex, et triangulation des polygones
+//
+enum SYNTHETIC_MESH_TYPE
+{
+	SYNTHETIC_GRID,				// quads, normales et UVs partags: aucun vertex dupliqu
+	SYNTHETIC_SPHERE,			// sphre UV: couture verticale et ples dupliquent les UVs
+	SYNTHETIC_NGONS,			// polygones  nombreux cts et normales par face, comme un modle CAO
+	SYNTHETIC_HARD_EDGES,		// grille dcoupe en blocs spars par des artes dures
+	SYNTHETIC_MESH_TYPE_COUNT
+};
+
+struct SYNTHETIC_MESH
+{
+	std::string					name;
+
+	unsigned int				numPoints;
+	std::vector<double>			points;				// x, y, z, w par point
+	std::vector<float>			normals;			// x, y, z
+	std::vector<float>			u;
+	std::vector<float>			v;
+
+	std::vector<unsigned int>	polygonSizes;
+	std::vector<unsigned int>	faceVertexPoints;	// un indice par face-vertex, polygone aprs polygone
+	std::vector<unsigned int>	faceVertexNormals;
+	std::vector<unsigned int>	faceVertexUVs;
+
+	std::vector<int>			triangleCounts;		// nombre de triangles de chaque polygone
+	std::vector<unsigned int>	trianglePoints;		// 3 points par triangle
+
+	std::vector< std::vector<unsigned int> >	materialFaces;	// polygones de chaque matriau
+
+	size_t numTriangles() const { return trianglePoints.size() / 3; }
+	size_t numFaceVertices() const { return faceVertexPoints.size(); }
+};
+
+const char *SyntheticMeshName(SYNTHETIC_MESH_TYPE type);
+
+// Gnre un mesh d'environ targetTriangles triangles
+void GenerateMesh(SYNTHETIC_MESH_TYPE type, size_t targetTriangles, SYNTHETIC_MESH &mesh);
+
+#endif // CPM_MESH_GENERATOR_H_INCLUDED
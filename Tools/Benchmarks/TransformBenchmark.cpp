@@ -0,0 +1,117 @@
+//
+//	Benchmark de la transformation des meshes dans l'espace monde (CPMTransformKernels)
+//	compare le chemin scalaire aux chemins SSE2 et AVX2, sur un thread puis sur tous les coeurs
+//
+//	usage: cpmbench_transform [nombre de vertices]
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+
+#include "CPMTransformKernels.h"
+#include "CPMParallel.h"
+
+struct BENCH_MESH
+{
+	VECTOR3_ARRAY<double>	points;
+	VECTOR3_ARRAY<float>	normals;
+	VECTOR3_ARRAY<float>	tangents;
+	VECTOR3_ARRAY<float>	binormals;
+};
+
+static void FillMesh(BENCH_MESH &mesh, size_t count)
+{
+	mesh.points.resize(count);
+	mesh.normals.resize(count);
+	mesh.tangents.resize(count);
+	mesh.binormals.resize(count);
+
+	srand(1);
+	for(size_t i = 0; i < count; i++)
+	{
+		mesh.points.x[i] = rand() * (200.0 / RAND_MAX) - 100.0;
+		mesh.points.y[i] = rand() * (200.0 / RAND_MAX) - 100.0;
+		mesh.points.z[i] = rand() * (200.0 / RAND_MAX) - 100.0;
+
+		const float a = rand() * (6.2831853f / RAND_MAX);
+		mesh.normals.x[i] = cosf(a); mesh.normals.y[i] = sinf(a); mesh.normals.z[i] = 0.0f;
+		mesh.tangents.x[i] = -sinf(a); mesh.tangents.y[i] = cosf(a); mesh.tangents.z[i] = 0.0f;
+		mesh.binormals.x[i] = 0.0f; mesh.binormals.y[i] = 0.0f; mesh.binormals.z[i] = 1.0f;
+	}
+}
+
+static double MaxDifference(const BENCH_MESH &a, const BENCH_MESH &b)
+{
+	double diff = 0.0;
+	for(size_t i = 0; i < a.points.size(); i++)
+	{
+		diff = fmax(diff, fabs(a.points.x[i] - b.points.x[i]) + fabs(a.points.y[i] - b.points.y[i]) + fabs(a.points.z[i] - b.points.z[i]));
+		diff = fmax(diff, fabs(a.normals.x[i] - b.normals.x[i]) + fabs(a.normals.y[i] - b.normals.y[i]) + fabs(a.normals.z[i] - b.normals.z[i]));
+		diff = fmax(diff, fabs(a.tangents.x[i] - b.tangents.x[i]) + fabs(a.tangents.y[i] - b.tangents.y[i]) + fabs(a.tangents.z[i] - b.tangents.z[i]));
+	}
+	return diff;
+}
+
+static double Run(const MESH_TRANSFORM &transform, const BENCH_MESH &source, BENCH_MESH &result, CPM_SIMD_LEVEL level, unsigned int workers)
+// Rsum: retourne le meilleur temps (en secondes) sur quelques rptitions
+{
+	SetWorkerCount(workers);
+
+	double best = 1e30;
+	for(unsigned int r = 0; r < 5; r++)
+	{
+		result = source;
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		TransformMesh(transform, &result.points, &result.normals, &result.tangents, &result.binormals, level);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if(seconds < best) best = seconds;
+	}
+
+	SetWorkerCount(0);
+	return best;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t count = argc > 1 ? (size_t) atol(argv[1]) : 4000000;
+
+	// rotation, chelle non uniforme et translation
+	const double matrix[4][4] = {
+		{ 0.0, 2.0, 0.0, 0.0 },
+		{ -1.0, 0.0, 0.0, 0.0 },
+		{ 0.0, 0.0, 0.5, 0.0 },
+		{ 10.0, -5.0, 3.0, 1.0 },
+	};
+	MESH_TRANSFORM transform;
+	BuildMeshTransform(matrix, transform);
+
+	BENCH_MESH source, reference, result;
+	FillMesh(source, count);
+
+	printf("vertices: %lu, threads: %u, best SIMD level: %s\n", (unsigned long) count, GetWorkerCount(), SimdLevelName(GetSimdLevel()));
+	printf("%-8s %8s %12s %14s %12s\n", "path", "threads", "time (ms)", "Mvertices/s", "max diff");
+
+	const double scalarTime = Run(transform, source, reference, CPM_SIMD_SCALAR, 1);
+	printf("%-8s %8u %12.2f %14.1f %12s\n", "scalar", 1u, scalarTime * 1000.0, count / scalarTime * 1e-6, "-");
+
+	const CPM_SIMD_LEVEL levels[] = { CPM_SIMD_SSE2, CPM_SIMD_AVX2 };
+	for(unsigned int l = 0; l < 2; l++)
+	{
+		if(levels[l] > GetSimdLevel()) continue;
+
+		const unsigned int workers[] = { 1, GetWorkerCount() };
+		for(unsigned int w = 0; w < 2; w++)
+		{
+			if(w == 1 && workers[1] == 1) break;
+
+			const double time = Run(transform, source, result, levels[l], workers[w]);
+			printf("%-8s %8u %12.2f %14.1f %12.2e  (x%.1f)\n", SimdLevelName(levels[l]), workers[w], time * 1000.0, count / time * 1e-6,
+				MaxDifference(reference, result), scalarTime / time);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,295 @@
+//
+//	Benchmark de la collecte des meshes visibles (CPMDagVisibility) sur une scne synthtique
+//	hirarchie alatoire de transforms et de meshes, avec des transforms instancis sous deux parents, des noeuds cachs,
+//	des overrides d'affichage (calques) cachs et des formes intermdiaires
+//	l'tat d'un noeud est lu comme le fait findPlug: recherche des attributs par leur nom dans la liste des attributs du noeud
+//
+//	trois mthodes sont compares:
+//	- propre: tat du seul mesh, ancienne collecte du plugin (exporte les meshes des sous-arbres cachs)
+//	- anctres: tat de chaque noeud du chemin de chaque mesh, sans mmorisation
+//	- mmoris: CollectVisibleShapes, parcours lagu sous les noeuds cachs avec un tat lu par noeud
+//
+//	usage: cpmbench_visibility [nombre de noeuds] [-seed n]
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "CPMDagVisibility.h"
+
+//
+//	Scne synthtique: le noeud 0 est le monde, les enfants de chaque noeud sont rangs par intervalles (CSR)
+//
+struct SYNTHETIC_DAG
+{
+	std::vector<unsigned int>	firstChild;	// enfants de n: children[firstChild[n], firstChild[n + 1])
+	std::vector<unsigned int>	children;
+	std::vector<unsigned char>	isMesh;
+	std::vector<unsigned int>	state;		// combinaison de CPM_NODE_VISIBILITY
+	std::vector<std::string>	attributes;	// attributs communs  tous les noeuds, les derniers sont ceux de la visibilit
+	unsigned int				instances;
+};
+
+static unsigned int Random(unsigned int range)
+{
+	return (unsigned int) (((unsigned long long) rand() * (RAND_MAX + 1ull) + rand()) % range);
+}
+
+static void GenerateDag(unsigned int numNodes, SYNTHETIC_DAG &dag)
+{
+	std::vector< std::pair<unsigned int, unsigned int> > edges; // (parent, enfant)
+	std::vector<unsigned int> transforms(1, 0);
+	std::vector<unsigned char> instanced(numNodes, 0); // noeud ou anctre instanci
+
+	dag.isMesh.assign(numNodes, 0);
+	dag.state.assign(numNodes, 0);
+	dag.instances = 0;
+	for(unsigned int n = 1; n < numNodes; n++)
+	{
+		// parent choisi au hasard parmi les transforms dj crs: arbre rcursif alatoire, profondeur moyenne en log(n)
+		const unsigned int parent = transforms[Random((unsigned int) transforms.size())];
+		edges.push_back(std::make_pair(parent, n));
+		instanced[n] = instanced[parent];
+
+		const unsigned int roll = Random(1000);
+		if(Random(2))
+		{
+			dag.isMesh[n] = 1;
+			if(roll < 100) dag.state[n] |= CPM_NODE_INTERMEDIATE;
+			else if(roll < 110) dag.state[n] |= CPM_NODE_HIDDEN;
+		}
+		else
+		{
+			if(roll < 10) dag.state[n] |= CPM_NODE_HIDDEN;
+			else if(roll < 15) dag.state[n] |= CPM_NODE_OVERRIDE_HIDDEN;
+
+			// un parent d'indice infrieur n'est jamais un descendant: le graphe reste acyclique; les instances ne sont pas
+			// imbriques, chaque noeud a au plus deux chemins
+			if(roll >= 980 && transforms.size() > 1 && !instanced[n])
+			{
+				const unsigned int other = transforms[Random((unsigned int) transforms.size())];
+				if(other != parent && !instanced[other])
+				{
+					edges.push_back(std::make_pair(other, n));
+					instanced[n] = 1;
+					dag.instances++;
+				}
+			}
+			transforms.push_back(n);
+		}
+	}
+
+	std::sort(edges.begin(), edges.end());
+	dag.firstChild.assign(numNodes + 1, 0);
+	for(size_t e = 0; e < edges.size(); e++) dag.firstChild[edges[e].first + 1]++;
+	for(unsigned int n = 0; n < numNodes; n++) dag.firstChild[n + 1] += dag.firstChild[n];
+	dag.children.resize(edges.size());
+	for(size_t e = 0; e < edges.size(); e++) dag.children[e] = edges[e].second;
+
+	const char *names[] = { "message", "caching", "frozen", "isHistoricallyInteresting", "nodeState", "binMembership", "boundingBox", "center",
+		"matrix", "inverseMatrix", "worldMatrix", "worldInverseMatrix", "parentMatrix", "parentInverseMatrix", "instObjGroups", "objectColor",
+		"useObjectColor", "template", "ghosting", "translate", "rotate", "scale", "shear", "rotatePivot", "scalePivot", "displayHandle",
+		"lodVisibility", "intermediateObject", "visibility", "overrideEnabled", "overrideVisibility" };
+	dag.attributes.assign(names, names + sizeof(names) / sizeof(names[0]));
+}
+
+static inline unsigned long long PathHash(unsigned long long parent, unsigned int node)
+{
+	unsigned long long h = (parent ^ node) * 0x9E3779B97F4A7C15ULL;
+	return h ^ (h >> 31);
+}
+
+class SYNTHETIC_DAG_ITERATOR
+// Parcours en profondeur prfixe comme MItDag: un noeud instanci est visit une fois par chemin
+{
+	public:
+	explicit SYNTHETIC_DAG_ITERATOR(const SYNTHETIC_DAG &dag) : m_dag(dag), m_pruned(false), m_reads(0)
+	{
+		FRAME root = { 0, 0, 0 };
+		m_stack.push_back(root);
+	}
+
+	bool isDone() const { return m_stack.empty(); }
+	void prune() { m_pruned = true; }
+	bool isShape() const { return m_dag.isMesh[m_stack.back().node] != 0; }
+	unsigned int node() const { return m_stack.back().node; }
+	unsigned long long path() const { return m_stack.back().path; }
+	unsigned int state() { return read(m_stack.back().node); }
+
+	void next()
+	{
+		const FRAME &current = m_stack.back();
+		if(!m_pruned && m_dag.firstChild[current.node] < m_dag.firstChild[current.node + 1])
+		{
+			push(current, 0);
+			return;
+		}
+
+		m_pruned = false;
+		while(m_stack.size() > 1)
+		{
+			const FRAME child = m_stack.back();
+			m_stack.pop_back();
+			const FRAME &parent = m_stack.back();
+			if(m_dag.firstChild[parent.node] + child.index + 1 < m_dag.firstChild[parent.node + 1])
+			{
+				push(parent, child.index + 1);
+				return;
+			}
+		}
+		m_stack.clear();
+	}
+
+	unsigned int read(unsigned int node)
+	// Rsum: lit les attributs de la visibilit par leur nom, comme MFnDagNode::findPlug
+	{
+		const char *plugs[] = { "intermediateObject", "visibility", "overrideEnabled", "overrideVisibility" };
+		unsigned int found = 0;
+		for(unsigned int p = 0; p < 4; p++)
+		{
+			for(size_t a = 0; a < m_dag.attributes.size(); a++)
+			{
+				if(m_dag.attributes[a] == plugs[p]) { found++; break; }
+			}
+		}
+		m_reads++;
+		return found == 4 ? m_dag.state[node] : (unsigned int) CPM_NODE_HIDDEN;
+	}
+
+	// noeuds du chemin courant, le monde compris
+	size_t depth() const { return m_stack.size(); }
+	unsigned int ancestor(size_t level) const { return m_stack[level].node; }
+
+	unsigned long long reads() const { return m_reads; }
+
+	protected:
+	struct FRAME
+	{
+		unsigned int		node;
+		unsigned int		index;	// rang parmi les enfants du parent
+		unsigned long long	path;
+	};
+
+	void push(const FRAME &parent, unsigned int index)
+	{
+		const unsigned int node = m_dag.children[m_dag.firstChild[parent.node] + index];
+		FRAME frame = { node, index, PathHash(parent.path, node) };
+		m_stack.push_back(frame);
+	}
+
+	protected:
+	const SYNTHETIC_DAG		&m_dag;
+	std::vector<FRAME>		m_stack;
+	bool					m_pruned;
+	unsigned long long		m_reads;
+};
+
+struct NODE_HASH
+{
+	size_t operator()(unsigned int node) const { return node * 0x9E3779B1u; }
+};
+
+struct RESULT
+{
+	std::vector<unsigned long long>	shapes;
+	unsigned long long				visited;
+	unsigned long long				reads;
+	double							seconds;
+};
+
+static void Print(const char *name, const RESULT &result)
+{
+	printf("%-10s %12llu %12llu %10lu %10.2f\n", name, result.visited, result.reads, (unsigned long) result.shapes.size(), result.seconds * 1e3);
+}
+
+static RESULT OwnState(const SYNTHETIC_DAG &dag)
+{
+	RESULT result;
+	result.visited = 0;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	SYNTHETIC_DAG_ITERATOR it(dag);
+	for(; !it.isDone(); it.next())
+	{
+		result.visited++;
+		if(it.isShape() && !it.state()) result.shapes.push_back(it.path());
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.reads = it.reads();
+	return result;
+}
+
+static RESULT Ancestors(const SYNTHETIC_DAG &dag)
+{
+	RESULT result;
+	result.visited = 0;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	SYNTHETIC_DAG_ITERATOR it(dag);
+	for(; !it.isDone(); it.next())
+	{
+		result.visited++;
+		if(!it.isShape()) continue;
+
+		bool visible = true;
+		for(size_t level = it.depth(); level-- > 1 && visible; ) visible = it.read(it.ancestor(level)) == 0;
+		if(visible) result.shapes.push_back(it.path());
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.reads = it.reads();
+	return result;
+}
+
+static RESULT Memoized(const SYNTHETIC_DAG &dag, CPM_VISIBILITY_STATS &stats)
+{
+	RESULT result;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	SYNTHETIC_DAG_ITERATOR it(dag);
+	CPMVisibilityCache<unsigned int, NODE_HASH> cache;
+	stats = CollectVisibleShapes(it, cache, result.shapes);
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.visited = stats.visitedNodes;
+	result.reads = it.reads();
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int numNodes = 100000;
+	unsigned int seed = 1;
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-seed") == 0 && i + 1 < argc) seed = (unsigned int) atoi(argv[++i]);
+		else numNodes = (unsigned int) atoi(argv[i]);
+	}
+	if(numNodes < 2) numNodes = 2;
+
+	srand(seed);
+	SYNTHETIC_DAG dag;
+	GenerateDag(numNodes, dag);
+	printf("%u nodes, %u instanced transforms, %lu edges\n\n", numNodes, dag.instances, (unsigned long) dag.children.size());
+
+	printf("%-10s %12s %12s %10s %10s\n", "method", "visited", "state reads", "meshes", "ms");
+	const RESULT own = OwnState(dag);
+	Print("own", own);
+	RESULT ancestors = Ancestors(dag);
+	Print("ancestors", ancestors);
+	CPM_VISIBILITY_STATS stats;
+	RESULT memoized = Memoized(dag, stats);
+	Print("memoized", memoized);
+
+	printf("\n%u subtrees pruned, %u hidden meshes visited, %lu meshes of hidden subtrees exported by the own-state collection\n",
+		stats.prunedSubtrees, stats.hiddenShapes, (unsigned long) (own.shapes.size() - memoized.shapes.size()));
+
+	// les deux collectes hirarchiques doivent trouver les mmes chemins
+	std::sort(ancestors.shapes.begin(), ancestors.shapes.end());
+	std::sort(memoized.shapes.begin(), memoized.shapes.end());
+	if(ancestors.shapes != memoized.shapes)
+	{
+		fprintf(stderr, "cpmbench_visibility: memoized and ancestor collections differ\n");
+		return 1;
+	}
+	return 0;
+}
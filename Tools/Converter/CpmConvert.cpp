@@ -0,0 +1,241 @@
+//
+//	Conversion de fichiers OBJ en fichiers CPM sans Maya, pour la production des assets en batch
+//	le pipeline est celui du plugin: assemblage des vertices, conversion des axes, criture par CPMMeshWriter
+//
+//	usage: cpmconvert [-j n] [-d rpertoire] [-weld auto|serial|parallel|radix] [-weldEpsilon e] [-memoryBudget Mo] [-exportBudget Mo] [-tempDir rpertoire] [-pageSize octets] [-<option> | -no-<option> ...] <entre.obj>...
+//	les options correspondent  CPM_POLYEXPORT_OPTION (-binary, -no-normals...), les valeurs par dfaut sont celles du plugin
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "ObjConverter.h"
+#include "CPMMeshAssembler.h"
+#include "CPMValueWelder.h"
+#include "CPMTriangleCleaner.h"
+#include "CPMStreamingExport.h"
+#include "CPMParallel.h"
+
+struct CONVERSION_JOB
+{
+	std::string			input;
+	std::string			output;
+	CONVERSION_STATS	stats;
+	std::string			error;
+	bool				succeeded;
+};
+
+static std::string OutputFileName(const std::string &input, const std::string &directory)
+// Rsum: nom du fichier de sortie: extension remplace par .cpm, dans le rpertoire demand ou  ct de l'entre
+{
+	std::string name = input;
+	const size_t slash = name.find_last_of("/\\");
+	const size_t dot = name.find_last_of('.');
+	if(dot != std::string::npos && (slash == std::string::npos || dot > slash)) name.resize(dot);
+	name += ".cpm";
+
+	if(directory.empty()) return name;
+
+	const std::string baseName = slash == std::string::npos ? name : name.substr(slash + 1);
+	const char last = directory[directory.size() - 1];
+	return last == '/' || last == '\\' ? directory + baseName : directory + "/" + baseName;
+}
+
+static void PrintOptions(unsigned int exportOptions)
+{
+	fprintf(stderr, "options:");
+	for(unsigned int i = 0; i < GetExportOptionCount(); i++)
+	{
+		const CPM_POLYEXPORT_OPTION option = GetExportOption(i);
+		fprintf(stderr, " %s%s", (exportOptions & option) ? "-" : "-no-", ExportOptionName(option));
+	}
+	fprintf(stderr, "\n");
+}
+
+static int Usage()
+{
+	fprintf(stderr, "usage: cpmconvert [-j workers] [-d outputDirectory] [-weld auto|serial|parallel|radix] [-weldEpsilon e] [-areaEpsilon e] [-memoryBudget MiB] [-exportBudget MiB] [-tempDir directory] [-pageSize bytes] [-<option> | -no-<option> ...] <input.obj>...\n");
+	PrintOptions(CPM_EXPORT_DEFAULT_OPTIONS);
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int exportOptions = CPM_EXPORT_DEFAULT_OPTIONS;
+	unsigned int workers = 0;
+	std::string directory;
+	std::vector<CONVERSION_JOB> jobs;
+
+	// les rsultats et les erreurs restent dans l'ordre quand les deux sorties sont rediriges vers le mme journal
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	for(int i = 1; i < argc; i++)
+	{
+		const char *arg = argv[i];
+		CPM_POLYEXPORT_OPTION option;
+		CPM_WELD_MODE weldMode;
+
+		if(strcmp(arg, "-j") == 0 && i + 1 < argc) workers = (unsigned int) atoi(argv[++i]);
+		else if(strcmp(arg, "-d") == 0 && i + 1 < argc) directory = argv[++i];
+		else if(strcmp(arg, "-weldEpsilon") == 0 && i + 1 < argc)
+		{
+			CPM_WELD_TOLERANCE tolerance = GetWeldTolerance();
+			tolerance.position = atof(argv[++i]);
+			SetWeldTolerance(tolerance);
+		}
+		else if(strcmp(arg, "-areaEpsilon") == 0 && i + 1 < argc) SetAreaEpsilon(atof(argv[++i]));
+		else if(strcmp(arg, "-memoryBudget") == 0 && i + 1 < argc)
+		{
+			CPM_STREAMING_SETTINGS settings = GetStreamingSettings();
+			settings.memoryBudget = (size_t) atoi(argv[++i]) << 20;
+			SetStreamingSettings(settings);
+		}
+		else if(strcmp(arg, "-exportBudget") == 0 && i + 1 < argc) SetExportMemoryBudget((unsigned long long) atoi(argv[++i]) << 20);
+		else if(strcmp(arg, "-tempDir") == 0 && i + 1 < argc)
+		{
+			CPM_STREAMING_SETTINGS settings = GetStreamingSettings();
+			settings.tempDirectory = argv[++i];
+			SetStreamingSettings(settings);
+		}
+		else if(strcmp(arg, "-pageSize") == 0 && i + 1 < argc) SetPageAlignment((unsigned int) atoi(argv[++i]));
+		else if(strcmp(arg, "-weld") == 0 && i + 1 < argc && ParseWeldMode(argv[i + 1], weldMode)) { SetWeldMode(weldMode); i++; }
+		else if(strcmp(arg, "-h") == 0 || strcmp(arg, "-help") == 0) return Usage();
+		else if(strncmp(arg, "-no-", 4) == 0 && ParseExportOption(arg + 4, option)) exportOptions &= ~option;
+		else if(arg[0] == '-' && ParseExportOption(arg + 1, option))
+		{
+			// les deux modes de compression s'excluent, comme dans la fentre du plugin
+			if(option == CPM_EXPORT_COMPRESS_FAST) exportOptions &= ~CPM_EXPORT_COMPRESS_ARCHIVE;
+			if(option == CPM_EXPORT_COMPRESS_ARCHIVE) exportOptions &= ~CPM_EXPORT_COMPRESS_FAST;
+			exportOptions |= option;
+		}
+		else if(arg[0] == '-')
+		{
+			fprintf(stderr, "cpmconvert: unknown option %s\n", arg);
+			return Usage();
+		}
+		else
+		{
+			CONVERSION_JOB job;
+			job.input = arg;
+			job.succeeded = false;
+			jobs.push_back(job);
+		}
+	}
+
+	if(jobs.empty()) return Usage();
+
+	// les fichiers OBJ n'ont pas de couleurs de vertices: la section CPM_TAG_COLORS serait vide
+	if(exportOptions & CPM_EXPORT_COLORS)
+	{
+		fprintf(stderr, "cpmconvert: OBJ files have no vertex colors, -colors is ignored\n");
+		exportOptions &= ~CPM_EXPORT_COLORS;
+	}
+	// les fichiers OBJ n'ont pas de tangentes: elles sont calcules (MikkTSpace)  partir des normales et des UVs du mesh entier
+	if((exportOptions & CPM_EXPORT_TGT_BINORMALS) && (!(exportOptions & CPM_EXPORT_NORMALS) || !(exportOptions & CPM_EXPORT_UVS)))
+	{
+		fprintf(stderr, "cpmconvert: -tangents needs -normals and -uvs, it is ignored\n");
+		exportOptions &= ~CPM_EXPORT_TGT_BINORMALS;
+	}
+	if((exportOptions & CPM_EXPORT_STREAMING) && (exportOptions & CPM_EXPORT_TGT_BINORMALS))
+	{
+		fprintf(stderr, "cpmconvert: -tangents needs the whole mesh in memory, it is ignored with -streaming\n");
+		exportOptions &= ~CPM_EXPORT_TGT_BINORMALS;
+	}
+	if((exportOptions & CPM_EXPORT_STREAMING) && (exportOptions & CPM_EXPORT_WELD_BY_VALUE))
+	{
+		fprintf(stderr, "cpmconvert: -weldByValue needs the whole mesh in memory, it is ignored with -streaming\n");
+		exportOptions &= ~CPM_EXPORT_WELD_BY_VALUE;
+	}
+	if((exportOptions & CPM_EXPORT_STREAMING) && (exportOptions & CPM_EXPORT_SUBMESHES))
+	{
+		fprintf(stderr, "cpmconvert: -submeshes needs the whole mesh in memory, it is ignored with -streaming\n");
+		exportOptions &= ~CPM_EXPORT_SUBMESHES;
+	}
+	if((exportOptions & CPM_EXPORT_STREAMING) && (exportOptions & CPM_EXPORT_SPLIT_16BIT))
+	{
+		fprintf(stderr, "cpmconvert: -split16 needs the whole mesh in memory, it is ignored with -streaming\n");
+		exportOptions &= ~CPM_EXPORT_SPLIT_16BIT;
+	}
+	if((exportOptions & CPM_EXPORT_STREAMING) && (exportOptions & CPM_EXPORT_CLEAN_TRIANGLES))
+	{
+		fprintf(stderr, "cpmconvert: -cleanTriangles needs the whole mesh in memory, it is ignored with -streaming\n");
+		exportOptions &= ~CPM_EXPORT_CLEAN_TRIANGLES;
+	}
+	if((exportOptions & CPM_EXPORT_STREAMING) && (exportOptions & CPM_EXPORT_ADJACENCY))
+	{
+		fprintf(stderr, "cpmconvert: -adjacency needs the whole mesh in memory, it is ignored with -streaming\n");
+		exportOptions &= ~CPM_EXPORT_ADJACENCY;
+	}
+	if(IsExportCompressed(exportOptions) && !IsCodecAvailable(GetExportCodec(exportOptions)))
+	{
+		fprintf(stderr, "cpmconvert: %s is not available in this build, chunks are stored\n", CodecName(GetExportCodec(exportOptions)));
+	}
+
+	// deux conversions simultanes ne doivent pas crire le mme fichier
+	for(size_t i = 0; i < jobs.size(); i++)
+	{
+		jobs[i].output = OutputFileName(jobs[i].input, directory);
+		for(size_t j = 0; j < i; j++)
+		{
+			if(jobs[j].output == jobs[i].output)
+			{
+				fprintf(stderr, "cpmconvert: %s and %s would both be written to %s\n", jobs[j].input.c_str(), jobs[i].input.c_str(), jobs[i].output.c_str());
+				return 2;
+			}
+		}
+	}
+
+	// un fichier par tche: chaque conversion est indpendante
+	unsigned int failures = 0;
+	{
+		CPMThreadPool pool(workers ? workers : GetWorkerCount());
+
+		std::vector< std::future<void> > pending(jobs.size());
+		for(size_t i = 0; i < jobs.size(); i++)
+		{
+			CONVERSION_JOB *job = &jobs[i];
+			pending[i] = pool.submit([job, exportOptions]() { job->succeeded = ConvertObjFile(job->input, job->output, exportOptions, job->stats, job->error); });
+		}
+
+		// les rsultats sont affichs dans l'ordre de la ligne de commande
+		for(size_t i = 0; i < jobs.size(); i++)
+		{
+			pending[i].wait();
+
+			const CONVERSION_JOB &job = jobs[i];
+			if(!job.succeeded)
+			{
+				fprintf(stderr, "cpmconvert: %s\n", job.error.c_str());
+				failures++;
+				continue;
+			}
+
+			// rduction par rapport au nombre de vertices avant la fusion par valeur, ou volume des fichiers temporaires, gain des indices 16 bits ou compresss
+			// et artes sans voisin de l'adjacence
+			char details[256] = "";
+			const unsigned long long inputVertices = job.stats.vertices + job.stats.weldedVertices;
+			if((exportOptions & CPM_EXPORT_WELD_BY_VALUE) && inputVertices) sprintf(details, " (%llu welded, -%.1f%%)", job.stats.weldedVertices, 100.0 * job.stats.weldedVertices / inputVertices);
+
+			if(exportOptions & CPM_EXPORT_STREAMING) sprintf(details, " (%.2f MiB spilled)", job.stats.spilledBytes / (1024.0 * 1024.0));
+			if(job.stats.savedIndexBytes) sprintf(details + strlen(details), " (%.2f MiB saved on indices)", job.stats.savedIndexBytes / (1024.0 * 1024.0));
+			if(exportOptions & CPM_EXPORT_ADJACENCY) sprintf(details + strlen(details), " (%llu open edges, %llu non-manifold)", job.stats.openEdges, job.stats.nonManifoldEdges);
+			if(job.stats.tangentVertices) sprintf(details + strlen(details), " (%llu split by tangents)", job.stats.tangentVertices);
+			if(job.stats.exportScheduler.deferred) sprintf(details + strlen(details), " (%u starts deferred by the export budget)", job.stats.exportScheduler.deferred);
+
+			printf("%s -> %s: %u meshes, %llu triangles, %llu vertices%s, %.2f MiB in %.3f s\n", job.input.c_str(), job.output.c_str(), job.stats.meshes,
+				job.stats.triangles, job.stats.vertices, details, job.stats.bytes / (1024.0 * 1024.0), job.stats.seconds);
+			for(size_t c = 0; c < job.stats.cleanups.size(); c++)
+			{
+				const CPM_TRIANGLE_CLEANUP_STATS &cleanup = job.stats.cleanups[c].stats;
+				printf("  %s: %u of %u triangles removed (%u index-degenerate, %u zero-area, %u duplicates)\n", job.stats.cleanups[c].name.c_str(),
+					cleanup.removed(), cleanup.inputTriangles, cleanup.indexDegenerate, cleanup.areaDegenerate, cleanup.duplicates);
+			}
+		}
+	}
+
+	if(failures) fprintf(stderr, "cpmconvert: %u of %u files failed\n", failures, (unsigned int) jobs.size());
+	return failures ? 1 : 0;
+}
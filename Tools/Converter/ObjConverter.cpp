@@ -0,0 +1,459 @@
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+
+#include "ObjConverter.h"
+#include "CPMMeshAssembler.h"
+#include "CPMVertexKernels.h"
+#include "CPMChunkedStream.h"
+#include "CPMChecksum.h"
+#include "CPMValueWelder.h"
+#include "CPMStreamingExport.h"
+#include "CPMSubmeshBuilder.h"
+#include "CPMMeshSplitter.h"
+#include "CPMAdjacency.h"
+#include "CPMTriangleCleaner.h"
+#include "CPMTangentSpace.h"
+#include "CPMExportScheduler.h"
+
+
+//
+//	LOCAL_INDEX_MAP
+//
+int LOCAL_INDEX_MAP::get(int global)
+{
+	if(m_local[global] < 0)
+	{
+		m_local[global] = (int) m_globals.size();
+		m_globals.push_back(global);
+	}
+	return m_local[global];
+}
+
+void LOCAL_INDEX_MAP::clear()
+{
+	for(size_t i = 0; i < m_globals.size(); i++) m_local[m_globals[i]] = -1;
+	m_globals.clear();
+}
+
+
+//
+//	ObjMeshBuilder
+//
+ObjMeshBuilder::ObjMeshBuilder(const OBJ_SCENE &scene, unsigned int exportOptions) : m_scene(scene), m_exportOptions(exportOptions),
+	m_points(scene.points.size() / 4), m_normals(scene.normals.size() / 3), m_uvs(scene.u.size())
+{
+
+}
+
+void ObjMeshBuilder::generateNormals(const OBJ_OBJECT &object, std::vector<float> &normals)
+// Rsum: normales lisses par point (somme des normales des polygones, pondres par leur aire), pour les faces sans 'vn'
+{
+	const std::vector<int> &globals = m_points.globals();
+	normals.assign(globals.size() * 3, 0.0f);
+
+	size_t f = 0;
+	for(size_t p = 0; p < object.polygonSizes.size(); f += object.polygonSizes[p], p++)
+	{
+		// normale de Newell: robuste pour les polygones non plans
+		double n[3] = { 0.0, 0.0, 0.0 };
+		const unsigned int size = object.polygonSizes[p];
+		for(unsigned int k = 0; k < size; k++)
+		{
+			const double *a = &m_scene.points[object.faceVertices[f + k].point * 4];
+			const double *b = &m_scene.points[object.faceVertices[f + (k + 1) % size].point * 4];
+			n[0] += (a[1] - b[1]) * (a[2] + b[2]);
+			n[1] += (a[2] - b[2]) * (a[0] + b[0]);
+			n[2] += (a[0] - b[0]) * (a[1] + b[1]);
+		}
+
+		for(unsigned int k = 0; k < size; k++)
+		{
+			float *normal = &normals[m_points.get(object.faceVertices[f + k].point) * 3];
+			for(unsigned int c = 0; c < 3; c++) normal[c] += (float) n[c];
+		}
+	}
+
+	for(size_t i = 0; i < normals.size(); i += 3)
+	{
+		const float length = sqrtf(normals[i] * normals[i] + normals[i + 1] * normals[i + 1] + normals[i + 2] * normals[i + 2]);
+		if(length > 0.0f) for(unsigned int c = 0; c < 3; c++) normals[i + c] /= length;
+	}
+}
+
+void ObjMeshBuilder::prepare(const OBJ_OBJECT &object)
+// Rsum: indices locaux des face-vertices de l'objet et tableaux source de l'assemblage
+{
+	const bool exportNormals = (m_exportOptions & CPM_EXPORT_NORMALS) != 0;
+	const bool exportUVs = (m_exportOptions & CPM_EXPORT_UVS) != 0;
+	const size_t numFaceVertices = object.faceVertices.size();
+
+	// points, normales et uvs de l'objet
+	m_points.clear();
+	m_normals.clear();
+	m_uvs.clear();
+	m_pointIds.resize(numFaceVertices);
+	for(size_t f = 0; f < numFaceVertices; f++) m_pointIds[f] = m_points.get(object.faceVertices[f].point);
+
+	bool missingNormals = false, missingUVs = false;
+	m_normalIds.assign(numFaceVertices, 0);
+	m_uvIds.assign(numFaceVertices, 0);
+	for(size_t f = 0; f < numFaceVertices; f++)
+	{
+		const OBJ_FACE_VERTEX &vertex = object.faceVertices[f];
+		if(vertex.normal >= 0) m_normalIds[f] = m_normals.get(vertex.normal);
+		else missingNormals = true;
+		if(vertex.uv >= 0) m_uvIds[f] = m_uvs.get(vertex.uv);
+		else missingUVs = true;
+	}
+
+	// source de l'assemblage: les normales gnres et l'uv (0, 0) des face-vertices qui n'en ont pas sont placs aprs ceux du fichier
+	m_sourcePoints.resize(m_points.globals().size() * 4);
+	for(size_t i = 0; i < m_points.globals().size(); i++) memcpy(&m_sourcePoints[i * 4], &m_scene.points[m_points.globals()[i] * 4], 4 * sizeof(double));
+
+	m_sourceNormals.resize(m_normals.globals().size() * 3);
+	for(size_t i = 0; i < m_normals.globals().size(); i++) memcpy(&m_sourceNormals[i * 3], &m_scene.normals[m_normals.globals()[i] * 3], 3 * sizeof(float));
+	if(exportNormals && missingNormals)
+	{
+		const unsigned int generated = (unsigned int) m_normals.globals().size();
+		std::vector<float> generatedNormals;
+		generateNormals(object, generatedNormals);
+		m_sourceNormals.insert(m_sourceNormals.end(), generatedNormals.begin(), generatedNormals.end());
+
+		for(size_t f = 0; f < numFaceVertices; f++)
+		{
+			if(object.faceVertices[f].normal < 0) m_normalIds[f] = generated + m_pointIds[f];
+		}
+	}
+
+	m_sourceU.resize(m_uvs.globals().size());
+	m_sourceV.resize(m_uvs.globals().size());
+	for(size_t i = 0; i < m_uvs.globals().size(); i++) { m_sourceU[i] = m_scene.u[m_uvs.globals()[i]]; m_sourceV[i] = m_scene.v[m_uvs.globals()[i]]; }
+	if(exportUVs && missingUVs)
+	{
+		const unsigned int origin = (unsigned int) m_sourceU.size();
+		m_sourceU.push_back(0.0f);
+		m_sourceV.push_back(0.0f);
+		for(size_t f = 0; f < numFaceVertices; f++) if(object.faceVertices[f].uv < 0) m_uvIds[f] = origin;
+	}
+
+	m_ids = FACE_VERTEX_IDS();
+	m_ids.count = numFaceVertices;
+	if(numFaceVertices)
+	{
+		m_ids.points = &m_pointIds[0];
+		if(exportNormals) m_ids.normals = &m_normalIds[0];
+		if(exportUVs) m_ids.uvs = &m_uvIds[0];
+	}
+
+	m_source = ASSEMBLY_SOURCE();
+	m_source.points = m_sourcePoints.empty() ? NULL : &m_sourcePoints[0];
+	m_source.normals = m_sourceNormals.empty() ? NULL : &m_sourceNormals[0];
+	m_source.u = m_sourceU.empty() ? NULL : &m_sourceU[0];
+	m_source.v = m_sourceV.empty() ? NULL : &m_sourceV[0];
+}
+
+void ObjMeshBuilder::collectMaterials(const OBJ_OBJECT &object, CPM_MESH_DATA &mesh, std::vector<int> &polygonMaterials)
+// Rsum: matriaux dans l'ordre de leur premire utilisation par l'objet et indice dans mesh.materials du matriau de chaque polygone
+{
+	std::vector<int> materialIndices;
+	polygonMaterials.resize(object.polygonMaterials.size());
+	for(size_t p = 0; p < object.polygonMaterials.size(); p++)
+	{
+		size_t m = 0;
+		while(m < materialIndices.size() && materialIndices[m] != object.polygonMaterials[p]) m++;
+		if(m == materialIndices.size()) materialIndices.push_back(object.polygonMaterials[p]);
+		polygonMaterials[p] = (int) m;
+	}
+
+	mesh.strings = &m_scene.strings;
+	mesh.materials.resize(materialIndices.size());
+	for(size_t m = 0; m < materialIndices.size(); m++)
+	{
+		// les faces sans 'usemtl' reoivent le matriau par dfaut
+		if(materialIndices[m] >= 0) mesh.materials[m] = m_scene.materials[materialIndices[m]].material;
+	}
+}
+
+void ObjMeshBuilder::buildMaterials(const OBJ_OBJECT &object, CPM_MESH_DATA &mesh)
+// Rsum: les triangles des matriaux suivent la triangulation en ventail
+{
+	std::vector<int> polygonMaterials;
+	collectMaterials(object, mesh, polygonMaterials);
+
+	std::vector<unsigned int> triangleCounts(object.polygonSizes.size());
+	for(size_t p = 0; p < object.polygonSizes.size(); p++) triangleCounts[p] = object.polygonSizes[p] - 2;
+
+	std::vector< std::vector<unsigned int> > materialFaces(mesh.materials.size());
+	for(size_t p = 0; p < polygonMaterials.size(); p++) materialFaces[polygonMaterials[p]].push_back((unsigned int) p);
+
+	std::vector<unsigned int> offsets;
+	BuildTriangleOffsets(triangleCounts, (unsigned int) triangleCounts.size(), offsets);
+	for(size_t m = 0; m < mesh.materials.size(); m++) BuildMaterialTriangleIds(offsets, materialFaces[m], mesh.materials[m].faceIds);
+}
+
+void ObjMeshBuilder::build(const OBJ_OBJECT &object, CPM_MESH_DATA &mesh)
+{
+	const size_t numFaceVertices = object.faceVertices.size();
+
+	mesh.name = object.name;
+	prepare(object);
+
+	// assemblage des vertices
+	CPMVertexWelder welder((unsigned int) m_points.globals().size());
+	std::vector<unsigned int> vertexIds(numFaceVertices);
+	if(numFaceVertices) welder.weld(m_ids, &vertexIds[0]);
+
+	// triangulation en ventail, dans l'ordre des sommets comme les polygones de Maya
+	size_t numTriangles = 0;
+	for(size_t p = 0; p < object.polygonSizes.size(); p++) numTriangles += object.polygonSizes[p] - 2;
+
+	mesh.triangles.resize(numTriangles * 3);
+	unsigned int *triangle = mesh.triangles.empty() ? NULL : &mesh.triangles[0];
+	size_t f = 0;
+	for(size_t p = 0; p < object.polygonSizes.size(); f += object.polygonSizes[p], p++)
+	{
+		for(unsigned int k = 1; k + 1 < object.polygonSizes[p]; k++)
+		{
+			*triangle++ = vertexIds[f];
+			*triangle++ = vertexIds[f + k];
+			*triangle++ = vertexIds[f + k + 1];
+		}
+	}
+
+	ASSEMBLY_OUTPUT output;
+	output.points = &mesh.points;
+	if(m_exportOptions & CPM_EXPORT_NORMALS) output.normals = &mesh.normals;
+	if(m_exportOptions & CPM_EXPORT_UVS) output.UVs = &mesh.UVs;
+
+	welder.assemble(m_source, output);
+
+	if(m_exportOptions & CPM_EXPORT_MATERIALSETS) buildMaterials(object, mesh);
+
+	// conversion vers le repre demand, comme CPMPolyWriter::extractGeometry
+	const AXIS_CONVERSION conversion = GetExportAxisConversion(m_exportOptions);
+	ApplyAxisConversion(conversion, mesh.triangles);
+	ApplyAxisConversion(conversion, mesh.points);
+	ApplyAxisConversion(conversion, mesh.normals);
+	ApplyAxisConversion(conversion, mesh.UVs);
+}
+
+bool ObjMeshBuilder::buildStreaming(const OBJ_OBJECT &object, CPM_MESH_DATA &mesh, CPMStreamingMesh &streamingMesh)
+{
+	mesh.name = object.name;
+	prepare(object);
+
+	CPMArrayVertexSource vertices(m_source);
+	STREAMING_SOURCE source;
+	source.vertices = &vertices;
+	source.numPoints = (unsigned int) m_points.globals().size();
+	source.numNormals = (unsigned int) m_sourceNormals.size() / 3;
+	source.numUVs = (unsigned int) m_sourceU.size();
+
+	// les triangles des matriaux sont rpartis par streamingMesh, mesh ne reoit que leurs paramtres
+	std::vector<int> polygonMaterials;
+	if(m_exportOptions & CPM_EXPORT_MATERIALSETS)
+	{
+		collectMaterials(object, mesh, polygonMaterials);
+		source.numMaterials = (unsigned int) mesh.materials.size();
+	}
+
+	// le streaming porte sur les triangles et les vertices, les face-vertices de l'objet sont dj en mmoire dans OBJ_SCENE
+	CPMFaceVertexStream polygons(m_ids, object.polygonSizes, source.numMaterials ? &polygonMaterials : NULL);
+	return streamingMesh.build(polygons, source);
+}
+
+struct CONVERTED_OBJECT
+// Objet entre son assemblage et son criture; stats ne reoit que les compteurs du traitement, ajouts  ceux du fichier  l'criture
+{
+	CONVERTED_OBJECT() : streamingMesh(NULL) {}
+
+	CPM_MESH_DATA				mesh;
+	std::vector<CPM_MESH_DATA>	parts;
+	CPMStreamingMesh			*streamingMesh;
+	CONVERSION_STATS			stats;
+};
+
+static void ProcessObject(CONVERTED_OBJECT &object, unsigned int exportOptions)
+// Rsum: traitement d'un objet assembl, sur un thread du pool: ne touche ni  la scne ni aux tables de ObjMeshBuilder
+{
+	CPM_MESH_DATA &mesh = object.mesh;
+	CONVERSION_STATS &stats = object.stats;
+
+	if(exportOptions & CPM_EXPORT_WELD_BY_VALUE)
+	{
+		const CPM_VALUE_WELD_STATS weldStats = WeldMeshByValue(mesh, GetWeldTolerance());
+		stats.weldedVertices += weldStats.inputVertices - weldStats.outputVertices;
+	}
+	if(exportOptions & CPM_EXPORT_CLEAN_TRIANGLES)
+	{
+		OBJECT_CLEANUP cleanup;
+		cleanup.name = mesh.name;
+		cleanup.stats = CleanMeshTriangles(mesh, GetAreaEpsilon());
+		if(cleanup.stats.removed()) stats.cleanups.push_back(cleanup);
+	}
+	// les fichiers OBJ n'ont pas de tangentes: elles sont toujours calcules par CPMTangentSpace
+	if(exportOptions & CPM_EXPORT_TGT_BINORMALS)
+	{
+		const CPM_TANGENT_STATS tangentStats = GenerateMeshTangents(mesh);
+		stats.tangentVertices += tangentStats.outputVertices - tangentStats.inputVertices;
+	}
+
+	// mme ordre que CPMPolyWriter::processGeometry: dcoupage, puis sous-meshes et adjacence de chaque morceau
+	const bool submeshes = (exportOptions & CPM_EXPORT_SUBMESHES) && (exportOptions & CPM_EXPORT_MATERIALSETS);
+	if(exportOptions & CPM_EXPORT_SPLIT_16BIT) SplitMesh(mesh, CPM_MAX_16BIT_VERTICES, submeshes, object.parts);
+
+	const size_t numObjects = object.parts.empty() ? 1 : object.parts.size();
+	for(size_t p = 0; p < numObjects; p++)
+	{
+		CPM_MESH_DATA &part = object.parts.empty() ? mesh : object.parts[p];
+		if(submeshes) BuildSubmeshes(part);
+		if(exportOptions & CPM_EXPORT_ADJACENCY)
+		{
+			const CPM_ADJACENCY_STATS adjacencyStats = BuildMeshAdjacency(part);
+			stats.openEdges += adjacencyStats.boundaryEdges + adjacencyStats.nonManifoldEdges + adjacencyStats.degenerateEdges;
+			stats.nonManifoldEdges += adjacencyStats.nonManifoldEdges;
+		}
+	}
+}
+
+bool ConvertObjFile(const std::string &input, const std::string &output, unsigned int exportOptions, CONVERSION_STATS &stats, std::string &error)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	OBJ_SCENE scene;
+	if(!ReadObjFile(input, scene, error)) return false;
+
+	if(scene.objects.empty())
+	{
+		error = input + ": no polygon to export";
+		return false;
+	}
+
+	std::ofstream file(output.c_str(), std::ios::out | std::ios::binary);
+	if(!file)
+	{
+		error = "cannot open " + output + " for writing";
+		return false;
+	}
+
+	// mme organisation du fichier que PolyExporter::writer
+	CPMChunkedOStream *container = IsExportCompressed(exportOptions) ? new CPMChunkedOStream(file, GetExportCodec(exportOptions)) : NULL;
+	CPMChecksumOStream *checksums = (exportOptions & CPM_EXPORT_BINARY) && !container ? new CPMChecksumOStream(file) : NULL;
+	std::ostream &os = container ? (std::ostream&) *container : checksums ? (std::ostream&) *checksums : (std::ostream&) file;
+
+	ObjMeshBuilder builder(scene, exportOptions);
+	CPMObjectTable objects;
+
+	WriteFileHeader(os, exportOptions);
+
+	// assemblage sur ce thread (tables d'indices partages de builder), du plus gros objet au plus petit dans la limite
+	// du budget mmoire, traitement sur les threads du pool, criture dans l'ordre du fichier OBJ
+	std::vector<CONVERTED_OBJECT> converted(scene.objects.size());
+	CPMExportScheduler scheduler(GetExportMemoryBudget());
+	for(size_t i = 0; i < scene.objects.size(); i++)
+	{
+		scheduler.add(EstimateMeshMemory(scene.objects[i].polygonSizes.size(), scene.objects[i].faceVertices.size(), exportOptions));
+	}
+
+	size_t failed = 0;
+	RunScheduledExport(scheduler,
+		[&](size_t i) -> bool
+		{
+			CONVERTED_OBJECT &object = converted[i];
+			if(exportOptions & CPM_EXPORT_STREAMING)
+			{
+				object.streamingMesh = new CPMStreamingMesh(exportOptions);
+				if(!builder.buildStreaming(scene.objects[i], object.mesh, *object.streamingMesh))
+				{
+					error = input + ": " + object.streamingMesh->getError();
+					return false;
+				}
+				return true;
+			}
+
+			builder.build(scene.objects[i], object.mesh);
+			return true;
+		},
+		[&](size_t i) -> bool
+		{
+			if(!converted[i].streamingMesh) ProcessObject(converted[i], exportOptions);
+			return true;
+		},
+		[&](size_t i) -> bool
+		{
+			CONVERTED_OBJECT &object = converted[i];
+			if(object.streamingMesh)
+			{
+				if(!object.streamingMesh->write(os, object.mesh, &objects))
+				{
+					error = input + ": " + object.streamingMesh->getError();
+					return false;
+				}
+
+				stats.meshes++;
+				stats.triangles += object.streamingMesh->getStats().triangles;
+				stats.vertices += object.streamingMesh->getStats().vertices;
+				stats.spilledBytes += object.streamingMesh->getStats().spilledBytes;
+				stats.savedIndexBytes += object.streamingMesh->getStats().savedIndexBytes;
+
+				delete object.streamingMesh;
+				object.streamingMesh = NULL;
+				return true;
+			}
+
+			const size_t numObjects = object.parts.empty() ? 1 : object.parts.size();
+			for(size_t p = 0; p < numObjects; p++)
+			{
+				const CPM_MESH_DATA &part = object.parts.empty() ? object.mesh : object.parts[p];
+
+				CPMMeshWriter writer(part, exportOptions);
+				writer.write(os, &objects);
+
+				stats.meshes++;
+				stats.triangles += part.triangles.size() / 3;
+				stats.vertices += part.points.size();
+				stats.savedIndexBytes += GetIndexLayout(part, exportOptions).savedBytes;
+			}
+
+			stats.weldedVertices += object.stats.weldedVertices;
+			stats.tangentVertices += object.stats.tangentVertices;
+			stats.openEdges += object.stats.openEdges;
+			stats.nonManifoldEdges += object.stats.nonManifoldEdges;
+			stats.cleanups.insert(stats.cleanups.end(), object.stats.cleanups.begin(), object.stats.cleanups.end());
+
+			// la mmoire de l'objet est rendue au budget
+			object = CONVERTED_OBJECT();
+			return true;
+		},
+		failed);
+
+	for(size_t i = 0; i < converted.size(); i++) delete converted[i].streamingMesh;
+	stats.exportScheduler = scheduler.getStats();
+
+	WriteFileFooter(os, exportOptions, scene.strings, objects);
+
+	bool written = (bool) os;
+	delete checksums;
+	if(container)
+	{
+		written = container->close() && written;
+		delete container;
+	}
+	file.flush();
+	stats.bytes = (unsigned long long) file.tellp();
+	written = written && (bool) file;
+	file.close();
+
+	if(!written || !error.empty())
+	{
+		remove(output.c_str());
+		if(error.empty()) error = "write error on " + output;
+		return false;
+	}
+
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
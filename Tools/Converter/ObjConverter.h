@@ -0,0 +1,100 @@
+#ifndef OBJ_CONVERTER_H_INCLUDED
+#define OBJ_CONVERTER_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "ObjReader.h"
+#include "CPMMeshAssembler.h"
+#include "CPMTriangleCleaner.h"
+#include "CPMExportScheduler.h"
+
+class CPMStreamingMesh;
+
+//
+//	Conversion OBJ -> CPM avec le pipeline du plugin: assemblage des vertices (CPMVertexWelder),
+//	conversion des axes, puis criture par CPMMeshWriter
+//
+struct OBJECT_CLEANUP
+{
+	std::string					name;
+	CPM_TRIANGLE_CLEANUP_STATS	stats;
+};
+
+struct CONVERSION_STATS
+{
+	CONVERSION_STATS() : meshes(0), triangles(0), vertices(0), weldedVertices(0), spilledBytes(0), savedIndexBytes(0), tangentVertices(0), openEdges(0), nonManifoldEdges(0), bytes(0), seconds(0.0) {}
+
+	unsigned int		meshes;		// objets crits, chaque morceau d'un mesh dcoup compris
+	unsigned long long	triangles;
+	unsigned long long	vertices;
+	unsigned long long	weldedVertices;	// vertices supprims par CPM_EXPORT_WELD_BY_VALUE
+	unsigned long long	spilledBytes;	// octets passs par les fichiers temporaires de CPM_EXPORT_STREAMING
+	unsigned long long	savedIndexBytes; // indices crits sur 16 bits ou compresss au lieu de 32 bits
+	unsigned long long	tangentVertices;	// vertices dupliqus par les tangentes de CPM_EXPORT_TGT_BINORMALS
+	unsigned long long	openEdges;		// artes sans voisin de CPM_EXPORT_ADJACENCY: bords, non-manifold et dgnres
+	unsigned long long	nonManifoldEdges;
+	std::vector<OBJECT_CLEANUP>	cleanups;	// objets dont CPM_EXPORT_CLEAN_TRIANGLES a supprim des triangles
+	CPM_SCHEDULER_STATS	exportScheduler;	// lancements retards par le budget mmoire de l'exportation
+	unsigned long long	bytes;		// taille du fichier crit
+	double				seconds;
+};
+
+class LOCAL_INDEX_MAP
+// Indices locaux  un objet: les tableaux de la scne sont partags par tous les objets du fichier
+{
+	public:
+	explicit LOCAL_INDEX_MAP(size_t globalCount) : m_local(globalCount, -1) {}
+
+	int get(int global); // indice local de l'lment global, attribu  sa premire utilisation
+	void clear(); // remet  zro les seuls lments utiliss par l'objet prcdent
+
+	const std::vector<int> &globals() const { return m_globals; }
+
+	protected:
+	std::vector<int>	m_local;
+	std::vector<int>	m_globals; // lment global de chaque indice local
+};
+
+class ObjMeshBuilder
+// Construit les meshes CPM des objets d'une scne, les tables d'indices locaux sont rutilises d'un objet  l'autre
+{
+	public:
+	ObjMeshBuilder(const OBJ_SCENE &scene, unsigned int exportOptions);
+
+	void build(const OBJ_OBJECT &object, CPM_MESH_DATA &mesh);
+
+	// CPM_EXPORT_STREAMING: mesh ne reoit que le nom et les matriaux, la gomtrie est assemble par streamingMesh
+	bool buildStreaming(const OBJ_OBJECT &object, CPM_MESH_DATA &mesh, CPMStreamingMesh &streamingMesh);
+
+	protected:
+	void prepare(const OBJ_OBJECT &object);
+	void collectMaterials(const OBJ_OBJECT &object, CPM_MESH_DATA &mesh, std::vector<int> &polygonMaterials);
+	void buildMaterials(const OBJ_OBJECT &object, CPM_MESH_DATA &mesh);
+	void generateNormals(const OBJ_OBJECT &object, std::vector<float> &normals);
+
+	protected:
+	const OBJ_SCENE		&m_scene;
+	unsigned int		m_exportOptions;
+
+	LOCAL_INDEX_MAP		m_points;
+	LOCAL_INDEX_MAP		m_normals;
+	LOCAL_INDEX_MAP		m_uvs;
+
+	// face-vertices de l'objet en cours, en indices locaux, et tableaux source de l'assemblage
+	std::vector<unsigned int>	m_pointIds;
+	std::vector<unsigned int>	m_normalIds;
+	std::vector<unsigned int>	m_uvIds;
+	FACE_VERTEX_IDS				m_ids;
+
+	std::vector<double>	m_sourcePoints;
+	std::vector<float>	m_sourceNormals;
+	std::vector<float>	m_sourceU;
+	std::vector<float>	m_sourceV;
+	ASSEMBLY_SOURCE		m_source;
+};
+
+// convertit un fichier entier, le fichier de sortie est supprim en cas d'chec
+bool ConvertObjFile(const std::string &input, const std::string &output, unsigned int exportOptions, CONVERSION_STATS &stats, std::string &error);
+
+#endif // OBJ_CONVERTER_H_INCLUDED
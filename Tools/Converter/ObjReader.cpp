@@ -0,0 +1,258 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "ObjReader.h"
+
+//
+//	Lecture ligne par ligne d'un fichier charg en mmoire
+//
+static bool ReadWholeFile(const std::string &fileName, std::string &data)
+{
+	std::ifstream file(fileName.c_str(), std::ios::binary);
+	if(!file) return false;
+
+	file.seekg(0, std::ios::end);
+	data.resize((size_t) file.tellg());
+	file.seekg(0, std::ios::beg);
+	if(!data.empty()) file.read(&data[0], data.size());
+
+	return (bool) file;
+}
+
+static const char *SkipSpaces(const char *p)
+{
+	while(*p == ' ' || *p == '\t') p++;
+	return p;
+}
+
+static std::string RestOfLine(const char *p)
+// Rsum: reste de la ligne sans les espaces de dbut et de fin
+{
+	p = SkipSpaces(p);
+	const char *end = p + strcspn(p, "\r\n");
+	while(end > p && (end[-1] == ' ' || end[-1] == '\t')) end--;
+	return std::string(p, end);
+}
+
+static bool IsKeyword(const char *line, const char *keyword, const char **args)
+{
+	const size_t length = strlen(keyword);
+	if(strncmp(line, keyword, length) != 0 || (line[length] != ' ' && line[length] != '\t')) return false;
+
+	*args = line + length;
+	return true;
+}
+
+static int ResolveIndex(long index, size_t count)
+// Rsum: indice OBJ ( partir de 1, ngatif = relatif  la fin) vers un indice  partir de 0, -1 si invalide
+{
+	if(index > 0 && (size_t) index <= count) return (int) index - 1;
+	if(index < 0 && (size_t) -index <= count) return (int) (count + index);
+	return -1;
+}
+
+static std::string DirectoryOf(const std::string &fileName)
+{
+	const size_t p = fileName.find_last_of("/\\");
+	return p == std::string::npos ? std::string() : fileName.substr(0, p + 1);
+}
+
+
+//
+//	Bibliothque de matriaux
+//
+static void ReadColor(const char *args, float *color)
+{
+	char *end;
+	for(unsigned int i = 0; i < 3; i++)
+	{
+		color[i] = (float) strtod(args, &end);
+		args = end;
+	}
+}
+
+static unsigned int TextureFile(const char *args, CPMStringPool &strings)
+// Rsum: offset dans le pool du nom de fichier d'une instruction map_*, les options (-bm 1, -clamp on...) le prcdent
+{
+	const std::string line = RestOfLine(args);
+	const size_t p = line.find_last_of(" \t");
+	return p == std::string::npos ? strings.intern(line.c_str(), line.size()) : strings.intern(line.c_str() + p + 1, line.size() - p - 1);
+}
+
+static void ReadMtlFile(const std::string &fileName, OBJ_SCENE &scene)
+{
+	std::string data;
+	if(!ReadWholeFile(fileName, data)) return; // les matriaux absents gardent leurs valeurs par dfaut
+
+	OBJ_MATERIAL *current = NULL;
+	for(const char *line = data.c_str(); *line; )
+	{
+		const char *p = SkipSpaces(line), *args;
+
+		if(IsKeyword(p, "newmtl", &args))
+		{
+			const std::string name = RestOfLine(args);
+
+			current = NULL;
+			for(size_t i = 0; i < scene.materials.size() && !current; i++) if(scene.materials[i].name == name) current = &scene.materials[i];
+			if(!current)
+			{
+				scene.materials.push_back(OBJ_MATERIAL());
+				current = &scene.materials.back();
+				current->name = name;
+			}
+		}
+		else if(current)
+		{
+			CPM_MATERIAL &m = current->material;
+
+			if(IsKeyword(p, "Kd", &args)) ReadColor(args, m.color);
+			else if(IsKeyword(p, "Ks", &args)) ReadColor(args, m.specularColor);
+			else if(IsKeyword(p, "Ka", &args)) ReadColor(args, m.ambient);
+			else if(IsKeyword(p, "Ns", &args)) m.specularPower = (float) atof(args);
+			else if(IsKeyword(p, "d", &args)) { const float t = 1.0f - (float) atof(args); CPM_MATERIAL::SetColor(m.transparency, t, t, t, t); }
+			else if(IsKeyword(p, "Tr", &args)) { const float t = (float) atof(args); CPM_MATERIAL::SetColor(m.transparency, t, t, t, t); }
+			else if(IsKeyword(p, "map_Kd", &args)) m.colorTexName = TextureFile(args, scene.strings);
+			else if(IsKeyword(p, "map_Ks", &args)) m.specularColorTexName = TextureFile(args, scene.strings);
+			else if(IsKeyword(p, "map_Ns", &args)) m.specularPowerTexName = TextureFile(args, scene.strings);
+			else if(IsKeyword(p, "map_Ka", &args)) m.ambientTexName = TextureFile(args, scene.strings);
+			else if(IsKeyword(p, "map_d", &args)) m.transparencyTexName = TextureFile(args, scene.strings);
+			else if(IsKeyword(p, "norm", &args) || IsKeyword(p, "map_Kn", &args)) m.normalTexName = TextureFile(args, scene.strings);
+			else if(IsKeyword(p, "bump", &args) || IsKeyword(p, "map_bump", &args) || IsKeyword(p, "map_Bump", &args)) m.bumpTexName = TextureFile(args, scene.strings);
+		}
+
+		line += strcspn(line, "\n");
+		if(*line) line++;
+	}
+}
+
+static int FindMaterial(OBJ_SCENE &scene, const std::string &name)
+// Rsum: indice du matriau, cr avec les valeurs par dfaut s'il n'est dfini dans aucune bibliothque
+{
+	for(size_t i = 0; i < scene.materials.size(); i++) if(scene.materials[i].name == name) return (int) i;
+
+	scene.materials.push_back(OBJ_MATERIAL());
+	scene.materials.back().name = name;
+	return (int) scene.materials.size() - 1;
+}
+
+
+//
+//	Fichier OBJ
+//
+static bool ReadFace(const char *args, OBJ_SCENE &scene, OBJ_OBJECT &object, int material)
+{
+	const size_t numPoints = scene.points.size() / 4, numNormals = scene.normals.size() / 3, numUVs = scene.u.size();
+	unsigned int polygonSize = 0;
+
+	for(const char *p = SkipSpaces(args); *p && *p != '\r' && *p != '\n' && *p != '#'; p = SkipSpaces(p))
+	{
+		OBJ_FACE_VERTEX vertex = { -1, -1, -1 };
+		char *end;
+
+		vertex.point = ResolveIndex(strtol(p, &end, 10), numPoints);
+		if(end == p || vertex.point < 0) return false;
+		p = end;
+
+		if(*p == '/')
+		{
+			p++;
+			if(*p != '/')
+			{
+				vertex.uv = ResolveIndex(strtol(p, &end, 10), numUVs);
+				p = end;
+			}
+			if(*p == '/')
+			{
+				p++;
+				vertex.normal = ResolveIndex(strtol(p, &end, 10), numNormals);
+				p = end;
+			}
+		}
+
+		object.faceVertices.push_back(vertex);
+		polygonSize++;
+	}
+
+	if(polygonSize < 3)
+	{
+		// les points et les lignes dgnres sont ignors
+		object.faceVertices.resize(object.faceVertices.size() - polygonSize);
+		return true;
+	}
+
+	object.polygonSizes.push_back(polygonSize);
+	object.polygonMaterials.push_back(material);
+	return true;
+}
+
+bool ReadObjFile(const std::string &fileName, OBJ_SCENE &scene, std::string &error)
+{
+	std::string data;
+	if(!ReadWholeFile(fileName, data))
+	{
+		error = "cannot read " + fileName;
+		return false;
+	}
+
+	scene.objects.push_back(OBJ_OBJECT());
+	scene.objects.back().name = "default";
+
+	int material = -1;
+	unsigned int lineNumber = 1;
+	for(const char *line = data.c_str(); *line; lineNumber++)
+	{
+		const char *p = SkipSpaces(line), *args;
+		char *end;
+
+		if(p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			p += 2;
+			for(unsigned int i = 0; i < 3; i++) { scene.points.push_back(strtod(p, &end)); p = end; }
+			const double w = strtod(p, &end);
+			scene.points.push_back(end != p ? w : 1.0);
+		}
+		else if(IsKeyword(p, "vn", &args))
+		{
+			for(unsigned int i = 0; i < 3; i++) { scene.normals.push_back((float) strtod(args, &end)); args = end; }
+		}
+		else if(IsKeyword(p, "vt", &args))
+		{
+			scene.u.push_back((float) strtod(args, &end));
+			args = end;
+			scene.v.push_back((float) strtod(args, &end));
+		}
+		else if(IsKeyword(p, "f", &args))
+		{
+			if(!ReadFace(args, scene, scene.objects.back(), material))
+			{
+				std::ostringstream message;
+				message << fileName << ":" << lineNumber << ": invalid face";
+				error = message.str();
+				return false;
+			}
+		}
+		else if(IsKeyword(p, "o", &args) || IsKeyword(p, "g", &args))
+		{
+			// un nouvel objet commence, sauf si le prcdent n'a encore aucune face
+			if(!scene.objects.back().polygonSizes.empty()) scene.objects.push_back(OBJ_OBJECT());
+			scene.objects.back().name = RestOfLine(args);
+		}
+		else if(IsKeyword(p, "usemtl", &args))
+		{
+			material = FindMaterial(scene, RestOfLine(args));
+		}
+		else if(IsKeyword(p, "mtllib", &args))
+		{
+			ReadMtlFile(DirectoryOf(fileName) + RestOfLine(args), scene);
+		}
+
+		line += strcspn(line, "\n");
+		if(*line) line++;
+	}
+
+	if(scene.objects.back().polygonSizes.empty()) scene.objects.pop_back();
+	return true;
+}
@@ -0,0 +1,49 @@
+#ifndef OBJ_READER_H_INCLUDED
+#define OBJ_READER_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "CPMMeshWriter.h"
+
+//
+//	Lecture des fichiers Wavefront OBJ et de leurs bibliothques de matriaux (.mtl)
+//	les indices sont ramens  partir de 0, -1 quand l'attribut est absent du face-vertex
+//
+struct OBJ_FACE_VERTEX
+{
+	int		point;
+	int		uv;
+	int		normal;
+};
+
+struct OBJ_OBJECT
+// Un objet par instruction 'o' ou 'g', les polygones rfrencent les tableaux partags de OBJ_SCENE
+{
+	std::string						name;
+	std::vector<unsigned int>		polygonSizes;
+	std::vector<int>				polygonMaterials;	// indice dans OBJ_SCENE::materials, -1 sans 'usemtl'
+	std::vector<OBJ_FACE_VERTEX>	faceVertices;
+};
+
+struct OBJ_MATERIAL
+{
+	std::string		name;
+	CPM_MATERIAL	material;
+};
+
+struct OBJ_SCENE
+{
+	std::vector<double>			points;		// x, y, z, w
+	std::vector<float>			normals;	// x, y, z
+	std::vector<float>			u;
+	std::vector<float>			v;
+
+	std::vector<OBJ_OBJECT>		objects;
+	std::vector<OBJ_MATERIAL>	materials;
+	CPMStringPool				strings;	// noms des textures des matriaux
+};
+
+bool ReadObjFile(const std::string &fileName, OBJ_SCENE &scene, std::string &error);
+
+#endif // OBJ_READER_H_INCLUDED
@@ -0,0 +1,135 @@
+//
+//	Tests de CPMTangentSpace contre les rsultats de l'implmentation de rfrence de MikkTSpace
+//	les cas sont plans (normale +z) et les UVs aligns sur les axes: la tangente de rfrence se dduit directement des UVs
+//	- quad dont un triangle a des UVs aligns (aire nulle): il rejoint le groupe de son voisin, le coin qu'aucun groupe
+//	  n'atteint garde la base par dfaut (1, 0, 0) avec l'orientation non prserve
+//	- triangle isol sans aire UV: base par dfaut  chaque coin
+//	- deux quads aux UVs en miroir: les vertices de la couture sont dupliqus
+//
+//	usage: cpmtest_tangents, code de retour non nul en cas d'chec
+//
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+#include "CPMTangentSpace.h"
+#include "CPMMeshWriter.h"
+
+struct EXPECTED_CORNER
+{
+	float	x, y, z, sign;
+};
+
+static unsigned int g_failures = 0;
+
+static void BuildPlane(const float *xy, const float *uv, unsigned int numVertices, const unsigned int *corners, unsigned int numCorners, CPM_MESH_DATA &mesh)
+// Rsum: mesh plan de normale +z
+{
+	mesh.points.resize(numVertices);
+	mesh.normals.resize(numVertices);
+	mesh.UVs.resize(numVertices);
+	for(unsigned int v = 0; v < numVertices; v++)
+	{
+		mesh.points.x[v] = xy[2 * v];
+		mesh.points.y[v] = xy[2 * v + 1];
+		mesh.points.z[v] = 0.0;
+		mesh.normals.x[v] = mesh.normals.y[v] = 0.0f;
+		mesh.normals.z[v] = 1.0f;
+		mesh.UVs.u[v] = uv[2 * v];
+		mesh.UVs.v[v] = uv[2 * v + 1];
+	}
+	mesh.triangles.assign(corners, corners + numCorners);
+}
+
+static void CheckCorners(const char *name, const CPM_MESH_DATA &mesh, const EXPECTED_CORNER *expected)
+{
+	std::vector<float> tangents;
+	GenerateCornerTangents(mesh.triangles, mesh.points, mesh.normals, mesh.UVs, tangents);
+
+	for(size_t c = 0; c < mesh.triangles.size(); c++)
+	{
+		const float *t = &tangents[4 * c];
+		const EXPECTED_CORNER &e = expected[c];
+		if(fabsf(t[0] - e.x) > 1e-5f || fabsf(t[1] - e.y) > 1e-5f || fabsf(t[2] - e.z) > 1e-5f || t[3] != e.sign)
+		{
+			fprintf(stderr, "%s: corner %u is (%g, %g, %g) %g, expected (%g, %g, %g) %g\n", name, (unsigned int) c, t[0], t[1], t[2], t[3], e.x, e.y, e.z, e.sign);
+			g_failures++;
+		}
+	}
+}
+
+static void TestZeroUVAreaTriangle()
+{
+	// triangle 0: UV du sommet 1 sur la diagonale, triangle 1 valide
+	const float xy[] = { 0, 0,  1, 0,  1, 1,  0, 1 };
+	const float uv[] = { 0, 0,  0.5f, 0.5f,  1, 1,  0, 1 };
+	const unsigned int corners[] = { 0, 1, 2,  0, 2, 3 };
+	const EXPECTED_CORNER expected[] =
+	{
+		{ 1, 0, 0, 1 }, { 1, 0, 0, -1 }, { 1, 0, 0, 1 },
+		{ 1, 0, 0, 1 }, { 1, 0, 0, 1 }, { 1, 0, 0, 1 },
+	};
+
+	CPM_MESH_DATA mesh;
+	BuildPlane(xy, uv, 4, corners, 6, mesh);
+	CheckCorners("zero UV area triangle", mesh, expected);
+}
+
+static void TestIsolatedZeroUVArea()
+{
+	const float xy[] = { 0, 0,  1, 0,  0, 1 };
+	const float uv[] = { 0, 0,  1, 1,  2, 2 };
+	const unsigned int corners[] = { 0, 1, 2 };
+	const EXPECTED_CORNER expected[] = { { 1, 0, 0, -1 }, { 1, 0, 0, -1 }, { 1, 0, 0, -1 } };
+
+	CPM_MESH_DATA mesh;
+	BuildPlane(xy, uv, 3, corners, 3, mesh);
+	CheckCorners("isolated zero UV area triangle", mesh, expected);
+}
+
+static void TestMirroredUVs()
+{
+	// quad de gauche: u = x, quad de droite: u = 2 - x, la couture x = 1 a les mmes UVs des deux cts
+	const float xy[] = { 0, 0,  1, 0,  1, 1,  0, 1,  2, 0,  2, 1 };
+	const float uv[] = { 0, 0,  1, 0,  1, 1,  0, 1,  0, 0,  0, 1 };
+	const unsigned int corners[] = { 0, 1, 2,  0, 2, 3,  1, 4, 5,  1, 5, 2 };
+	const EXPECTED_CORNER expected[] =
+	{
+		{ 1, 0, 0, 1 }, { 1, 0, 0, 1 }, { 1, 0, 0, 1 },
+		{ 1, 0, 0, 1 }, { 1, 0, 0, 1 }, { 1, 0, 0, 1 },
+		{ -1, 0, 0, -1 }, { -1, 0, 0, -1 }, { -1, 0, 0, -1 },
+		{ -1, 0, 0, -1 }, { -1, 0, 0, -1 }, { -1, 0, 0, -1 },
+	};
+
+	CPM_MESH_DATA mesh;
+	BuildPlane(xy, uv, 6, corners, 12, mesh);
+	CheckCorners("mirrored UVs", mesh, expected);
+
+	// les deux vertices de la couture sont dupliqus, la binormale signe * (n x t) suit v des deux cts
+	const CPM_TANGENT_STATS stats = GenerateMeshTangents(mesh);
+	if(stats.outputVertices != 8 || mesh.points.size() != 8 || mesh.tangents.size() != 8)
+	{
+		fprintf(stderr, "mirrored UVs: %u vertices after tangents, expected 8\n", (unsigned int) mesh.points.size());
+		g_failures++;
+		return;
+	}
+	for(size_t c = 0; c < mesh.triangles.size(); c++)
+	{
+		const unsigned int v = mesh.triangles[c];
+		if(mesh.tangents.x[v] != expected[c].x || fabsf(mesh.binormals.y[v] - 1.0f) > 1e-5f)
+		{
+			fprintf(stderr, "mirrored UVs: vertex %u of corner %u has tangent x %g and binormal y %g\n", v, (unsigned int) c, mesh.tangents.x[v], mesh.binormals.y[v]);
+			g_failures++;
+		}
+	}
+}
+
+int main()
+{
+	TestZeroUVAreaTriangle();
+	TestIsolatedZeroUVArea();
+	TestMirroredUVs();
+
+	if(g_failures) fprintf(stderr, "cpmtest_tangents: %u failures\n", g_failures);
+	return g_failures ? 1 : 0;
+}
@@ -0,0 +1,255 @@
+//
+//	Compression et dcompression des fichiers CPM dans le conteneur par blocs (CPMChunkedStream)
+//
+//	usage: cpmzip pack [-lz4 | -zstd] [-threads n] <entre> <sortie>
+//		   cpmzip unpack [-threads n] <entre> <sortie>
+//		   cpmzip list <entre>
+//		   cpmzip objects [-object nom <sortie>] <entre>
+//		   cpmzip verify [-threads n] <entre>
+//	objects affiche la table des objets d'un fichier CPM, compress ou non, et les colonnes de chaque objet;
+//	avec -object, seules les sections de cet objet sont lues et crites
+//	verify vrifie en parallle les sommes de contrle de tous les blocs (conteneur compress ou fichier binaire), code de retour 1 si un bloc est corrompu
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "CPMChunkedStream.h"
+#include "CPMChecksum.h"
+#include "CPMObjectTable.h"
+
+static double Seconds(const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void PrintRun(const char *action, CPM_CODEC codec, unsigned long long rawSize, unsigned long long compressedSize, unsigned int chunks, double seconds)
+{
+	const double megabytes = rawSize / (1024.0 * 1024.0);
+	printf("%s %s: %.2f MiB <-> %.2f MiB, %u chunks, ratio %.2f, %.1f MiB/s, %u threads\n", action, CodecName(codec), megabytes,
+		compressedSize / (1024.0 * 1024.0), chunks, compressedSize ? (double) rawSize / compressedSize : 0.0, seconds > 0.0 ? megabytes / seconds : 0.0,
+		GetWorkerCount());
+}
+
+static int Pack(CPM_CODEC codec, const char *input, const char *output)
+{
+	std::ifstream in(input, std::ios::binary);
+	std::ofstream out(output, std::ios::binary);
+	if(!in || !out)
+	{
+		fprintf(stderr, "cpmzip: cannot open %s or %s\n", input, output);
+		return 1;
+	}
+
+	if(!IsCodecAvailable(codec)) fprintf(stderr, "cpmzip: %s is not available in this build, chunks are stored\n", CodecName(codec));
+
+	CPMChunkedOStream container(out, codec);
+
+	// lecture par morceaux: le fichier passe dans le conteneur comme le ferait l'exportateur
+	std::string buffer(256 * 1024, '\0');
+	while(in)
+	{
+		in.read(&buffer[0], buffer.size());
+		container.write(buffer.data(), in.gcount());
+	}
+
+	if(!container.close())
+	{
+		fprintf(stderr, "cpmzip: write error on %s\n", output);
+		return 1;
+	}
+
+	const CPM_CONTAINER_STATS &stats = container.getStats();
+	PrintRun("pack", codec, stats.rawSize, stats.compressedSize, stats.chunkCount, stats.seconds);
+	return 0;
+}
+
+static int Unpack(const char *input, const char *output)
+{
+	std::ifstream in(input, std::ios::binary);
+	CPMChunkedReader reader;
+	if(!in || !reader.open(in))
+	{
+		fprintf(stderr, "cpmzip: %s is not a valid CPM container\n", input);
+		return 1;
+	}
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::string data;
+	if(!reader.readAll(data))
+	{
+		fprintf(stderr, "cpmzip: cannot decompress %s\n", input);
+		return 1;
+	}
+
+	const double seconds = Seconds(start);
+
+	std::ofstream out(output, std::ios::binary);
+	out.write(data.data(), data.size());
+	if(!out)
+	{
+		fprintf(stderr, "cpmzip: write error on %s\n", output);
+		return 1;
+	}
+
+	in.clear();
+	in.seekg(0, std::ios::end);
+	PrintRun("unpack", reader.getCodec(), reader.getRawSize(), (unsigned long long) in.tellg(), reader.getChunkCount(), seconds);
+	return 0;
+}
+
+static int List(const char *input)
+{
+	std::ifstream in(input, std::ios::binary);
+	CPMChunkedReader reader;
+	if(!in || !reader.open(in))
+	{
+		fprintf(stderr, "cpmzip: %s is not a valid CPM container\n", input);
+		return 1;
+	}
+
+	printf("codec %s, %u chunks, %llu bytes\n", CodecName(reader.getCodec()), reader.getChunkCount(), reader.getRawSize());
+	printf("%8s %12s %10s %10s %6s %10s\n", "chunk", "offset", "size", "raw", "codec", "crc32c");
+	for(unsigned int i = 0; i < reader.getChunkCount(); i++)
+	{
+		const CPM_CHUNK_ENTRY &entry = reader.getChunk(i);
+		char checksum[16] = "-";
+		if(reader.hasChecksums()) sprintf(checksum, "%08x", entry.checksum);
+		printf("%8u %12llu %10u %10u %6s %10s\n", i, entry.offset, entry.size, entry.rawSize, CodecName((CPM_CODEC) entry.codec), checksum);
+	}
+	return 0;
+}
+
+static int Objects(const char *input, const char *name, const char *output)
+{
+	std::ifstream in(input, std::ios::binary);
+	CPMObjectFile file;
+	if(!in || !file.open(in))
+	{
+		fprintf(stderr, "cpmzip: %s has no object table\n", input);
+		return 1;
+	}
+
+	if(!name)
+	{
+		printf("%s%s file, %lu objects\n", file.isCompressed() ? "compressed " : "", file.isBinary() ? "binary" : "text", (unsigned long) file.getObjectCount());
+		printf("%12s %12s  %-40s %s\n", "offset", "size", "bounds", "name");
+		for(size_t i = 0; i < file.getObjectCount(); i++)
+		{
+			const CPM_OBJECT_INFO &object = file.getObject(i);
+			char bounds[128] = "empty";
+			if(!object.bounds.empty())
+			{
+				sprintf(bounds, "(%g %g %g) (%g %g %g)", object.bounds.min[0], object.bounds.min[1], object.bounds.min[2],
+					object.bounds.max[0], object.bounds.max[1], object.bounds.max[2]);
+			}
+			printf("%12llu %12llu  %-40s %s\n", object.offset, object.size, bounds, object.name.c_str());
+			for(size_t c = 0; c < object.columns.size(); c++)
+				printf("%12llu %12llu    %s\n", object.columns[c].offset, object.columns[c].size, object.columns[c].tag);
+		}
+		return 0;
+	}
+
+	const CPM_OBJECT_INFO *object = file.find(name);
+	if(!object)
+	{
+		fprintf(stderr, "cpmzip: no object named %s in %s\n", name, input);
+		return 1;
+	}
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::string data;
+	std::ofstream out(output, std::ios::binary);
+	if(!file.readObject(*object, data) || !out.write(data.data(), data.size()))
+	{
+		fprintf(stderr, "cpmzip: cannot copy %s from %s to %s\n", name, input, output);
+		return 1;
+	}
+
+	printf("%s: %llu bytes at offset %llu, %.3f ms\n", name, object->size, object->offset, Seconds(start) * 1e3);
+	return 0;
+}
+
+static int Verify(const char *input)
+{
+	std::ifstream in(input, std::ios::binary);
+	CPMObjectFile file;
+	if(!in || !file.open(in))
+	{
+		fprintf(stderr, "cpmzip: %s is not a readable CPM file\n", input);
+		return 1;
+	}
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	CPM_VALIDATION result;
+	if(!file.validate(result))
+	{
+		fprintf(stderr, "cpmzip: cannot read the checksums of %s\n", input);
+		return 1;
+	}
+	const double seconds = Seconds(start);
+
+	if(!result.checksums)
+	{
+		printf("%s: no checksums\n", input);
+		return 0;
+	}
+
+	const double megabytes = (double) result.blockCount * result.blockSize / (1024.0 * 1024.0);
+	printf("%s: %u blocks of %u bytes, crc32c %s, %.3f ms, %.1f MiB/s, %u threads\n", input, result.blockCount, result.blockSize, Crc32cImplementation(),
+		seconds * 1e3, seconds > 0.0 ? megabytes / seconds : 0.0, GetWorkerCount());
+	for(size_t i = 0; i < result.corrupted.size(); i++)
+	{
+		const unsigned long long offset = (unsigned long long) result.corrupted[i] * result.blockSize;
+		printf("corrupted block %u: bytes %llu to %llu\n", result.corrupted[i], offset, offset + result.blockSize);
+	}
+	if(!result.corrupted.empty()) return 1;
+
+	printf("ok\n");
+	return 0;
+}
+
+static int Usage()
+{
+	fprintf(stderr, "usage: cpmzip pack [-lz4 | -zstd] [-threads n] <input> <output>\n"
+					"       cpmzip unpack [-threads n] <input> <output>\n"
+					"       cpmzip list <input>\n"
+					"       cpmzip objects [-object name <output>] <input>\n"
+					"       cpmzip verify [-threads n] <input>\n");
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	if(argc < 3) return Usage();
+
+	const char *command = argv[1];
+	CPM_CODEC codec = CPM_CODEC_LZ4;
+	const char *files[2] = { NULL, NULL };
+	const char *object = NULL;
+	int fileCount = 0;
+
+	for(int i = 2; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-lz4") == 0) codec = CPM_CODEC_LZ4;
+		else if(strcmp(argv[i], "-zstd") == 0) codec = CPM_CODEC_ZSTD;
+		else if(strcmp(argv[i], "-store") == 0) codec = CPM_CODEC_STORE;
+		else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc) SetWorkerCount((unsigned int) atoi(argv[++i]));
+		else if(strcmp(argv[i], "-object") == 0 && i + 1 < argc) object = argv[++i];
+		else if(fileCount < 2) files[fileCount++] = argv[i];
+		else return Usage();
+	}
+
+	if(strcmp(command, "pack") == 0 && fileCount == 2) return Pack(codec, files[0], files[1]);
+	if(strcmp(command, "unpack") == 0 && fileCount == 2) return Unpack(files[0], files[1]);
+	if(strcmp(command, "list") == 0 && fileCount == 1) return List(files[0]);
+	if(strcmp(command, "objects") == 0 && !object && fileCount == 1) return Objects(files[0], NULL, NULL);
+	if(strcmp(command, "objects") == 0 && object && fileCount == 2) return Objects(files[1], object, files[0]);
+	if(strcmp(command, "verify") == 0 && fileCount == 1) return Verify(files[0]);
+
+	return Usage();
+}